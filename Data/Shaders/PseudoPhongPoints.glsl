@@ -4,7 +4,41 @@
 
 #include "VertexAttributeNames.glsl"
 
+#ifdef QUANTIZED_POINT_POSITIONS
+// 16-bit positions local to the bounds of their octree node, normalized to [0,1] (see PointQuantization.hpp).
+layout(location = 0) in vec3 vertexPositionQuantized;
+
+struct QuantizationNode
+{
+    vec3 boundsMin;
+    uint firstPoint;
+    vec3 boundsExtent;
+    uint padding;
+};
+
+// Sorted by the index of their first point.
+layout(std430, binding = 7) readonly buffer QuantizationNodeBuffer
+{
+    QuantizationNode quantizationNodes[];
+};
+
+vec3 decodePointPosition(uint pointIndex)
+{
+    // Binary search for the last node starting at or before the point.
+    int lower = 0, upper = quantizationNodes.length() - 1;
+    while (lower < upper) {
+        int middle = (lower + upper + 1) / 2;
+        if (quantizationNodes[middle].firstPoint <= pointIndex) {
+            lower = middle;
+        } else {
+            upper = middle - 1;
+        }
+    }
+    return quantizationNodes[lower].boundsMin + vertexPositionQuantized * quantizationNodes[lower].boundsExtent;
+}
+#else
 layout(location = 0) in vec3 vertexPosition;
+#endif
 layout(location = 3) in float VERTEX_ATTRIBUTE;
 
 out VertexData
@@ -15,7 +49,12 @@ out VertexData
 
 void main()
 {
+#ifdef QUANTIZED_POINT_POSITIONS
+    // gl_VertexID is the point index both for indexed (octree node selection) and non-indexed rendering.
+    pointPosition = decodePointPosition(uint(gl_VertexID));
+#else
     pointPosition = vertexPosition;
+#endif
     pointAttribute = VERTEX_ATTRIBUTE;
 }
 
@@ -5,12 +5,17 @@
 //============================================================================
 
 #include <iostream>
+#include <string>
+#include <omp.h>
 #include <SDL2/SDL.h>
 #include <Utils/File/FileUtils.hpp>
 #include <Utils/AppSettings.hpp>
 #include <Graphics/Window.hpp>
 
 #include "MainApp.hpp"
+#include "Tests/TestMeshAdjacency.hpp"
+#include "Tests/TestKDTree.hpp"
+#include "Tests/TestVoxelCurveDiscretizer.hpp"
 
 using namespace std;
 using namespace sgl;
@@ -19,6 +24,17 @@ int main(int argc, char *argv[]) {
     // Initialize the filesystem utilities
     FileUtils::get()->initialize("pixel-sync-oit", argc, argv);
 
+    // "--test" runs the tests and benchmarks of the CPU mesh processing code without opening a window.
+    if (argc > 1 && string(argv[1]) == "--test") {
+        bool testsPassed = testVertexTriangleAdjacencyDeterminism(omp_get_max_threads());
+        testsPassed = testKDTreeQueries() && testsPassed;
+        testsPassed = testVoxelCurveDiscretization() && testsPassed;
+        benchmarkVertexTriangleAdjacency(1u << 22);
+        benchmarkKDTree(1000000, 100000);
+        benchmarkVoxelCurveDiscretization(10000);
+        return testsPassed ? 0 : 1;
+    }
+
     // Load the file containing the app settings
     string settingsFile = FileUtils::get()->getConfigDirectory() + "settings.txt";
     AppSettings::get()->loadSettings(settingsFile.c_str());
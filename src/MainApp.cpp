@@ -7,6 +7,7 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <climits>
+#include <cmath>
 #include <chrono>
 #include <ctime>
 #include <algorithm>
@@ -19,6 +20,7 @@
 #include <glm/gtx/euler_angles.hpp>
 #include <GL/glew.h>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
 
 #include <Input/Keyboard.hpp>
 #include <Math/Math.hpp>
@@ -47,9 +49,12 @@
 #include "Utils/MeshSerializer.hpp"
 #include "Utils/OBJLoader.hpp"
 #include "Utils/BinaryObjLoader.hpp"
+#include "Utils/OutOfCoreBinaryObjLoader.hpp"
 #include "Utils/PointRendering/PointFileLoader.hpp"
+#include "Utils/PointQuantization.hpp"
 #include "Utils/TrajectoryLoader.hpp"
 #include "Utils/HairLoader.hpp"
+#include "Utils/GuideHairFile.hpp"
 #include "OIT/BufferSizeWatch.hpp"
 #include "OIT/OIT_Dummy.hpp"
 #include "OIT/OIT_KBuffer.hpp"
@@ -61,6 +66,7 @@
 #include "OIT/OIT_WBOIT.hpp"
 #include "OIT/OIT_DepthComplexity.hpp"
 #include "OIT/OIT_DepthPeeling.hpp"
+#include "OIT/OIT_SortedSegments.hpp"
 #include "OIT/TilingMode.hpp"
 #include "VoxelRaytracing/OIT_VoxelRaytracing.hpp"
 #include "Tests/TestPixelSyncPerformance.hpp"
@@ -455,6 +461,161 @@ void PixelSyncApp::loadCameraPositionFromFile(const std::string& filename)
 
 
 
+void PixelSyncApp::loadEnsembleMember(int member)
+{
+    // The mesh was usually already converted in the background, so only the upload to the GPU remains.
+    std::shared_ptr<BinaryMesh> lineMesh = ensembleMemberCache->getLineMesh(EnsembleSelection(member));
+    transparentObject = parseMesh3D(*lineMesh, transparencyShader, shuffleGeometry,
+            useProgrammableFetch, programmableFetchUseAoS, lineRadius);
+    if (shaderMode == SHADER_MODE_SCIENTIFIC_ATTRIBUTE) {
+        recomputeHistogramForMesh();
+    }
+    boundingBox = transparentObject.boundingBox;
+    updateLineFilter();
+    updateTransferFunctionCulling();
+    lineBVHBinmeshFilename = "";
+    buildLineSegmentBVH();
+    reRender = true;
+}
+
+void PixelSyncApp::sortTransparentSegments()
+{
+    SegmentSorter &segmentSorter = transparentObject.segmentSorter;
+    if (segmentSorter.isEmpty()) {
+        return;
+    }
+
+    transparentObject.uploadSortedLineIndices(camera->getViewMatrix() * rotation * scaling);
+    double sortTimeMS = segmentSorter.getLastSortTimeMS();
+    static_cast<OIT_SortedSegments*>(oitRenderer.get())->setLastSortTimeMS(sortTimeMS);
+    if (perfMeasurementMode) {
+        measurer->pushCpuSortTime(sortTimeMS);
+    }
+}
+
+void PixelSyncApp::loadLineSegmentBVH(const std::string &binmeshFilename)
+{
+    lineBVHBinmeshFilename = binmeshFilename;
+    if (shuffleGeometry) {
+        // The line order is different each time the mesh is loaded, so the BVH can't be cached.
+        buildLineSegmentBVH();
+        return;
+    }
+
+    // The cache is only used if it was built from the current binmesh file and importance criterion.
+    LineSegmentBVHSource source;
+    source.lastModified = uint64_t(boost::filesystem::last_write_time(binmeshFilename));
+    source.numIndices = transparentObject.lineFilter.getLineIndices().size();
+    source.attributeIndex = importanceCriterionIndex < int(transparentObject.importanceCriterionAttributes.size())
+            ? importanceCriterionIndex : -1;
+    std::string bvhFilename = getLineSegmentBVHFilename(binmeshFilename);
+    if (source.numIndices > 0 && FileUtils::get()->exists(bvhFilename) && lineBVH.readFromFile(bvhFilename, source)) {
+        return;
+    }
+
+    buildLineSegmentBVH();
+    if (!lineBVH.isEmpty()) {
+        lineBVH.writeToFile(bvhFilename, source);
+    }
+}
+
+void PixelSyncApp::buildLineSegmentBVH()
+{
+    lineBVH = LineSegmentBVH();
+    pickedLineId = -1;
+
+    // Use the line data the renderer keeps on the CPU for filtering and sorting (not kept with programmable fetch).
+    // This way, the line IDs and attribute ranges match the rendered lines (the renderer may have shuffled the line
+    // order), and the mesh doesn't need to be read again.
+    const LineFilter &lineFilter = transparentObject.lineFilter;
+    const std::vector<glm::vec3> &vertexPositions = transparentObject.segmentSorter.getVertexPositions();
+    if (lineFilter.isEmpty() || vertexPositions.empty()) {
+        return;
+    }
+    const std::vector<float> *vertexAttributes = NULL;
+    if (importanceCriterionIndex < int(transparentObject.importanceCriterionAttributes.size())
+            && transparentObject.importanceCriterionAttributes.at(importanceCriterionIndex).attributes.size()
+            == vertexPositions.size()) {
+        vertexAttributes = &transparentObject.importanceCriterionAttributes.at(importanceCriterionIndex).attributes;
+    }
+    lineBVH.build(vertexPositions, lineFilter.getLineIndices(), vertexAttributes);
+}
+
+void PixelSyncApp::updateLineSegmentBVHAttribute()
+{
+    if (!lineBVHBinmeshFilename.empty()) {
+        loadLineSegmentBVH(lineBVHBinmeshFilename);
+    } else if (!lineBVH.isEmpty()) {
+        buildLineSegmentBVH();
+    }
+}
+
+void PixelSyncApp::pickLine()
+{
+    // Unproject the mouse position to a ray in the object space of the model.
+    Window *window = AppSettings::get()->getMainWindow();
+    sgl::Point2 mousePosition = Mouse->getAxis();
+    glm::vec2 ndc(2.0f * float(mousePosition.x) / float(window->getWidth()) - 1.0f,
+            1.0f - 2.0f * float(mousePosition.y) / float(window->getHeight()));
+    glm::mat4 inverseModelViewProjection = glm::inverse(
+            camera->getProjectionMatrix() * camera->getViewMatrix() * rotation * scaling);
+    glm::vec4 nearPoint = inverseModelViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseModelViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+    glm::vec3 rayOrigin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 rayDirection = glm::normalize(glm::vec3(farPoint) / farPoint.w - rayOrigin);
+
+    // Be a bit more tolerant than the actual line radius, as lines are only a few pixels wide.
+    LineSegmentHit hit;
+    if (lineBVH.pickRay(rayOrigin, rayDirection, lineRadius * 4.0f, hit)) {
+        pickedLineId = int(hit.lineId);
+        Logfile::get()->writeInfo(std::string() + "Picked line " + std::to_string(hit.lineId)
+                + " (segment " + std::to_string(hit.segmentIndex) + ").");
+    } else {
+        pickedLineId = -1;
+    }
+}
+
+void PixelSyncApp::updateTransferFunctionCulling()
+{
+    LineFilter &lineFilter = transparentObject.lineFilter;
+    if (lineFilter.isEmpty()) {
+        return;
+    }
+
+    // The gather shaders discard fragments with an opacity below 1/255, so culling these lines changes nothing.
+    std::vector<uint8_t> lineMask;
+    if (cullTransparentLines && transparencyMapping && shaderMode == SHADER_MODE_SCIENTIFIC_ATTRIBUTE
+            && importanceCriterionIndex < int(lineFilter.getNumAttributes())) {
+        const std::vector<sgl::Color> &transferFunctionMap = transferFunctionWindow.getTransferFunctionMap_sRGB();
+        std::vector<float> opacityTable(transferFunctionMap.size());
+        for (size_t i = 0; i < transferFunctionMap.size(); i++) {
+            opacityTable.at(i) = transferFunctionMap.at(i).getFloatA();
+        }
+        computeTransferFunctionLineMask(
+                lineFilter.getLineSummaries(importanceCriterionIndex), opacityTable,
+                minCriterionValue, maxCriterionValue, 1.0f / 255.0f, lineMask);
+    }
+
+    if (lineFilter.setLineMask(lineMask)) {
+        transparentObject.uploadFilteredLineIndices();
+        reRender = true;
+    }
+}
+
+void PixelSyncApp::updateLineFilter()
+{
+    bool changed = false;
+    if (useLineFilter && importanceCriterionIndex < int(transparentObject.lineFilter.getNumAttributes())) {
+        changed = transparentObject.lineFilter.setThreshold(importanceCriterionIndex, lineFilterThreshold);
+    } else {
+        changed = transparentObject.lineFilter.resetThreshold();
+    }
+    if (changed) {
+        transparentObject.uploadFilteredLineIndices();
+        reRender = true;
+    }
+}
+
 void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
 {
     // Pure filename without extension (to create compressed .binmesh filename)
@@ -645,9 +806,45 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
         sgl::ShaderManager->removePreprocessorDefine("USE_PROGRAMMABLE_FETCH");
     }
 
-    if (!FileUtils::get()->exists(modelFilenameOptimized)) {
+    // Welding and levels of detail need the whole mesh in memory and are skipped for huge iso surface meshes.
+    bool convertOutOfCore = boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")
+            && estimateBinaryObjConversionMemory(filename) > meshConversionMemoryBudget;
+
+    // Welded meshes are cached separately from the original ones.
+    float weldingEpsilon = 0.0f;
+    if (weldMeshVertices && (modelType == MODEL_TYPE_TRIANGLE_MESH_NORMAL
+            || modelType == MODEL_TYPE_TRIANGLE_MESH_SCIENTIFIC)) {
+        if (convertOutOfCore) {
+            Logfile::get()->writeInfo("The mesh is too large for welding its vertices. Loading it unwelded.");
+        } else {
+            modelFilenameOptimized += "_welded";
+            weldingEpsilon = meshWeldingEpsilon;
+        }
+    }
+
+    // Point data sets with 8-bit attributes are cached separately from the ones with 16-bit attributes.
+    if (modelType == MODEL_TYPE_POINTS && reducePointAttributeBits) {
+        modelFilenameOptimized += "_8bit";
+    }
+
+    // The strands of guide hair files are generated at load time. Their tube mesh is created in memory, as caching it
+    // on disk would undo the savings of the format (only the OSPRay backend needs the binmesh file).
+    bool isGuideHair = modelType == MODEL_TYPE_HAIR && isGuideHairFilename(filename);
+    BinaryMesh guideHairMesh;
+    if (isGuideHair) {
+        if (!FileUtils::get()->exists(filename)) {
+            convertHairFileToGuideHairFile(getHairFilenameOfGuideHairFile(filename), filename);
+        }
+        if (mode == RENDER_MODE_RAYTRACING) {
+            if (!FileUtils::get()->exists(modelFilenameOptimized)) {
+                convertHairDataToBinaryTriangleMesh(filename, modelFilenameOptimized);
+            }
+        } else {
+            createHairBinaryTriangleMesh(filename, guideHairMesh, { 0.5f, 0.25f, 0.125f });
+        }
+    } else if (!FileUtils::get()->exists(modelFilenameOptimized)) {
         if (modelType == MODEL_TYPE_TRIANGLE_MESH_NORMAL) {
-            convertObjMeshToBinary(filename, modelFilenameOptimized);
+            convertObjMeshToBinary(filename, modelFilenameOptimized, weldingEpsilon);
         } else if (modelType == MODEL_TYPE_TRAJECTORIES) {
             if (boost::ends_with(modelFilenameOptimized, "_lines")) {
                 convertTrajectoryDataToBinaryLineMesh(trajectoryType, filename, modelFilenameOptimized);
@@ -658,11 +855,18 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
 //                        modelFilenameOptimized, lineRadius);
             }
         } else if (boost::starts_with(modelFilenamePure, "Data/Hair")) {
-            convertHairDataToBinaryTriangleMesh(filename, modelFilenameOptimized);
+            // Stochastic levels of detail with 1/2, 1/4 and 1/8 of the strands.
+            convertHairDataToBinaryTriangleMesh(filename, modelFilenameOptimized, { 0.5f, 0.25f, 0.125f });
         } else if (boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
-            convertBinaryObjMeshToBinmesh(filename, modelFilenameOptimized);
+            if (convertOutOfCore) {
+                convertBinaryObjMeshToBinmeshOutOfCore(filename, modelFilenameOptimized, meshConversionMemoryBudget);
+            } else {
+                // Levels of detail with 1/4, 1/16 and 1/64 of the triangles.
+                convertBinaryObjMeshToBinmesh(filename, modelFilenameOptimized, weldingEpsilon,
+                        {0.25f, 0.0625f, 0.015625f});
+            }
         } else if (boost::starts_with(modelFilenamePure, "Data/PointDatasets")) {
-            convertPointDataSetToBinmesh(filename, modelFilenameOptimized);
+            convertPointDataSetToBinmesh(filename, modelFilenameOptimized, reducePointAttributeBits ? 8 : 16);
         }
     }
 
@@ -699,15 +903,60 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
         gatherShaderIDs = {"PseudoPhongPoints.Vertex", "PseudoPhongPoints.Geometry", "PseudoPhongPoints.Fragment"};
     }
 
+    // The ensemble members of WCB NetCDF files can be switched interactively when rendering line meshes.
+    ensembleMember = 0;
+    bool useEnsembleMembers = modelType == MODEL_TYPE_TRAJECTORIES && trajectoryType == TRAJECTORY_TYPE_WCB
+            && boost::ends_with(filename, ".nc") && boost::ends_with(modelFilenameOptimized, "_lines")
+            && mode != RENDER_MODE_VOXEL_RAYTRACING_LINES && mode != RENDER_MODE_RAYTRACING;
+    if (useEnsembleMembers) {
+        if (!ensembleMemberCache || ensembleMemberCache->getFilename() != filename) {
+            ensembleMemberCache = std::make_shared<EnsembleMemberCache>(filename, trajectoryType);
+        }
+        // Member 0 is loaded from the binmesh file below, so start decoding the next member right away.
+        if (ensembleMemberCache->getNumMembers() > 1) {
+            ensembleMemberCache->prefetch(EnsembleSelection(1));
+        }
+    } else {
+        ensembleMemberCache.reset();
+    }
+
+    lineBVH = LineSegmentBVH();
+    lineBVHBinmeshFilename = "";
+    pickedLineId = -1;
+
     updateShaderMode(SHADER_MODE_UPDATE_NEW_MODEL);
 
     if (mode != RENDER_MODE_VOXEL_RAYTRACING_LINES && mode != RENDER_MODE_RAYTRACING) {
-        transparentObject = parseMesh3D(modelFilenameOptimized, transparencyShader, shuffleGeometry,
-                useProgrammableFetch, programmableFetchUseAoS, lineRadius);
+        if (isGuideHair) {
+            transparentObject = parseMesh3D(guideHairMesh, transparencyShader, shuffleGeometry,
+                    useProgrammableFetch, programmableFetchUseAoS, lineRadius);
+        } else {
+            transparentObject = parseMesh3D(modelFilenameOptimized, transparencyShader, shuffleGeometry,
+                    useProgrammableFetch, programmableFetchUseAoS, lineRadius);
+        }
         if (shaderMode == SHADER_MODE_SCIENTIFIC_ATTRIBUTE) {
             recomputeHistogramForMesh();
         }
         boundingBox = transparentObject.boundingBox;
+        updateLineFilter();
+        updateTransferFunctionCulling();
+        if (modelType == MODEL_TYPE_TRAJECTORIES && boost::ends_with(modelFilenameOptimized, "_lines")) {
+            loadLineSegmentBVH(modelFilenameOptimized);
+        }
+
+        // Quantized point positions are decoded in the vertex shader (see PointQuantization.hpp).
+        bool hasQuantizedPoints = transparentObject.hasAttributeWithName(QUANTIZED_POSITION_ATTRIBUTE_NAME);
+        if (hasQuantizedPoints != quantizedPointsMode) {
+            if (hasQuantizedPoints) {
+                sgl::ShaderManager->addPreprocessorDefine("QUANTIZED_POINT_POSITIONS", "");
+            } else {
+                sgl::ShaderManager->removePreprocessorDefine("QUANTIZED_POINT_POSITIONS");
+            }
+            quantizedPointsMode = hasQuantizedPoints;
+            sgl::ShaderManager->invalidateShaderCache();
+            updateShaderMode(SHADER_MODE_UPDATE_NEW_MODEL);
+            transparentObject.setNewShader(transparencyShader);
+        }
 
         if (boost::starts_with(modelFilenamePure, "Data/Hair")) {
             bool changed = false;
@@ -727,8 +976,13 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
             }
         }
     } else if (mode == RENDER_MODE_VOXEL_RAYTRACING_LINES) {
-        transparentObject = parseMesh3D(modelFilenameOptimized, transparencyShader, shuffleGeometry,
-                useProgrammableFetch, programmableFetchUseAoS);
+        if (isGuideHair) {
+            transparentObject = parseMesh3D(guideHairMesh, transparencyShader, shuffleGeometry,
+                    useProgrammableFetch, programmableFetchUseAoS);
+        } else {
+            transparentObject = parseMesh3D(modelFilenameOptimized, transparencyShader, shuffleGeometry,
+                    useProgrammableFetch, programmableFetchUseAoS);
+        }
         boundingBox = transparentObject.boundingBox;
         std::vector<float> lineAttributes;
         OIT_VoxelRaytracing *voxelRaytracer = (OIT_VoxelRaytracing*)oitRenderer.get();
@@ -933,6 +1187,8 @@ void PixelSyncApp::setRenderMode(RenderModeOIT newMode, bool forceReset)
         oitRenderer = boost::shared_ptr<OIT_Renderer>(new OIT_DepthPeeling);
     } else if (mode == RENDER_MODE_OIT_MLAB_BUCKET) {
         oitRenderer = boost::shared_ptr<OIT_Renderer>(new OIT_MLABBucket);
+    } else if (mode == RENDER_MODE_OIT_SORTED_SEGMENTS) {
+        oitRenderer = boost::shared_ptr<OIT_Renderer>(new OIT_SortedSegments);
     } else if (mode == RENDER_MODE_VOXEL_RAYTRACING_LINES) {
         oitRenderer = boost::shared_ptr<OIT_Renderer>(new OIT_VoxelRaytracing(camera, clearColor));
 #ifdef USE_RAYTRACING
@@ -1190,6 +1446,7 @@ void PixelSyncApp::setNewState(const InternalState &newState)
         ShaderManager->invalidateShaderCache();
         updateShaderMode(SHADER_MODE_UPDATE_EFFECT_CHANGE);
         transparentObject.setNewShader(transparencyShader);
+        updateLineSegmentBVHAttribute();
         reRender = true;
     }
 
@@ -1506,6 +1763,19 @@ void PixelSyncApp::renderOIT()
     glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
     glBlendEquation(GL_FUNC_ADD);
 
+    if (mode == RENDER_MODE_OIT_SORTED_SEGMENTS) {
+        sortTransparentSegments();
+    }
+    if (transparentObject.hasLods()) {
+        float projectionScale = float(window->getHeight()) / (2.0f * std::tan(camera->getFOVy() * 0.5f));
+        transparentObject.selectLod(camera->getViewMatrix() * rotation * scaling, projectionScale,
+                lodPixelErrorBudget);
+    }
+    if (transparentObject.hasPointOctree()) {
+        transparentObject.selectPoints(camera->getViewMatrix() * rotation * scaling, camera->getProjectionMatrix(),
+                size_t(pointBudgetMillions * 1e6f));
+    }
+
 #ifdef PROFILING_MODE
     timer.startGPU("gatherBegin");
     oitRenderer->gatherBegin();
@@ -1603,6 +1873,13 @@ void PixelSyncApp::renderGUI()
                 loadModel(MODEL_FILENAMES[usedModelIndex], false);
             }
 
+            if (ensembleMemberCache && ensembleMemberCache->getNumMembers() > 1) {
+                if (ImGui::SliderInt("Ensemble Member", &ensembleMember, 0,
+                        int(ensembleMemberCache->getNumMembers()) - 1)) {
+                    loadEnsembleMember(ensembleMember);
+                }
+            }
+
             ImGui::Separator();
 
             static bool showSceneSettings = true;
@@ -1618,6 +1895,7 @@ void PixelSyncApp::renderGUI()
     if (transferFunctionWindow.renderGUI()) {
         reRender = true;
         if (transferFunctionWindow.getTransferFunctionMapRebuilt()) {
+            updateTransferFunctionCulling();
             if (mode == RENDER_MODE_VOXEL_RAYTRACING_LINES) {
                 static_cast<OIT_VoxelRaytracing*>(oitRenderer.get())->onTransferFunctionMapRebuilt();
 #ifdef USE_RAYTRACING
@@ -1702,10 +1980,39 @@ void PixelSyncApp::renderSceneSettingsGUI()
     } ImGui::SameLine();
     ImGui::Checkbox("Continuous Rendering", &continuousRendering);
     ImGui::Checkbox("UI on Screenshot", &uiOnScreenshot);
+    if (modelType == MODEL_TYPE_TRIANGLE_MESH_NORMAL || modelType == MODEL_TYPE_TRIANGLE_MESH_SCIENTIFIC) {
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Weld Vertices", &weldMeshVertices)) {
+            loadModel(MODEL_FILENAMES[usedModelIndex], false);
+            reRender = true;
+        }
+    }
+    if (transparentObject.hasLods()) {
+        if (ImGui::SliderFloat("LOD Pixel Error", &lodPixelErrorBudget, 0.0f, 8.0f, "%.1f")) {
+            reRender = true;
+        }
+        ImGui::SameLine();
+        ImGui::Text("LOD: %d", transparentObject.currentLod);
+    }
+    if (modelType == MODEL_TYPE_POINTS) {
+        ImGui::SameLine();
+        if (ImGui::Checkbox("8-Bit Attributes", &reducePointAttributeBits)) {
+            loadModel(MODEL_FILENAMES[usedModelIndex], false);
+            reRender = true;
+        }
+    }
+    if (transparentObject.hasPointOctree()) {
+        if (ImGui::SliderFloat("Point Budget (M)", &pointBudgetMillions, 0.1f, 50.0f, "%.1f")) {
+            reRender = true;
+        }
+        ImGui::SameLine();
+        ImGui::Text("Points: %.2fM", transparentObject.numSelectedPoints * 1e-6);
+    }
 
     if (shaderMode == SHADER_MODE_SCIENTIFIC_ATTRIBUTE || modelType == MODEL_TYPE_HAIR) {
         ImGui::SameLine();
         if (ImGui::Checkbox("Transparency", &transparencyMapping)) {
+            updateTransferFunctionCulling();
             reRender = true;
         }
         if (ImGui::Checkbox("Color By Position", &colorByPosition)) {
@@ -1792,8 +2099,29 @@ void PixelSyncApp::renderSceneSettingsGUI()
             ShaderManager->invalidateShaderCache();
             updateShaderMode(SHADER_MODE_UPDATE_EFFECT_CHANGE);
             transparentObject.setNewShader(transparencyShader);
+            lineFilterThreshold = minCriterionValue;
+            updateLineFilter();
+            updateTransferFunctionCulling();
+            updateLineSegmentBVHAttribute();
             reRender = true;
         }
+
+        // Filter lines by the maximum of the importance criterion along each line
+        if (!transparentObject.lineFilter.isEmpty()) {
+            if (ImGui::Checkbox("Cull Transparent Lines", &cullTransparentLines)) {
+                updateTransferFunctionCulling();
+            }
+            if (ImGui::Checkbox("Filter Lines", &useLineFilter)) {
+                updateLineFilter();
+            }
+            if (useLineFilter && ImGui::SliderFloat("Filter Threshold", &lineFilterThreshold,
+                    minCriterionValue, maxCriterionValue)) {
+                updateLineFilter();
+            }
+        }
+        if (pickedLineId >= 0) {
+            ImGui::Text("Picked Line: %d", pickedLineId);
+        }
     }
 
     if (ImGui::Combo("AO Mode", (int*)&currentAOTechnique, AO_TECHNIQUE_DISPLAYNAMES,
@@ -2176,6 +2504,11 @@ void PixelSyncApp::update(float dt)
     }
 
 
+    // Line picking
+    if (Mouse->buttonPressed(3) && !lineBVH.isEmpty()) {
+        pickLine();
+    }
+
     // Mouse rotation
     if (Mouse->isButtonDown(1) && Mouse->mouseMoved()) {
         sgl::Point2 pixelMovement = Mouse->mouseMovement();
@@ -23,6 +23,8 @@
 #include "Utils/MeshSerializer.hpp"
 #include "Utils/CameraPath.hpp"
 #include "Utils/ImportanceCriteria.hpp"
+#include "Utils/EnsembleMemberCache.hpp"
+#include "Utils/LineSegmentBVH.hpp"
 #include "OIT/OIT_Renderer.hpp"
 #include "AmbientOcclusion/SSAO.hpp"
 #include "AmbientOcclusion/VoxelAO.hpp"
@@ -130,6 +132,17 @@ private:
     ShaderMode shaderMode = SHADER_MODE_PSEUDO_PHONG;
     std::string modelFilenamePure;
     bool shuffleGeometry = false; // For testing order dependency of OIT algorithms on triangle order
+    // Merge triangle mesh vertices closer than meshWeldingEpsilon times the bounding box extent when converting meshes.
+    bool weldMeshVertices = false;
+    float meshWeldingEpsilon = 1e-6f;
+    // Levels of detail of iso-surfaces are selected such that their geometric error projects to at most this many pixels.
+    float lodPixelErrorBudget = 1.0f;
+    // Point data sets with an octree are rendered with at most this many points per frame (see PointOctree.hpp).
+    float pointBudgetMillions = 5.0f;
+    // Store the attributes of point data sets with 8 instead of 16 bits on conversion (see PointQuantization.hpp).
+    bool reducePointAttributeBits = false;
+    // Iso-surfaces needing more memory than this (in bytes) for their conversion are converted out-of-core.
+    size_t meshConversionMemoryBudget = size_t(2) << 30;
     std::list<std::string> gatherShaderIDs;
 
     // Off-screen rendering
@@ -194,9 +207,39 @@ private:
     void changeImportanceCriterionType();
     void recomputeHistogramForMesh();
 
+    // Ensemble members of WCB NetCDF files (only for line meshes rendered with rasterization)
+    std::shared_ptr<EnsembleMemberCache> ensembleMemberCache;
+    int ensembleMember = 0;
+    void loadEnsembleMember(int member);
+
+    // Filtering lines by the maximum of the importance criterion along the line (see LineFilter)
+    bool useLineFilter = false;
+    float lineFilterThreshold = 0.0f;
+    void updateLineFilter();
+
+    // Culling of lines that are invisible with the current transfer function (see computeTransferFunctionLineMask)
+    bool cullTransparentLines = true;
+    void updateTransferFunctionCulling();
+
+    // Picking lines with the right mouse button (BVH in object space, stored next to the binmesh file)
+    LineSegmentBVH lineBVH;
+    std::string lineBVHBinmeshFilename; ///< Empty if the BVH wasn't built from a binmesh file.
+    int pickedLineId = -1;
+    void loadLineSegmentBVH(const std::string &binmeshFilename);
+    void buildLineSegmentBVH();
+    /// Rebuilds the BVH after the importance criterion used for its attribute ranges changed.
+    void updateLineSegmentBVHAttribute();
+    void pickLine();
+
+    // For RENDER_MODE_OIT_SORTED_SEGMENTS: Sorts the line segments back-to-front and uploads the index buffer.
+    void sortTransparentSegments();
+
     // Hair rendering
     bool colorArrayMode = false;
 
+    // Point data sets with quantized positions (QUANTIZED_POINT_POSITIONS)
+    bool quantizedPointsMode = false;
+
     // Continuous rendering: Re-render each frame or only when scene changes?
     bool continuousRendering = false;
     bool reRender = true;
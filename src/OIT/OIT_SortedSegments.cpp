@@ -0,0 +1,72 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <GL/glew.h>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <ImGui/ImGuiWrapper.hpp>
+
+#include "OIT_SortedSegments.hpp"
+#include "BufferSizeWatch.hpp"
+
+OIT_SortedSegments::OIT_SortedSegments()
+{
+    create();
+}
+
+OIT_SortedSegments::~OIT_SortedSegments()
+{
+    sgl::ShaderManager->removePreprocessorDefine("DIRECT_BLIT_GATHER"); // Remove for case that renderer is switched
+}
+
+void OIT_SortedSegments::create()
+{
+    sgl::ShaderManager->addPreprocessorDefine("DIRECT_BLIT_GATHER", "");
+    sgl::ShaderManager->addPreprocessorDefine("OIT_GATHER_HEADER", "GatherDummy.glsl");
+    gatherShader = sgl::ShaderManager->getShaderProgram(gatherShaderIDs);
+    glDisable(GL_STENCIL_TEST);
+    setCurrentAlgorithmBufferSizeBytes(0);
+}
+
+void OIT_SortedSegments::gatherBegin()
+{
+    // The segments arrive back-to-front, so they are simply blended over each other without a depth test.
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+}
+
+void OIT_SortedSegments::gatherEnd()
+{
+}
+
+void OIT_SortedSegments::renderGUI()
+{
+    ImGui::Separator();
+    ImGui::Text("CPU Sort Time: %.2f ms", lastSortTimeMS);
+}
@@ -0,0 +1,66 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_OIT_SORTEDSEGMENTS_HPP
+#define PIXELSYNCOIT_OIT_SORTEDSEGMENTS_HPP
+
+#include "OIT_Renderer.hpp"
+
+/**
+ * Renders line segments sorted back-to-front on the CPU (see SegmentSorter) with ordinary alpha blending.
+ * The order is exact per segment, not per fragment, which is usually sufficient for thin lines and needs no
+ * per-pixel fragment storage. The application sorts and uploads the index buffer before the gather pass.
+ * Other meshes are rendered unsorted.
+ */
+class OIT_SortedSegments : public OIT_Renderer
+{
+public:
+    virtual sgl::ShaderProgramPtr getGatherShader() { return gatherShader; }
+
+    OIT_SortedSegments();
+    virtual ~OIT_SortedSegments();
+    virtual void create();
+    virtual void resolutionChanged(sgl::FramebufferObjectPtr &sceneFramebuffer, sgl::TexturePtr &sceneTexture,
+            sgl::RenderbufferObjectPtr &sceneDepthRBO) {}
+
+    virtual void gatherBegin();
+    // In between "gatherBegin" and "gatherEnd", we can render our objects using the gather shader
+    virtual void gatherEnd();
+    virtual void renderToScreen() {}
+
+    virtual void renderGUI();
+
+    /// Called by the application after sorting to display the CPU time needed.
+    inline void setLastSortTimeMS(double timeMS) { lastSortTimeMS = timeMS; }
+
+private:
+    double lastSortTimeMS = 0.0;
+};
+
+#endif //PIXELSYNCOIT_OIT_SORTEDSEGMENTS_HPP
@@ -20,17 +20,19 @@ AutoPerfMeasurer::AutoPerfMeasurer(std::vector<InternalState> _states,
         const std::string &_csvFilename, const std::string &_depthComplexityFilename,
         std::function<void(const InternalState&)> _newStateCallback, bool measureTimeCoherence)
        : states(_states), currentStateIndex(0), newStateCallback(_newStateCallback), file(_csvFilename),
-         depthComplexityFile(_depthComplexityFilename), errorMetricFile("error_metrics.csv"), perfFile("performance_list.csv"), timeCoherence(measureTimeCoherence)
+         depthComplexityFile(_depthComplexityFilename), errorMetricFile("error_metrics.csv"), perfFile("performance_list.csv"),
+         cpuSortTimeFile("cpu_sort_times.csv"), timeCoherence(measureTimeCoherence)
 {
     sgl::FileUtils::get()->ensureDirectoryExists("images/");
 
     // Write header
     file.writeRow({"Name", "Average Time (ms)", "Image Filename", "Memory (GB)", "Buffer Size (GB)",
-                   "SSIM", "RMSE", "PSNR", "Time Stamp (s), Frame Time (ns)"});
+                   "SSIM", "RMSE", "PSNR", "CPU Sort Time (ms)", "Time Stamp (s), Frame Time (ns)"});
     depthComplexityFile.writeRow({"Current State", "Frame Number", "Min Depth Complexity", "Max Depth Complexity",
                                   "Avg Depth Complexity Used", "Avg Depth Complexity All", "Total Number of Fragments"});
     errorMetricFile.writeRow({"Name", "Error measures"});
     perfFile.writeRow({"Name", "Time per frame (ms)"});
+    cpuSortTimeFile.writeRow({"Name", "CPU sort time per frame (ms)"});
     setPerformanceMeasurer(this);
 
     // Set initial state
@@ -45,6 +47,7 @@ AutoPerfMeasurer::~AutoPerfMeasurer()
     depthComplexityFile.close();
     errorMetricFile.close();
     perfFile.close();
+    cpuSortTimeFile.close();
     //perfTimeProfileFile.close();
 }
 
@@ -126,6 +129,19 @@ void AutoPerfMeasurer::writeCurrentModeData()
         file.writeCell(sgl::toString(0));
 //    }
 
+    // Average CPU time needed for sorting (0 for algorithms not sorting on the CPU)
+    double averageCpuSortTimeMS = 0.0;
+    if (!cpuSortTimesMS.empty()) {
+        cpuSortTimeFile.writeCell(currentState.name);
+        for (double cpuSortTimeMS : cpuSortTimesMS) {
+            averageCpuSortTimeMS += cpuSortTimeMS;
+            cpuSortTimeFile.writeCell(sgl::toString(cpuSortTimeMS));
+        }
+        averageCpuSortTimeMS /= double(cpuSortTimesMS.size());
+        cpuSortTimeFile.newRow();
+    }
+    file.writeCell(sgl::toString(averageCpuSortTimeMS));
+
     auto performanceProfile = timerGL.getCurrentFrameTimeList();
     for (auto &perfPair : performanceProfile) {
         float timeStamp = perfPair.first;
@@ -231,6 +247,7 @@ void AutoPerfMeasurer::setNextState(bool first)
 
     depthComplexityFrameNumber = 0;
     currentAlgorithmsBufferSizeBytes = 0;
+    cpuSortTimesMS.clear();
     currentState = states.at(currentStateIndex);
     sgl::Logfile::get()->writeInfo(std::string() + "New state: " + currentState.name);
     newStateCallback(currentState);
@@ -276,6 +293,11 @@ void AutoPerfMeasurer::setCurrentAlgorithmBufferSizeBytes(size_t numBytes)
     currentAlgorithmsBufferSizeBytes = numBytes;
 }
 
+void AutoPerfMeasurer::pushCpuSortTime(double timeMS)
+{
+    cpuSortTimesMS.push_back(timeMS);
+}
+
 void AutoPerfMeasurer::saveScreenshot(const std::string &filename)
 {
     sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
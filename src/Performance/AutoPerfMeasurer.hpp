@@ -42,6 +42,9 @@ public:
     // Called by OIT algorithms
     void setCurrentAlgorithmBufferSizeBytes(size_t numBytes);
 
+    // Called by the application for modes sorting on the CPU (RENDER_MODE_OIT_SORTED_SEGMENTS)
+    void pushCpuSortTime(double timeMS);
+
 private:
     /// Write out the performance data of "currentState" to "file".
     void writeCurrentModeData();
@@ -71,8 +74,10 @@ private:
     CsvWriter depthComplexityFile;
     CsvWriter errorMetricFile;
     CsvWriter perfFile;
+    CsvWriter cpuSortTimeFile;
     size_t depthComplexityFrameNumber = 0;
     size_t currentAlgorithmsBufferSizeBytes = 0;
+    std::vector<double> cpuSortTimesMS;
 
     // For making screenshots and computing reference metrics
     sgl::FramebufferObjectPtr sceneFramebuffer;
@@ -519,6 +519,15 @@ void getTestModesRayTracing(std::vector<InternalState> &states, InternalState st
     states.push_back(state);
 }
 
+void getTestModesSortedSegments(std::vector<InternalState> &states, InternalState state)
+{
+    // The segments are only sorted for line meshes.
+    state.oitAlgorithm = RENDER_MODE_OIT_SORTED_SEGMENTS;
+    state.lineRenderingTechnique = LINE_RENDERING_TECHNIQUE_LINES;
+    state.name = std::string() + "Sorted Segments (CPU)";
+    states.push_back(state);
+}
+
 void getTestModesDepthComplexity(std::vector<InternalState> &states, InternalState state)
 {
     state.oitAlgorithm = RENDER_MODE_OIT_DEPTH_COMPLEXITY;
@@ -539,6 +548,7 @@ void getTestModesPaperForMesh(std::vector<InternalState> &states, InternalState
 //    getTestModesMBOIT(states, state);
 //    getTestModesMLABBuckets(states, state);
 //    getTestModesVoxelRaytracing(states, state);
+    getTestModesSortedSegments(states, state);
     getTestModesDepthComplexity(states, state);
 }
 
@@ -720,5 +730,8 @@ std::vector<InternalState> getAllTestModes()
     // Voxel ray casting
     getTestModesVoxelRaytracing(states, state);
 
+    // Back-to-front sorting of the line segments on the CPU
+    getTestModesSortedSegments(states, state);
+
     return states;
 }
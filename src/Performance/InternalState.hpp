@@ -13,7 +13,8 @@
 const int NUM_OIT_MODES = 11;
 const char *const OIT_MODE_NAMES[] = {
         "K-Buffer", "Linked List", "Multi-layer Alpha Blending", "Hybrid Transparency", "Moment-Based OIT", "WBOIT",
-        "Depth Complexity", "No OIT", "Depth Peeling", "MLAB (Buckets)", "Voxel Ray Casting (Lines)", "Ray Tracing"
+        "Depth Complexity", "No OIT", "Depth Peeling", "MLAB (Buckets)", "Voxel Ray Casting (Lines)", "Ray Tracing",
+        "Sorted Segments (CPU)"
 };
 enum RenderModeOIT {
     RENDER_MODE_OIT_KBUFFER = 0,
@@ -28,6 +29,7 @@ enum RenderModeOIT {
     RENDER_MODE_OIT_MLAB_BUCKET,
     RENDER_MODE_VOXEL_RAYTRACING_LINES,
     RENDER_MODE_RAYTRACING,
+    RENDER_MODE_OIT_SORTED_SEGMENTS, // Back-to-front sorting of line segments on the CPU
     RENDER_MODE_TEST_PIXEL_SYNC_PERFORMANCE
 };
 
@@ -37,6 +39,7 @@ const char *const MODEL_FILENAMES[] = {
         "Data/IsoSurfaces/rm-80-isosurface.bobj",
         "Data/PointDatasets/0.000xv000.dat",
         "Data/PointDatasets/0.000xv001.dat",
+        "Data/PointDatasets/CosmicWeb",
         "Data/PointDatasets/OFC-wasatch-50Mpps.uda.001/t06002/timestep.xml",
         "Data/Rings/rings.obj",
         "Data/Trajectories/9213_streamlines.obj",
@@ -44,6 +47,7 @@ const char *const MODEL_FILENAMES[] = {
         "Data/ConvectionRolls/turbulence80000.obj",
         "Data/ConvectionRolls/turbulence20000.obj",
         "Data/Hair/ponytail.hair",
+        "Data/Hair/ponytail_guides.ghair",
         "Data/Trajectories/single_streamline.obj",
         "Data/Trajectories/torus.obj",
         "Data/Trajectories/tornado.obj",
@@ -85,6 +89,7 @@ const char *const MODEL_DISPLAYNAMES[] = {
         "Meshkov (80)",
         "Cosmic Web 0",
         "Cosmic Web 1",
+        "Cosmic Web (All Bricks)",
         "Uintah Particle Data Set",
         "Rings",
         "Aneurysm",
@@ -92,6 +97,7 @@ const char *const MODEL_DISPLAYNAMES[] = {
         "Turbulence",
         "Convection Rolls Small",
         "Hair",
+        "Hair (Guide Strands)",
         "Single Streamline",
         "Torus",
         "Tornado",
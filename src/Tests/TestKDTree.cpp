@@ -0,0 +1,192 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "../Utils/KDTree.hpp"
+#include "TestUtils.hpp"
+#include "TestKDTree.hpp"
+
+static void createRandomPoints(size_t numPoints, std::vector<glm::vec3> &positions)
+{
+    std::mt19937 generator = createTestRandomGenerator();
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    positions.resize(numPoints);
+    for (size_t i = 0; i < numPoints; i++) {
+        positions[i] = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+    }
+}
+
+/// Returns the sorted Point::index values of the passed points.
+static std::vector<int> getSortedIndices(const std::vector<Point> &points)
+{
+    std::vector<int> indices;
+    indices.reserve(points.size());
+    for (const Point &point : points) {
+        indices.push_back(point.index);
+    }
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+bool testKDTreeQueries()
+{
+    const size_t NUM_POINTS = 20000;
+    const size_t NUM_QUERIES = 200;
+    const size_t K = 10;
+    const float RADIUS = 0.05f;
+    std::vector<glm::vec3> positions;
+    createRandomPoints(NUM_POINTS, positions);
+    KDTree kdTree;
+    kdTree.build(positions);
+
+    std::mt19937 generator = createTestRandomGenerator(1);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    size_t numMismatches = 0;
+    std::vector<Point> foundPoints;
+    for (size_t queryIdx = 0; queryIdx < NUM_QUERIES; queryIdx++) {
+        glm::vec3 center(distribution(generator), distribution(generator), distribution(generator));
+        Rectangle rect;
+        rect.min = center - glm::vec3(RADIUS);
+        rect.max = center + glm::vec3(RADIUS);
+
+        // Brute force reference
+        std::vector<int> rectangleIndices, radiusIndices;
+        std::vector<std::pair<float, int>> distances(NUM_POINTS);
+        for (size_t i = 0; i < NUM_POINTS; i++) {
+            if (rect.contains(positions[i])) {
+                rectangleIndices.push_back(int(i));
+            }
+            float distance = glm::length(positions[i] - center);
+            if (distance <= RADIUS) {
+                radiusIndices.push_back(int(i));
+            }
+            distances[i] = std::make_pair(distance, int(i));
+        }
+        std::sort(distances.begin(), distances.end());
+
+        kdTree.findPointsInRectangle(rect, foundPoints);
+        if (getSortedIndices(foundPoints) != rectangleIndices) {
+            numMismatches++;
+        }
+        kdTree.findPointsInRadius(center, RADIUS, foundPoints);
+        if (getSortedIndices(foundPoints) != radiusIndices) {
+            numMismatches++;
+        }
+        // Compare the distances, as points with equal distances may be returned in any order.
+        kdTree.findKNearestNeighbors(center, K, foundPoints);
+        bool kNearestNeighborsMatch = foundPoints.size() == K;
+        for (size_t i = 0; kNearestNeighborsMatch && i < K; i++) {
+            kNearestNeighborsMatch = glm::length(foundPoints[i].position - center) == distances[i].first;
+        }
+        if (!kNearestNeighborsMatch) {
+            numMismatches++;
+        }
+        const Point *closestPoint = kdTree.findCloseIndexedPoint(center, RADIUS);
+        bool hasClosestPoint = distances.front().first < RADIUS;
+        if ((closestPoint != NULL) != hasClosestPoint || (closestPoint != NULL
+                && glm::length(closestPoint->position - center) != distances.front().first)) {
+            numMismatches++;
+        }
+    }
+
+    if (numMismatches != 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in testKDTreeQueries: "
+                + sgl::toString(numMismatches) + " queries differ from the brute force search.");
+        return false;
+    }
+    sgl::Logfile::get()->writeInfo("testKDTreeQueries: Passed.");
+    return true;
+}
+
+void benchmarkKDTree(size_t numPoints, size_t numQueries)
+{
+    std::vector<glm::vec3> positions;
+    createRandomPoints(numPoints, positions);
+
+    // Query rectangles containing about 100 points each.
+    const float extent = std::cbrt(100.0f / float(numPoints));
+    std::mt19937 generator = createTestRandomGenerator(1);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f - extent);
+    std::vector<Rectangle> queries(numQueries);
+    for (Rectangle &rect : queries) {
+        rect.min = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+        rect.max = rect.min + glm::vec3(extent);
+    }
+
+    KDTree kdTree;
+    double buildTimeMS = measureBestTimeMS([&]() { kdTree.build(positions); });
+    size_t numFoundPoints = 0;
+    std::vector<Point> foundPoints;
+    double queryTimeMS = measureBestTimeMS([&]() {
+        numFoundPoints = 0;
+        for (const Rectangle &rect : queries) {
+            kdTree.findPointsInRectangle(rect, foundPoints);
+            numFoundPoints += foundPoints.size();
+        }
+    });
+
+    // A brute force search over all points is only run for a subset of the queries, as it scales with numPoints.
+    const size_t numBruteForceQueries = std::min(numQueries, size_t(100));
+    size_t numFoundPointsSubset = 0, numBruteForcePoints = 0;
+    for (size_t queryIdx = 0; queryIdx < numBruteForceQueries; queryIdx++) {
+        kdTree.findPointsInRectangle(queries[queryIdx], foundPoints);
+        numFoundPointsSubset += foundPoints.size();
+    }
+    double bruteForceQueryTimeMS = measureBestTimeMS([&]() {
+        numBruteForcePoints = 0;
+        for (size_t queryIdx = 0; queryIdx < numBruteForceQueries; queryIdx++) {
+            for (const glm::vec3 &position : positions) {
+                if (queries[queryIdx].contains(position)) {
+                    numBruteForcePoints++;
+                }
+            }
+        }
+    }, 1);
+
+    if (numFoundPointsSubset != numBruteForcePoints) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkKDTree: The tree found "
+                + sgl::toString(numFoundPointsSubset) + " points, the brute force search "
+                + sgl::toString(numBruteForcePoints) + " points.");
+    }
+
+    double queryTimeUS = queryTimeMS * 1000.0 / double(std::max(numQueries, size_t(1)));
+    double bruteForceQueryTimeUS = bruteForceQueryTimeMS * 1000.0 / double(std::max(numBruteForceQueries, size_t(1)));
+    sgl::Logfile::get()->writeInfo(std::string() + "benchmarkKDTree: " + sgl::toString(numPoints) + " points, "
+            + sgl::toString(numQueries) + " rectangle queries (" + sgl::toString(numFoundPoints) + " points found).");
+    sgl::Logfile::get()->writeInfo(std::string() + "benchmarkKDTree: Build: " + sgl::toString(buildTimeMS) + " ms");
+    sgl::Logfile::get()->writeInfo(std::string() + "benchmarkKDTree: Query: " + sgl::toString(bruteForceQueryTimeUS)
+            + " us (brute force) -> " + sgl::toString(queryTimeUS) + " us (KD-tree), speedup "
+            + sgl::toString(bruteForceQueryTimeUS / queryTimeUS));
+}
@@ -0,0 +1,147 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <vector>
+#include <omp.h>
+
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "../Utils/MeshAdjacency.hpp"
+#include "TestUtils.hpp"
+#include "TestMeshAdjacency.hpp"
+
+/**
+ * Creates a random triangle list. Every 16th triangle references vertex 0, which makes it a high-valence vertex with
+ * many concurrent increments, and every 32nd triangle is degenerate (references one vertex twice).
+ */
+static void createRandomTriangles(size_t numVertices, size_t numTriangles, std::vector<uint32_t> &indices)
+{
+    std::mt19937 generator = createTestRandomGenerator();
+    std::uniform_int_distribution<uint32_t> vertexDistribution(0, uint32_t(numVertices - 1));
+    indices.resize(numTriangles * 3);
+    for (size_t triangleIdx = 0; triangleIdx < numTriangles; triangleIdx++) {
+        uint32_t *triangle = &indices[triangleIdx * 3];
+        for (int i = 0; i < 3; i++) {
+            triangle[i] = vertexDistribution(generator);
+        }
+        if (triangleIdx % 16 == 0) {
+            triangle[0] = 0;
+        }
+        if (triangleIdx % 32 == 0) {
+            triangle[2] = triangle[1];
+        }
+    }
+}
+
+/// Builds the adjacency with numThreads OpenMP threads.
+static void buildVertexTriangleAdjacencyWithThreads(
+        int numThreads, size_t numVertices, const std::vector<uint32_t> &indices, VertexTriangleAdjacency &adjacency)
+{
+    const int maxNumThreads = omp_get_max_threads();
+    omp_set_num_threads(numThreads);
+    buildVertexTriangleAdjacency(numVertices, indices, adjacency);
+    omp_set_num_threads(maxNumThreads);
+}
+
+bool testVertexTriangleAdjacencyDeterminism(int numThreads)
+{
+    const size_t numVertices = 10000;
+    const size_t numTriangles = 200000;
+    std::vector<uint32_t> indices;
+    createRandomTriangles(numVertices, numTriangles, indices);
+
+    // Sequential reference: Appending the triangles in index order keeps the triangles of each vertex sorted.
+    std::vector<std::vector<uint32_t>> vertexTriangles(numVertices);
+    for (size_t j = 0; j < indices.size(); j++) {
+        vertexTriangles[indices[j]].push_back(uint32_t(j / 3));
+    }
+    VertexTriangleAdjacency referenceAdjacency;
+    referenceAdjacency.triangleOffsets.push_back(0);
+    for (size_t i = 0; i < numVertices; i++) {
+        referenceAdjacency.triangleIndices.insert(
+                referenceAdjacency.triangleIndices.end(), vertexTriangles[i].begin(), vertexTriangles[i].end());
+        referenceAdjacency.triangleOffsets.push_back(uint32_t(referenceAdjacency.triangleIndices.size()));
+    }
+
+    VertexTriangleAdjacency singleThreadedAdjacency, multiThreadedAdjacency;
+    buildVertexTriangleAdjacencyWithThreads(1, numVertices, indices, singleThreadedAdjacency);
+    buildVertexTriangleAdjacencyWithThreads(numThreads, numVertices, indices, multiThreadedAdjacency);
+
+    bool testPassed = true;
+    if (singleThreadedAdjacency.triangleOffsets != referenceAdjacency.triangleOffsets
+            || singleThreadedAdjacency.triangleIndices != referenceAdjacency.triangleIndices) {
+        sgl::Logfile::get()->writeError("Error in testVertexTriangleAdjacencyDeterminism: The adjacency built with "
+                "one thread differs from the sequential reference.");
+        testPassed = false;
+    }
+    if (multiThreadedAdjacency.triangleOffsets != singleThreadedAdjacency.triangleOffsets
+            || multiThreadedAdjacency.triangleIndices != singleThreadedAdjacency.triangleIndices) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in testVertexTriangleAdjacencyDeterminism: The "
+                + "adjacency built with " + sgl::toString(numThreads) + " threads differs from the one built with "
+                + "one thread.");
+        testPassed = false;
+    }
+    if (testPassed) {
+        sgl::Logfile::get()->writeInfo(std::string() + "testVertexTriangleAdjacencyDeterminism: Passed (1 and "
+                + sgl::toString(numThreads) + " threads).");
+    }
+    return testPassed;
+}
+
+void benchmarkVertexTriangleAdjacency(size_t numTriangles)
+{
+    // About two triangles per vertex like in a closed triangle mesh.
+    const size_t numVertices = numTriangles / 2;
+    std::vector<uint32_t> indices;
+    createRandomTriangles(numVertices, numTriangles, indices);
+    sgl::Logfile::get()->writeInfo(std::string() + "benchmarkVertexTriangleAdjacency: "
+            + sgl::toString(numVertices) + " vertices, " + sgl::toString(numTriangles) + " triangles.");
+
+    std::vector<int> threadCounts;
+    const int maxNumThreads = omp_get_max_threads();
+    for (int numThreads = 1; numThreads < maxNumThreads; numThreads *= 2) {
+        threadCounts.push_back(numThreads);
+    }
+    threadCounts.push_back(maxNumThreads);
+
+    double singleThreadedTimeMS = 0.0;
+    for (int numThreads : threadCounts) {
+        VertexTriangleAdjacency adjacency;
+        double bestTimeMS = measureBestTimeMS([&]() {
+            buildVertexTriangleAdjacencyWithThreads(numThreads, numVertices, indices, adjacency);
+        });
+        if (numThreads == 1) {
+            singleThreadedTimeMS = bestTimeMS;
+        }
+        sgl::Logfile::get()->writeInfo(std::string() + "benchmarkVertexTriangleAdjacency: "
+                + sgl::toString(numThreads) + " thread(s): " + sgl::toString(bestTimeMS) + " ms (speedup "
+                + sgl::toString(singleThreadedTimeMS / bestTimeMS) + ")");
+    }
+}
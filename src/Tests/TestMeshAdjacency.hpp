@@ -0,0 +1,49 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_TESTMESHADJACENCY_HPP
+#define PIXELSYNCOIT_TESTMESHADJACENCY_HPP
+
+#include <cstddef>
+
+/**
+ * Checks that buildVertexTriangleAdjacency returns the same table with one thread and with numThreads threads, and
+ * that this table matches a sequential reference construction. The test mesh contains high-valence vertices and
+ * triangles referencing a vertex more than once. Mismatches are written to the log file.
+ * @return True if the test passed.
+ */
+bool testVertexTriangleAdjacencyDeterminism(int numThreads);
+
+/**
+ * Measures buildVertexTriangleAdjacency on a random mesh with numTriangles triangles for 1, 2, 4, ... threads up to
+ * the number of available threads and writes the times and speedups to the log file.
+ */
+void benchmarkVertexTriangleAdjacency(size_t numTriangles);
+
+#endif //PIXELSYNCOIT_TESTMESHADJACENCY_HPP
@@ -0,0 +1,65 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifndef PIXELSYNCOIT_TESTUTILS_HPP
+#define PIXELSYNCOIT_TESTUTILS_HPP
+
+#include <random>
+#include <limits>
+#include <chrono>
+#include <algorithm>
+
+/**
+ * Returns the random number generator for the test data. The seed is fixed such that every run of the tests and
+ * benchmarks uses the same data. Different streams can be used for independent data (e.g., points and queries).
+ */
+inline std::mt19937 createTestRandomGenerator(unsigned int stream = 0)
+{
+    return std::mt19937(17u + stream);
+}
+
+/**
+ * Calls function numRuns times and returns the best time in milliseconds. Taking the best of several runs reduces the
+ * influence of other processes on the benchmarks.
+ */
+template<typename Function>
+double measureBestTimeMS(Function function, int numRuns = 5)
+{
+    double bestTimeMS = std::numeric_limits<double>::max();
+    for (int run = 0; run < numRuns; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        auto end = std::chrono::high_resolution_clock::now();
+        bestTimeMS = std::min(bestTimeMS, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return bestTimeMS;
+}
+
+#endif //PIXELSYNCOIT_TESTUTILS_HPP
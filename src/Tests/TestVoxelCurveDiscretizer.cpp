@@ -0,0 +1,227 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "../VoxelRaytracing/VoxelCurveDiscretizer.hpp"
+#include "TestUtils.hpp"
+#include "TestVoxelCurveDiscretizer.hpp"
+
+/**
+ * Creates random walks with numPoints points each, which start in the grid and take steps of at most maxStepLength
+ * voxels along each axis. Every 8th step is parallel to the planes of one axis.
+ */
+static void createRandomCurves(
+        const glm::ivec3 &gridResolution, size_t numCurves, size_t numPoints, float maxStepLength,
+        std::vector<Curve> &curves)
+{
+    std::mt19937 generator = createTestRandomGenerator();
+    std::uniform_real_distribution<float> startDistribution(0.0f, 1.0f);
+    std::uniform_real_distribution<float> stepDistribution(-maxStepLength, maxStepLength);
+    curves.resize(numCurves);
+    for (size_t curveIdx = 0; curveIdx < numCurves; curveIdx++) {
+        Curve &curve = curves[curveIdx];
+        curve.lineID = (unsigned int)curveIdx;
+        glm::vec3 point = glm::vec3(startDistribution(generator), startDistribution(generator),
+                startDistribution(generator)) * glm::vec3(gridResolution);
+        for (size_t i = 0; i < numPoints; i++) {
+            curve.points.push_back(point);
+            curve.attributes.push_back(float(i));
+            glm::vec3 step(stepDistribution(generator), stepDistribution(generator), stepDistribution(generator));
+            if (i % 8 == 7) {
+                step[(i / 8) % 3] = 0.0f;
+            }
+            point += step;
+        }
+    }
+}
+
+/**
+ * Clips the ray origin + t * direction to the slab [lower, upper] of one axis by updating the range [tNear, tFar].
+ * Returns false if the range is empty.
+ */
+static bool clipToSlab(float origin, float direction, float lower, float upper, float &tNear, float &tFar)
+{
+    if (direction == 0.0f) {
+        return lower <= origin && origin <= upper;
+    }
+    float t0 = (lower - origin) / direction;
+    float t1 = (upper - origin) / direction;
+    if (t0 > t1) {
+        std::swap(t0, t1);
+    }
+    tNear = std::max(tNear, t0);
+    tFar = std::min(tFar, t1);
+    return tNear <= tFar;
+}
+
+/**
+ * Brute force voxelization: All voxels in the bounding box of a segment are tested for an intersection with the
+ * segment, and the points where the segment enters and leaves a voxel are added to the voxel. Like in
+ * VoxelCurveDiscretizer::discretizeCurve, consecutive pairs of these points form the clipped segments of a voxel.
+ */
+static void discretizeCurveBruteForce(
+        const glm::ivec3 &gridResolution, const Curve &curve, std::vector<VoxelLineSegment> &voxelLineSegments)
+{
+    std::map<uint32_t, std::vector<AttributePoint>> curveIntersections;
+    for (size_t i = 0; i + 1 < curve.points.size(); i++) {
+        const glm::vec3 &v1 = curve.points[i];
+        const glm::vec3 &v2 = curve.points[i+1];
+        const float a1 = curve.attributes[i], a2 = curve.attributes[i+1];
+        const glm::vec3 direction = v2 - v1;
+        glm::ivec3 lower = glm::max(glm::ivec3(glm::floor(glm::min(v1, v2))), glm::ivec3(0));
+        glm::ivec3 upper = glm::min(glm::ivec3(glm::floor(glm::max(v1, v2))), gridResolution - glm::ivec3(1));
+        for (int z = lower.z; z <= upper.z; z++) {
+            for (int y = lower.y; y <= upper.y; y++) {
+                for (int x = lower.x; x <= upper.x; x++) {
+                    glm::vec3 voxelLower(x, y, z);
+                    float tNear = -FLT_MAX, tFar = FLT_MAX;
+                    bool intersects = true;
+                    for (int axis = 0; intersects && axis < 3; axis++) {
+                        intersects = clipToSlab(v1[axis], direction[axis], voxelLower[axis],
+                                voxelLower[axis] + 1.0f, tNear, tFar);
+                    }
+                    if (!intersects) {
+                        continue;
+                    }
+                    uint32_t voxelIndex = uint32_t(x + (y + z * gridResolution.y) * gridResolution.x);
+                    if (0.0f <= tNear && tNear <= 1.0f) {
+                        curveIntersections[voxelIndex].push_back(
+                                AttributePoint(v1 + tNear * direction, a1 + tNear * (a2 - a1)));
+                    }
+                    if (0.0f <= tFar && tFar <= 1.0f) {
+                        curveIntersections[voxelIndex].push_back(
+                                AttributePoint(v1 + tFar * direction, a1 + tFar * (a2 - a1)));
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto &voxelIntersections : curveIntersections) {
+        std::vector<AttributePoint> &intersections = voxelIntersections.second;
+        for (size_t i = 0; i + 1 < intersections.size(); i += 2) {
+            voxelLineSegments.push_back(VoxelLineSegment(voxelIntersections.first, LineSegment(
+                    intersections[i].v, intersections[i].a, intersections[i+1].v, intersections[i+1].a,
+                    curve.lineID)));
+        }
+    }
+}
+
+/// Sums up the lengths of the clipped segments in each voxel.
+static std::map<uint32_t, float> computeVoxelLineLengths(std::vector<VoxelLineSegment> &voxelLineSegments)
+{
+    std::map<uint32_t, float> voxelLineLengths;
+    for (VoxelLineSegment &voxelLineSegment : voxelLineSegments) {
+        voxelLineLengths[voxelLineSegment.voxelIndex] += voxelLineSegment.line.length();
+    }
+    return voxelLineLengths;
+}
+
+bool testVoxelCurveDiscretization()
+{
+    const glm::ivec3 gridResolution(32, 24, 16);
+    std::vector<Curve> curves;
+    createRandomCurves(gridResolution, 500, 100, 2.0f, curves);
+    VoxelCurveDiscretizer discretizer(gridResolution);
+
+    // Segments touching a voxel only in a point or an edge may be missed by one of the two methods due to rounding.
+    // Thus, the line lengths in the voxels are compared instead of the clipped segments themselves.
+    const float EPSILON = 1e-3f;
+    size_t numMismatches = 0;
+    std::vector<VoxelLineSegment> voxelLineSegments, referenceVoxelLineSegments;
+    for (const Curve &curve : curves) {
+        voxelLineSegments.clear();
+        referenceVoxelLineSegments.clear();
+        discretizer.discretizeCurve(curve, voxelLineSegments);
+        discretizeCurveBruteForce(gridResolution, curve, referenceVoxelLineSegments);
+
+        std::map<uint32_t, float> voxelLineLengths = computeVoxelLineLengths(voxelLineSegments);
+        std::map<uint32_t, float> referenceVoxelLineLengths = computeVoxelLineLengths(referenceVoxelLineSegments);
+        for (auto &voxelLineLength : referenceVoxelLineLengths) {
+            voxelLineLengths[voxelLineLength.first] -= voxelLineLength.second;
+        }
+        for (auto &voxelLineLength : voxelLineLengths) {
+            if (std::abs(voxelLineLength.second) > EPSILON) {
+                numMismatches++;
+            }
+        }
+    }
+
+    if (numMismatches != 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in testVoxelCurveDiscretization: "
+                + sgl::toString(numMismatches) + " voxels differ from the brute force voxelization.");
+        return false;
+    }
+    sgl::Logfile::get()->writeInfo("testVoxelCurveDiscretization: Passed.");
+    return true;
+}
+
+void benchmarkVoxelCurveDiscretization(size_t numCurves)
+{
+    const glm::ivec3 gridResolution(256, 256, 256);
+    const size_t NUM_POINTS = 100;
+    std::vector<Curve> curves;
+    createRandomCurves(gridResolution, numCurves, NUM_POINTS, 4.0f, curves);
+    VoxelCurveDiscretizer discretizer(gridResolution);
+
+    size_t numLineSegments = 0, numReferenceLineSegments = 0;
+    std::vector<VoxelLineSegment> voxelLineSegments;
+    double timeMS = measureBestTimeMS([&]() {
+        numLineSegments = 0;
+        for (const Curve &curve : curves) {
+            voxelLineSegments.clear();
+            discretizer.discretizeCurve(curve, voxelLineSegments);
+            numLineSegments += voxelLineSegments.size();
+        }
+    });
+    double bruteForceTimeMS = measureBestTimeMS([&]() {
+        numReferenceLineSegments = 0;
+        for (const Curve &curve : curves) {
+            voxelLineSegments.clear();
+            discretizeCurveBruteForce(gridResolution, curve, voxelLineSegments);
+            numReferenceLineSegments += voxelLineSegments.size();
+        }
+    });
+
+    sgl::Logfile::get()->writeInfo(std::string() + "benchmarkVoxelCurveDiscretization: " + sgl::toString(numCurves)
+            + " curves, " + sgl::toString(numLineSegments) + " clipped segments (brute force: "
+            + sgl::toString(numReferenceLineSegments) + ").");
+    sgl::Logfile::get()->writeInfo(std::string() + "benchmarkVoxelCurveDiscretization: "
+            + sgl::toString(bruteForceTimeMS) + " ms (brute force) -> " + sgl::toString(timeMS)
+            + " ms (3D-DDA), speedup " + sgl::toString(bruteForceTimeMS / timeMS));
+}
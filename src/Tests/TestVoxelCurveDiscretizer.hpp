@@ -0,0 +1,51 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifndef PIXELSYNCOIT_TESTVOXELCURVEDISCRETIZER_HPP
+#define PIXELSYNCOIT_TESTVOXELCURVEDISCRETIZER_HPP
+
+#include <cstddef>
+
+/**
+ * Compares the clipped line segments VoxelCurveDiscretizer::discretizeCurve computes with its 3D-DDA traversal with
+ * the ones of a brute force voxelization testing all voxels in the bounding box of each segment for an intersection.
+ * The random curves leave the grid and contain segments parallel to the voxel planes. Mismatches are written to the
+ * log file.
+ * @return True if the test passed.
+ */
+bool testVoxelCurveDiscretization();
+
+/**
+ * Measures voxelizing numCurves random curves in a 256^3 grid with VoxelCurveDiscretizer::discretizeCurve and with the
+ * brute force voxelization (see testVoxelCurveDiscretization) and writes the times and the speedup to the log file.
+ */
+void benchmarkVoxelCurveDiscretization(size_t numCurves);
+
+#endif //PIXELSYNCOIT_TESTVOXELCURVEDISCRETIZER_HPP
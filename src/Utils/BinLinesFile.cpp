@@ -0,0 +1,354 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/Convert.hpp>
+
+#include "BinLinesFile.hpp"
+
+static inline uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + BINLINES_ARRAY_ALIGNMENT - 1) / BINLINES_ARRAY_ALIGNMENT * BINLINES_ARRAY_ALIGNMENT;
+}
+
+/**
+ * The line summaries directly follow the attribute arrays, so no header field is needed for them.
+ */
+static inline uint64_t getLineSummariesStart(const BinLinesHeader &header)
+{
+    return alignOffset(header.attributesStart + uint64_t(header.numAttributes) * header.numPoints * sizeof(float));
+}
+
+/**
+ * @return True if the array of numElements elements of elementSize bytes starting at the passed byte offset is aligned
+ * and lies within the file of the passed size.
+ */
+static inline bool isArrayInFile(uint64_t start, uint64_t numElements, uint64_t elementSize, uint64_t fileSize)
+{
+    if (start % BINLINES_ARRAY_ALIGNMENT != 0 || start > fileSize) {
+        return false;
+    }
+    return elementSize == 0 || numElements <= (fileSize - start) / elementSize;
+}
+
+bool BinLinesFile::open(const std::string &filename)
+{
+    close();
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    const uint8_t *data = file.getData();
+    const size_t size = file.getSize();
+    if (size < sizeof(BinLinesHeader)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in BinLinesFile::open: File \""
+                + filename + "\" is too small.");
+        file.close();
+        return false;
+    }
+
+    const BinLinesHeader *fileHeader = (const BinLinesHeader*)data;
+    if (fileHeader->formatVersion != BINLINES_FORMAT_VERSION_CSR) {
+        // Not an error, as e.g. loadTrajectoriesFromBinLines uses this function to test for the format version.
+        file.close();
+        return false;
+    }
+
+    // Check that all arrays are aligned and lie within the file. The array sizes are compared without multiplying
+    // the (untrusted) element counts to avoid overflows.
+    const uint64_t numLines = fileHeader->numLines;
+    const uint64_t numPoints = fileHeader->numPoints;
+    const uint64_t numAttributes = fileHeader->numAttributes;
+    bool isValid =
+            numLines < size / sizeof(uint64_t)
+            && isArrayInFile(fileHeader->lineOffsetsStart, numLines + 1, sizeof(uint64_t), size)
+            && isArrayInFile(fileHeader->positionsStart, numPoints, sizeof(glm::vec3), size)
+            && isArrayInFile(fileHeader->attributesStart, numAttributes, numPoints * sizeof(float), size);
+    const uint64_t lineSummariesStart = isValid ? getLineSummariesStart(*fileHeader) : 0;
+    if (isValid && (fileHeader->flags & BINLINES_FLAG_HAS_LINE_SUMMARIES) != 0) {
+        isValid = isArrayInFile(lineSummariesStart, numAttributes, numLines * sizeof(LineAttributeSummary), size);
+    }
+    if (isValid) {
+        // The line offsets need to be non-decreasing and cover all points, as they are used to index the arrays.
+        const uint64_t *fileLineOffsets = (const uint64_t*)(data + fileHeader->lineOffsetsStart);
+        isValid = fileLineOffsets[0] == 0 && fileLineOffsets[numLines] == numPoints;
+        for (uint64_t lineIdx = 0; isValid && lineIdx < numLines; lineIdx++) {
+            isValid = fileLineOffsets[lineIdx] <= fileLineOffsets[lineIdx + 1];
+        }
+    }
+    if (!isValid) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in BinLinesFile::open: Invalid header in file \""
+                + filename + "\".");
+        file.close();
+        return false;
+    }
+
+    header = fileHeader;
+    lineOffsets = (const uint64_t*)(data + header->lineOffsetsStart);
+    positions = (const glm::vec3*)(data + header->positionsStart);
+    attributes = (const float*)(data + header->attributesStart);
+    if (hasLineSummaries()) {
+        lineSummaries = (const LineAttributeSummary*)(data + lineSummariesStart);
+    }
+    return true;
+}
+
+void BinLinesFile::close()
+{
+    file.close();
+    header = NULL;
+    lineOffsets = NULL;
+    positions = NULL;
+    attributes = NULL;
+    lineSummaries = NULL;
+}
+
+TrajectoryNormalization BinLinesFile::getNormalization() const
+{
+    TrajectoryNormalization normalization;
+    normalization.boundingBox = sgl::AABB3(header->boundingBoxMin, header->boundingBoxMax);
+    normalization.normalizePositions = header->normalizePositions != 0;
+    normalization.minVec = header->minVec;
+    normalization.maxVec = header->maxVec;
+    normalization.positionOffset = header->positionOffset;
+    normalization.normalizeAttribute = header->normalizeAttribute != 0;
+    normalization.minAttribute = header->minAttribute;
+    normalization.maxAttribute = header->maxAttribute;
+    return normalization;
+}
+
+Trajectories BinLinesFile::toTrajectories() const
+{
+    Trajectories trajectories;
+    const size_t numLines = header->numLines;
+    const uint32_t numAttributes = header->numAttributes;
+    trajectories.resize(numLines);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        Trajectory &trajectory = trajectories[lineIdx];
+        const uint64_t lineStart = lineOffsets[lineIdx];
+        const uint64_t lineEnd = lineOffsets[lineIdx + 1];
+        trajectory.positions.assign(positions + lineStart, positions + lineEnd);
+        trajectory.attributes.resize(numAttributes);
+        for (uint32_t attributeIdx = 0; attributeIdx < numAttributes; attributeIdx++) {
+            const float *attribute = getAttribute(attributeIdx);
+            trajectory.attributes[attributeIdx].assign(attribute + lineStart, attribute + lineEnd);
+        }
+    }
+
+    return trajectories;
+}
+
+
+/**
+ * Writes zero bytes to the file until the file position is a multiple of BINLINES_ARRAY_ALIGNMENT.
+ */
+static void writePadding(FILE *file, uint64_t &filePosition)
+{
+    static const uint8_t zeros[BINLINES_ARRAY_ALIGNMENT] = { 0 };
+    uint64_t paddingSize = alignOffset(filePosition) - filePosition;
+    if (paddingSize > 0) {
+        fwrite(zeros, 1, paddingSize, file);
+        filePosition += paddingSize;
+    }
+}
+
+bool writeBinLinesFile(
+        const std::string &filename, const Trajectories &trajectories, TrajectoryType trajectoryType,
+        const TrajectoryNormalization &normalization)
+{
+    const size_t numLines = trajectories.size();
+    uint32_t numAttributes = 0;
+    for (const Trajectory &trajectory : trajectories) {
+        if (!trajectory.positions.empty()) {
+            numAttributes = uint32_t(trajectory.attributes.size());
+            break;
+        }
+    }
+
+    // Prefix sum over the number of points of all lines.
+    std::vector<uint64_t> lineOffsets(numLines + 1);
+    lineOffsets[0] = 0;
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        lineOffsets[lineIdx + 1] = lineOffsets[lineIdx] + trajectories[lineIdx].positions.size();
+    }
+    const uint64_t numPoints = lineOffsets[numLines];
+
+    BinLinesHeader header;
+    memset(&header, 0, sizeof(BinLinesHeader));
+    header.formatVersion = BINLINES_FORMAT_VERSION_CSR;
+    header.flags = BINLINES_FLAG_HAS_NORMALIZATION | BINLINES_FLAG_HAS_LINE_SUMMARIES;
+    header.trajectoryType = uint32_t(trajectoryType);
+    header.numAttributes = numAttributes;
+    header.numLines = numLines;
+    header.numPoints = numPoints;
+    header.lineOffsetsStart = alignOffset(sizeof(BinLinesHeader));
+    header.positionsStart = alignOffset(header.lineOffsetsStart + (numLines + 1) * sizeof(uint64_t));
+    header.attributesStart = alignOffset(header.positionsStart + numPoints * sizeof(glm::vec3));
+    header.normalizePositions = normalization.normalizePositions ? 1u : 0u;
+    header.normalizeAttribute = normalization.normalizeAttribute ? 1u : 0u;
+    header.boundingBoxMin = normalization.boundingBox.getMinimum();
+    header.boundingBoxMax = normalization.boundingBox.getMaximum();
+    header.minVec = normalization.minVec;
+    header.maxVec = normalization.maxVec;
+    header.positionOffset = normalization.positionOffset;
+    header.minAttribute = normalization.minAttribute;
+    header.maxAttribute = normalization.maxAttribute;
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in writeBinLinesFile: File \""
+                + filename + "\" couldn't be opened for writing.");
+        return false;
+    }
+
+    uint64_t filePosition = 0;
+    fwrite(&header, sizeof(BinLinesHeader), 1, file);
+    filePosition += sizeof(BinLinesHeader);
+    writePadding(file, filePosition);
+
+    fwrite(&lineOffsets.front(), sizeof(uint64_t), numLines + 1, file);
+    filePosition += (numLines + 1) * sizeof(uint64_t);
+    writePadding(file, filePosition);
+
+    // Gather the positions into one contiguous array in parallel.
+    if (numPoints > 0) {
+        std::vector<glm::vec3> positions(numPoints);
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            const std::vector<glm::vec3> &linePositions = trajectories[lineIdx].positions;
+            std::copy(linePositions.begin(), linePositions.end(), positions.begin() + lineOffsets[lineIdx]);
+        }
+        fwrite(&positions.front(), sizeof(glm::vec3), numPoints, file);
+        filePosition += numPoints * sizeof(glm::vec3);
+    }
+    writePadding(file, filePosition);
+
+    // Gather one attribute at a time to bound the memory overhead.
+    std::vector<LineAttributeSummary> lineSummaries(size_t(numAttributes) * numLines);
+    if (numPoints > 0) {
+        std::vector<float> attributeValues(numPoints);
+        for (uint32_t attributeIdx = 0; attributeIdx < numAttributes; attributeIdx++) {
+            #pragma omp parallel for schedule(dynamic, 64)
+            for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+                const Trajectory &trajectory = trajectories[lineIdx];
+                if (trajectory.positions.empty()) {
+                    continue;
+                }
+                const std::vector<float> &lineAttribute = trajectory.attributes.at(attributeIdx);
+                std::copy(lineAttribute.begin(), lineAttribute.end(), attributeValues.begin() + lineOffsets[lineIdx]);
+            }
+            fwrite(&attributeValues.front(), sizeof(float), numPoints, file);
+            filePosition += numPoints * sizeof(float);
+            computeLineAttributeSummaries(
+                    &lineOffsets.front(), numLines, &attributeValues.front(),
+                    &lineSummaries.front() + attributeIdx * numLines);
+        }
+    }
+    writePadding(file, filePosition);
+    if (!lineSummaries.empty()) {
+        fwrite(&lineSummaries.front(), sizeof(LineAttributeSummary), lineSummaries.size(), file);
+    }
+
+    bool writeSuccessful = ferror(file) == 0;
+    fclose(file);
+    if (!writeSuccessful) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in writeBinLinesFile: Couldn't write to file \""
+                + filename + "\".");
+        remove(filename.c_str());
+    }
+    return writeSuccessful;
+}
+
+void convertTrajectoryDataToBinLines(
+        TrajectoryType trajectoryType,
+        const std::string &trajectoriesFilename,
+        const std::string &binLinesFilename)
+{
+    auto start = std::chrono::system_clock::now();
+
+    Trajectories trajectories = loadTrajectoriesFromFileUnnormalized(trajectoriesFilename, trajectoryType);
+    TrajectoryNormalization normalization = computeTrajectoryNormalization(trajectories, trajectoryType);
+    writeBinLinesFile(binLinesFilename, trajectories, trajectoryType, normalization);
+
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    sgl::Logfile::get()->writeInfo(std::string() + "Computational time to create binlines file: "
+            + std::to_string(elapsed.count()));
+}
+
+std::string getBinLinesCacheFilename(const std::string &trajectoriesFilename)
+{
+    const std::string CACHE_EXTENSION = ".cache.binlines";
+    if (boost::ends_with(trajectoriesFilename, CACHE_EXTENSION)) {
+        return trajectoriesFilename;
+    }
+    return sgl::FileUtils::get()->removeExtension(trajectoriesFilename) + CACHE_EXTENSION;
+}
+
+bool openBinLinesDataForTrajectoryFile(
+        const std::string &trajectoriesFilename, TrajectoryType trajectoryType, BinLinesFile &binLinesFile)
+{
+    // Use the binlines cache if it is up to date and was created for the same trajectory type.
+    std::string cacheFilename = getBinLinesCacheFilename(trajectoriesFilename);
+    bool isCacheUpToDate = false;
+    try {
+        isCacheUpToDate = boost::filesystem::exists(cacheFilename) && (cacheFilename == trajectoriesFilename
+                || boost::filesystem::last_write_time(cacheFilename)
+                        >= boost::filesystem::last_write_time(trajectoriesFilename));
+    } catch (const boost::filesystem::filesystem_error &e) {
+        isCacheUpToDate = false;
+    }
+    // A binlines v2 file passed directly also stores its normalization and doesn't need a separate cache.
+    std::vector<std::string> binLinesFilenames;
+    if (isCacheUpToDate) {
+        binLinesFilenames.push_back(cacheFilename);
+    }
+    if (cacheFilename != trajectoriesFilename
+            && boost::ends_with(boost::to_lower_copy(trajectoriesFilename), ".binlines")) {
+        binLinesFilenames.push_back(trajectoriesFilename);
+    }
+    for (const std::string &binLinesFilename : binLinesFilenames) {
+        if (binLinesFile.open(binLinesFilename) && binLinesFile.hasNormalization()
+                && binLinesFile.getTrajectoryType() == trajectoryType) {
+            return true;
+        }
+    }
+    binLinesFile.close();
+    return false;
+}
@@ -0,0 +1,170 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIXELSYNCOIT_BINLINESFILE_HPP
+#define PIXELSYNCOIT_BINLINESFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "MappedFile.hpp"
+#include "TrajectoryFile.hpp"
+#include "LineFilter.hpp"
+
+/**
+ * Binlines v2 format: A memory-mappable, compressed sparse row (CSR) layout of a line data set.
+ * All values are stored in little endian byte order. The file consists of:
+ *  - The header (see BinLinesHeader below). The first four bytes hold the format version, like in the v1 format.
+ *  - A line offset table (uint64_t[numLines+1]). The points of line i are [lineOffsets[i], lineOffsets[i+1]).
+ *  - The point positions (glm::vec3[numPoints]).
+ *  - The point attributes (float[numAttributes][numPoints]), i.e., one contiguous array per attribute.
+ *  - Optionally (BINLINES_FLAG_HAS_LINE_SUMMARIES), the minimum, maximum and mean value of each attribute per line
+ *    (LineAttributeSummary[numAttributes][numLines]) for filtering lines without touching the point data.
+ * Every array starts at an offset aligned to BINLINES_ARRAY_ALIGNMENT bytes, so the data can be used in place.
+ *
+ * The positions are stored without the normalization loadTrajectoriesFromFile applies. Instead, the normalization
+ * transformation is stored in the header so that it doesn't need to be recomputed when the file is loaded.
+ */
+const uint32_t BINLINES_FORMAT_VERSION_CSR = 2u;
+const uint64_t BINLINES_ARRAY_ALIGNMENT = 64u;
+
+enum BinLinesFlags {
+    BINLINES_FLAG_HAS_NORMALIZATION = 1u,
+    BINLINES_FLAG_HAS_LINE_SUMMARIES = 2u
+};
+
+struct BinLinesHeader {
+    uint32_t formatVersion;
+    uint32_t flags; ///< Bit field of BinLinesFlags.
+    uint32_t trajectoryType; ///< The TrajectoryType the attributes were computed for.
+    uint32_t numAttributes;
+    uint64_t numLines;
+    uint64_t numPoints;
+
+    // Byte offsets of the arrays from the start of the file.
+    uint64_t lineOffsetsStart;
+    uint64_t positionsStart;
+    uint64_t attributesStart;
+
+    // The normalization transformation (see TrajectoryNormalization).
+    uint32_t normalizePositions;
+    uint32_t normalizeAttribute;
+    glm::vec3 boundingBoxMin;
+    glm::vec3 boundingBoxMax;
+    glm::vec3 minVec;
+    glm::vec3 maxVec;
+    glm::vec3 positionOffset;
+    float minAttribute;
+    float maxAttribute;
+};
+
+/**
+ * A read-only view of a binlines v2 file. The file is memory-mapped, and the arrays are used in place.
+ */
+class BinLinesFile
+{
+public:
+    /**
+     * Maps the specified file and validates its header.
+     * @return False if the file could not be opened or is not a valid binlines v2 file.
+     */
+    bool open(const std::string &filename);
+    void close();
+
+    inline bool isOpen() const { return header != NULL; }
+    inline const BinLinesHeader &getHeader() const { return *header; }
+    inline uint64_t getNumLines() const { return header->numLines; }
+    inline uint64_t getNumPoints() const { return header->numPoints; }
+    inline uint32_t getNumAttributes() const { return header->numAttributes; }
+    inline TrajectoryType getTrajectoryType() const { return TrajectoryType(header->trajectoryType); }
+    inline bool hasNormalization() const { return (header->flags & BINLINES_FLAG_HAS_NORMALIZATION) != 0; }
+    inline bool hasLineSummaries() const { return (header->flags & BINLINES_FLAG_HAS_LINE_SUMMARIES) != 0; }
+
+    /// The points of line i are [lineOffsets[i], lineOffsets[i+1]).
+    inline const uint64_t *getLineOffsets() const { return lineOffsets; }
+    inline const glm::vec3 *getPositions() const { return positions; }
+    inline const float *getAttribute(uint32_t attributeIndex) const {
+        return attributes + attributeIndex * header->numPoints;
+    }
+    /// Returns the summaries of the (not normalized) attribute for all lines, or NULL if the file stores none.
+    inline const LineAttributeSummary *getLineSummaries(uint32_t attributeIndex) const {
+        return lineSummaries == NULL ? NULL : lineSummaries + attributeIndex * header->numLines;
+    }
+
+    /// Returns the normalization transformation stored in the header.
+    TrajectoryNormalization getNormalization() const;
+
+    /// Copies the data to the per-trajectory representation in parallel.
+    Trajectories toTrajectories() const;
+
+private:
+    MappedFile file;
+    const BinLinesHeader *header = NULL;
+    const uint64_t *lineOffsets = NULL;
+    const glm::vec3 *positions = NULL;
+    const float *attributes = NULL;
+    const LineAttributeSummary *lineSummaries = NULL;
+};
+
+/**
+ * Writes the trajectories to a binlines v2 file. The contiguous arrays are assembled in parallel.
+ * @param filename The name of the binlines file to write.
+ * @param trajectories The (not normalized) trajectories.
+ * @param trajectoryType The type the trajectory attributes were computed for.
+ * @param normalization The normalization transformation to store in the header.
+ * @return False if the file could not be written.
+ */
+bool writeBinLinesFile(
+        const std::string &filename, const Trajectories &trajectories, TrajectoryType trajectoryType,
+        const TrajectoryNormalization &normalization);
+
+/**
+ * Loads the trajectories from an .obj, .nc or .binlines (v1) file, computes their attributes and normalization
+ * transformation and stores them in a binlines v2 file.
+ */
+void convertTrajectoryDataToBinLines(
+        TrajectoryType trajectoryType,
+        const std::string &trajectoriesFilename,
+        const std::string &binLinesFilename);
+
+/**
+ * @return The filename of the binlines v2 cache used by loadTrajectoriesFromFile for the passed trajectory file.
+ */
+std::string getBinLinesCacheFilename(const std::string &trajectoriesFilename);
+
+/**
+ * Opens the binlines v2 data belonging to a trajectory file, i.e., the file itself if it is a binlines v2 file, or its
+ * up-to-date cache. Only files storing their normalization and created for the passed trajectory type are accepted.
+ * @return False if no such file exists.
+ */
+bool openBinLinesDataForTrajectoryFile(
+        const std::string &trajectoriesFilename, TrajectoryType trajectoryType, BinLinesFile &binLinesFile);
+
+#endif //PIXELSYNCOIT_BINLINESFILE_HPP
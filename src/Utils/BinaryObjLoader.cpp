@@ -35,11 +35,15 @@
 #include "MeshSerializer.hpp"
 #include "ComputeNormals.hpp"
 #include "ImportanceCriteria.hpp"
+#include "VertexWelding.hpp"
+#include "MeshSimplification.hpp"
 #include "BinaryObjLoader.hpp"
 
 void convertBinaryObjMeshToBinmesh(
         const std::string &bobjFilename,
-        const std::string &binaryFilename)
+        const std::string &binaryFilename,
+        float weldingEpsilon,
+        const std::vector<float> &lodTriangleRatios)
 {
     std::ifstream fin(bobjFilename.c_str(), std::ios::binary);
     if (!fin.is_open()) {
@@ -105,6 +109,11 @@ void convertBinaryObjMeshToBinmesh(
     indices.clear();
     indices.shrink_to_fit();
 
+    // Merge vertices that only differ by floating point noise before computing the smooth normals.
+    if (weldingEpsilon > 0.0f) {
+        weldVertices(vertices, indices32, weldingEpsilon);
+    }
+
     // Compute the normals for our mesh.
     std::vector<glm::vec3> normals;
     std::vector<float> attributes;
@@ -153,6 +162,11 @@ void convertBinaryObjMeshToBinmesh(
     attributes.clear(); attributes.shrink_to_fit();
     vertexAttributeData.clear(); vertexAttributeData.shrink_to_fit();
 
+    if (!lodTriangleRatios.empty()) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Computing levels of detail...");
+        addTriangleMeshLods(binaryMesh, lodTriangleRatios);
+    }
+
     sgl::Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
     writeMesh3D(binaryFilename, binaryMesh);
     sgl::Logfile::get()->writeInfo(std::string() + "Finished writing binary mesh.");
@@ -29,13 +29,22 @@
 #ifndef PIXELSYNCOIT_BINARYOBJLOADER_HPP
 #define PIXELSYNCOIT_BINARYOBJLOADER_HPP
 
+#include <string>
+#include <vector>
+
 /**
  * Converts the content of a binary OBJ file to the binmesh format.
  * @param objFilename The filename of the .bobj file
  * @param binaryFilename: The filename of the binary output file.
+ * @param weldingEpsilon: If greater than zero, vertices closer than weldingEpsilon times the maximum extent of the
+ * bounding box are merged before the normals are computed (see VertexWelding.hpp).
+ * @param lodTriangleRatios: For each entry, a simplified level of detail keeping approximately this fraction of the
+ * triangles is stored in the binmesh file (see MeshSimplification.hpp).
  */
 void convertBinaryObjMeshToBinmesh(
         const std::string &bobjFilename,
-        const std::string &binaryFilename);
+        const std::string &binaryFilename,
+        float weldingEpsilon = 0.0f,
+        const std::vector<float> &lodTriangleRatios = std::vector<float>());
 
 #endif //PIXELSYNCOIT_BINARYOBJLOADER_HPP
@@ -30,6 +30,8 @@
 #define PIXELSYNCOIT_COMPUTENORMALS_HPP
 
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 #include <glm/glm.hpp>
 
 /**
@@ -43,4 +45,31 @@ void computeNormals(
         std::vector<glm::vec3> &normals,
         std::vector<float> &attributes);
 
+/**
+ * The building blocks of computeNormals for meshes that are processed in parts (see OutOfCoreBinaryObjLoader.hpp).
+ * computeFaceNormals computes the (not normalized, i.e., area-weighted) normal of each triangle.
+ */
+void computeFaceNormals(
+        const glm::vec3 *vertices,
+        const std::vector<uint32_t> &indices,
+        std::vector<glm::vec3> &faceNormals);
+
+/**
+ * Averages the normals of the faces adjacent to a vertex (faceIndices, e.g., from a VertexTriangleAdjacency).
+ * numFaces needs to be greater than zero.
+ */
+glm::vec3 computeVertexNormal(const glm::vec3 *faceNormals, const uint32_t *faceIndices, uint32_t numFaces);
+
+/**
+ * Estimates the curvature at vertex i from the normals of its one-ring neighbors. The one-ring is formed by the
+ * vertices of the adjacent faces faceIndices in the order the faces are listed.
+ */
+float computeVertexCurvature(
+        size_t i,
+        const glm::vec3 *vertices,
+        const glm::vec3 *normals,
+        const uint32_t *indices,
+        const uint32_t *faceIndices,
+        uint32_t numFaces);
+
 #endif //PIXELSYNCOIT_COMPUTENORMALS_HPP
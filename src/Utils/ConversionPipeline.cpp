@@ -0,0 +1,124 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <thread>
+#include <algorithm>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "ConversionPipeline.hpp"
+
+void ConversionPipeline::addStage(const std::string &name, int numThreads,
+        const std::function<void(PipelineStageTimer&)> &stageFunction)
+{
+    PipelineStage stage;
+    stage.name = name;
+    stage.numThreads = std::max(numThreads, 1);
+    stage.stageFunction = stageFunction;
+    stages.push_back(stage);
+}
+
+void ConversionPipeline::run()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    size_t numThreadsTotal = 0;
+    for (const PipelineStage &stage : stages) {
+        numThreadsTotal += size_t(stage.numThreads);
+    }
+    std::vector<PipelineStageTimer> timers(numThreadsTotal);
+    std::vector<double> wallTimesMS(numThreadsTotal, 0.0);
+    std::vector<std::thread> threads;
+    threads.reserve(numThreadsTotal);
+
+    size_t threadIndex = 0;
+    for (const PipelineStage &stage : stages) {
+        for (int i = 0; i < stage.numThreads; i++) {
+            PipelineStageTimer *timer = &timers.at(threadIndex);
+            double *wallTimeMS = &wallTimesMS.at(threadIndex);
+            const std::function<void(PipelineStageTimer&)> *stageFunction = &stage.stageFunction;
+            threads.push_back(std::thread([timer, wallTimeMS, stageFunction]() {
+                auto threadStart = std::chrono::high_resolution_clock::now();
+                (*stageFunction)(*timer);
+                *wallTimeMS = std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - threadStart).count();
+            }));
+            threadIndex++;
+        }
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    totalTimeMS = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    statistics.clear();
+    threadIndex = 0;
+    for (const PipelineStage &stage : stages) {
+        PipelineStageStatistics stageStatistics;
+        stageStatistics.name = stage.name;
+        stageStatistics.numThreads = stage.numThreads;
+        stageStatistics.numBatches = 0;
+        stageStatistics.busyTimeMS = 0.0;
+        stageStatistics.wallTimeMS = 0.0;
+        for (int i = 0; i < stage.numThreads; i++) {
+            stageStatistics.numBatches += timers.at(threadIndex).getNumBatches();
+            stageStatistics.busyTimeMS += timers.at(threadIndex).getBusyTimeMS();
+            stageStatistics.wallTimeMS += wallTimesMS.at(threadIndex);
+            threadIndex++;
+        }
+        statistics.push_back(stageStatistics);
+    }
+}
+
+void ConversionPipeline::logStatistics() const
+{
+    size_t bottleneckStageIndex = 0;
+    double maxUtilization = -1.0;
+    for (size_t i = 0; i < statistics.size(); i++) {
+        const PipelineStageStatistics &stageStatistics = statistics.at(i);
+        double utilization = stageStatistics.busyTimeMS / std::max(stageStatistics.wallTimeMS, 1e-6);
+        if (utilization > maxUtilization) {
+            maxUtilization = utilization;
+            bottleneckStageIndex = i;
+        }
+    }
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Conversion pipeline finished in "
+            + sgl::toString(totalTimeMS) + " ms.");
+    for (size_t i = 0; i < statistics.size(); i++) {
+        const PipelineStageStatistics &stageStatistics = statistics.at(i);
+        double utilization = stageStatistics.busyTimeMS / std::max(stageStatistics.wallTimeMS, 1e-6);
+        sgl::Logfile::get()->writeInfo(std::string() + "Stage \"" + stageStatistics.name + "\": "
+                + sgl::toString(stageStatistics.numThreads) + " thread(s), "
+                + sgl::toString(stageStatistics.numBatches) + " batches, busy for "
+                + sgl::toString(stageStatistics.busyTimeMS) + " ms (" + sgl::toString(int(utilization * 100.0))
+                + "% utilization)" + (i == bottleneckStageIndex ? " <- bottleneck" : ""));
+    }
+}
@@ -0,0 +1,172 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_CONVERSIONPIPELINE_HPP
+#define PIXELSYNCOIT_CONVERSIONPIPELINE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+/**
+ * A thread-safe FIFO queue with a maximum size connecting two stages of a ConversionPipeline.
+ * The capacity bounds the memory used by batches in flight and makes fast producers wait for slow consumers.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+    /**
+     * @param capacity The maximum number of items in the queue.
+     * @param numProducers The number of threads pushing items. The queue is closed after all of them called close.
+     */
+    BoundedQueue(size_t capacity, int numProducers = 1) : capacity(capacity), numOpenProducers(numProducers) {}
+
+    /// Appends an item. Blocks while the queue is full.
+    void push(T &&item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFullCondition.wait(lock, [this] { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        notEmptyCondition.notify_one();
+    }
+
+    /**
+     * Removes the oldest item. Blocks while the queue is empty.
+     * @return False if the queue is empty and all producers closed it.
+     */
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmptyCondition.wait(lock, [this] { return !items.empty() || numOpenProducers == 0; });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFullCondition.notify_one();
+        return true;
+    }
+
+    /// Called by each producer after pushing its last item.
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        numOpenProducers--;
+        if (numOpenProducers == 0) {
+            notEmptyCondition.notify_all();
+        }
+    }
+
+private:
+    size_t capacity;
+    int numOpenProducers;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notFullCondition;
+    std::condition_variable notEmptyCondition;
+};
+
+/**
+ * Measures the time a thread of a pipeline stage spends working on batches. The remaining time of the thread was
+ * spent waiting for input or for space in the output queue.
+ */
+class PipelineStageTimer
+{
+public:
+    inline void beginBatch() { batchStart = std::chrono::high_resolution_clock::now(); }
+    inline void endBatch()
+    {
+        busyTimeMS += std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - batchStart).count();
+        numBatches++;
+    }
+
+    inline double getBusyTimeMS() const { return busyTimeMS; }
+    inline size_t getNumBatches() const { return numBatches; }
+
+private:
+    std::chrono::high_resolution_clock::time_point batchStart;
+    double busyTimeMS = 0.0;
+    size_t numBatches = 0;
+};
+
+struct PipelineStageStatistics
+{
+    std::string name;
+    int numThreads;
+    size_t numBatches;
+    double busyTimeMS; ///< Summed over all threads of the stage.
+    double wallTimeMS; ///< Summed over all threads of the stage.
+};
+
+/**
+ * Runs the stages of a conversion (e.g., reading, attribute computation, geometry generation, merging) concurrently,
+ * each on its own threads. The stages are connected by BoundedQueue objects owned by the caller, and each stage
+ * function closes its output queue when it is done.
+ *
+ * After run returned, the statistics show the fraction of time each stage was busy. The stage with the highest
+ * utilization is the bottleneck of the conversion.
+ */
+class ConversionPipeline
+{
+public:
+    /**
+     * @param name The name of the stage used in the statistics.
+     * @param numThreads The number of threads calling stageFunction concurrently.
+     * @param stageFunction Processes batches until its input is exhausted. It is called once per thread with a
+     * thread-local timer, which should enclose the processing of each batch with beginBatch and endBatch.
+     */
+    void addStage(const std::string &name, int numThreads,
+            const std::function<void(PipelineStageTimer&)> &stageFunction);
+
+    /// Starts all stages and waits until all of them finished.
+    void run();
+
+    /// Writes the per-stage statistics of the last run to the log file.
+    void logStatistics() const;
+    inline const std::vector<PipelineStageStatistics> &getStatistics() const { return statistics; }
+
+private:
+    struct PipelineStage
+    {
+        std::string name;
+        int numThreads;
+        std::function<void(PipelineStageTimer&)> stageFunction;
+    };
+    std::vector<PipelineStage> stages;
+    std::vector<PipelineStageStatistics> statistics;
+    double totalTimeMS = 0.0;
+};
+
+#endif //PIXELSYNCOIT_CONVERSIONPIPELINE_HPP
@@ -0,0 +1,138 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "NetCDFConverter.hpp"
+#include "TrajectoryLoader.hpp"
+#include "EnsembleMemberCache.hpp"
+
+static std::shared_ptr<BinaryMesh> loadEnsembleMemberLineMesh(
+        const std::string &filename, TrajectoryType trajectoryType, EnsembleSelection selection)
+{
+    auto start = std::chrono::system_clock::now();
+
+    Trajectories trajectories = loadTrajectoriesFromNetCdf(
+            filename, trajectoryType, selection.ensembleMember, selection.timeStart, selection.timeCount);
+    TrajectoryNormalization normalization = computeTrajectoryNormalization(trajectories, trajectoryType);
+    applyTrajectoryNormalization(trajectories, normalization);
+
+    std::shared_ptr<BinaryMesh> binaryMesh(new BinaryMesh);
+    convertTrajectoriesToBinaryLineMesh(trajectories, *binaryMesh);
+
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    sgl::Logfile::get()->writeInfo(std::string() + "Loaded ensemble member "
+            + sgl::toString(selection.ensembleMember) + " of \"" + filename + "\" in "
+            + sgl::toString(elapsed.count()) + "ms.");
+    return binaryMesh;
+}
+
+EnsembleMemberCache::EnsembleMemberCache(const std::string &filename, TrajectoryType trajectoryType, size_t capacity)
+        : filename(filename), trajectoryType(trajectoryType), capacity(std::max(capacity, size_t(2)))
+{
+    numMembers = getNetCdfNumEnsembleMembers(filename);
+}
+
+EnsembleMemberCache::~EnsembleMemberCache()
+{
+    // Releasing the last reference to a future of std::async blocks until its task has finished, i.e., until the whole
+    // member was decoded. The members still being loaded are handed to a detached thread waiting for them instead,
+    // so that switching the data set doesn't block the UI. The tasks only use copies of the cache's settings.
+    std::vector<MeshFuture> pendingFutures;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (auto &cacheEntry : cacheEntries) {
+            if (cacheEntry.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                pendingFutures.push_back(cacheEntry.second);
+            }
+        }
+        cacheEntries.clear();
+    }
+    if (!pendingFutures.empty()) {
+        std::thread([pendingFutures]() {
+            for (const MeshFuture &meshFuture : pendingFutures) {
+                meshFuture.wait();
+            }
+        }).detach();
+    }
+}
+
+std::shared_ptr<BinaryMesh> EnsembleMemberCache::getLineMesh(const EnsembleSelection &selection)
+{
+    MeshFuture meshFuture = request(selection);
+    if (numMembers > 1) {
+        prefetch(EnsembleSelection((selection.ensembleMember + 1) % numMembers,
+                selection.timeStart, selection.timeCount));
+    }
+    return meshFuture.get();
+}
+
+void EnsembleMemberCache::prefetch(const EnsembleSelection &selection)
+{
+    request(selection);
+}
+
+EnsembleMemberCache::MeshFuture EnsembleMemberCache::request(const EnsembleSelection &selection)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    for (auto it = cacheEntries.begin(); it != cacheEntries.end(); it++) {
+        if (it->first == selection) {
+            // Move the entry to the front of the LRU list.
+            cacheEntries.splice(cacheEntries.begin(), cacheEntries, it);
+            return cacheEntries.front().second;
+        }
+    }
+
+    // The NetCDF reads are serialized by loadNetCdfFile, but the conversion overlaps with the main thread.
+    MeshFuture meshFuture = std::async(
+            std::launch::async, loadEnsembleMemberLineMesh, filename, trajectoryType, selection).share();
+    cacheEntries.push_front(std::make_pair(selection, meshFuture));
+    evictUnusedEntries();
+    return meshFuture;
+}
+
+void EnsembleMemberCache::evictUnusedEntries()
+{
+    // Entries that are still being loaded are not evicted, as destroying their future would block until they finish.
+    auto it = cacheEntries.end();
+    while (cacheEntries.size() > capacity && it != cacheEntries.begin()) {
+        it--;
+        bool isReady = it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (isReady) {
+            it = cacheEntries.erase(it);
+        }
+    }
+}
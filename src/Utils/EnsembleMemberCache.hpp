@@ -0,0 +1,102 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_ENSEMBLEMEMBERCACHE_HPP
+#define PIXELSYNCOIT_ENSEMBLEMEMBERCACHE_HPP
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <future>
+#include <memory>
+
+#include "TrajectoryFile.hpp"
+#include "MeshSerializer.hpp"
+
+/**
+ * Selects one ensemble member and a window of time steps of a WCB NetCDF file (timeCount = 0 means all time steps).
+ */
+struct EnsembleSelection
+{
+    EnsembleSelection(size_t ensembleMember = 0, size_t timeStart = 0, size_t timeCount = 0)
+            : ensembleMember(ensembleMember), timeStart(timeStart), timeCount(timeCount) {}
+    bool operator==(const EnsembleSelection &other) const {
+        return ensembleMember == other.ensembleMember && timeStart == other.timeStart && timeCount == other.timeCount;
+    }
+
+    size_t ensembleMember;
+    size_t timeStart;
+    size_t timeCount;
+};
+
+/**
+ * Loads ensemble members (or time windows) of a WCB NetCDF file on demand and keeps the line meshes of the most
+ * recently used ones in memory. Whenever a member is requested, the next member is decoded and converted in the
+ * background, so stepping through the ensemble only needs to upload the already converted mesh to the GPU.
+ */
+class EnsembleMemberCache
+{
+public:
+    /**
+     * @param filename The WCB NetCDF file.
+     * @param trajectoryType The trajectory type used for computing the line attributes.
+     * @param capacity The maximum number of line meshes kept in memory (including the ones being prefetched).
+     */
+    EnsembleMemberCache(const std::string &filename, TrajectoryType trajectoryType, size_t capacity = 3);
+    /// Doesn't wait for members still being loaded (see the implementation).
+    ~EnsembleMemberCache();
+
+    inline const std::string &getFilename() const { return filename; }
+    inline size_t getNumMembers() const { return numMembers; }
+
+    /**
+     * Returns the line mesh of the selected member (see convertTrajectoriesToBinaryLineMesh). Only blocks if the
+     * member is neither cached nor being prefetched. Afterwards, the next ensemble member is prefetched.
+     */
+    std::shared_ptr<BinaryMesh> getLineMesh(const EnsembleSelection &selection);
+
+    /// Starts loading the selected member in the background (if it isn't cached yet).
+    void prefetch(const EnsembleSelection &selection);
+
+private:
+    typedef std::shared_future<std::shared_ptr<BinaryMesh>> MeshFuture;
+    MeshFuture request(const EnsembleSelection &selection);
+    void evictUnusedEntries();
+
+    std::string filename;
+    TrajectoryType trajectoryType;
+    size_t numMembers;
+    size_t capacity;
+
+    /// Most recently used entries first. Guarded by cacheMutex.
+    std::list<std::pair<EnsembleSelection, MeshFuture>> cacheEntries;
+    std::mutex cacheMutex;
+};
+
+#endif //PIXELSYNCOIT_ENSEMBLEMEMBERCACHE_HPP
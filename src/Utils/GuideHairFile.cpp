@@ -0,0 +1,511 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstring>
+#include <cstdio>
+#include <cfloat>
+#include <algorithm>
+#include <chrono>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/Convert.hpp>
+
+#include "MappedFile.hpp"
+#include "KDTree.hpp"
+#include "GuideHairFile.hpp"
+
+const uint32_t GUIDE_HAIR_MAGIC_NUMBER = 0x49414847; // "GHAI"
+
+// The number of sample points per strand used for comparing strands.
+const int NUM_STRAND_FEATURE_SAMPLES = 4;
+// The number of clusters/guides with the closest roots each strand is compared with.
+const int NUM_CANDIDATE_GUIDES = 16;
+const int NUM_CLUSTERING_ITERATIONS = 5;
+
+bool isGuideHairFilename(const std::string &filename)
+{
+    return boost::ends_with(boost::to_lower_copy(filename), ".ghair");
+}
+
+std::string getHairFilenameOfGuideHairFile(const std::string &guideHairFilename)
+{
+    std::string filenamePure = sgl::FileUtils::get()->removeExtension(guideHairFilename);
+    if (boost::ends_with(filenamePure, "_guides")) {
+        filenamePure = filenamePure.substr(0, filenamePure.size() - 7);
+    }
+    return filenamePure + ".hair";
+}
+
+/**
+ * Interpolates the value of a strand or guide with numPoints values at the parameter t in [0, 1].
+ */
+template<typename T>
+inline T sampleStrandLinear(const T *values, uint32_t numPoints, float t)
+{
+    if (numPoints < 2) {
+        return values[0];
+    }
+    float position = t * float(numPoints - 1);
+    uint32_t index = std::min(uint32_t(position), numPoints - 2);
+    float interpolationFactor = position - float(index);
+    return values[index] + (values[index + 1] - values[index]) * interpolationFactor;
+}
+
+inline glm::vec4 unpackColor(uint32_t color)
+{
+    return glm::vec4(float(color & 0xFFu), float((color >> 8) & 0xFFu), float((color >> 16) & 0xFFu),
+            float(color >> 24));
+}
+
+inline uint32_t packColor(const glm::vec4 &color)
+{
+    glm::vec4 clampedColor = glm::clamp(glm::round(color), glm::vec4(0.0f), glm::vec4(255.0f));
+    return uint32_t(clampedColor.r) | (uint32_t(clampedColor.g) << 8) | (uint32_t(clampedColor.b) << 16)
+            | (uint32_t(clampedColor.a) << 24);
+}
+
+inline glm::vec4 sampleColorLinear(const uint32_t *colors, uint32_t numPoints, float t)
+{
+    if (numPoints < 2) {
+        return unpackColor(colors[0]);
+    }
+    float position = t * float(numPoints - 1);
+    uint32_t index = std::min(uint32_t(position), numPoints - 2);
+    float interpolationFactor = position - float(index);
+    return glm::mix(unpackColor(colors[index]), unpackColor(colors[index + 1]), interpolationFactor);
+}
+
+bool loadGuideHairFile(const std::string &guideHairFilename, FlatHairData &hairData)
+{
+    MappedFile file;
+    if (!file.open(guideHairFilename)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadGuideHairFile: File \""
+                + guideHairFilename + "\" not found.");
+        return false;
+    }
+    const uint8_t *data = file.getData();
+    const size_t size = file.getSize();
+
+    if (size < sizeof(GuideHairFileHeader)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadGuideHairFile: File \""
+                + guideHairFilename + "\" is too small.");
+        return false;
+    }
+    const GuideHairFileHeader &header = *reinterpret_cast<const GuideHairFileHeader*>(data);
+    if (header.magicNumber != GUIDE_HAIR_MAGIC_NUMBER || header.formatVersion != GUIDE_HAIR_FORMAT_VERSION) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadGuideHairFile: Invalid magic number or "
+                "format version in file \"" + guideHairFilename + "\".");
+        return false;
+    }
+
+    const bool hasThicknessArray = (header.flags & GUIDE_HAIR_FLAG_HAS_THICKNESS_ARRAY) != 0;
+    const bool hasColorArray = (header.flags & GUIDE_HAIR_FLAG_HAS_COLOR_ARRAY) != 0;
+    const size_t numGuides = header.numGuides;
+    const size_t numGuidePoints = header.numGuidePoints;
+    const size_t numStrands = header.numStrands;
+    uint64_t expectedSize = sizeof(GuideHairFileHeader) + (numGuides + 1) * sizeof(uint32_t)
+            + numGuidePoints * sizeof(glm::vec3) + numStrands * sizeof(GuideHairStrand);
+    if (hasThicknessArray) {
+        expectedSize += numGuidePoints * sizeof(float);
+    }
+    if (hasColorArray) {
+        expectedSize += numGuidePoints * sizeof(uint32_t);
+    }
+    if (size < expectedSize) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadGuideHairFile: File \""
+                + guideHairFilename + "\" is truncated.");
+        return false;
+    }
+
+    size_t offset = sizeof(GuideHairFileHeader);
+    const uint32_t *guideOffsets = reinterpret_cast<const uint32_t*>(data + offset);
+    offset += (numGuides + 1) * sizeof(uint32_t);
+    const glm::vec3 *guidePoints = reinterpret_cast<const glm::vec3*>(data + offset);
+    offset += numGuidePoints * sizeof(glm::vec3);
+    const float *guideThicknesses = NULL;
+    if (hasThicknessArray) {
+        guideThicknesses = reinterpret_cast<const float*>(data + offset);
+        offset += numGuidePoints * sizeof(float);
+    }
+    const uint32_t *guideColors = NULL;
+    if (hasColorArray) {
+        guideColors = reinterpret_cast<const uint32_t*>(data + offset);
+        offset += numGuidePoints * sizeof(uint32_t);
+    }
+    const GuideHairStrand *strands = reinterpret_cast<const GuideHairStrand*>(data + offset);
+
+    // Validate the guides and the strands before generating the points.
+    bool guidesValid = guideOffsets[0] == 0 && guideOffsets[numGuides] == numGuidePoints;
+    for (size_t i = 0; i < numGuides && guidesValid; i++) {
+        guidesValid = guideOffsets[i] < guideOffsets[i + 1];
+    }
+    size_t numInvalidStrands = 0;
+    #pragma omp parallel for reduction(+:numInvalidStrands)
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        const GuideHairStrand &strand = strands[strandIdx];
+        bool strandValid = strand.numPoints > 0;
+        for (uint32_t k = 0; k < GUIDE_HAIR_NUM_INTERPOLATION_GUIDES; k++) {
+            strandValid = strandValid && (strand.guideWeights[k] == 0.0f || strand.guideIndices[k] < numGuides);
+        }
+        if (!strandValid) {
+            numInvalidStrands++;
+        }
+    }
+    if (!guidesValid || numInvalidStrands > 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadGuideHairFile: Invalid guides or strands in "
+                "file \"" + guideHairFilename + "\".");
+        return false;
+    }
+
+    hairData.filename = guideHairFilename;
+    hairData.hasThicknessArray = hasThicknessArray;
+    hairData.hasColorArray = hasColorArray;
+    hairData.defaultThickness = header.defaultThickness;
+    hairData.defaultOpacity = header.defaultOpacity;
+    hairData.defaultColor = header.defaultColor;
+
+    hairData.strandOffsets.resize(numStrands + 1);
+    hairData.strandOffsets.at(0) = 0;
+    uint64_t numPoints = 0;
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        numPoints += strands[strandIdx].numPoints;
+        hairData.strandOffsets.at(strandIdx + 1) = uint32_t(numPoints);
+    }
+    if (numPoints > UINT32_MAX) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadGuideHairFile: Too many points in file \""
+                + guideHairFilename + "\".");
+        return false;
+    }
+
+    // Generate the render strands from the guides in parallel.
+    hairData.points.resize(numPoints);
+    hairData.thicknesses.clear();
+    hairData.colors.clear();
+    if (hasThicknessArray) {
+        hairData.thicknesses.resize(numPoints);
+    }
+    if (hasColorArray) {
+        hairData.colors.resize(numPoints);
+    }
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        const GuideHairStrand &strand = strands[strandIdx];
+        const uint32_t strandOffset = hairData.strandOffsets[strandIdx];
+        for (uint32_t j = 0; j < strand.numPoints; j++) {
+            float t = strand.numPoints > 1 ? float(j) / float(strand.numPoints - 1) : 0.0f;
+            glm::vec3 point = strand.root;
+            float thickness = 0.0f;
+            glm::vec4 color(0.0f);
+            for (uint32_t k = 0; k < GUIDE_HAIR_NUM_INTERPOLATION_GUIDES; k++) {
+                const float weight = strand.guideWeights[k];
+                if (weight == 0.0f) {
+                    continue;
+                }
+                const uint32_t guideOffset = guideOffsets[strand.guideIndices[k]];
+                const uint32_t numGuideStrandPoints = guideOffsets[strand.guideIndices[k] + 1] - guideOffset;
+                const glm::vec3 *guide = guidePoints + guideOffset;
+                point += weight * (sampleStrandLinear(guide, numGuideStrandPoints, t) - guide[0]);
+                if (hasThicknessArray) {
+                    thickness += weight * sampleStrandLinear(
+                            guideThicknesses + guideOffset, numGuideStrandPoints, t);
+                }
+                if (hasColorArray) {
+                    color += weight * sampleColorLinear(guideColors + guideOffset, numGuideStrandPoints, t);
+                }
+            }
+            hairData.points[strandOffset + j] = point;
+            if (hasThicknessArray) {
+                hairData.thicknesses[strandOffset + j] = thickness;
+            }
+            if (hasColorArray) {
+                hairData.colors[strandOffset + j] = packColor(color);
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * The points of a strand at the parameters t = i / (NUM_STRAND_FEATURE_SAMPLES - 1) used for comparing strands.
+ */
+struct StrandFeature {
+    glm::vec3 samples[NUM_STRAND_FEATURE_SAMPLES];
+
+    inline const glm::vec3 &getRoot() const { return samples[0]; }
+    inline float squaredDistance(const StrandFeature &other) const {
+        float distance = 0.0f;
+        for (int i = 0; i < NUM_STRAND_FEATURE_SAMPLES; i++) {
+            glm::vec3 difference = samples[i] - other.samples[i];
+            distance += glm::dot(difference, difference);
+        }
+        return distance;
+    }
+};
+
+static bool writeGuideHairFile(
+        const std::string &guideHairFilename, const FlatHairData &hairData,
+        const std::vector<uint32_t> &guideStrandIndices, const std::vector<GuideHairStrand> &strands)
+{
+    const size_t numGuides = guideStrandIndices.size();
+    std::vector<uint32_t> guideOffsets(numGuides + 1);
+    guideOffsets.at(0) = 0;
+    for (size_t i = 0; i < numGuides; i++) {
+        guideOffsets.at(i + 1) = guideOffsets.at(i) + uint32_t(hairData.getNumStrandPoints(guideStrandIndices.at(i)));
+    }
+    const size_t numGuidePoints = guideOffsets.back();
+
+    GuideHairFileHeader header;
+    memset(&header, 0, sizeof(GuideHairFileHeader));
+    header.magicNumber = GUIDE_HAIR_MAGIC_NUMBER;
+    header.formatVersion = GUIDE_HAIR_FORMAT_VERSION;
+    header.flags = (hairData.hasThicknessArray ? GUIDE_HAIR_FLAG_HAS_THICKNESS_ARRAY : 0u)
+            | (hairData.hasColorArray ? GUIDE_HAIR_FLAG_HAS_COLOR_ARRAY : 0u);
+    header.numGuides = uint32_t(numGuides);
+    header.numGuidePoints = uint32_t(numGuidePoints);
+    header.numStrands = uint32_t(strands.size());
+    header.defaultThickness = hairData.defaultThickness;
+    header.defaultOpacity = hairData.defaultOpacity;
+    header.defaultColor = hairData.defaultColor;
+
+    FILE *file = fopen(guideHairFilename.c_str(), "wb");
+    if (!file) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in writeGuideHairFile: File \""
+                + guideHairFilename + "\" couldn't be opened for writing.");
+        return false;
+    }
+
+    fwrite(&header, sizeof(GuideHairFileHeader), 1, file);
+    fwrite(&guideOffsets.front(), sizeof(uint32_t), numGuides + 1, file);
+    for (uint32_t strandIdx : guideStrandIndices) {
+        const uint32_t begin = hairData.strandOffsets.at(strandIdx);
+        fwrite(&hairData.points.at(begin), sizeof(glm::vec3), hairData.getNumStrandPoints(strandIdx), file);
+    }
+    if (hairData.hasThicknessArray) {
+        for (uint32_t strandIdx : guideStrandIndices) {
+            const uint32_t begin = hairData.strandOffsets.at(strandIdx);
+            fwrite(&hairData.thicknesses.at(begin), sizeof(float), hairData.getNumStrandPoints(strandIdx), file);
+        }
+    }
+    if (hairData.hasColorArray) {
+        for (uint32_t strandIdx : guideStrandIndices) {
+            const uint32_t begin = hairData.strandOffsets.at(strandIdx);
+            fwrite(&hairData.colors.at(begin), sizeof(uint32_t), hairData.getNumStrandPoints(strandIdx), file);
+        }
+    }
+    if (!strands.empty()) {
+        fwrite(&strands.front(), sizeof(GuideHairStrand), strands.size(), file);
+    }
+
+    bool writeSuccessful = ferror(file) == 0;
+    fclose(file);
+    if (!writeSuccessful) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in writeGuideHairFile: Couldn't write to file \""
+                + guideHairFilename + "\".");
+        remove(guideHairFilename.c_str());
+    }
+    return writeSuccessful;
+}
+
+bool convertHairFileToGuideHairFile(
+        const std::string &hairFilename, const std::string &guideHairFilename, float guideRatio)
+{
+    auto start = std::chrono::system_clock::now();
+
+    FlatHairData hairData;
+    if (!loadHairFile(hairFilename, hairData)) {
+        return false;
+    }
+    const size_t numStrands = hairData.getNumStrands();
+    if (numStrands == 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertHairFileToGuideHairFile: File \""
+                + hairFilename + "\" contains no strands.");
+        return false;
+    }
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        if (hairData.getNumStrandPoints(strandIdx) == 0) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in convertHairFileToGuideHairFile: File \""
+                    + hairFilename + "\" contains empty strands.");
+            return false;
+        }
+    }
+
+    std::vector<StrandFeature> strandFeatures(numStrands);
+    #pragma omp parallel for
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        const glm::vec3 *points = &hairData.points[hairData.strandOffsets[strandIdx]];
+        const uint32_t numPoints = uint32_t(hairData.getNumStrandPoints(strandIdx));
+        for (int i = 0; i < NUM_STRAND_FEATURE_SAMPLES; i++) {
+            float t = float(i) / float(NUM_STRAND_FEATURE_SAMPLES - 1);
+            strandFeatures[strandIdx].samples[i] = sampleStrandLinear(points, numPoints, t);
+        }
+    }
+
+    // Initialize the cluster centers with a spatially stratified subset of the strands.
+    std::vector<float> strandRanks;
+    computeHairStrandRanks(hairData, strandRanks);
+    std::vector<StrandFeature> clusterCenters;
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        if (strandRanks.at(strandIdx) < guideRatio) {
+            clusterCenters.push_back(strandFeatures.at(strandIdx));
+        }
+    }
+    if (clusterCenters.empty()) {
+        clusterCenters.push_back(strandFeatures.at(0));
+    }
+    const size_t numClusters = clusterCenters.size();
+
+    // k-means clustering. Each strand is only compared with the clusters with the closest roots.
+    std::vector<uint32_t> strandClusters(numStrands);
+    std::vector<glm::vec3> centerRoots(numClusters);
+    for (int iteration = 0; iteration < NUM_CLUSTERING_ITERATIONS; iteration++) {
+        for (size_t clusterIdx = 0; clusterIdx < numClusters; clusterIdx++) {
+            centerRoots.at(clusterIdx) = clusterCenters.at(clusterIdx).getRoot();
+        }
+        KDTree kdTree;
+        kdTree.build(centerRoots);
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+            std::vector<Point> candidates;
+            kdTree.findKNearestNeighbors(strandFeatures[strandIdx].getRoot(), NUM_CANDIDATE_GUIDES, candidates);
+            float minDistance = FLT_MAX;
+            for (const Point &candidate : candidates) {
+                float distance = strandFeatures[strandIdx].squaredDistance(clusterCenters[candidate.index]);
+                if (distance < minDistance) {
+                    minDistance = distance;
+                    strandClusters[strandIdx] = uint32_t(candidate.index);
+                }
+            }
+        }
+
+        // Move the centers to the means of their strands. Empty clusters keep their center.
+        std::vector<StrandFeature> featureSums(numClusters);
+        std::vector<uint32_t> clusterSizes(numClusters, 0);
+        memset(&featureSums.front(), 0, numClusters * sizeof(StrandFeature));
+        for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+            StrandFeature &featureSum = featureSums.at(strandClusters.at(strandIdx));
+            for (int i = 0; i < NUM_STRAND_FEATURE_SAMPLES; i++) {
+                featureSum.samples[i] += strandFeatures.at(strandIdx).samples[i];
+            }
+            clusterSizes.at(strandClusters.at(strandIdx))++;
+        }
+        #pragma omp parallel for
+        for (size_t clusterIdx = 0; clusterIdx < numClusters; clusterIdx++) {
+            if (clusterSizes[clusterIdx] > 0) {
+                for (int i = 0; i < NUM_STRAND_FEATURE_SAMPLES; i++) {
+                    clusterCenters[clusterIdx].samples[i] =
+                            featureSums[clusterIdx].samples[i] / float(clusterSizes[clusterIdx]);
+                }
+            }
+        }
+    }
+
+    // The guide of a cluster is the strand closest to its center.
+    std::vector<float> strandCenterDistances(numStrands);
+    #pragma omp parallel for
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        strandCenterDistances[strandIdx] = strandFeatures[strandIdx].squaredDistance(
+                clusterCenters[strandClusters[strandIdx]]);
+    }
+    std::vector<uint32_t> clusterGuideStrands(numClusters, UINT32_MAX);
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        uint32_t &guideStrand = clusterGuideStrands.at(strandClusters.at(strandIdx));
+        if (guideStrand == UINT32_MAX || strandCenterDistances.at(strandIdx) < strandCenterDistances.at(guideStrand)) {
+            guideStrand = uint32_t(strandIdx);
+        }
+    }
+    std::vector<uint32_t> guideStrandIndices;
+    std::vector<glm::vec3> guideRoots;
+    for (uint32_t guideStrand : clusterGuideStrands) {
+        if (guideStrand != UINT32_MAX) {
+            guideStrandIndices.push_back(guideStrand);
+            guideRoots.push_back(strandFeatures.at(guideStrand).getRoot());
+        }
+    }
+    const size_t numGuides = guideStrandIndices.size();
+
+    // Interpolate each strand from the most similar guides among the guides with the closest roots.
+    KDTree guideKDTree;
+    guideKDTree.build(guideRoots);
+    std::vector<GuideHairStrand> strands(numStrands);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        const StrandFeature &feature = strandFeatures[strandIdx];
+        GuideHairStrand &strand = strands[strandIdx];
+        strand.root = feature.getRoot();
+        strand.numPoints = uint32_t(hairData.getNumStrandPoints(strandIdx));
+
+        std::vector<Point> candidates;
+        guideKDTree.findKNearestNeighbors(feature.getRoot(), NUM_CANDIDATE_GUIDES, candidates);
+        std::vector<std::pair<float, uint32_t>> candidateDistances;
+        for (const Point &candidate : candidates) {
+            const StrandFeature &guideFeature = strandFeatures[guideStrandIndices[candidate.index]];
+            candidateDistances.push_back(std::make_pair(
+                    feature.squaredDistance(guideFeature), uint32_t(candidate.index)));
+        }
+        const size_t numInterpolationGuides = std::min(
+                candidateDistances.size(), size_t(GUIDE_HAIR_NUM_INTERPOLATION_GUIDES));
+        std::partial_sort(candidateDistances.begin(), candidateDistances.begin() + numInterpolationGuides,
+                candidateDistances.end());
+
+        float weightSum = 0.0f;
+        for (uint32_t k = 0; k < GUIDE_HAIR_NUM_INTERPOLATION_GUIDES; k++) {
+            strand.guideIndices[k] = 0;
+            strand.guideWeights[k] = 0.0f;
+            if (k < numInterpolationGuides) {
+                strand.guideIndices[k] = candidateDistances[k].second;
+                strand.guideWeights[k] = 1.0f / std::max(candidateDistances[k].first, FLT_MIN);
+                weightSum += strand.guideWeights[k];
+            }
+        }
+        // Guides (and strands identical to a guide) are only interpolated from themselves.
+        if (numInterpolationGuides > 0 && candidateDistances[0].first <= FLT_MIN) {
+            strand.guideWeights[0] = 1.0f;
+            strand.guideWeights[1] = strand.guideWeights[2] = 0.0f;
+            weightSum = 1.0f;
+        }
+        for (uint32_t k = 0; k < GUIDE_HAIR_NUM_INTERPOLATION_GUIDES; k++) {
+            strand.guideWeights[k] /= weightSum;
+        }
+    }
+
+    if (!writeGuideHairFile(guideHairFilename, hairData, guideStrandIndices, strands)) {
+        return false;
+    }
+
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    sgl::Logfile::get()->writeInfo(std::string() + "convertHairFileToGuideHairFile: "
+            + sgl::toString(numGuides) + " guides for " + sgl::toString(numStrands) + " strands. "
+            + "Computational time: " + std::to_string(elapsed.count()) + "ms");
+    return true;
+}
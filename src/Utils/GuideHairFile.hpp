@@ -0,0 +1,113 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_GUIDEHAIRFILE_HPP
+#define PIXELSYNCOIT_GUIDEHAIRFILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "HairLoader.hpp"
+
+/**
+ * Guide hair format (.ghair): Instead of all render strands, only a small set of guide strands is stored explicitly.
+ * Every render strand stores its root, its number of points and the indices and weights of up to
+ * GUIDE_HAIR_NUM_INTERPOLATION_GUIDES guides. Its points are generated at load time by adding the weighted
+ * displacements of the guides from their roots to the root of the strand, i.e., for t = j / (numPoints - 1):
+ *   p_j = root + sum_k w_k * (g_k(t) - g_k(0)),
+ * where g_k(t) linearly interpolates the points of guide k at t * (numGuidePoints_k - 1). Thicknesses and colors are
+ * interpolated from the guides in the same way.
+ *
+ * All values are stored in little endian byte order. The file consists of:
+ *  - The header (see GuideHairFileHeader below).
+ *  - The guide offset table (uint32_t[numGuides+1]). The points of guide i are [guideOffsets[i], guideOffsets[i+1]).
+ *  - The guide points (glm::vec3[numGuidePoints]).
+ *  - Optionally (GUIDE_HAIR_FLAG_HAS_THICKNESS_ARRAY), the guide thicknesses (float[numGuidePoints]).
+ *  - Optionally (GUIDE_HAIR_FLAG_HAS_COLOR_ARRAY), the guide colors and opacities (RGBA8, uint32_t[numGuidePoints]).
+ *  - The render strands (GuideHairStrand[numStrands]).
+ * All arrays consist of 4 byte values, so they can be used in place from the memory-mapped file.
+ */
+const uint32_t GUIDE_HAIR_FORMAT_VERSION = 1u;
+const uint32_t GUIDE_HAIR_NUM_INTERPOLATION_GUIDES = 3u;
+
+enum GuideHairFlags {
+    GUIDE_HAIR_FLAG_HAS_THICKNESS_ARRAY = 1u,
+    GUIDE_HAIR_FLAG_HAS_COLOR_ARRAY = 2u
+};
+
+struct GuideHairFileHeader {
+    uint32_t magicNumber; ///< "GHAI"
+    uint32_t formatVersion;
+    uint32_t flags; ///< Bit field of GuideHairFlags.
+    uint32_t numGuides;
+    uint32_t numGuidePoints;
+    uint32_t numStrands;
+    float defaultThickness;
+    float defaultOpacity;
+    glm::vec3 defaultColor;
+    uint32_t padding[5];
+};
+
+struct GuideHairStrand {
+    glm::vec3 root;
+    uint32_t numPoints;
+    uint32_t guideIndices[GUIDE_HAIR_NUM_INTERPOLATION_GUIDES];
+    float guideWeights[GUIDE_HAIR_NUM_INTERPOLATION_GUIDES]; ///< Unused entries have the weight zero.
+};
+
+/// @return True if the file name has the extension of guide hair files (.ghair).
+bool isGuideHairFilename(const std::string &filename);
+
+/// @return The hair file the guides of a guide hair file are derived from ("<name>_guides.ghair" -> "<name>.hair").
+std::string getHairFilenameOfGuideHairFile(const std::string &guideHairFilename);
+
+/**
+ * Loads a guide hair file and generates all render strands from the guides in parallel.
+ * @return False if the file could not be opened or is not a valid guide hair file.
+ */
+bool loadGuideHairFile(const std::string &guideHairFilename, FlatHairData &hairData);
+
+/**
+ * Derives guide strands from a hair file (see loadHairFile) by clustering its strands and stores the guides and the
+ * interpolation weights of all strands in a guide hair file.
+ *
+ * The strands are compared by their points at the parameters t = 0, 1/3, 2/3 and 1. Starting from a spatially
+ * stratified subset of the strands (see computeHairStrandRanks), a few iterations of k-means clustering are
+ * performed, where each strand is only compared with the clusters whose centers have one of the closest roots.
+ * The strand closest to the center of a cluster becomes its guide. Each strand is then interpolated from the
+ * GUIDE_HAIR_NUM_INTERPOLATION_GUIDES most similar guides among those with the closest roots, weighted by the
+ * inverse squared distance.
+ * @param guideRatio The fraction of the strands to use as guides.
+ * @return False if the hair file could not be loaded or the guide hair file could not be written.
+ */
+bool convertHairFileToGuideHairFile(
+        const std::string &hairFilename, const std::string &guideHairFilename, float guideRatio = 1.0f / 16.0f);
+
+#endif //PIXELSYNCOIT_GUIDEHAIRFILE_HPP
@@ -2,17 +2,30 @@
 // Created by christoph on 22.01.19.
 //
 
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <random>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
 
 #include <Utils/File/Logfile.hpp>
 #include <Utils/Convert.hpp>
-#include <Utils/Events/Stream/Stream.hpp>
 #include <Math/Geometry/MatrixUtil.hpp>
 
+#include "MappedFile.hpp"
+#include "KDTree.hpp"
+#include "MeshSimplification.hpp"
 #include "MeshSerializer.hpp"
 #include "TrajectoryLoader.hpp"
 #include "HairLoader.hpp"
+#include "GuideHairFile.hpp"
+
+// Parameters of the stratified selection of strands for the levels of detail (see computeHairStrandRanks).
+const int HAIR_LOD_STRANDS_PER_CELL = 16;
+const uint32_t HAIR_LOD_RANDOM_SEED = 17u;
 
 uint32_t toUint32Color(const glm::vec4 &vecColor) {
     uint32_t packedColor;
@@ -24,43 +37,65 @@ uint32_t toUint32Color(const glm::vec4 &vecColor) {
 }
 
 /**
- * Loads the specified hair file into memory.
- * For more on the file format see http://www.cemyuksel.com/research/hairmodels/
+ * The 128 byte header of a hair file.
  */
-void loadHairFile(const std::string &hairFilename, HairData &hairData) {
-    std::ifstream file(hairFilename.c_str(), std::ifstream::binary);
-    if (!file.is_open()) {
-        sgl::Logfile::get()->writeError(std::string() +
-                "Error in readMesh3D: File \"" + hairFilename + "\" not found.");
-        return;
+struct HairFileHeader {
+    uint32_t magicNumber;
+    uint32_t numStrands;
+    uint32_t totalNumPoints;
+    uint32_t settingsBitField;
+    uint32_t defaultNumSegments;
+    float defaultThickness;
+    float defaultOpacity;
+    glm::vec3 defaultColor;
+    char fileInformation[88];
+};
+
+/**
+ * Copies an array from the mapped file in parallel chunks. The source may not be aligned.
+ */
+static void copyArrayParallel(void *dst, const uint8_t *src, size_t numBytes)
+{
+    const size_t CHUNK_SIZE = 1 << 20;
+    const size_t numChunks = (numBytes + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    #pragma omp parallel for
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+        size_t offset = chunkIdx * CHUNK_SIZE;
+        memcpy((uint8_t*)dst + offset, src + offset, std::min(CHUNK_SIZE, numBytes - offset));
     }
+}
 
-    file.seekg(0, file.end);
-    size_t size = file.tellg();
-    file.seekg(0);
-    char *buffer = new char[size];
-    file.read(buffer, size);
+bool loadHairFile(const std::string &hairFilename, FlatHairData &hairData) {
+    if (isGuideHairFilename(hairFilename)) {
+        return loadGuideHairFile(hairFilename, hairData);
+    }
+
+    MappedFile file;
+    if (!file.open(hairFilename)) {
+        sgl::Logfile::get()->writeError(std::string() +
+                "Error in loadHairFile: File \"" + hairFilename + "\" not found.");
+        return false;
+    }
+    const uint8_t *data = file.getData();
+    const size_t size = file.getSize();
 
     // Read magic number
-    sgl::BinaryReadStream stream(buffer, size);
     const uint32_t FILE_FORMAT_HAIR_MAGIC_NUMBER = 0x52494148; // 48 41 49 52
-    uint32_t magicNumber;
-    stream.read(magicNumber);
-    if (magicNumber != FILE_FORMAT_HAIR_MAGIC_NUMBER) {
+    HairFileHeader header;
+    if (size < sizeof(HairFileHeader)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: File \""
+                                        + hairFilename + "\" is too small.");
+        return false;
+    }
+    memcpy(&header, data, sizeof(HairFileHeader));
+    if (header.magicNumber != FILE_FORMAT_HAIR_MAGIC_NUMBER) {
         sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Invalid magic number in file \""
                                         + hairFilename + "\".");
-        return;
+        return false;
     }
 
-
-
-    // Rest of header after magic number
-    uint32_t numStrands, totalNumPoints, settingsBitField;
-    stream.read(numStrands);
-    stream.read(totalNumPoints);
-    stream.read(settingsBitField);
-
     // Read bitfield options
+    const uint32_t settingsBitField = header.settingsBitField;
     bool hasSegmentsArray, hasPointsArray, hasThicknessArray, hasOpacityArray, hasColorArray;
     hasSegmentsArray = (settingsBitField & 0x1) == 1;
     hasPointsArray = (settingsBitField >> 1 & 0x1) == 1;
@@ -71,142 +106,135 @@ void loadHairFile(const std::string &hairFilename, HairData &hairData) {
     if (!hasPointsArray) {
         sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Invalid bitfield in file \""
                                         + hairFilename + "\".");
-        return;
+        return false;
     }
 
-    // Read default values
-    uint32_t defaultNumSegments;
-    float defaultThickness, defaultOpacity;
-    glm::vec3 defaultColor;
-    stream.read(defaultNumSegments);
-    stream.read(defaultThickness);
-    stream.read(defaultOpacity);
-    stream.read(defaultColor);
-
-    // Read file information
-    const size_t FILE_INFO_SIZE = 88;
-    char fileInformation[FILE_INFO_SIZE];
-    stream.read(fileInformation, FILE_INFO_SIZE);
-
-
     // ---------- Starting from here: Read actual hair data ----------
 
-    // First: Read number of segments per strand and reserve data for point, thickness and color arrays (if necessary)
+    // First: Compute the offsets of the strands from the number of segments per strand.
+    const size_t numStrands = header.numStrands;
+    size_t offset = sizeof(HairFileHeader);
     hairData.filename = hairFilename;
-    hairData.strands.resize(numStrands);
+    hairData.strandOffsets.resize(numStrands + 1);
+    hairData.strandOffsets.at(0) = 0;
     if (hasSegmentsArray) {
-        std::vector<uint16_t> segmentsArray;
-        segmentsArray.resize(numStrands);
-        stream.read(&segmentsArray.front(), numStrands * sizeof(uint16_t));
+        if (size - offset < numStrands * sizeof(uint16_t)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: File \""
+                                            + hairFilename + "\" is truncated.");
+            return false;
+        }
+        std::vector<uint16_t> segmentsArray(numStrands);
+        memcpy(segmentsArray.data(), data + offset, numStrands * sizeof(uint16_t));
+        offset += numStrands * sizeof(uint16_t);
+        uint64_t numPoints = 0;
         for (size_t i = 0; i < numStrands; i++) {
-            size_t numPoints = segmentsArray.at(i)+1;
-            HairStrand &strand = hairData.strands.at(i);
-            strand.points.resize(numPoints);
-            if (hasThicknessArray) {
-                strand.thicknesses.resize(numPoints);
-            }
-            if (hasOpacityArray || hasColorArray) {
-                strand.colors.resize(numPoints);
-            }
+            numPoints += uint64_t(segmentsArray.at(i)) + 1;
+            hairData.strandOffsets.at(i+1) = uint32_t(numPoints);
+        }
+        if (numPoints > UINT32_MAX) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Too many points in file \""
+                                            + hairFilename + "\".");
+            return false;
         }
     } else {
-        for (HairStrand &strand : hairData.strands) {
-            size_t numPoints = defaultNumSegments+1;
-            strand.points.resize(numPoints);
-            if (hasThicknessArray) {
-                strand.thicknesses.resize(numPoints);
-            }
-            if (hasOpacityArray || hasColorArray) {
-                strand.colors.resize(numPoints);
-            }
+        if ((uint64_t(header.defaultNumSegments) + 1) * numStrands > UINT32_MAX) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Too many points in file \""
+                                            + hairFilename + "\".");
+            return false;
+        }
+        #pragma omp parallel for
+        for (size_t i = 0; i < numStrands; i++) {
+            hairData.strandOffsets.at(i+1) = uint32_t((i + 1) * (header.defaultNumSegments + 1));
         }
     }
+    const size_t totalNumPoints = hairData.strandOffsets.back();
+
+    // All arrays need to be stored in the file.
+    size_t bytesPerPoint = sizeof(glm::vec3);
+    if (hasThicknessArray) bytesPerPoint += sizeof(float);
+    if (hasOpacityArray) bytesPerPoint += sizeof(float);
+    if (hasColorArray) bytesPerPoint += sizeof(glm::vec3);
+    if ((size - offset) / bytesPerPoint < totalNumPoints) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: File \""
+                                        + hairFilename + "\" is truncated.");
+        return false;
+    }
 
     // Next: Read points array (obligatory)
-    for (HairStrand &strand : hairData.strands) {
-        stream.read(&strand.points.front(), strand.points.size() * sizeof(float) * 3);
-    }
+    hairData.points.resize(totalNumPoints);
+    copyArrayParallel(hairData.points.data(), data + offset, totalNumPoints * sizeof(glm::vec3));
+    offset += totalNumPoints * sizeof(glm::vec3);
 
     // Next: Read thickness array (optional)
     hairData.hasThicknessArray = hasThicknessArray;
-    hairData.defaultThickness = defaultThickness;
+    hairData.defaultThickness = header.defaultThickness;
+    hairData.thicknesses.clear();
     if (hasThicknessArray) {
-        for (HairStrand &strand : hairData.strands) {
-            stream.read(&strand.thicknesses.front(), strand.thicknesses.size() * sizeof(float));
-        }
+        hairData.thicknesses.resize(totalNumPoints);
+        copyArrayParallel(hairData.thicknesses.data(), data + offset, totalNumPoints * sizeof(float));
+        offset += totalNumPoints * sizeof(float);
     }
 
-    // Next: Read opacity and color array (optional)
+    // Next: Read opacity and color array (optional) and merge them to 32-bit RGBA colors
     hairData.hasColorArray = hasOpacityArray || hasColorArray;
-    hairData.defaultOpacity = defaultOpacity;
-    hairData.defaultColor = defaultColor;
+    hairData.defaultOpacity = header.defaultOpacity;
+    hairData.defaultColor = header.defaultColor;
+    hairData.colors.clear();
     if (hairData.hasColorArray) {
-        // 1. Read color and opacity arrays (optional)
-        std::vector<std::vector<float>> opacityArrays;
-        std::vector<std::vector<glm::vec3>> colorArrays;
-        opacityArrays.resize(numStrands);
-        colorArrays.resize(numStrands);
-        if (hasOpacityArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                std::vector<float> &opacityArray = opacityArrays.at(i);
-                opacityArray.resize(hairData.strands.at(i).colors.size());
-                stream.read(&opacityArray.front(), hairData.strands.at(i).points.size() * sizeof(float));
+        const uint8_t *opacityArray = hasOpacityArray ? data + offset : NULL;
+        const uint8_t *colorArray = hasColorArray
+                ? data + offset + (hasOpacityArray ? totalNumPoints * sizeof(float) : 0) : NULL;
+        const float defaultOpacity = header.defaultOpacity;
+        const glm::vec3 defaultColor = header.defaultColor;
+        hairData.colors.resize(totalNumPoints);
+        #pragma omp parallel for
+        for (size_t i = 0; i < totalNumPoints; i++) {
+            float opacity = defaultOpacity;
+            glm::vec3 color = defaultColor;
+            if (opacityArray) {
+                memcpy(&opacity, opacityArray + i * sizeof(float), sizeof(float));
             }
-        }
-        if (hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                std::vector<glm::vec3> &colorArray = colorArrays.at(i);
-                colorArray.resize(hairData.strands.at(i).colors.size());
-                stream.read(&colorArray.front(), hairData.strands.at(i).points.size() * sizeof(glm::vec3));
+            if (colorArray) {
+                memcpy(&color, colorArray + i * sizeof(glm::vec3), sizeof(glm::vec3));
             }
+            hairData.colors[i] = toUint32Color(glm::vec4(color, opacity));
         }
+    }
 
-        // 2. Merge the arrays
-        std::vector<std::vector<glm::vec4>> mergedColorOpacityArrays;
-        mergedColorOpacityArrays.resize(numStrands);
-        if (hasOpacityArray && hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                size_t numPoints = hairData.strands.at(i).points.size();
-                std::vector<float> &opacityArray = opacityArrays.at(i);
-                std::vector<glm::vec3> &colorArray = colorArrays.at(i);
-                std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-                mergedColorOpacityArray.resize(hairData.strands.at(i).colors.size());
-                for (size_t j = 0; j < numPoints; j++) {
-                    mergedColorOpacityArray.at(j) = glm::vec4(colorArray.at(j), opacityArray.at(j));
-                }
-            }
-        } else if (hasOpacityArray && !hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                size_t numPoints = hairData.strands.at(i).points.size();
-                std::vector<float> &opacityArray = opacityArrays.at(i);
-                std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-                mergedColorOpacityArray.resize(hairData.strands.at(i).colors.size());
-                for (size_t j = 0; j < numPoints; j++) {
-                    mergedColorOpacityArray.at(j) = glm::vec4(defaultColor, opacityArray.at(j));
-                }
-            }
-        } else { //if (!hasOpacityArray && hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                size_t numPoints = hairData.strands.at(i).points.size();
-                std::vector<glm::vec3> &colorArray = colorArrays.at(i);
-                std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-                mergedColorOpacityArray.resize(hairData.strands.at(i).colors.size());
-                for (size_t j = 0; j < numPoints; j++) {
-                    mergedColorOpacityArray.at(j) = glm::vec4(colorArray.at(j), defaultOpacity);
-                }
-            }
-        }
+    return true;
+}
 
-        // 3. Convert floating point colors & opacities to 32-bit RGBA colors
-        for (size_t i = 0; i < numStrands; i++) {
-            size_t numPoints = hairData.strands.at(i).points.size();
-            std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-            std::vector<uint32_t> &colorArray = hairData.strands.at(i).colors;
-            for (size_t j = 0; j < numPoints; j++) {
-                colorArray.at(j) = toUint32Color(mergedColorOpacityArray.at(j));
-            }
-        }
+/**
+ * Loads the specified hair file into memory.
+ * For more on the file format see http://www.cemyuksel.com/research/hairmodels/
+ */
+void loadHairFile(const std::string &hairFilename, HairData &hairData) {
+    FlatHairData flatHairData;
+    if (!loadHairFile(hairFilename, flatHairData)) {
+        return;
+    }
+
+    hairData.filename = flatHairData.filename;
+    hairData.hasThicknessArray = flatHairData.hasThicknessArray;
+    hairData.hasColorArray = flatHairData.hasColorArray;
+    hairData.defaultThickness = flatHairData.defaultThickness;
+    hairData.defaultOpacity = flatHairData.defaultOpacity;
+    hairData.defaultColor = flatHairData.defaultColor;
 
+    const size_t numStrands = flatHairData.getNumStrands();
+    hairData.strands.resize(numStrands);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < numStrands; i++) {
+        HairStrand &strand = hairData.strands.at(i);
+        const uint32_t begin = flatHairData.strandOffsets.at(i), end = flatHairData.strandOffsets.at(i+1);
+        strand.points.assign(flatHairData.points.begin() + begin, flatHairData.points.begin() + end);
+        if (flatHairData.hasThicknessArray) {
+            strand.thicknesses.assign(
+                    flatHairData.thicknesses.begin() + begin, flatHairData.thicknesses.begin() + end);
+        }
+        if (flatHairData.hasColorArray) {
+            strand.colors.assign(flatHairData.colors.begin() + begin, flatHairData.colors.begin() + end);
+        }
     }
 }
 
@@ -236,76 +264,159 @@ void downscaleHairData(HairData &hairData, float scalingFactor)
     }
 }
 
-void convertHairDataToBinaryTriangleMesh(
-        const std::string &hairFilename,
-        const std::string &binaryFilename)
+void downscaleHairData(FlatHairData &hairData, float scalingFactor)
 {
-    // First, load the hair data from the specified file
-    HairData hairData;
-    loadHairFile(hairFilename, hairData);
-    downscaleHairData(hairData, HAIR_MODEL_SCALING_FACTOR);
-
-    BinaryMesh binaryMesh;
-    binaryMesh.submeshes.push_back(BinarySubMesh());
-    BinarySubMesh &submesh = binaryMesh.submeshes.front();
-    submesh.vertexMode = sgl::VERTEX_MODE_TRIANGLES;
+    hairData.defaultThickness *= scalingFactor;
 
-    std::vector<glm::vec3> globalVertexPositions;
-    std::vector<glm::vec3> globalNormals;
-    std::vector<uint32_t> globalColors;
-    std::vector<uint32_t> globalIndices;
+    // For some hair data files: Swap y-axis and z-axis
+    bool swapAxes = !boost::starts_with(hairData.filename, "Data/Hair/ponytail")
+            && !boost::starts_with(hairData.filename, "Data/Hair/bear");
+    glm::mat4 hairRotationMatrix = sgl::matrixRowMajor(
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+    );
+    #pragma omp parallel for
+    for (size_t i = 0; i < hairData.points.size(); i++) {
+        glm::vec3 &pt = hairData.points[i];
+        pt *= scalingFactor;
+        if (swapAxes) {
+            pt = sgl::transformPoint(hairRotationMatrix, pt);
+        }
+    }
+}
 
-    initializeCircleData(3, hairData.defaultThickness);
+float computeHairStrandRanks(const FlatHairData &hairData, std::vector<float> &strandRanks)
+{
+    const size_t numStrands = hairData.getNumStrands();
+    strandRanks.clear();
+    strandRanks.resize(numStrands, 0.0f);
+    if (numStrands < 2) {
+        return 0.0f;
+    }
 
-    size_t numStrands = hairData.strands.size();
-    for (HairStrand &strand : hairData.strands) {
-        std::vector<glm::vec3> &pathLineCenters = strand.points;
-        std::vector<float> &pathLineThicknesses = strand.thicknesses;
-        std::vector<uint32_t> &pathLineColors = strand.colors;
-
-        // Create tube render data
-        std::vector<glm::vec3> localVertices;
-        std::vector<uint32_t> localColors;
-        std::vector<glm::vec3> localNormals;
-        std::vector<uint32_t> localIndices;
-        if (hairData.hasThicknessArray) {
-            sgl::Logfile::get()->writeError("Error in convertHairDataToBinaryTriangleMesh: Variable thickness not yet "
-                                            "supported.");
-        } else {
-            createTubeRenderData(pathLineCenters, pathLineColors, localVertices, localNormals, localColors, localIndices);
+    // The typical spacing of the strands is the median distance of a root to the closest other root.
+    std::vector<glm::vec3> roots(numStrands);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numStrands; i++) {
+        roots[i] = hairData.points[hairData.strandOffsets[i]];
+    }
+    KDTree kdTree;
+    kdTree.build(roots);
+    std::vector<float> closestDistances(numStrands);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numStrands; i++) {
+        std::vector<Point> neighbors;
+        kdTree.findKNearestNeighbors(roots[i], 2, neighbors);
+        closestDistances[i] = glm::length(neighbors.back().position - roots[i]);
+    }
+    std::nth_element(closestDistances.begin(), closestDistances.begin() + numStrands / 2, closestDistances.end());
+    const float rootSpacing = closestDistances[numStrands / 2];
+    closestDistances.clear(); closestDistances.shrink_to_fit();
+
+    // Stratify the strands with a grid of about HAIR_LOD_STRANDS_PER_CELL roots per cell (on the scalp surface).
+    const float cellSize = std::max(rootSpacing * std::sqrt(float(HAIR_LOD_STRANDS_PER_CELL)), FLT_MIN);
+    sgl::AABB3 rootsAABB;
+    for (const glm::vec3 &root : roots) {
+        rootsAABB.combine(root);
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> strandCells(numStrands);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numStrands; i++) {
+        glm::ivec3 cell = glm::ivec3(glm::min((roots[i] - rootsAABB.getMinimum()) / cellSize, glm::vec3(2097151.0f)));
+        uint64_t cellKey = uint64_t(cell.x) | (uint64_t(cell.y) << 21) | (uint64_t(cell.z) << 42);
+        strandCells[i] = std::make_pair(cellKey, uint32_t(i));
+    }
+    roots.clear(); roots.shrink_to_fit();
+
+    // Shuffle the strands of each cell. The strand at position k of m gets the rank (k + jitter) / m, i.e., the
+    // ranks of each cell are stratified in [0, 1).
+    std::mt19937 generator(HAIR_LOD_RANDOM_SEED);
+    std::shuffle(strandCells.begin(), strandCells.end(), generator);
+    std::stable_sort(strandCells.begin(), strandCells.end(),
+            [](const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b) {
+        return a.first < b.first;
+    });
+    std::uniform_real_distribution<float> jitterDistribution(0.0f, 1.0f);
+    size_t cellStart = 0;
+    while (cellStart < numStrands) {
+        size_t cellEnd = cellStart + 1;
+        while (cellEnd < numStrands && strandCells[cellEnd].first == strandCells[cellStart].first) {
+            cellEnd++;
         }
-        //createTubeRenderData(pathLineCenters, pathLineThicknesses, hairData.defaultThickness, pathLineColors,
-        //        localVertices, localColors, localIndices);
-        //createNormals(localVertices, localIndices, localNormals);
-
-        // Local -> global
-        for (size_t i = 0; i < localIndices.size(); i++) {
-            globalIndices.push_back(localIndices.at(i) + globalVertexPositions.size());
+        const float numCellStrands = float(cellEnd - cellStart);
+        for (size_t i = cellStart; i < cellEnd; i++) {
+            float jitter = jitterDistribution(generator);
+            strandRanks[strandCells[i].second] = std::min((float(i - cellStart) + jitter) / numCellStrands, 1.0f);
         }
-        globalVertexPositions.insert(globalVertexPositions.end(), localVertices.begin(), localVertices.end());
-        globalColors.insert(globalColors.end(), localColors.begin(), localColors.end());
-        globalNormals.insert(globalNormals.end(), localNormals.begin(), localNormals.end());
+        cellStart = cellEnd;
+    }
+
+    return rootSpacing;
+}
+
+float compensateHairOpacity(float opacity, float strandRatio)
+{
+    if (opacity >= 1.0f || strandRatio >= 1.0f) {
+        return opacity;
     }
+    return 1.0f - std::pow(1.0f - opacity, 1.0f / strandRatio);
+}
 
+/// The tube geometry of a set of strands.
+struct HairTubeGeometry {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> colors;
+    std::vector<uint32_t> indices;
+    size_t numStrands = 0;
+};
+
+/**
+ * Appends the tube of a strand to the geometry of a level of detail (local indices -> global indices).
+ * @param alphaTable If not NULL, the alpha channel of the colors is mapped with this table.
+ */
+static void appendHairTube(const HairTubeGeometry &tube, HairTubeGeometry &geometry, const uint8_t *alphaTable)
+{
+    const uint32_t indexOffset = uint32_t(geometry.vertices.size());
+    for (size_t i = 0; i < tube.indices.size(); i++) {
+        geometry.indices.push_back(tube.indices.at(i) + indexOffset);
+    }
+    geometry.vertices.insert(geometry.vertices.end(), tube.vertices.begin(), tube.vertices.end());
+    geometry.normals.insert(geometry.normals.end(), tube.normals.begin(), tube.normals.end());
+    if (alphaTable == NULL) {
+        geometry.colors.insert(geometry.colors.end(), tube.colors.begin(), tube.colors.end());
+    } else {
+        for (uint32_t color : tube.colors) {
+            geometry.colors.push_back((color & 0x00FFFFFFu) | (uint32_t(alphaTable[color >> 24]) << 24));
+        }
+    }
+    geometry.numStrands++;
+}
 
+static void createHairSubmesh(
+        const HairTubeGeometry &geometry, const FlatHairData &hairData, float opacity, BinarySubMesh &submesh)
+{
+    submesh.vertexMode = sgl::VERTEX_MODE_TRIANGLES;
     submesh.material.diffuseColor = hairData.defaultColor;
-    submesh.material.opacity = hairData.defaultOpacity;
-    submesh.indices = globalIndices;
+    submesh.material.opacity = opacity;
+    submesh.indices = geometry.indices;
 
     BinaryMeshAttribute positionAttribute;
     positionAttribute.name = "vertexPosition";
     positionAttribute.attributeFormat = sgl::ATTRIB_FLOAT;
     positionAttribute.numComponents = 3;
-    positionAttribute.data.resize(globalVertexPositions.size() * sizeof(glm::vec3));
-    memcpy(&positionAttribute.data.front(), &globalVertexPositions.front(), globalVertexPositions.size() * sizeof(glm::vec3));
+    positionAttribute.data.resize(geometry.vertices.size() * sizeof(glm::vec3));
+    memcpy(&positionAttribute.data.front(), &geometry.vertices.front(), geometry.vertices.size() * sizeof(glm::vec3));
     submesh.attributes.push_back(positionAttribute);
 
     BinaryMeshAttribute lineNormalsAttribute;
     lineNormalsAttribute.name = "vertexNormal";
     lineNormalsAttribute.attributeFormat = sgl::ATTRIB_FLOAT;
     lineNormalsAttribute.numComponents = 3;
-    lineNormalsAttribute.data.resize(globalNormals.size() * sizeof(glm::vec3));
-    memcpy(&lineNormalsAttribute.data.front(), &globalNormals.front(), globalNormals.size() * sizeof(glm::vec3));
+    lineNormalsAttribute.data.resize(geometry.normals.size() * sizeof(glm::vec3));
+    memcpy(&lineNormalsAttribute.data.front(), &geometry.normals.front(), geometry.normals.size() * sizeof(glm::vec3));
     submesh.attributes.push_back(lineNormalsAttribute);
 
     if (hairData.hasColorArray) {
@@ -313,8 +424,8 @@ void convertHairDataToBinaryTriangleMesh(
         colorsAttribute.name = "vertexColor";
         colorsAttribute.attributeFormat = sgl::ATTRIB_UNSIGNED_BYTE;
         colorsAttribute.numComponents = 4;
-        colorsAttribute.data.resize(globalColors.size() * sizeof(uint32_t));
-        memcpy(&colorsAttribute.data.front(), &globalColors.front(), globalColors.size() * sizeof(uint32_t));
+        colorsAttribute.data.resize(geometry.colors.size() * sizeof(uint32_t));
+        memcpy(&colorsAttribute.data.front(), &geometry.colors.front(), geometry.colors.size() * sizeof(uint32_t));
         submesh.attributes.push_back(colorsAttribute);
     }
 
@@ -328,10 +439,132 @@ void convertHairDataToBinaryTriangleMesh(
         memcpy(&thicknessesAttribute.data.front(), &globalThicknesses.front(), globalThicknesses.size() * sizeof(float));
         submesh.attributes.push_back(thicknessesAttribute);*/
     }
+}
+
+bool createHairBinaryTriangleMesh(
+        const std::string &hairFilename,
+        BinaryMesh &binaryMesh,
+        const std::vector<float> &lodStrandRatios)
+{
+    // First, load the hair data from the specified file
+    FlatHairData hairData;
+    if (!loadHairFile(hairFilename, hairData)) {
+        return false;
+    }
+    downscaleHairData(hairData, HAIR_MODEL_SCALING_FACTOR);
+
+    initializeCircleData(3, hairData.defaultThickness);
+
+    if (hairData.hasThicknessArray) {
+        sgl::Logfile::get()->writeError("Error in convertHairDataToBinaryTriangleMesh: Variable thickness not yet "
+                                        "supported. Using the default thickness for all strands.");
+    }
+
+    // Level 0 contains all strands, the levels of detail the strands with a rank less than their strand ratio.
+    std::vector<float> strandRatios = { 1.0f };
+    for (float ratio : lodStrandRatios) {
+        if (ratio > 0.0f && ratio < 1.0f) {
+            strandRatios.push_back(ratio);
+        }
+    }
+    std::sort(strandRatios.begin() + 1, strandRatios.end(), std::greater<float>());
+    std::vector<float> strandRanks;
+    float rootSpacing = 0.0f;
+    if (strandRatios.size() > 1) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Computing the strand ranks for the levels of detail...");
+        rootSpacing = computeHairStrandRanks(hairData, strandRanks);
+    }
+    const size_t numLevels = strandRatios.size();
+    std::vector<HairTubeGeometry> levelGeometries(numLevels);
+    std::vector<float> levelOpacities(numLevels);
+    std::vector<std::vector<uint8_t>> levelAlphaTables(numLevels);
+    for (size_t level = 0; level < numLevels; level++) {
+        levelOpacities.at(level) = compensateHairOpacity(hairData.defaultOpacity, strandRatios.at(level));
+        if (level > 0) {
+            levelAlphaTables.at(level).resize(256);
+            for (int alpha = 0; alpha < 256; alpha++) {
+                levelAlphaTables.at(level).at(alpha) = uint8_t(glm::round(
+                        compensateHairOpacity(float(alpha) / 255.0f, strandRatios.at(level)) * 255.0f));
+            }
+        }
+    }
+
+    // The tubes of a block of strands are created in parallel and then appended in the order of the strands.
+    const size_t STRAND_BLOCK_SIZE = 4096;
+    std::vector<HairTubeGeometry> strandTubes(STRAND_BLOCK_SIZE);
+
+    const size_t numStrands = hairData.getNumStrands();
+    for (size_t blockStart = 0; blockStart < numStrands; blockStart += STRAND_BLOCK_SIZE) {
+        const size_t blockEnd = std::min(blockStart + STRAND_BLOCK_SIZE, numStrands);
+
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t strandIdx = blockStart; strandIdx < blockEnd; strandIdx++) {
+            const uint32_t begin = hairData.strandOffsets[strandIdx], end = hairData.strandOffsets[strandIdx+1];
+            std::vector<glm::vec3> pathLineCenters(
+                    hairData.points.begin() + begin, hairData.points.begin() + end);
+            std::vector<uint32_t> pathLineColors;
+            if (hairData.hasColorArray) {
+                pathLineColors.assign(hairData.colors.begin() + begin, hairData.colors.begin() + end);
+            }
+
+            // Create tube render data
+            HairTubeGeometry &tube = strandTubes.at(strandIdx - blockStart);
+            tube.vertices.clear();
+            tube.normals.clear();
+            tube.colors.clear();
+            tube.indices.clear();
+            createTubeRenderData(pathLineCenters, pathLineColors, tube.vertices, tube.normals, tube.colors,
+                    tube.indices);
+        }
+
+        for (size_t strandIdx = blockStart; strandIdx < blockEnd; strandIdx++) {
+            const HairTubeGeometry &tube = strandTubes.at(strandIdx - blockStart);
+            appendHairTube(tube, levelGeometries.at(0), NULL);
+            for (size_t level = 1; level < numLevels; level++) {
+                if (strandRanks.at(strandIdx) < strandRatios.at(level)) {
+                    appendHairTube(tube, levelGeometries.at(level), &levelAlphaTables.at(level).front());
+                }
+            }
+        }
+    }
+    strandTubes.clear();
+
+    // Store each level as a submesh. The geometric error of a level is the typical spacing of its strands.
+    binaryMesh.submeshes.clear();
+    size_t lastNumStrands = numStrands + 1;
+    for (size_t level = 0; level < numLevels; level++) {
+        HairTubeGeometry &geometry = levelGeometries.at(level);
+        if (geometry.indices.empty() || geometry.numStrands >= lastNumStrands) {
+            continue;
+        }
+        lastNumStrands = geometry.numStrands;
+
+        binaryMesh.submeshes.push_back(BinarySubMesh());
+        createHairSubmesh(geometry, hairData, levelOpacities.at(level), binaryMesh.submeshes.back());
+        if (numLevels > 1) {
+            float lodError = rootSpacing / std::sqrt(strandRatios.at(level));
+            setSubmeshLod(binaryMesh.submeshes.back(), uint32_t(binaryMesh.submeshes.size() - 1),
+                    level == 0 ? 0.0f : lodError);
+        }
+        sgl::Logfile::get()->writeInfo(std::string() + "Summary (level " + sgl::toString(level) + ", "
+                + sgl::toString(geometry.numStrands) + " strands): "
+                + sgl::toString(geometry.vertices.size()) + " vertices, "
+                + sgl::toString(geometry.indices.size()) + " indices.");
+        geometry = HairTubeGeometry();
+    }
+    return true;
+}
+
+void convertHairDataToBinaryTriangleMesh(
+        const std::string &hairFilename,
+        const std::string &binaryFilename,
+        const std::vector<float> &lodStrandRatios)
+{
+    BinaryMesh binaryMesh;
+    if (!createHairBinaryTriangleMesh(hairFilename, binaryMesh, lodStrandRatios)) {
+        return;
+    }
 
-    sgl::Logfile::get()->writeInfo(std::string() + "Summary: "
-                              + sgl::toString(globalVertexPositions.size()) + " vertices, "
-                              + sgl::toString(globalIndices.size()) + " indices.");
     sgl::Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
     writeMesh3D(binaryFilename, binaryMesh);
 }
@@ -8,6 +8,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 
@@ -37,16 +38,89 @@ struct HairData {
     glm::vec3 defaultColor;
 };
 
+/**
+ * The same data as HairData in a structure-of-arrays layout. The points of strand i are
+ * [strandOffsets[i], strandOffsets[i+1]) in the per-point arrays.
+ */
+struct FlatHairData {
+    std::string filename;
+    std::vector<uint32_t> strandOffsets;
+
+    // Obligatory data
+    std::vector<glm::vec3> points;
+
+    // --- For all following data fields: If the vector is empty, assume constant default value for all points ---
+    std::vector<float> thicknesses;
+    // Opacity & color (merged to one array if either opacity or color is given)
+    std::vector<uint32_t> colors;
+
+    bool hasThicknessArray;
+    bool hasColorArray;
+    float defaultThickness;
+    float defaultOpacity;
+    glm::vec3 defaultColor;
+
+    inline size_t getNumStrands() const { return strandOffsets.empty() ? 0 : strandOffsets.size() - 1; }
+    inline size_t getNumStrandPoints(size_t strandIdx) const {
+        return strandOffsets[strandIdx+1] - strandOffsets[strandIdx];
+    }
+};
+
 /**
  * Loads the specified hair file into memory.
  * For more on the file format see http://www.cemyuksel.com/research/hairmodels/
  */
 void loadHairFile(const std::string &hairFilename, HairData &hairData);
 
+/**
+ * Loads the specified hair file into the structure-of-arrays layout. The file is memory-mapped, and the point,
+ * thickness, opacity and color arrays are decoded in parallel. Guide hair files (.ghair, see GuideHairFile.hpp) are
+ * expanded to all render strands.
+ * @return False if the file could not be opened or is not a valid hair file.
+ */
+bool loadHairFile(const std::string &hairFilename, FlatHairData &hairData);
+
+struct BinaryMesh;
+
+/**
+ * Converts the hair strands to tubes and stores them in a binmesh file.
+ * @param lodStrandRatios For each entry, a level of detail keeping approximately this fraction of the strands is stored
+ * in the binmesh file (using the LOD uniforms of MeshSimplification.hpp). The kept strands are a stratified random
+ * subset (see computeHairStrandRanks), and their opacity is increased (see compensateHairOpacity). The geometric
+ * error of a level is the typical spacing of its strand roots.
+ */
 void convertHairDataToBinaryTriangleMesh(
         const std::string &hairFilename,
-        const std::string &binaryFilename);
+        const std::string &binaryFilename,
+        const std::vector<float> &lodStrandRatios = std::vector<float>());
+
+/**
+ * Same as convertHairDataToBinaryTriangleMesh, but only creates the mesh in memory (e.g., for guide hair files, whose
+ * expanded tube mesh is too large to be worth caching on disk).
+ * @return False if the hair file could not be loaded.
+ */
+bool createHairBinaryTriangleMesh(
+        const std::string &hairFilename,
+        BinaryMesh &binaryMesh,
+        const std::vector<float> &lodStrandRatios = std::vector<float>());
+
+/**
+ * Assigns each strand a rank in [0, 1) used for selecting the strands of the levels of detail. A level keeping the
+ * fraction p of the strands contains the strands with a rank less than p, so each level is a subset of the finer
+ * levels. The ranks are stratified spatially: The strand roots are sorted into the cells of a uniform grid, and the
+ * ranks of the strands of each cell are a jittered, shuffled sequence (k + jitter) / m, k = 0, ..., m - 1. Thus,
+ * every cell keeps about the fraction p of its strands. The result is deterministic.
+ * @return The typical spacing of the strand roots (the median distance of a root to its closest neighbor).
+ */
+float computeHairStrandRanks(const FlatHairData &hairData, std::vector<float> &strandRanks);
+
+/**
+ * Computes the opacity of the strands of a level keeping the fraction strandRatio of the strands such that the
+ * transmittance of the kept strands matches the one of the full model, i.e., (1 - a')^(n * strandRatio) = (1 - a)^n.
+ */
+float compensateHairOpacity(float opacity, float strandRatio);
 
 void downscaleHairData(HairData &hairData, float scalingFactor);
+void downscaleHairData(FlatHairData &hairData, float scalingFactor);
 
 #endif //PIXELSYNCOIT_HAIRLOADER_HPP
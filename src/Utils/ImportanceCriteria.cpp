@@ -17,10 +17,16 @@ void packUnorm16Array(const std::vector<float> &floatVector, std::vector<uint16_
     }
 
     unormVector.resize(floatVector.size());
+    packUnorm16Array(floatVector.data(), floatVector.size(), minValue, maxValue, unormVector.data());
+}
+
+void packUnorm16Array(
+        const float *floatValues, size_t numValues, float minValue, float maxValue, uint16_t *unormValues)
+{
     #pragma omp parallel for
-    for (size_t i = 0; i < unormVector.size(); i++) {
-        unormVector.at(i) = glm::round(glm::clamp((floatVector.at(i) - minValue) / (maxValue - minValue),
-                                                  0.0f, 1.0f) * 65535.0f);
+    for (size_t i = 0; i < numValues; i++) {
+        unormValues[i] = glm::round(glm::clamp((floatValues[i] - minValue) / (maxValue - minValue),
+                                               0.0f, 1.0f) * 65535.0f);
     }
 }
 
@@ -46,6 +52,16 @@ void unpackUnorm16Array(uint16_t *unormVector, size_t vectorSize, std::vector<fl
     }
 }
 
+/// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/unpackUnorm.xhtml
+void unpackUnorm8Array(uint8_t *unormVector, size_t vectorSize, std::vector<float> &floatVector)
+{
+    floatVector.resize(vectorSize);
+    #pragma omp parallel for
+    for (size_t i = 0; i < vectorSize; i++) {
+        floatVector.at(i) = unormVector[i]/255.0;
+    }
+}
+
 
 std::vector<float> computeSegmentLengths(std::vector<glm::vec3> &vertexPositions)
 {
@@ -61,6 +61,13 @@ const char *const IMPORTANCE_CRITERION_CFD_DISPLAYNAMES[] = {
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/packUnorm.xhtml
 void packUnorm16Array(const std::vector<float> &floatVector, std::vector<uint16_t> &unormVector);
 
+/**
+ * Same as above, but maps the range [minValue, maxValue] to [0, 65535] instead of the range of the passed values
+ * (e.g., for packing an array chunk by chunk).
+ */
+void packUnorm16Array(
+        const float *floatValues, size_t numValues, float minValue, float maxValue, uint16_t *unormValues);
+
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/packUnorm.xhtml
 void packUnorm16ArrayOfArrays(
         const std::vector<std::vector<float>> &floatVector,
@@ -69,6 +76,9 @@ void packUnorm16ArrayOfArrays(
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/unpackUnorm.xhtml
 void unpackUnorm16Array(uint16_t *unormVector, size_t vectorSize, std::vector<float> &floatVector);
 
+/// Same as above for 8-bit values (https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/unpackUnorm.xhtml).
+void unpackUnorm8Array(uint8_t *unormVector, size_t vectorSize, std::vector<float> &floatVector);
+
 void computeTrajectoryAttributes(
         TrajectoryType trajectoryType,
         std::vector<glm::vec3> &vertexPositions,
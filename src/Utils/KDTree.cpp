@@ -4,6 +4,9 @@
 
 #include "KDTree.hpp"
 
+// The depth of the tree is at most log2(number of points), so the traversal stacks never overflow.
+const int KD_TREE_MAX_STACK_SIZE = 64;
+
 bool Rectangle::contains(const glm::vec3 &pt) const
 {
     if (pt.x >= min.x && pt.y >= min.y && pt.z >= min.z
@@ -12,87 +15,237 @@ bool Rectangle::contains(const glm::vec3 &pt) const
     return false;
 }
 
-void KDTree::build(const std::vector<Point*> &points)
+void KDTree::build(const std::vector<Point> &points)
+{
+    this->points = points;
+    _build();
+}
+
+void KDTree::build(const std::vector<glm::vec3> &positions)
 {
-    root = _build(points, 0);
+    points.resize(positions.size());
+    #pragma omp parallel for
+    for (size_t i = 0; i < positions.size(); i++) {
+        points[i] = Point(positions[i], int(i));
+    }
+    _build();
 }
 
-std::shared_ptr<KDNode> KDTree::_build(std::vector<Point*> points, int depth)
+void KDTree::_build()
 {
-    const int k = 3; // Number of dimensions
+    axes.clear();
+    axes.resize(points.size(), 0);
 
-    if (points.size() == 0) {
-        return std::shared_ptr<KDNode>();
+    std::vector<Range> levelRanges;
+    std::vector<Range> nextLevelRanges;
+    if (points.size() > LEAF_SIZE) {
+        Range root = { 0, points.size() };
+        levelRanges.push_back(root);
     }
 
-    int axis = depth % k;
-    std::sort(points.begin(), points.end(), [axis](Point *a, Point *b) {
-        if (axis == 0) return a->position.x < b->position.x;
-        if (axis == 1) return a->position.y < b->position.y;
-        return a->position.z < b->position.z;
-    });
-    size_t medianIndex = points.size() / 2;
-    std::vector<Point*> leftPoints = std::vector<Point*>(points.begin(), points.begin() + medianIndex);
-    std::vector<Point*> rightPoints = std::vector<Point*>(points.begin() + medianIndex + 1, points.end());
-
-    std::shared_ptr<KDNode> node = std::shared_ptr<KDNode>(new KDNode);
-    node->axis = axis;
-    node->location = points.at(medianIndex);
-    node->left = _build(leftPoints, depth + 1);
-    node->right = _build(rightPoints, depth + 1);
-    return node;
+    while (!levelRanges.empty()) {
+        nextLevelRanges.resize(levelRanges.size() * 2);
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < levelRanges.size(); i++) {
+            const Range range = levelRanges[i];
+
+            // Split along the axis of the largest extent.
+            glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+            for (size_t j = range.begin; j < range.end; j++) {
+                minimum = glm::min(minimum, points[j].position);
+                maximum = glm::max(maximum, points[j].position);
+            }
+            glm::vec3 extent = maximum - minimum;
+            int axis = 0;
+            if (extent.y > extent[axis]) axis = 1;
+            if (extent.z > extent[axis]) axis = 2;
+
+            size_t median = range.begin + (range.end - range.begin) / 2;
+            std::nth_element(
+                    points.begin() + range.begin, points.begin() + median, points.begin() + range.end,
+                    [axis](const Point &a, const Point &b) { return a.position[axis] < b.position[axis]; });
+            axes[median] = uint8_t(axis);
+
+            Range left = { range.begin, median };
+            Range right = { median + 1, range.end };
+            nextLevelRanges[i * 2] = left;
+            nextLevelRanges[i * 2 + 1] = right;
+        }
+
+        // Only ranges with more than LEAF_SIZE points are split further.
+        levelRanges.clear();
+        for (const Range &range : nextLevelRanges) {
+            if (range.end - range.begin > LEAF_SIZE) {
+                levelRanges.push_back(range);
+            }
+        }
+    }
 }
 
 
-std::vector<Point*> KDTree::findPointsInRectangle(const Rectangle &rect)
+void KDTree::findPointsInRectangle(const Rectangle &rect, std::vector<Point> &foundPoints) const
 {
-    std::vector<Point*> points;
-    _findPointsInRectangle(rect, points, root);
-    return points;
+    foundPoints.clear();
+    if (points.empty()) {
+        return;
+    }
+
+    Range stack[KD_TREE_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, points.size() };
+    while (stackSize > 0) {
+        const Range range = stack[--stackSize];
+        if (range.end - range.begin <= LEAF_SIZE) {
+            for (size_t i = range.begin; i < range.end; i++) {
+                if (rect.contains(points[i].position)) {
+                    foundPoints.push_back(points[i]);
+                }
+            }
+            continue;
+        }
+
+        const size_t median = range.begin + (range.end - range.begin) / 2;
+        const Point &point = points[median];
+        const int axis = axes[median];
+        if (rect.contains(point.position)) {
+            foundPoints.push_back(point);
+        }
+        if (rect.min[axis] <= point.position[axis] && median > range.begin) {
+            stack[stackSize++] = { range.begin, median };
+        }
+        if (rect.max[axis] >= point.position[axis] && range.end > median + 1) {
+            stack[stackSize++] = { median + 1, range.end };
+        }
+    }
 }
 
-void KDTree::_findPointsInRectangle(const Rectangle &rect, std::vector<Point*> &points, std::shared_ptr<KDNode> node)
+void KDTree::findPointsInRadius(const glm::vec3 &centerPoint, float radius, std::vector<Point> &foundPoints) const
 {
-    if (rect.contains(node->location->position)) {
-        points.push_back(node->location);
+    foundPoints.clear();
+    if (points.empty()) {
+        return;
+    }
+
+    const float radiusSquared = radius * radius;
+    Range stack[KD_TREE_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, points.size() };
+    while (stackSize > 0) {
+        const Range range = stack[--stackSize];
+        if (range.end - range.begin <= LEAF_SIZE) {
+            for (size_t i = range.begin; i < range.end; i++) {
+                glm::vec3 diff = points[i].position - centerPoint;
+                if (glm::dot(diff, diff) <= radiusSquared) {
+                    foundPoints.push_back(points[i]);
+                }
+            }
+            continue;
+        }
+
+        const size_t median = range.begin + (range.end - range.begin) / 2;
+        const Point &point = points[median];
+        const int axis = axes[median];
+        glm::vec3 diff = point.position - centerPoint;
+        if (glm::dot(diff, diff) <= radiusSquared) {
+            foundPoints.push_back(point);
+        }
+        if (centerPoint[axis] - radius <= point.position[axis] && median > range.begin) {
+            stack[stackSize++] = { range.begin, median };
+        }
+        if (centerPoint[axis] + radius >= point.position[axis] && range.end > median + 1) {
+            stack[stackSize++] = { median + 1, range.end };
+        }
     }
+}
 
-    if ((node->axis == 0 && rect.min.x <= node->location->position.x)
-        || (node->axis == 1 && rect.min.y <= node->location->position.y)
-        || (node->axis == 2 && rect.min.z <= node->location->position.z)) {
-        _findPointsInRectangle(rect, points, node->left);
+void KDTree::_findKNearestNeighbors(
+        const glm::vec3 &centerPoint, size_t k, float maxDistanceSquared,
+        std::vector<std::pair<float, size_t>> &heap) const
+{
+    heap.clear();
+    if (points.empty() || k == 0) {
+        return;
     }
-    if ((node->axis == 0 && rect.max.x >= node->location->position.x)
-        || (node->axis == 1 && rect.max.y >= node->location->position.y)
-        || (node->axis == 2 && rect.max.z >= node->location->position.z)) {
-        _findPointsInRectangle(rect, points, node->right);
+
+    // The maximum squared distance a point may have to be added, i.e., the one of the k-th closest point found so far.
+    float worstDistanceSquared = maxDistanceSquared;
+    auto addCandidate = [&](size_t i) {
+        glm::vec3 diff = points[i].position - centerPoint;
+        float distanceSquared = glm::dot(diff, diff);
+        if (distanceSquared > worstDistanceSquared) {
+            return;
+        }
+        if (heap.size() == k) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+        }
+        heap.push_back(std::make_pair(distanceSquared, i));
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() == k) {
+            worstDistanceSquared = heap.front().first;
+        }
+    };
+
+    // The traversal stack stores a lower bound of the squared distance of the points of each range.
+    struct StackEntry {
+        Range range;
+        float minDistanceSquared;
+    };
+    StackEntry stack[KD_TREE_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = { { 0, points.size() }, 0.0f };
+    while (stackSize > 0) {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.minDistanceSquared > worstDistanceSquared) {
+            continue;
+        }
+        const Range &range = entry.range;
+        if (range.end - range.begin <= LEAF_SIZE) {
+            for (size_t i = range.begin; i < range.end; i++) {
+                addCandidate(i);
+            }
+            continue;
+        }
+
+        const size_t median = range.begin + (range.end - range.begin) / 2;
+        const int axis = axes[median];
+        addCandidate(median);
+
+        // Visit the subtree on the side of the splitting plane containing the center point first.
+        float planeDistance = centerPoint[axis] - points[median].position[axis];
+        Range left = { range.begin, median };
+        Range right = { median + 1, range.end };
+        const Range &nearRange = planeDistance <= 0.0f ? left : right;
+        const Range &farRange = planeDistance <= 0.0f ? right : left;
+        if (farRange.end > farRange.begin) {
+            stack[stackSize++] = { farRange, std::max(entry.minDistanceSquared, planeDistance * planeDistance) };
+        }
+        if (nearRange.end > nearRange.begin) {
+            stack[stackSize++] = { nearRange, entry.minDistanceSquared };
+        }
     }
-};
 
+    std::sort_heap(heap.begin(), heap.end());
+}
 
-Point *KDTree::findCloseIndexedPoint(Point *centerPoint, float maxDistance)
+void KDTree::findKNearestNeighbors(
+        const glm::vec3 &centerPoint, size_t k, std::vector<Point> &neighbors, float maxDistance) const
 {
-    // Find all points in bounding rectangle and test if their distance is less or equal than searched one
-    Rectangle rect;
-    rect.min = glm::vec3(
-            centerPoint->position.x - maxDistance,
-            centerPoint->position.y - maxDistance,
-            centerPoint->position.z - maxDistance);
-    rect.max = glm::vec3(
-            centerPoint->position.x + maxDistance,
-            centerPoint->position.y + maxDistance,
-            centerPoint->position.z + maxDistance);
-
-    std::vector<Point*> rectPoints = findPointsInRectangle(rect);
-
-    Point *closestPoint = NULL;
-    float closestDistance = FLT_MAX;
-    for (Point *point : rectPoints) {
-        float currDistance = (centerPoint->position - point->position).length();
-        if (currDistance < closestDistance && currDistance < maxDistance) {
-            closestPoint = point;
-            closestDistance = currDistance;
-        }
+    std::vector<std::pair<float, size_t>> heap;
+    heap.reserve(k);
+    _findKNearestNeighbors(centerPoint, k, maxDistance == FLT_MAX ? FLT_MAX : maxDistance * maxDistance, heap);
+    neighbors.resize(heap.size());
+    for (size_t i = 0; i < heap.size(); i++) {
+        neighbors[i] = points[heap[i].second];
+    }
+}
+
+const Point *KDTree::findCloseIndexedPoint(const glm::vec3 &centerPoint, float maxDistance) const
+{
+    std::vector<std::pair<float, size_t>> heap;
+    _findKNearestNeighbors(centerPoint, 1, maxDistance * maxDistance, heap);
+    if (heap.empty() || heap.front().first >= maxDistance * maxDistance) {
+        return NULL;
     }
-    return closestPoint;
+    return &points[heap.front().second];
 }
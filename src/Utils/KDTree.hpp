@@ -6,13 +6,17 @@
 #define PIXELSYNCOIT_KDTREE_HPP
 
 #include <algorithm>
-#include <memory>
 #include <vector>
+#include <utility>
+#include <cfloat>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 class Point
 {
 public:
+    Point() : index(0) {}
+    Point(const glm::vec3 &position, int index) : position(position), index(index) {}
     glm::vec3 position;
     int index;
 };
@@ -24,30 +28,57 @@ public:
     bool contains(const glm::vec3 &pt) const;
 };
 
-class KDNode
+/**
+ * A KD-tree stored implicitly in a flat array. The points are permuted such that the node of the subtree spanning
+ * the range [begin, end) of the array is the median point at (begin + end) / 2, with the left subtree in
+ * [begin, median) and the right subtree in [median + 1, end). Ranges of at most LEAF_SIZE points aren't split
+ * further and are scanned linearly by the queries. Each node splits its range along the axis of the largest extent.
+ *
+ * The tree is built level by level. All ranges of a level are split in parallel using std::nth_element.
+ * The queries are thread-safe and don't allocate memory apart from the result vectors.
+ */
+class KDTree
 {
 public:
-    int axis;
-    Point *location;
-    std::shared_ptr<KDNode> left;
-    std::shared_ptr<KDNode> right;
-};
+    /// Builds the tree over the passed points. Point::index can be used to store e.g. the index in another array.
+    void build(const std::vector<Point> &points);
+    /// Builds the tree over the passed positions. Point::index is set to the index of the position in the vector.
+    void build(const std::vector<glm::vec3> &positions);
 
-class KDTree
-{
-    void build(const std::vector<Point*> &points);
+    inline size_t getNumPoints() const { return points.size(); }
+    /// The points in the order of the tree.
+    inline const std::vector<Point> &getPoints() const { return points; }
 
     /// Used for e.g. giving points that are approx. the same (i.e. low distance)
-    /// the same index.
-    Point *findCloseIndexedPoint(Point *centerPoint, float maxDistance);
-    std::vector<Point*> findPointsInRectangle(const Rectangle &rect);
+    /// the same index. Returns the point closest to centerPoint with a distance less than maxDistance or NULL.
+    const Point *findCloseIndexedPoint(const glm::vec3 &centerPoint, float maxDistance) const;
+    /// Finds all points inside of (or on the border of) the rectangle.
+    void findPointsInRectangle(const Rectangle &rect, std::vector<Point> &foundPoints) const;
+    /// Finds all points with a distance of at most radius to centerPoint.
+    void findPointsInRadius(const glm::vec3 &centerPoint, float radius, std::vector<Point> &foundPoints) const;
+    /**
+     * Finds the k points closest to centerPoint with a distance of at most maxDistance.
+     * @param neighbors Is set to the found points sorted by their distance in ascending order.
+     */
+    void findKNearestNeighbors(
+            const glm::vec3 &centerPoint, size_t k, std::vector<Point> &neighbors,
+            float maxDistance = FLT_MAX) const;
 
 private:
-    // Internal implementations
-    std::shared_ptr<KDNode> _build(std::vector<Point*> points, int depth);
-    void _findPointsInRectangle(const Rectangle &rect, std::vector<Point*> &points, std::shared_ptr<KDNode> node);
+    static const size_t LEAF_SIZE = 8;
+
+    struct Range {
+        size_t begin, end;
+    };
+
+    void _build();
+    // Fills the max-heap of (squared distance, index into points) pairs with the k closest points.
+    void _findKNearestNeighbors(
+            const glm::vec3 &centerPoint, size_t k, float maxDistanceSquared,
+            std::vector<std::pair<float, size_t>> &heap) const;
 
-    std::shared_ptr<KDNode> root;
+    std::vector<Point> points;
+    std::vector<uint8_t> axes; ///< The split axis of the node at each point index.
 };
 
 #endif //PIXELSYNCOIT_KDTREE_HPP
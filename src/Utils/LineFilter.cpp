@@ -0,0 +1,394 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+#include <Utils/Convert.hpp>
+
+#include "MeshSerializer.hpp"
+#include "LineFilter.hpp"
+
+// The summaries of attribute i are stored in the uniform LINE_SUMMARIES_UNIFORM_NAME + i.
+static const std::string LINE_SUMMARIES_UNIFORM_NAME = "lineAttributeSummaries";
+
+void computeLineAttributeSummaries(
+        const uint64_t *lineOffsets, size_t numLines, const float *values, LineAttributeSummary *summaries)
+{
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t lineIndex = 0; lineIndex < numLines; lineIndex++) {
+        LineAttributeSummary &summary = summaries[lineIndex];
+        const uint64_t pointsStart = lineOffsets[lineIndex];
+        const uint64_t pointsEnd = lineOffsets[lineIndex + 1];
+        if (pointsStart == pointsEnd) {
+            summary.minValue = summary.maxValue = summary.meanValue = 0.0f;
+            continue;
+        }
+
+        float minValue = FLT_MAX, maxValue = -FLT_MAX;
+        double sum = 0.0;
+        for (uint64_t i = pointsStart; i < pointsEnd; i++) {
+            float value = values[i];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            sum += value;
+        }
+        summary.minValue = minValue;
+        summary.maxValue = maxValue;
+        summary.meanValue = float(sum / double(pointsEnd - pointsStart));
+    }
+}
+
+size_t computeTransferFunctionLineMask(
+        const std::vector<LineAttributeSummary> &summaries, const std::vector<float> &opacityTable,
+        float minAttribute, float maxAttribute, float epsilon, std::vector<uint8_t> &lineMask)
+{
+    const size_t numLines = summaries.size();
+    const int tableSize = int(opacityTable.size());
+    lineMask.resize(numLines);
+    if (tableSize == 0) {
+        std::fill(lineMask.begin(), lineMask.end(), 1);
+        return 0;
+    }
+
+    // Sparse table for range maximum queries: maxTable[k][i] is the maximum of the entries [i, i + 2^k).
+    std::vector<std::vector<float>> maxTable;
+    maxTable.push_back(opacityTable);
+    for (int k = 1; (1 << k) <= tableSize; k++) {
+        const std::vector<float> &previousLevel = maxTable.back();
+        std::vector<float> level(tableSize - (1 << k) + 1);
+        for (size_t i = 0; i < level.size(); i++) {
+            level[i] = std::max(previousLevel[i], previousLevel[i + (1 << (k - 1))]);
+        }
+        maxTable.push_back(level);
+    }
+
+    const float attributeRange = maxAttribute - minAttribute;
+    size_t numCulledLines = 0;
+
+    #pragma omp parallel for reduction(+:numCulledLines)
+    for (size_t lineIndex = 0; lineIndex < numLines; lineIndex++) {
+        // Map the attribute range to the table entries, including the neighbors used for linear interpolation.
+        const LineAttributeSummary &summary = summaries[lineIndex];
+        float minPosition = attributeRange > 0.0f ? (summary.minValue - minAttribute) / attributeRange : 0.0f;
+        float maxPosition = attributeRange > 0.0f ? (summary.maxValue - minAttribute) / attributeRange : 1.0f;
+        minPosition = std::min(std::max(minPosition, 0.0f), 1.0f);
+        maxPosition = std::min(std::max(maxPosition, 0.0f), 1.0f);
+        int firstEntry = std::max(int(std::floor(minPosition * float(tableSize - 1))), 0);
+        int lastEntry = std::min(int(std::ceil(maxPosition * float(tableSize - 1))), tableSize - 1);
+
+        int level = 0;
+        while ((2 << level) <= lastEntry - firstEntry + 1) {
+            level++;
+        }
+        float maxOpacity = std::max(
+                maxTable[level][firstEntry], maxTable[level][lastEntry - (1 << level) + 1]);
+        bool visible = maxOpacity >= epsilon;
+        lineMask[lineIndex] = visible;
+        if (!visible) {
+            numCulledLines++;
+        }
+    }
+
+    return numCulledLines;
+}
+
+void LineFilter::setLineIndices(const std::vector<uint32_t> &indices)
+{
+    lineIndices = indices;
+    lineSummaries.clear();
+    lineMask.clear();
+    thresholdActive = false;
+    sortedAttributeIndex = SIZE_MAX;
+    linesSortedByMaximum.clear();
+    sortedMaximumValues.clear();
+
+    // A new line starts at each segment that doesn't continue the previous one.
+    const size_t numSegments = lineIndices.size() / 2;
+    std::vector<uint8_t> isLineStart(numSegments);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numSegments; i++) {
+        isLineStart[i] = i == 0 || lineIndices[i*2] != lineIndices[i*2 - 1];
+    }
+
+    lineIndexOffsets.clear();
+    for (size_t i = 0; i < numSegments; i++) {
+        if (isLineStart[i]) {
+            lineIndexOffsets.push_back(i*2);
+        }
+    }
+    lineIndexOffsets.push_back(numSegments*2);
+
+    lineVisibility.clear();
+    lineVisibility.resize(getNumLines(), 1);
+    numHiddenLines = 0;
+    filteredIndicesDirty = true;
+}
+
+size_t LineFilter::addAttribute(const std::vector<float> &vertexValues)
+{
+    const size_t numLines = getNumLines();
+    lineSummaries.push_back(std::vector<LineAttributeSummary>());
+    std::vector<LineAttributeSummary> &summaries = lineSummaries.back();
+    summaries.resize(numLines);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t lineIndex = 0; lineIndex < numLines; lineIndex++) {
+        // Each vertex of a line is referenced once as segment start or end (except for the shared ones).
+        const uint64_t indicesStart = lineIndexOffsets[lineIndex];
+        const uint64_t indicesEnd = lineIndexOffsets[lineIndex + 1];
+        float value = vertexValues[lineIndices[indicesStart]];
+        float minValue = value, maxValue = value;
+        double sum = value;
+        for (uint64_t i = indicesStart + 1; i < indicesEnd; i += 2) {
+            value = vertexValues[lineIndices[i]];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            sum += value;
+        }
+        LineAttributeSummary &summary = summaries[lineIndex];
+        summary.minValue = minValue;
+        summary.maxValue = maxValue;
+        summary.meanValue = float(sum / double((indicesEnd - indicesStart) / 2 + 1));
+    }
+
+    return lineSummaries.size() - 1;
+}
+
+size_t LineFilter::addAttribute(const std::vector<LineAttributeSummary> &summaries)
+{
+    if (summaries.size() != getNumLines()) {
+        return SIZE_MAX;
+    }
+    lineSummaries.push_back(summaries);
+    return lineSummaries.size() - 1;
+}
+
+void LineFilter::sortLinesByMaximum(size_t attributeIndex)
+{
+    if (sortedAttributeIndex == attributeIndex) {
+        return;
+    }
+
+    const std::vector<LineAttributeSummary> &summaries = lineSummaries.at(attributeIndex);
+    linesSortedByMaximum.resize(summaries.size());
+    std::iota(linesSortedByMaximum.begin(), linesSortedByMaximum.end(), 0u);
+    std::sort(linesSortedByMaximum.begin(), linesSortedByMaximum.end(), [&summaries](uint32_t a, uint32_t b) {
+        return summaries[a].maxValue < summaries[b].maxValue;
+    });
+    sortedMaximumValues.resize(summaries.size());
+    #pragma omp parallel for
+    for (size_t i = 0; i < linesSortedByMaximum.size(); i++) {
+        sortedMaximumValues[i] = summaries[linesSortedByMaximum[i]].maxValue;
+    }
+    sortedAttributeIndex = attributeIndex;
+}
+
+void LineFilter::updateLineVisibility(size_t lineIndex)
+{
+    bool visible = (lineMask.empty() || lineMask[lineIndex] != 0)
+            && (!thresholdActive || lineSummaries[thresholdAttributeIndex][lineIndex].maxValue >= threshold);
+    if (visible != (lineVisibility[lineIndex] != 0)) {
+        lineVisibility[lineIndex] = visible;
+        if (visible) {
+            numHiddenLines--;
+        } else {
+            numHiddenLines++;
+        }
+        filteredIndicesDirty = true;
+    }
+}
+
+bool LineFilter::setThreshold(size_t attributeIndex, float newThreshold)
+{
+    if (attributeIndex >= lineSummaries.size()) {
+        return false;
+    }
+    sortLinesByMaximum(attributeIndex);
+
+    // Only the lines with a maximum between the old and the new threshold can change their visibility.
+    // If the filter was inactive or used another attribute, all lines up to the new threshold are affected.
+    float oldThreshold = -FLT_MAX;
+    if (thresholdActive && thresholdAttributeIndex == attributeIndex) {
+        oldThreshold = threshold;
+    } else if (thresholdActive) {
+        thresholdAttributeIndex = attributeIndex;
+        threshold = newThreshold;
+        return updateAllLineVisibilities();
+    }
+    thresholdActive = true;
+    thresholdAttributeIndex = attributeIndex;
+    threshold = newThreshold;
+
+    float lower = std::min(oldThreshold, newThreshold);
+    float upper = std::max(oldThreshold, newThreshold);
+    size_t rangeStart = std::lower_bound(sortedMaximumValues.begin(), sortedMaximumValues.end(), lower)
+            - sortedMaximumValues.begin();
+    size_t rangeEnd = std::lower_bound(sortedMaximumValues.begin(), sortedMaximumValues.end(), upper)
+            - sortedMaximumValues.begin();
+
+    bool changed = false;
+    for (size_t i = rangeStart; i < rangeEnd; i++) {
+        size_t oldNumHiddenLines = numHiddenLines;
+        updateLineVisibility(linesSortedByMaximum[i]);
+        changed = changed || oldNumHiddenLines != numHiddenLines;
+    }
+    return changed;
+}
+
+bool LineFilter::resetThreshold()
+{
+    if (!thresholdActive) {
+        return false;
+    }
+    thresholdActive = false;
+    return updateAllLineVisibilities();
+}
+
+bool LineFilter::setLineMask(const std::vector<uint8_t> &mask)
+{
+    lineMask = mask;
+    return updateAllLineVisibilities();
+}
+
+bool LineFilter::updateAllLineVisibilities()
+{
+    const size_t numLines = getNumLines();
+    size_t newNumHiddenLines = 0;
+    size_t numChangedLines = 0;
+
+    #pragma omp parallel for reduction(+:newNumHiddenLines) reduction(+:numChangedLines)
+    for (size_t lineIndex = 0; lineIndex < numLines; lineIndex++) {
+        uint8_t visible = (lineMask.empty() || lineMask[lineIndex] != 0)
+                && (!thresholdActive || lineSummaries[thresholdAttributeIndex][lineIndex].maxValue >= threshold);
+        if (visible != lineVisibility[lineIndex]) {
+            lineVisibility[lineIndex] = visible;
+            numChangedLines++;
+        }
+        if (!visible) {
+            newNumHiddenLines++;
+        }
+    }
+
+    numHiddenLines = newNumHiddenLines;
+    if (numChangedLines > 0) {
+        filteredIndicesDirty = true;
+    }
+    return numChangedLines > 0;
+}
+
+const std::vector<uint32_t> &LineFilter::getFilteredIndices()
+{
+    if (numHiddenLines == 0) {
+        return lineIndices;
+    }
+    if (!filteredIndicesDirty) {
+        return filteredIndices;
+    }
+
+    // Exclusive prefix sum over the index counts of the visible lines, then copy the lines in parallel.
+    const size_t numLines = getNumLines();
+    std::vector<uint64_t> filteredOffsets(numLines + 1);
+    filteredOffsets[0] = 0;
+    for (size_t lineIndex = 0; lineIndex < numLines; lineIndex++) {
+        uint64_t numLineIndices = lineVisibility[lineIndex]
+                ? lineIndexOffsets[lineIndex + 1] - lineIndexOffsets[lineIndex] : 0;
+        filteredOffsets[lineIndex + 1] = filteredOffsets[lineIndex] + numLineIndices;
+    }
+
+    filteredIndices.resize(filteredOffsets[numLines]);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t lineIndex = 0; lineIndex < numLines; lineIndex++) {
+        uint64_t numLineIndices = filteredOffsets[lineIndex + 1] - filteredOffsets[lineIndex];
+        if (numLineIndices > 0) {
+            memcpy(&filteredIndices[filteredOffsets[lineIndex]], &lineIndices[lineIndexOffsets[lineIndex]],
+                    numLineIndices * sizeof(uint32_t));
+        }
+    }
+
+    filteredIndicesDirty = false;
+    return filteredIndices;
+}
+
+
+void setSubmeshLineSummaries(
+        BinarySubMesh &submesh, const std::vector<std::vector<LineAttributeSummary>> &summaries)
+{
+    for (auto it = submesh.uniforms.begin(); it != submesh.uniforms.end();) {
+        if (it->name.compare(0, LINE_SUMMARIES_UNIFORM_NAME.size(), LINE_SUMMARIES_UNIFORM_NAME) == 0) {
+            it = submesh.uniforms.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    for (size_t attributeIdx = 0; attributeIdx < summaries.size(); attributeIdx++) {
+        const std::vector<LineAttributeSummary> &attributeSummaries = summaries.at(attributeIdx);
+        BinaryMeshUniform summariesUniform;
+        summariesUniform.name = LINE_SUMMARIES_UNIFORM_NAME + sgl::toString(attributeIdx);
+        summariesUniform.attributeFormat = sgl::ATTRIB_FLOAT;
+        summariesUniform.numComponents = 3;
+        summariesUniform.data.resize(attributeSummaries.size() * sizeof(LineAttributeSummary));
+        if (!attributeSummaries.empty()) {
+            memcpy(&summariesUniform.data.front(), &attributeSummaries.front(), summariesUniform.data.size());
+        }
+        submesh.uniforms.push_back(summariesUniform);
+    }
+}
+
+bool getSubmeshLineSummaries(
+        const BinarySubMesh &submesh, std::vector<std::vector<LineAttributeSummary>> &summaries)
+{
+    summaries.clear();
+    while (true) {
+        const std::string uniformName = LINE_SUMMARIES_UNIFORM_NAME + sgl::toString(summaries.size());
+        const BinaryMeshUniform *summariesUniform = NULL;
+        for (const BinaryMeshUniform &uniform : submesh.uniforms) {
+            if (uniform.name == uniformName && uniform.attributeFormat == sgl::ATTRIB_FLOAT
+                    && uniform.numComponents == 3 && uniform.data.size() % sizeof(LineAttributeSummary) == 0) {
+                summariesUniform = &uniform;
+                break;
+            }
+        }
+        if (summariesUniform == NULL) {
+            break;
+        }
+
+        summaries.push_back(std::vector<LineAttributeSummary>());
+        std::vector<LineAttributeSummary> &attributeSummaries = summaries.back();
+        attributeSummaries.resize(summariesUniform->data.size() / sizeof(LineAttributeSummary));
+        if (!attributeSummaries.empty()) {
+            memcpy(&attributeSummaries.front(), &summariesUniform->data.front(), summariesUniform->data.size());
+        }
+    }
+    return !summaries.empty();
+}
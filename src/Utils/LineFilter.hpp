@@ -0,0 +1,157 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_LINEFILTER_HPP
+#define PIXELSYNCOIT_LINEFILTER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct BinarySubMesh;
+
+/**
+ * Minimum, maximum and mean value of one attribute along one line.
+ */
+struct LineAttributeSummary
+{
+    float minValue;
+    float maxValue;
+    float meanValue;
+};
+
+/**
+ * Computes the attribute summaries of lines stored in a CSR layout in parallel.
+ * @param lineOffsets The values of line i are [lineOffsets[i], lineOffsets[i+1]).
+ * @param numLines The number of lines.
+ * @param values The attribute values of all points.
+ * @param summaries The output array of size numLines.
+ */
+void computeLineAttributeSummaries(
+        const uint64_t *lineOffsets, size_t numLines, const float *values, LineAttributeSummary *summaries);
+
+/**
+ * Computes which lines can be seen with a transfer function. A line is invisible if the maximum opacity the transfer
+ * function assigns to its attribute range [minValue, maxValue] is below the passed epsilon.
+ * @param summaries The attribute summaries of all lines.
+ * @param opacityTable The opacity of the transfer function at equidistant positions in [0, 1].
+ * @param minAttribute The attribute value mapped to position 0 of the transfer function.
+ * @param maxAttribute The attribute value mapped to position 1 of the transfer function.
+ * @param epsilon Lines with a maximum opacity below this value are culled.
+ * @param lineMask The output mask (1 for visible lines, 0 for culled lines).
+ * @return The number of culled lines.
+ */
+size_t computeTransferFunctionLineMask(
+        const std::vector<LineAttributeSummary> &summaries, const std::vector<float> &opacityTable,
+        float minAttribute, float maxAttribute, float epsilon, std::vector<uint8_t> &lineMask);
+
+/**
+ * Filters the lines of a line list index buffer (VERTEX_MODE_LINES) by per-line attribute summaries.
+ * The lines are the maximal chains of consecutive segments where each segment starts at the end of its predecessor.
+ * Changing the threshold only touches the lines whose visibility changes, and the filtered index buffer is compacted
+ * in parallel, so it can be rebuilt interactively.
+ */
+class LineFilter
+{
+public:
+    /// Splits the index buffer into lines. Removes all attributes and resets the filter.
+    void setLineIndices(const std::vector<uint32_t> &indices);
+    /// Computes the line summaries of an attribute from its per-vertex values. Returns the attribute index.
+    size_t addAttribute(const std::vector<float> &vertexValues);
+    /**
+     * Adds an attribute with precomputed line summaries (e.g., stored in the mesh, see getSubmeshLineSummaries).
+     * @return The attribute index, or SIZE_MAX if the number of summaries doesn't match the number of lines.
+     */
+    size_t addAttribute(const std::vector<LineAttributeSummary> &summaries);
+
+    inline bool isEmpty() const { return lineIndexOffsets.size() <= 1; }
+    inline size_t getNumLines() const { return lineIndexOffsets.empty() ? 0 : lineIndexOffsets.size() - 1; }
+    inline size_t getNumAttributes() const { return lineSummaries.size(); }
+    inline const std::vector<LineAttributeSummary> &getLineSummaries(size_t attributeIndex) const {
+        return lineSummaries.at(attributeIndex);
+    }
+    inline bool isLineVisible(size_t lineIndex) const { return lineVisibility.at(lineIndex) != 0; }
+    /// The unfiltered index buffer passed to setLineIndices.
+    inline const std::vector<uint32_t> &getLineIndices() const { return lineIndices; }
+    /// The points of line i are [lineIndexOffsets[i], lineIndexOffsets[i+1]) in the unfiltered index buffer.
+    inline const std::vector<uint64_t> &getLineIndexOffsets() const { return lineIndexOffsets; }
+
+    /**
+     * Shows only the lines whose maximum value of the passed attribute is greater or equal to the threshold.
+     * @return True if the set of visible lines changed.
+     */
+    bool setThreshold(size_t attributeIndex, float threshold);
+    /// Shows all lines again.
+    bool resetThreshold();
+
+    /**
+     * Sets the visibility of all lines (e.g., for filters using other criteria). The threshold is combined with it.
+     * @return True if the set of visible lines changed.
+     */
+    bool setLineMask(const std::vector<uint8_t> &mask);
+
+    /// Returns the index buffer of all visible lines. Compacts the buffer in parallel if the visibility changed.
+    const std::vector<uint32_t> &getFilteredIndices();
+    inline bool isFiltered() const { return numHiddenLines > 0; }
+
+private:
+    void sortLinesByMaximum(size_t attributeIndex);
+    void updateLineVisibility(size_t lineIndex);
+    bool updateAllLineVisibilities();
+
+    std::vector<uint32_t> lineIndices;
+    std::vector<uint64_t> lineIndexOffsets;
+    std::vector<std::vector<LineAttributeSummary>> lineSummaries;
+
+    // Threshold filter state. linesSortedByMaximum is computed on demand for the filtered attribute.
+    bool thresholdActive = false;
+    size_t thresholdAttributeIndex = 0;
+    float threshold = 0.0f;
+    size_t sortedAttributeIndex = SIZE_MAX;
+    std::vector<uint32_t> linesSortedByMaximum;
+    std::vector<float> sortedMaximumValues;
+
+    std::vector<uint8_t> lineMask; ///< Empty if no mask is set.
+    std::vector<uint8_t> lineVisibility;
+    size_t numHiddenLines = 0;
+    bool filteredIndicesDirty = true;
+    std::vector<uint32_t> filteredIndices;
+};
+
+/**
+ * Stores the line summaries of all attributes of a line submesh (summaries[attributeIndex][lineIndex]) in its
+ * uniforms, so that the line filter doesn't need to recompute them when the mesh is loaded.
+ */
+void setSubmeshLineSummaries(
+        BinarySubMesh &submesh, const std::vector<std::vector<LineAttributeSummary>> &summaries);
+/// @return False if the submesh stores no line summaries.
+bool getSubmeshLineSummaries(
+        const BinarySubMesh &submesh, std::vector<std::vector<LineAttributeSummary>> &summaries);
+
+#endif //PIXELSYNCOIT_LINEFILTER_HPP
@@ -0,0 +1,587 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+
+#include "LineSegmentBVH.hpp"
+
+const uint32_t LINE_SEGMENT_BVH_FORMAT_VERSION = 2u;
+const uint32_t BVH_MAX_LEAF_SIZE = 4u;
+/// Subtrees up to this depth are built in separate OpenMP tasks.
+const int BVH_MAX_TASK_DEPTH = 8;
+const int BVH_MAX_STACK_SIZE = 64;
+
+struct LineSegmentBVHHeader
+{
+    uint32_t formatVersion;
+    uint32_t padding;
+    uint64_t numNodes;
+    uint64_t numSegments;
+    uint64_t numLines;
+
+    // The LineSegmentBVHSource the BVH was built from.
+    uint64_t sourceLastModified;
+    uint64_t sourceNumIndices;
+    int32_t sourceAttributeIndex;
+    uint32_t padding2;
+};
+
+/**
+ * The median splits make the size of each subtree a function of its number of segments. This allows assigning
+ * disjoint node ranges to the subtrees before they are built in parallel.
+ */
+static uint32_t computeNumNodes(uint32_t numSegments, std::map<uint32_t, uint32_t> &numNodesMap)
+{
+    if (numSegments <= BVH_MAX_LEAF_SIZE) {
+        return 1;
+    }
+    auto it = numNodesMap.find(numSegments);
+    if (it != numNodesMap.end()) {
+        return it->second;
+    }
+    uint32_t numNodes = 1 + computeNumNodes(numSegments / 2, numNodesMap)
+            + computeNumNodes(numSegments - numSegments / 2, numNodesMap);
+    numNodesMap.insert(std::make_pair(numSegments, numNodes));
+    return numNodes;
+}
+
+static inline glm::vec3 getSegmentCentroid(const BVHLineSegment &segment)
+{
+    return (segment.p0 + segment.p1) * 0.5f;
+}
+
+void LineSegmentBVH::build(const std::vector<glm::vec3> &vertexPositions, const std::vector<uint32_t> &lineIndices,
+        const std::vector<float> *vertexAttributes)
+{
+    nodes.clear();
+    segments.clear();
+    numLines = 0;
+
+    const size_t numSegments = lineIndices.size() / 2;
+    if (numSegments == 0) {
+        return;
+    }
+
+    // A new line starts at each segment that doesn't continue the previous one (like in LineFilter).
+    std::vector<uint32_t> segmentLineIds(numSegments);
+    uint32_t lineId = 0;
+    for (size_t i = 0; i < numSegments; i++) {
+        if (i > 0 && lineIndices[i*2] != lineIndices[i*2 - 1]) {
+            lineId++;
+        }
+        segmentLineIds[i] = lineId;
+    }
+    numLines = size_t(lineId) + 1;
+
+    segments.resize(numSegments);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numSegments; i++) {
+        BVHLineSegment &segment = segments[i];
+        uint32_t idx0 = lineIndices[i*2];
+        uint32_t idx1 = lineIndices[i*2 + 1];
+        segment.p0 = vertexPositions[idx0];
+        segment.p1 = vertexPositions[idx1];
+        segment.lineId = segmentLineIds[i];
+        segment.segmentIndex = uint32_t(i);
+        if (vertexAttributes != NULL) {
+            segment.minAttribute = std::min((*vertexAttributes)[idx0], (*vertexAttributes)[idx1]);
+            segment.maxAttribute = std::max((*vertexAttributes)[idx0], (*vertexAttributes)[idx1]);
+        } else {
+            segment.minAttribute = 0.0f;
+            segment.maxAttribute = 0.0f;
+        }
+    }
+
+    std::map<uint32_t, uint32_t> numNodesMap;
+    nodes.resize(computeNumNodes(uint32_t(numSegments), numNodesMap));
+    subtreeNumNodes.clear();
+    subtreeNumNodes.insert(numNodesMap.begin(), numNodesMap.end());
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        buildRecursive(0, 0, uint32_t(numSegments), 0);
+    }
+    subtreeNumNodes.clear();
+}
+
+uint32_t LineSegmentBVH::getSubtreeNumNodes(uint32_t numSegments) const
+{
+    if (numSegments <= BVH_MAX_LEAF_SIZE) {
+        return 1;
+    }
+    return subtreeNumNodes.find(numSegments)->second;
+}
+
+void LineSegmentBVH::buildRecursive(uint32_t nodeIndex, uint32_t segmentsBegin, uint32_t segmentsEnd, int depth)
+{
+    LineSegmentBVHNode &node = nodes[nodeIndex];
+    const uint32_t numNodeSegments = segmentsEnd - segmentsBegin;
+
+    if (numNodeSegments <= BVH_MAX_LEAF_SIZE) {
+        glm::vec3 aabbMin(FLT_MAX), aabbMax(-FLT_MAX);
+        float minAttribute = FLT_MAX, maxAttribute = -FLT_MAX;
+        for (uint32_t i = segmentsBegin; i < segmentsEnd; i++) {
+            const BVHLineSegment &segment = segments[i];
+            aabbMin = glm::min(aabbMin, glm::min(segment.p0, segment.p1));
+            aabbMax = glm::max(aabbMax, glm::max(segment.p0, segment.p1));
+            minAttribute = std::min(minAttribute, segment.minAttribute);
+            maxAttribute = std::max(maxAttribute, segment.maxAttribute);
+        }
+        node.aabbMin = aabbMin;
+        node.aabbMax = aabbMax;
+        node.offset = segmentsBegin;
+        node.numSegments = numNodeSegments;
+        node.minAttribute = minAttribute;
+        node.maxAttribute = maxAttribute;
+        return;
+    }
+
+    // Split at the median of the segment centroids along the axis with the largest extent.
+    glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+    for (uint32_t i = segmentsBegin; i < segmentsEnd; i++) {
+        glm::vec3 centroid = getSegmentCentroid(segments[i]);
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+    glm::vec3 centroidExtent = centroidMax - centroidMin;
+    int axis = 0;
+    if (centroidExtent.y > centroidExtent.x) {
+        axis = 1;
+    }
+    if (centroidExtent.z > centroidExtent[axis]) {
+        axis = 2;
+    }
+
+    const uint32_t segmentsMid = segmentsBegin + numNodeSegments / 2;
+    std::nth_element(segments.begin() + segmentsBegin, segments.begin() + segmentsMid, segments.begin() + segmentsEnd,
+            [axis](const BVHLineSegment &a, const BVHLineSegment &b) {
+        return a.p0[axis] + a.p1[axis] < b.p0[axis] + b.p1[axis];
+    });
+
+    const uint32_t leftChildIndex = nodeIndex + 1;
+    const uint32_t rightChildIndex = leftChildIndex + getSubtreeNumNodes(numNodeSegments / 2);
+    if (depth < BVH_MAX_TASK_DEPTH) {
+        #pragma omp task
+        buildRecursive(leftChildIndex, segmentsBegin, segmentsMid, depth + 1);
+        buildRecursive(rightChildIndex, segmentsMid, segmentsEnd, depth + 1);
+        #pragma omp taskwait
+    } else {
+        buildRecursive(leftChildIndex, segmentsBegin, segmentsMid, depth + 1);
+        buildRecursive(rightChildIndex, segmentsMid, segmentsEnd, depth + 1);
+    }
+
+    const LineSegmentBVHNode &leftChild = nodes[leftChildIndex];
+    const LineSegmentBVHNode &rightChild = nodes[rightChildIndex];
+    node.aabbMin = glm::min(leftChild.aabbMin, rightChild.aabbMin);
+    node.aabbMax = glm::max(leftChild.aabbMax, rightChild.aabbMax);
+    node.offset = rightChildIndex;
+    node.numSegments = 0;
+    node.minAttribute = std::min(leftChild.minAttribute, rightChild.minAttribute);
+    node.maxAttribute = std::max(leftChild.maxAttribute, rightChild.maxAttribute);
+}
+
+
+bool LineSegmentBVH::writeToFile(const std::string &filename, const LineSegmentBVHSource &source) const
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in LineSegmentBVH::writeToFile: File \""
+                + filename + "\" couldn't be opened for writing.");
+        return false;
+    }
+
+    LineSegmentBVHHeader header;
+    header.formatVersion = LINE_SEGMENT_BVH_FORMAT_VERSION;
+    header.padding = 0;
+    header.numNodes = nodes.size();
+    header.numSegments = segments.size();
+    header.numLines = numLines;
+    header.sourceLastModified = source.lastModified;
+    header.sourceNumIndices = source.numIndices;
+    header.sourceAttributeIndex = source.attributeIndex;
+    header.padding2 = 0;
+    fwrite(&header, sizeof(LineSegmentBVHHeader), 1, file);
+    if (!nodes.empty()) {
+        fwrite(&nodes.front(), sizeof(LineSegmentBVHNode), nodes.size(), file);
+    }
+    if (!segments.empty()) {
+        fwrite(&segments.front(), sizeof(BVHLineSegment), segments.size(), file);
+    }
+
+    bool writeSuccessful = ferror(file) == 0;
+    fclose(file);
+    if (!writeSuccessful) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in LineSegmentBVH::writeToFile: Couldn't write to file \""
+                + filename + "\".");
+        remove(filename.c_str());
+    }
+    return writeSuccessful;
+}
+
+bool LineSegmentBVH::readFromFile(const std::string &filename, const LineSegmentBVHSource &source)
+{
+    nodes.clear();
+    segments.clear();
+    numLines = 0;
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in LineSegmentBVH::readFromFile: File \""
+                + filename + "\" not found.");
+        return false;
+    }
+
+    LineSegmentBVHHeader header;
+    if (fread(&header, sizeof(LineSegmentBVHHeader), 1, file) != 1
+            || header.formatVersion != LINE_SEGMENT_BVH_FORMAT_VERSION
+            || header.sourceLastModified != source.lastModified || header.sourceNumIndices != source.numIndices
+            || header.sourceAttributeIndex != source.attributeIndex) {
+        // Not an error, the cache is outdated and needs to be rebuilt.
+        fclose(file);
+        return false;
+    }
+
+    bool readSuccessful = header.numSegments == source.numIndices / 2 && header.numNodes <= 2 * header.numSegments;
+    if (readSuccessful) {
+        nodes.resize(header.numNodes);
+        segments.resize(header.numSegments);
+        readSuccessful =
+                (nodes.empty() || fread(&nodes.front(), sizeof(LineSegmentBVHNode), nodes.size(), file) == nodes.size())
+                && (segments.empty() || fread(&segments.front(), sizeof(BVHLineSegment), segments.size(), file)
+                        == segments.size());
+    }
+    fclose(file);
+
+    // The traversal trusts the child offsets, segment ranges and line IDs.
+    for (size_t nodeIdx = 0; nodeIdx < nodes.size() && readSuccessful; nodeIdx++) {
+        const LineSegmentBVHNode &node = nodes.at(nodeIdx);
+        if (node.numSegments > 0) {
+            readSuccessful = uint64_t(node.offset) + uint64_t(node.numSegments) <= uint64_t(segments.size());
+        } else {
+            // The left child directly follows its parent, the right child follows the left subtree.
+            readSuccessful = node.offset > nodeIdx + 1 && node.offset < nodes.size();
+        }
+    }
+    for (size_t segmentIdx = 0; segmentIdx < segments.size() && readSuccessful; segmentIdx++) {
+        readSuccessful = segments.at(segmentIdx).lineId < header.numLines;
+    }
+
+    if (!readSuccessful) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in LineSegmentBVH::readFromFile: Invalid file \""
+                + filename + "\".");
+        nodes.clear();
+        segments.clear();
+        return false;
+    }
+    numLines = header.numLines;
+    return true;
+}
+
+
+/**
+ * Slab test of a ray against a box.
+ * @return The ray parameter where the ray enters the box, or FLT_MAX if it misses the box.
+ */
+static inline float intersectRayAABB(
+        const glm::vec3 &rayOrigin, const glm::vec3 &invRayDirection, const glm::vec3 &aabbMin,
+        const glm::vec3 &aabbMax)
+{
+    glm::vec3 t0 = (aabbMin - rayOrigin) * invRayDirection;
+    glm::vec3 t1 = (aabbMax - rayOrigin) * invRayDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float tExit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    return tEnter <= tExit ? tEnter : FLT_MAX;
+}
+
+/**
+ * Computes the closest points of a ray (t >= 0) and a segment (see Ericson, Real-Time Collision Detection, 5.1.9).
+ * @return The squared distance between the closest points.
+ */
+static float closestPointsRaySegment(
+        const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, const glm::vec3 &p0, const glm::vec3 &p1,
+        float &rayT)
+{
+    const glm::vec3 segmentDirection = p1 - p0;
+    const glm::vec3 r = rayOrigin - p0;
+    const float a = glm::dot(rayDirection, rayDirection);
+    const float e = glm::dot(segmentDirection, segmentDirection);
+    const float f = glm::dot(segmentDirection, r);
+    const float c = glm::dot(rayDirection, r);
+    const float b = glm::dot(rayDirection, segmentDirection);
+    const float denom = a*e - b*b;
+
+    // Parameter of the closest point on the segment for the infinite line, then clamp both parameters.
+    float s = 0.0f;
+    float t = 0.0f;
+    if (e > 0.0f && denom > 1e-12f) {
+        s = glm::clamp((a*f - b*c) / denom, 0.0f, 1.0f);
+    }
+    t = (b*s - c) / a;
+    if (t < 0.0f) {
+        t = 0.0f;
+        s = e > 0.0f ? glm::clamp(f / e, 0.0f, 1.0f) : 0.0f;
+    } else if (e > 0.0f) {
+        s = glm::clamp((b*t + f) / e, 0.0f, 1.0f);
+    }
+
+    glm::vec3 difference = (rayOrigin + t*rayDirection) - (p0 + s*segmentDirection);
+    rayT = t;
+    return glm::dot(difference, difference);
+}
+
+static inline float squaredDistancePointSegment(const glm::vec3 &point, const glm::vec3 &p0, const glm::vec3 &p1)
+{
+    glm::vec3 segmentDirection = p1 - p0;
+    float e = glm::dot(segmentDirection, segmentDirection);
+    float s = e > 0.0f ? glm::clamp(glm::dot(point - p0, segmentDirection) / e, 0.0f, 1.0f) : 0.0f;
+    glm::vec3 difference = point - (p0 + s*segmentDirection);
+    return glm::dot(difference, difference);
+}
+
+static inline float squaredDistancePointAABB(const glm::vec3 &point, const glm::vec3 &aabbMin, const glm::vec3 &aabbMax)
+{
+    glm::vec3 difference = glm::max(glm::max(aabbMin - point, point - aabbMax), glm::vec3(0.0f));
+    return glm::dot(difference, difference);
+}
+
+/**
+ * Clips the segment against the box (slab test with t in [0, 1]).
+ */
+static inline bool intersectSegmentAABB(const glm::vec3 &p0, const glm::vec3 &p1, const sgl::AABB3 &box)
+{
+    glm::vec3 direction = p1 - p0;
+    float tEnter = 0.0f, tExit = 1.0f;
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(direction[i]) < 1e-12f) {
+            if (p0[i] < box.min[i] || p0[i] > box.max[i]) {
+                return false;
+            }
+        } else {
+            float t0 = (box.min[i] - p0[i]) / direction[i];
+            float t1 = (box.max[i] - p0[i]) / direction[i];
+            tEnter = std::max(tEnter, std::min(t0, t1));
+            tExit = std::min(tExit, std::max(t0, t1));
+        }
+    }
+    return tEnter <= tExit;
+}
+
+static inline bool overlapsAABB(const LineSegmentBVHNode &node, const glm::vec3 &aabbMin, const glm::vec3 &aabbMax)
+{
+    return node.aabbMin.x <= aabbMax.x && node.aabbMax.x >= aabbMin.x
+            && node.aabbMin.y <= aabbMax.y && node.aabbMax.y >= aabbMin.y
+            && node.aabbMin.z <= aabbMax.z && node.aabbMax.z >= aabbMin.z;
+}
+
+bool LineSegmentBVH::pickRay(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, float maxDistance,
+        LineSegmentHit &hit) const
+{
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const glm::vec3 invRayDirection = glm::vec3(1.0f) / rayDirection;
+    const glm::vec3 expansion(maxDistance);
+    const float maxDistanceSquared = maxDistance * maxDistance;
+    bool hasHit = false;
+    hit.rayT = FLT_MAX;
+
+    uint32_t stack[BVH_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const LineSegmentBVHNode &node = nodes[stack[--stackSize]];
+        // The boxes are expanded by the pick radius, as the lines are treated as tubes.
+        float tEnter = intersectRayAABB(rayOrigin, invRayDirection, node.aabbMin - expansion, node.aabbMax + expansion);
+        if (tEnter == FLT_MAX || tEnter > hit.rayT) {
+            continue;
+        }
+
+        if (node.numSegments > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.numSegments; i++) {
+                const BVHLineSegment &segment = segments[i];
+                float rayT;
+                float distanceSquared = closestPointsRaySegment(rayOrigin, rayDirection, segment.p0, segment.p1, rayT);
+                if (distanceSquared <= maxDistanceSquared && rayT < hit.rayT) {
+                    hit.lineId = segment.lineId;
+                    hit.segmentIndex = segment.segmentIndex;
+                    hit.distance = std::sqrt(distanceSquared);
+                    hit.rayT = rayT;
+                    hasHit = true;
+                }
+            }
+        } else {
+            stack[stackSize++] = node.offset;
+            stack[stackSize++] = uint32_t(&node - &nodes.front()) + 1;
+        }
+    }
+
+    return hasHit;
+}
+
+void LineSegmentBVH::queryBox(const sgl::AABB3 &box, std::vector<uint32_t> &lineIds,
+        float minAttribute, float maxAttribute) const
+{
+    lineIds.clear();
+    if (nodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[BVH_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const LineSegmentBVHNode &node = nodes[stack[--stackSize]];
+        if (!overlapsAABB(node, box.min, box.max)
+                || node.maxAttribute < minAttribute || node.minAttribute > maxAttribute) {
+            continue;
+        }
+
+        if (node.numSegments > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.numSegments; i++) {
+                const BVHLineSegment &segment = segments[i];
+                if (segment.maxAttribute >= minAttribute && segment.minAttribute <= maxAttribute
+                        && intersectSegmentAABB(segment.p0, segment.p1, box)) {
+                    lineIds.push_back(segment.lineId);
+                }
+            }
+        } else {
+            stack[stackSize++] = node.offset;
+            stack[stackSize++] = uint32_t(&node - &nodes.front()) + 1;
+        }
+    }
+
+    makeLineIdsUnique(lineIds);
+}
+
+void LineSegmentBVH::querySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &lineIds,
+        float minAttribute, float maxAttribute) const
+{
+    lineIds.clear();
+    if (nodes.empty()) {
+        return;
+    }
+
+    const float radiusSquared = radius * radius;
+    uint32_t stack[BVH_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const LineSegmentBVHNode &node = nodes[stack[--stackSize]];
+        if (squaredDistancePointAABB(center, node.aabbMin, node.aabbMax) > radiusSquared
+                || node.maxAttribute < minAttribute || node.minAttribute > maxAttribute) {
+            continue;
+        }
+
+        if (node.numSegments > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.numSegments; i++) {
+                const BVHLineSegment &segment = segments[i];
+                if (segment.maxAttribute >= minAttribute && segment.minAttribute <= maxAttribute
+                        && squaredDistancePointSegment(center, segment.p0, segment.p1) <= radiusSquared) {
+                    lineIds.push_back(segment.lineId);
+                }
+            }
+        } else {
+            stack[stackSize++] = node.offset;
+            stack[stackSize++] = uint32_t(&node - &nodes.front()) + 1;
+        }
+    }
+
+    makeLineIdsUnique(lineIds);
+}
+
+bool LineSegmentBVH::findNearestLine(const glm::vec3 &point, LineSegmentHit &hit, float maxDistance) const
+{
+    if (nodes.empty()) {
+        return false;
+    }
+
+    float bestDistanceSquared = maxDistance == FLT_MAX ? FLT_MAX : maxDistance * maxDistance;
+    bool hasHit = false;
+
+    uint32_t stack[BVH_MAX_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const LineSegmentBVHNode &node = nodes[stack[--stackSize]];
+        if (squaredDistancePointAABB(point, node.aabbMin, node.aabbMax) > bestDistanceSquared) {
+            continue;
+        }
+
+        if (node.numSegments > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.numSegments; i++) {
+                const BVHLineSegment &segment = segments[i];
+                float distanceSquared = squaredDistancePointSegment(point, segment.p0, segment.p1);
+                if (distanceSquared <= bestDistanceSquared) {
+                    bestDistanceSquared = distanceSquared;
+                    hit.lineId = segment.lineId;
+                    hit.segmentIndex = segment.segmentIndex;
+                    hit.distance = std::sqrt(distanceSquared);
+                    hit.rayT = 0.0f;
+                    hasHit = true;
+                }
+            }
+        } else {
+            // Visit the closer child first to shrink the search radius early.
+            uint32_t leftChildIndex = uint32_t(&node - &nodes.front()) + 1;
+            uint32_t rightChildIndex = node.offset;
+            const LineSegmentBVHNode &leftChild = nodes[leftChildIndex];
+            const LineSegmentBVHNode &rightChild = nodes[rightChildIndex];
+            float leftDistance = squaredDistancePointAABB(point, leftChild.aabbMin, leftChild.aabbMax);
+            float rightDistance = squaredDistancePointAABB(point, rightChild.aabbMin, rightChild.aabbMax);
+            if (leftDistance < rightDistance) {
+                stack[stackSize++] = rightChildIndex;
+                stack[stackSize++] = leftChildIndex;
+            } else {
+                stack[stackSize++] = leftChildIndex;
+                stack[stackSize++] = rightChildIndex;
+            }
+        }
+    }
+
+    return hasHit;
+}
+
+void LineSegmentBVH::makeLineIdsUnique(std::vector<uint32_t> &lineIds) const
+{
+    std::sort(lineIds.begin(), lineIds.end());
+    lineIds.erase(std::unique(lineIds.begin(), lineIds.end()), lineIds.end());
+}
+
+std::string getLineSegmentBVHFilename(const std::string &binmeshFilename)
+{
+    return binmeshFilename + ".bvh";
+}
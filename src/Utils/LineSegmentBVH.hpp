@@ -0,0 +1,161 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_LINESEGMENTBVH_HPP
+#define PIXELSYNCOIT_LINESEGMENTBVH_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cfloat>
+#include <map>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB3.hpp>
+
+/**
+ * A line segment stored in the leaves of the BVH. The segments are reordered during the build, so they store the
+ * index of the segment in the line list index buffer they were created from.
+ */
+struct BVHLineSegment
+{
+    glm::vec3 p0;
+    uint32_t lineId;
+    glm::vec3 p1;
+    uint32_t segmentIndex;
+    float minAttribute;
+    float maxAttribute;
+};
+
+/**
+ * Inner nodes store the index of their right child (the left child directly follows its parent), leaves store the
+ * range of their segments. Both store the bounds and the attribute range of all segments below them.
+ */
+struct LineSegmentBVHNode
+{
+    glm::vec3 aabbMin;
+    uint32_t offset; ///< Leaf: Index of the first segment. Inner node: Index of the right child.
+    glm::vec3 aabbMax;
+    uint32_t numSegments; ///< 0 for inner nodes.
+    float minAttribute;
+    float maxAttribute;
+};
+
+/**
+ * Result of a ray pick or nearest line query.
+ */
+struct LineSegmentHit
+{
+    uint32_t lineId;
+    uint32_t segmentIndex;
+    float distance; ///< Distance between the query (ray or point) and the segment.
+    float rayT; ///< Ray parameter of the closest point on the ray (only for ray picks).
+};
+
+/**
+ * Identifies the data a BVH was built from, so that outdated cache files are detected.
+ */
+struct LineSegmentBVHSource
+{
+    uint64_t lastModified = 0; ///< Modification time of the binmesh file the BVH was built from.
+    uint64_t numIndices = 0; ///< Size of the line list index buffer.
+    int32_t attributeIndex = -1; ///< Index of the attribute used for the attribute ranges (-1 if none).
+};
+
+/**
+ * Bounding volume hierarchy over the segments of a line mesh (VERTEX_MODE_LINES).
+ * The line IDs are assigned like in LineFilter, i.e., a new line starts at each segment that doesn't continue the
+ * previous one, so query results can directly be used for filtering the rendered lines.
+ */
+class LineSegmentBVH
+{
+public:
+    /**
+     * Builds the BVH in parallel using median splits along the largest axis of the segment centroids.
+     * @param vertexPositions The vertex positions of the line mesh.
+     * @param lineIndices The line list index buffer.
+     * @param vertexAttributes Optional per-vertex attribute used for the attribute ranges of the nodes (or NULL).
+     */
+    void build(const std::vector<glm::vec3> &vertexPositions, const std::vector<uint32_t> &lineIndices,
+            const std::vector<float> *vertexAttributes = NULL);
+
+    /// Writes the BVH together with the source it was built from.
+    bool writeToFile(const std::string &filename, const LineSegmentBVHSource &source) const;
+    /**
+     * Reads a BVH written by writeToFile.
+     * @return False if the file is invalid, has an old format version or was built from a different source.
+     */
+    bool readFromFile(const std::string &filename, const LineSegmentBVHSource &source);
+
+    inline bool isEmpty() const { return nodes.empty(); }
+    inline size_t getNumLines() const { return numLines; }
+    inline const std::vector<LineSegmentBVHNode> &getNodes() const { return nodes; }
+    inline const std::vector<BVHLineSegment> &getSegments() const { return segments; }
+
+    /**
+     * Finds the segment closest to the ray among all segments with a distance of at most maxDistance to the ray
+     * (i.e., lines are treated as tubes with radius maxDistance). Among those, the closest hit along the ray is chosen.
+     * @return False if no segment was hit.
+     */
+    bool pickRay(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, float maxDistance,
+            LineSegmentHit &hit) const;
+
+    /**
+     * Returns the sorted IDs of all lines with at least one segment intersecting the box (or sphere) and an attribute
+     * range overlapping [minAttribute, maxAttribute].
+     */
+    void queryBox(const sgl::AABB3 &box, std::vector<uint32_t> &lineIds,
+            float minAttribute = -FLT_MAX, float maxAttribute = FLT_MAX) const;
+    void querySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &lineIds,
+            float minAttribute = -FLT_MAX, float maxAttribute = FLT_MAX) const;
+
+    /**
+     * Finds the line closest to the point within maxDistance.
+     * @return False if no line is closer than maxDistance.
+     */
+    bool findNearestLine(const glm::vec3 &point, LineSegmentHit &hit, float maxDistance = FLT_MAX) const;
+
+private:
+    void buildRecursive(uint32_t nodeIndex, uint32_t segmentsBegin, uint32_t segmentsEnd, int depth);
+    uint32_t getSubtreeNumNodes(uint32_t numSegments) const;
+    void makeLineIdsUnique(std::vector<uint32_t> &lineIds) const;
+
+    std::vector<LineSegmentBVHNode> nodes;
+    std::vector<BVHLineSegment> segments;
+    size_t numLines = 0;
+
+    /// Number of nodes of a subtree with a given number of segments (only used during the build).
+    std::map<uint32_t, uint32_t> subtreeNumNodes;
+};
+
+/**
+ * Returns the filename of the BVH cache stored next to a binmesh file.
+ */
+std::string getLineSegmentBVHFilename(const std::string &binmeshFilename);
+
+#endif //PIXELSYNCOIT_LINESEGMENTBVH_HPP
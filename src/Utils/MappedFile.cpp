@@ -0,0 +1,131 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <cstdio>
+#include <Utils/File/Logfile.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define USE_POSIX_MMAP
+#endif
+
+#include "MappedFile.hpp"
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+#ifdef USE_POSIX_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: File \""
+                + filename + "\" not found.");
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: Couldn't stat file \""
+                + filename + "\".");
+        ::close(fd);
+        return false;
+    }
+    size = size_t(fileStat.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *mappedMemory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after closing the file descriptor.
+    ::close(fd);
+    if (mappedMemory == MAP_FAILED) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: Couldn't map file \""
+                + filename + "\".");
+        size = 0;
+        return false;
+    }
+    // All users read the whole file, so let the kernel start reading ahead immediately.
+    madvise(mappedMemory, size, MADV_WILLNEED);
+    data = (const uint8_t*)mappedMemory;
+    isHeapBuffer = false;
+#else
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: File \""
+                + filename + "\" not found.");
+        return false;
+    }
+#if defined(_WIN32)
+    _fseeki64(file, 0, SEEK_END);
+    size = _ftelli64(file);
+    _fseeki64(file, 0, SEEK_SET);
+#else
+    fseeko(file, 0, SEEK_END);
+    size = ftello(file);
+    fseeko(file, 0, SEEK_SET);
+#endif
+    uint8_t *buffer = new uint8_t[size];
+    size_t readSize = fread(buffer, 1, size, file);
+    fclose(file);
+    if (readSize != size) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: Couldn't read file \""
+                + filename + "\".");
+        delete[] buffer;
+        size = 0;
+        return false;
+    }
+    data = buffer;
+    isHeapBuffer = true;
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data == NULL) {
+        return;
+    }
+
+    if (isHeapBuffer) {
+        delete[] data;
+    } else {
+#ifdef USE_POSIX_MMAP
+        munmap((void*)data, size);
+#endif
+    }
+    data = NULL;
+    size = 0;
+    isHeapBuffer = false;
+}
@@ -0,0 +1,67 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIXELSYNCOIT_MAPPEDFILE_HPP
+#define PIXELSYNCOIT_MAPPEDFILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * A read-only memory mapping of a whole file. On systems without mmap support, the file is read into a heap buffer.
+ * The data stays valid until close() is called or the object is destroyed.
+ */
+class MappedFile
+{
+public:
+    MappedFile() : data(NULL), size(0), isHeapBuffer(false) {}
+    ~MappedFile() { close(); }
+
+    /**
+     * Maps the specified file into memory.
+     * @return False if the file could not be opened or mapped.
+     */
+    bool open(const std::string &filename);
+    void close();
+
+    inline bool isOpen() const { return data != NULL; }
+    inline const uint8_t *getData() const { return data; }
+    inline size_t getSize() const { return size; }
+
+private:
+    // Non-copyable
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+
+    const uint8_t *data;
+    size_t size;
+    bool isHeapBuffer;
+};
+
+#endif //PIXELSYNCOIT_MAPPEDFILE_HPP
@@ -0,0 +1,71 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include "MeshAdjacency.hpp"
+
+void buildVertexTriangleAdjacency(
+        size_t numVertices, const std::vector<uint32_t> &indices, VertexTriangleAdjacency &adjacency)
+{
+    std::vector<uint32_t> &triangleOffsets = adjacency.triangleOffsets;
+    std::vector<uint32_t> &triangleIndices = adjacency.triangleIndices;
+    triangleOffsets.clear();
+    triangleOffsets.resize(numVertices + 1, 0);
+    triangleIndices.resize(indices.size());
+    const size_t numIndices = indices.size();
+
+    // 1. Count the references of each vertex.
+    uint32_t *counts = &triangleOffsets.front() + 1;
+    #pragma omp parallel for
+    for (size_t j = 0; j < numIndices; j++) {
+        #pragma omp atomic
+        counts[indices[j]]++;
+    }
+
+    // 2. Exclusive prefix sum over the counts.
+    for (size_t i = 0; i < numVertices; i++) {
+        triangleOffsets[i + 1] += triangleOffsets[i];
+    }
+
+    // 3. Scatter the triangles into the slots of their vertices.
+    std::vector<uint32_t> writePositions(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    #pragma omp parallel for
+    for (size_t j = 0; j < numIndices; j++) {
+        uint32_t writePosition;
+        #pragma omp atomic capture
+        writePosition = writePositions[indices[j]]++;
+        triangleIndices[writePosition] = uint32_t(j / 3);
+    }
+
+    // The order of the scatter depends on the thread scheduling, so sort the triangles of each vertex.
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t i = 0; i < numVertices; i++) {
+        std::sort(triangleIndices.begin() + triangleOffsets[i], triangleIndices.begin() + triangleOffsets[i + 1]);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_MESHADJACENCY_HPP
+#define PIXELSYNCOIT_MESHADJACENCY_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Vertex-to-triangle adjacency of an indexed triangle mesh in compressed sparse row (CSR) layout.
+ * The triangles referencing vertex i are triangleIndices[triangleOffsets[i], triangleOffsets[i+1]), sorted in
+ * ascending order. A triangle referencing a vertex more than once is listed once per reference.
+ */
+struct VertexTriangleAdjacency
+{
+    std::vector<uint32_t> triangleOffsets;
+    std::vector<uint32_t> triangleIndices;
+
+    inline uint32_t getNumTriangles(size_t vertexIndex) const {
+        return triangleOffsets[vertexIndex+1] - triangleOffsets[vertexIndex];
+    }
+    inline const uint32_t *getTriangles(size_t vertexIndex) const {
+        return triangleIndices.data() + triangleOffsets[vertexIndex];
+    }
+};
+
+/**
+ * Builds the vertex-to-triangle adjacency of the triangle list "indices" referencing "numVertices" vertices.
+ * The table is built in parallel by counting the references of each vertex with atomic increments, computing the
+ * prefix sum of the counts and scattering the triangles. The result doesn't depend on the number of threads.
+ */
+void buildVertexTriangleAdjacency(
+        size_t numVertices, const std::vector<uint32_t> &indices, VertexTriangleAdjacency &adjacency);
+
+#endif //PIXELSYNCOIT_MESHADJACENCY_HPP
@@ -22,13 +22,13 @@
 #include <Graphics/Renderer.hpp>
 
 #include "ImportanceCriteria.hpp"
+#include "MeshSimplification.hpp"
+#include "PointQuantization.hpp"
 #include "MeshSerializer.hpp"
 
 using namespace std;
 using namespace sgl;
 
-const uint32_t MESH_FORMAT_VERSION = 4u;
-
 void writeMesh3D(const std::string &filename, const BinaryMesh &mesh) {
 #ifndef __MINGW32__
     std::ofstream file(filename.c_str(), std::ofstream::binary);
@@ -81,6 +81,23 @@ void writeMesh3D(const std::string &filename, const BinaryMesh &mesh) {
 #endif
 }
 
+bool writeMesh3DData(FILE *file, const void *data, size_t numBytes)
+{
+    return numBytes == 0 || fwrite(data, 1, numBytes, file) == numBytes;
+}
+
+bool writeMesh3DAttributeHeader(
+        FILE *file, const std::string &name, sgl::VertexAttributeFormat attributeFormat, uint32_t numComponents,
+        size_t numBytes)
+{
+    sgl::BinaryWriteStream stream;
+    stream.write(name);
+    stream.write((uint32_t)attributeFormat);
+    stream.write((uint32_t)numComponents);
+    stream.write((uint32_t)numBytes);
+    return writeMesh3DData(file, stream.getBuffer(), stream.getSize());
+}
+
 void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
 #ifndef __MINGW32__
     std::ifstream file(filename.c_str(), std::ifstream::binary);
@@ -176,6 +193,15 @@ void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
 
 void MeshRenderer::render(sgl::ShaderProgramPtr passShader, bool isGBufferPass, int attributeIndex)
 {
+    if (allLinesFiltered || allPointsCulled) {
+        return;
+    }
+
+    if (pointQuantizationNodeBuffer) {
+        sgl::ShaderManager->bindShaderStorageBuffer(
+                POINT_QUANTIZATION_NODE_BUFFER_BINDING, pointQuantizationNodeBuffer);
+    }
+
     if (useProgrammableFetch) {
         for (SSBOEntry &ssboEntry : ssboEntries) {
             if (ssboEntry.bindingPoint >= 0 && (!boost::starts_with(ssboEntry.attributeName, "vertexAttribute")
@@ -186,6 +212,9 @@ void MeshRenderer::render(sgl::ShaderProgramPtr passShader, bool isGBufferPass,
     }
 
     for (size_t i = 0; i < shaderAttributes.size(); i++) {
+        if (!submeshLodLevels.empty() && submeshLodLevels.at(i) >= 0 && submeshLodLevels.at(i) != currentLod) {
+            continue;
+        }
         //ShaderProgram *shader = shaderAttributes.at(i)->getShaderProgram();
         if (!boost::starts_with(passShader->getShaderList().front()->getFileID(), "PseudoPhongVorticity")
                 && !boost::starts_with(passShader->getShaderList().front()->getFileID(), "DepthPeelingGatherDepthComplexity")
@@ -217,6 +246,93 @@ void MeshRenderer::setNewShader(sgl::ShaderProgramPtr newShader)
     }
 }
 
+void MeshRenderer::uploadFilteredLineIndices()
+{
+    if (lineFilter.isEmpty() || shaderAttributes.size() != 1) {
+        return;
+    }
+
+    const std::vector<uint32_t> &filteredIndices = lineFilter.getFilteredIndices();
+    allLinesFiltered = filteredIndices.empty();
+    segmentSorter.setLineIndices(filteredIndices);
+    if (allLinesFiltered) {
+        return;
+    }
+    GeometryBufferPtr indexBuffer = Renderer->createGeometryBuffer(
+            sizeof(uint32_t)*filteredIndices.size(), (void*)&filteredIndices.front(), INDEX_BUFFER);
+    shaderAttributes.front()->setIndexGeometryBuffer(indexBuffer, ATTRIB_UNSIGNED_INT);
+}
+
+void MeshRenderer::uploadSortedLineIndices(const glm::mat4 &modelViewMatrix)
+{
+    if (segmentSorter.isEmpty() || shaderAttributes.size() != 1) {
+        return;
+    }
+
+    const std::vector<uint32_t> &sortedIndices = segmentSorter.sortBackToFront(modelViewMatrix);
+    if (sortedIndices.empty()) {
+        return;
+    }
+    // The number of visible segments only changes with the line filter, so the buffer is overwritten in most frames.
+    size_t sortedIndicesSize = sizeof(uint32_t)*sortedIndices.size();
+    if (!sortedLineIndexBuffer || sortedLineIndexBufferSize != sortedIndicesSize) {
+        sortedLineIndexBuffer = Renderer->createGeometryBuffer(
+                sortedIndicesSize, (void*)&sortedIndices.front(), INDEX_BUFFER);
+        sortedLineIndexBufferSize = sortedIndicesSize;
+    } else {
+        sortedLineIndexBuffer->subData(0, sortedIndicesSize, (void*)&sortedIndices.front());
+    }
+    shaderAttributes.front()->setIndexGeometryBuffer(sortedLineIndexBuffer, ATTRIB_UNSIGNED_INT);
+}
+
+void MeshRenderer::selectLod(const glm::mat4 &modelViewMatrix, float projectionScale, float pixelErrorBudget)
+{
+    currentLod = 0;
+    if (!hasLods() || pixelErrorBudget <= 0.0f) {
+        return;
+    }
+
+    // Distance from the camera to the bounding sphere. Inside of the sphere, the full resolution is used.
+    float scale = glm::length(glm::vec3(modelViewMatrix[0]));
+    glm::vec3 centerView = glm::vec3(modelViewMatrix * glm::vec4(boundingBox.getCenter(), 1.0f));
+    float distance = glm::length(centerView) - glm::length(boundingBox.getExtent()) * scale;
+    if (distance <= 0.0f) {
+        return;
+    }
+
+    for (int level = int(lodErrors.size()) - 1; level > 0; level--) {
+        float pixelError = lodErrors.at(level) * scale * projectionScale / distance;
+        if (pixelError <= pixelErrorBudget) {
+            currentLod = level;
+            return;
+        }
+    }
+}
+
+void MeshRenderer::selectPoints(const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix, size_t pointBudget)
+{
+    if (pointOctreeNodes.empty() || shaderAttributes.size() != 1) {
+        return;
+    }
+
+    std::vector<uint32_t> newSelection;
+    numSelectedPoints = selectPointOctreeNodes(
+            pointOctreeNodes, modelViewMatrix, projectionMatrix, pointBudget, newSelection);
+    if (newSelection == selectedPointOctreeNodes && !selectedPointOctreeNodes.empty()) {
+        return;
+    }
+    selectedPointOctreeNodes.swap(newSelection);
+
+    std::vector<uint32_t> pointIndices;
+    getPointOctreeNodeIndices(pointOctreeNodes, selectedPointOctreeNodes, pointIndices);
+    allPointsCulled = pointIndices.empty();
+    if (allPointsCulled) {
+        return;
+    }
+    GeometryBufferPtr indexBuffer = Renderer->createGeometryBuffer(
+            sizeof(uint32_t)*pointIndices.size(), (void*)&pointIndices.front(), INDEX_BUFFER);
+    shaderAttributes.front()->setIndexGeometryBuffer(indexBuffer, ATTRIB_UNSIGNED_INT);
+}
 
 sgl::AABB3 computeAABB(const std::vector<glm::vec3> &vertices)
 {
@@ -335,9 +451,15 @@ struct LinePointData
 MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shader, bool shuffleData,
         bool useProgrammableFetch, bool programmableFetchUseAoS, float lineRadius)
 {
-    MeshRenderer meshRenderer(useProgrammableFetch);
     BinaryMesh mesh;
     readMesh3D(filename, mesh);
+    return parseMesh3D(mesh, shader, shuffleData, useProgrammableFetch, programmableFetchUseAoS, lineRadius);
+}
+
+MeshRenderer parseMesh3D(const BinaryMesh &mesh, sgl::ShaderProgramPtr shader, bool shuffleData,
+        bool useProgrammableFetch, bool programmableFetchUseAoS, float lineRadius)
+{
+    MeshRenderer meshRenderer(useProgrammableFetch);
 
     if (!shader) {
         shader = ShaderManager->getShaderProgram({"PseudoPhong.Vertex", "PseudoPhong.Fragment"});
@@ -355,9 +477,52 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
     //int importanceCriterionLocationCounter = 3;
 
 
+    // Levels of detail stored in the submesh uniforms
+    bool hasLods = false;
+    for (const BinarySubMesh &submesh : mesh.submeshes) {
+        uint32_t lodLevel;
+        float lodError;
+        if (getSubmeshLod(submesh, lodLevel, lodError)) {
+            hasLods = true;
+            if (lodLevel >= meshRenderer.lodErrors.size()) {
+                meshRenderer.lodErrors.resize(lodLevel + 1, 0.0f);
+            }
+            meshRenderer.lodErrors.at(lodLevel) = std::max(meshRenderer.lodErrors.at(lodLevel), lodError);
+            meshRenderer.submeshLodLevels.push_back(int(lodLevel));
+        } else {
+            meshRenderer.submeshLodLevels.push_back(-1);
+        }
+    }
+    if (!hasLods) {
+        meshRenderer.submeshLodLevels.clear();
+    }
+
+    // Octree of point data sets (stored by convertPointDataSetToBinmesh).
+    if (mesh.submeshes.size() == 1 && mesh.submeshes.front().vertexMode == VERTEX_MODE_POINTS && !useProgrammableFetch) {
+        getSubmeshPointOctree(mesh.submeshes.front(), meshRenderer.pointOctreeNodes);
+    }
+    // Quantized point positions are decoded in the vertex shader with the bounds of their octree node.
+    if (!meshRenderer.pointOctreeNodes.empty() && isQuantizedPointSubmesh(mesh.submeshes.front())) {
+        std::vector<PointQuantizationNode> quantizationNodes;
+        getPointQuantizationNodes(meshRenderer.pointOctreeNodes, quantizationNodes);
+        meshRenderer.pointQuantizationNodeBuffer = Renderer->createGeometryBuffer(
+                quantizationNodes.size()*sizeof(PointQuantizationNode), (void*)&quantizationNodes.front(),
+                SHADER_STORAGE_BUFFER);
+        totalBoundingBox.combine(computeQuantizedPointsAABB(
+                mesh.submeshes.front(), meshRenderer.pointOctreeNodes));
+    }
+
+    // Line summaries of line meshes (stored by convertTrajectoriesToBinaryLineMesh). Shuffling changes the line order.
+    std::vector<std::vector<LineAttributeSummary>> storedLineSummaries;
+    if (mesh.submeshes.size() == 1 && mesh.submeshes.front().vertexMode == VERTEX_MODE_LINES && !shuffleData) {
+        getSubmeshLineSummaries(mesh.submeshes.front(), storedLineSummaries);
+    }
+
     // Iterate over all submeshes and create rendering data
     for (size_t i = 0; i < mesh.submeshes.size(); i++) {
-        BinarySubMesh &submesh = mesh.submeshes.at(i);
+        const BinarySubMesh &submesh = mesh.submeshes.at(i);
+        // The importance criteria are only taken from the original data, not from simplified levels of detail.
+        bool isSimplifiedLod = hasLods && meshRenderer.submeshLodLevels.at(i) > 0;
         ShaderAttributesPtr renderData = ShaderManager->createShaderAttributes(shader);
         if (!useProgrammableFetch) {
             renderData->setVertexMode(submesh.vertexMode);
@@ -380,10 +545,16 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
                 GeometryBufferPtr indexBuffer = Renderer->createGeometryBuffer(
                         sizeof(uint32_t)*shuffledIndices.size(), (void*)&shuffledIndices.front(), INDEX_BUFFER);
                 renderData->setIndexGeometryBuffer(indexBuffer, ATTRIB_UNSIGNED_INT);
+                if (submesh.vertexMode == VERTEX_MODE_LINES && mesh.submeshes.size() == 1) {
+                    meshRenderer.lineFilter.setLineIndices(shuffledIndices);
+                }
             } else {
                 GeometryBufferPtr indexBuffer = Renderer->createGeometryBuffer(
                         sizeof(uint32_t)*submesh.indices.size(), (void*)&submesh.indices.front(), INDEX_BUFFER);
                 renderData->setIndexGeometryBuffer(indexBuffer, ATTRIB_UNSIGNED_INT);
+                if (submesh.vertexMode == VERTEX_MODE_LINES && mesh.submeshes.size() == 1) {
+                    meshRenderer.lineFilter.setLineIndices(submesh.indices);
+                }
             }
         }
         if (submesh.indices.size() > 0 && useProgrammableFetch) {
@@ -413,18 +584,27 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
         std::vector<glm::vec3> vertexTangentData;
 
         for (size_t j = 0; j < submesh.attributes.size(); j++) {
-            BinaryMeshAttribute &meshAttribute = submesh.attributes.at(j);
+            const BinaryMeshAttribute &meshAttribute = submesh.attributes.at(j);
             GeometryBufferPtr attributeBuffer;
 
             // Assume only one component means importance criterion like vorticity, line width, ...
-            if (meshAttribute.numComponents == 1) {
+            if (meshAttribute.numComponents == 1 && !isSimplifiedLod) {
                 ImportanceCriterionAttribute importanceCriterionAttribute;
                 importanceCriterionAttribute.name = meshAttribute.name;
 
-                // Copy values to mesh renderer data structure
-                uint16_t *attributeValuesUnorm = (uint16_t*)&meshAttribute.data.front();
-                size_t numAttributeValues = meshAttribute.data.size() / sizeof(uint16_t);
-                unpackUnorm16Array(attributeValuesUnorm, numAttributeValues, importanceCriterionAttribute.attributes);
+                // Copy values to mesh renderer data structure (quantized point attributes may only use 8 bits)
+                size_t numAttributeValues;
+                if (meshAttribute.attributeFormat == ATTRIB_UNSIGNED_BYTE) {
+                    uint8_t *attributeValuesUnorm = (uint8_t*)&meshAttribute.data.front();
+                    numAttributeValues = meshAttribute.data.size();
+                    unpackUnorm8Array(
+                            attributeValuesUnorm, numAttributeValues, importanceCriterionAttribute.attributes);
+                } else {
+                    uint16_t *attributeValuesUnorm = (uint16_t*)&meshAttribute.data.front();
+                    numAttributeValues = meshAttribute.data.size() / sizeof(uint16_t);
+                    unpackUnorm16Array(
+                            attributeValuesUnorm, numAttributeValues, importanceCriterionAttribute.attributes);
+                }
 
                 // Compute minimum and maximum value
                 float minValue = FLT_MAX, maxValue = 0.0f;
@@ -435,6 +615,13 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
                 }
                 importanceCriterionAttribute.minAttribute = minValue;
                 importanceCriterionAttribute.maxAttribute = maxValue;
+                if (!meshRenderer.lineFilter.isEmpty()) {
+                    size_t attributeIndex = meshRenderer.importanceCriterionAttributes.size();
+                    if (attributeIndex >= storedLineSummaries.size() || meshRenderer.lineFilter.addAttribute(
+                            storedLineSummaries.at(attributeIndex)) == SIZE_MAX) {
+                        meshRenderer.lineFilter.addAttribute(importanceCriterionAttribute.attributes);
+                    }
+                }
 
                 meshRenderer.importanceCriterionAttributes.push_back(importanceCriterionAttribute);
 
@@ -484,11 +671,12 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
                             attributeBuffer, meshAttribute.name.c_str(), meshAttribute.attributeFormat,
                             meshAttribute.numComponents, 0, 0, 0, ATTRIB_CONVERSION_FLOAT_NORMALIZED);
                 } else {
-                    bool isNormalizedColor = (meshAttribute.name == "vertexColor");
+                    bool isNormalized = (meshAttribute.name == "vertexColor")
+                            || meshAttribute.name == QUANTIZED_POSITION_ATTRIBUTE_NAME;
                     renderData->addGeometryBufferOptional(
                             attributeBuffer, meshAttribute.name.c_str(), meshAttribute.attributeFormat,
                             meshAttribute.numComponents, 0, 0, 0,
-                            isNormalizedColor ? ATTRIB_CONVERSION_FLOAT_NORMALIZED : ATTRIB_CONVERSION_FLOAT);
+                            isNormalized ? ATTRIB_CONVERSION_FLOAT_NORMALIZED : ATTRIB_CONVERSION_FLOAT);
                 }
                 meshRenderer.shaderAttributeNames.insert(meshAttribute.name);
             } else {
@@ -526,6 +714,10 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
                 vertices.resize(meshAttribute.data.size() / sizeof(glm::vec3));
                 memcpy(&vertices.front(), &meshAttribute.data.front(), meshAttribute.data.size());
                 totalBoundingBox.combine(computeAABB(vertices));
+                if (!meshRenderer.lineFilter.isEmpty()) {
+                    meshRenderer.segmentSorter.setVertexPositions(vertices);
+                    meshRenderer.segmentSorter.setLineIndices(meshRenderer.lineFilter.getFilteredIndices());
+                }
             }
         }
 
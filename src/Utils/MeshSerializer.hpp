@@ -10,12 +10,17 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <cstdio>
 #include <set>
 
 #include <Math/Geometry/AABB3.hpp>
 #include <Math/Geometry/Sphere.hpp>
 #include <Graphics/Shader/ShaderAttributes.hpp>
 
+#include "LineFilter.hpp"
+#include "SegmentSorter.hpp"
+#include "PointOctree.hpp"
+
 /**
  * Parsing text-based mesh files, like .obj files, is really slow compared to binary formats.
  * The utility functions below serialize 3D mesh data to a file/read the data back from such a file.
@@ -69,6 +74,7 @@ struct ObjMesh
  *
  * A uniform attribute is an attribute constant over all vertices.
  */
+const uint32_t MESH_FORMAT_VERSION = 4u;
 
 struct BinaryMeshAttribute
 {
@@ -106,6 +112,18 @@ struct BinaryMesh
  */
 void writeMesh3D(const std::string &filename, const BinaryMesh &mesh);
 
+/*
+ * Helpers for writing a binary mesh file in the layout of writeMesh3D piece by piece, e.g., when the mesh data doesn't
+ * fit into memory a second time. Arrays are stored like sgl::BinaryWriteStream::writeArray does it, i.e., as a 32-bit
+ * element count followed by the elements.
+ */
+/// Writes raw data. Returns false if not all bytes could be written.
+bool writeMesh3DData(FILE *file, const void *data, size_t numBytes);
+/// Writes everything writeMesh3D stores in front of the data of a vertex attribute.
+bool writeMesh3DAttributeHeader(
+        FILE *file, const std::string &name, sgl::VertexAttributeFormat attributeFormat, uint32_t numComponents,
+        size_t numBytes);
+
 /**
  * Reads a mesh from a binary file. The mesh data vectors may also be empty (i.e. size 0).
  * @param indices, vertices, texcoords, normals: The mesh data.
@@ -137,6 +155,23 @@ public:
     // attributeIndex: For programmable vertex fetching/pulling. We need to bind the correct line attribute SSBO!
     void render(sgl::ShaderProgramPtr passShader, bool isGBufferPass, int attributeIndex);
     void setNewShader(sgl::ShaderProgramPtr newShader);
+    /// Uploads the index buffer of the lines currently visible in lineFilter.
+    void uploadFilteredLineIndices();
+    /// Sorts the visible line segments back-to-front on the CPU and uploads the sorted index buffer.
+    void uploadSortedLineIndices(const glm::mat4 &modelViewMatrix);
+    /**
+     * Selects the coarsest level of detail whose geometric error projects to at most pixelErrorBudget pixels.
+     * @param modelViewMatrix The model view matrix (may contain a uniform scaling).
+     * @param projectionScale The viewport height divided by 2*tan(fovy/2), i.e., pixels per unit at distance one.
+     */
+    void selectLod(const glm::mat4 &modelViewMatrix, float projectionScale, float pixelErrorBudget);
+    inline bool hasLods() const { return lodErrors.size() > 1; }
+    /**
+     * Selects the octree nodes of a point data set to render with at most pointBudget points (see PointOctree.hpp)
+     * and uploads their index buffer if the selection changed.
+     */
+    void selectPoints(const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix, size_t pointBudget);
+    inline bool hasPointOctree() const { return !pointOctreeNodes.empty(); }
     bool isLoaded() { return shaderAttributes.size() > 0; }
     bool hasAttributeWithName(const std::string &name) {
         return shaderAttributeNames.find(name) != shaderAttributeNames.end();
@@ -150,6 +185,30 @@ public:
     sgl::AABB3 boundingBox;
     sgl::Sphere boundingSphere;
     std::vector<ImportanceCriterionAttribute> importanceCriterionAttributes;
+
+    // Per-line summaries of the importance criterion attributes for filtering line meshes (only set up for line
+    // meshes consisting of one submesh without programmable fetch).
+    LineFilter lineFilter;
+    bool allLinesFiltered = false;
+    // Sorts the visible segments of the same line meshes for OIT_SortedSegments.
+    SegmentSorter segmentSorter;
+    // The index buffer the sorted segments are uploaded to every frame (reused while their number stays the same).
+    sgl::GeometryBufferPtr sortedLineIndexBuffer;
+    size_t sortedLineIndexBufferSize = 0;
+
+    // Levels of detail of triangle meshes (see MeshSimplification.hpp). The geometric error of each level in object
+    // space, and the level of each submesh (-1 for submeshes that are part of every level).
+    std::vector<float> lodErrors;
+    std::vector<int> submeshLodLevels;
+    int currentLod = 0;
+
+    // Octree of point data sets consisting of one submesh (see PointOctree.hpp) and the nodes currently rendered.
+    std::vector<PointOctreeNode> pointOctreeNodes;
+    std::vector<uint32_t> selectedPointOctreeNodes;
+    size_t numSelectedPoints = 0;
+    bool allPointsCulled = false;
+    // The octree node bounds for decoding quantized point positions in the vertex shader (see PointQuantization.hpp).
+    sgl::GeometryBufferPtr pointQuantizationNodeBuffer;
 };
 
 
@@ -161,4 +220,10 @@ public:
 MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shader, bool shuffleData = false,
         bool useProgrammableFetch = false, bool programmableFetchUseAoS = true, float lineRadius = 0.001f);
 
+/**
+ * Same as above, but assigns the data of a mesh that is already in memory (e.g., a mesh created in the background).
+ */
+MeshRenderer parseMesh3D(const BinaryMesh &mesh, sgl::ShaderProgramPtr shader, bool shuffleData = false,
+        bool useProgrammableFetch = false, bool programmableFetchUseAoS = true, float lineRadius = 0.001f);
+
 #endif /* UTILS_MESHSERIALIZER_HPP_ */
@@ -0,0 +1,607 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "MeshAdjacency.hpp"
+#include "MeshSimplification.hpp"
+
+void setSubmeshLod(BinarySubMesh &submesh, uint32_t lodLevel, float lodError)
+{
+    for (auto it = submesh.uniforms.begin(); it != submesh.uniforms.end();) {
+        if (it->name == LOD_LEVEL_UNIFORM_NAME || it->name == LOD_ERROR_UNIFORM_NAME) {
+            it = submesh.uniforms.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    BinaryMeshUniform levelUniform;
+    levelUniform.name = LOD_LEVEL_UNIFORM_NAME;
+    levelUniform.attributeFormat = sgl::ATTRIB_UNSIGNED_INT;
+    levelUniform.numComponents = 1;
+    levelUniform.data.resize(sizeof(uint32_t));
+    memcpy(&levelUniform.data.front(), &lodLevel, sizeof(uint32_t));
+    submesh.uniforms.push_back(levelUniform);
+
+    BinaryMeshUniform errorUniform;
+    errorUniform.name = LOD_ERROR_UNIFORM_NAME;
+    errorUniform.attributeFormat = sgl::ATTRIB_FLOAT;
+    errorUniform.numComponents = 1;
+    errorUniform.data.resize(sizeof(float));
+    memcpy(&errorUniform.data.front(), &lodError, sizeof(float));
+    submesh.uniforms.push_back(errorUniform);
+}
+
+bool getSubmeshLod(const BinarySubMesh &submesh, uint32_t &lodLevel, float &lodError)
+{
+    bool hasLevel = false, hasError = false;
+    for (const BinaryMeshUniform &uniform : submesh.uniforms) {
+        if (uniform.name == LOD_LEVEL_UNIFORM_NAME && uniform.data.size() == sizeof(uint32_t)) {
+            memcpy(&lodLevel, &uniform.data.front(), sizeof(uint32_t));
+            hasLevel = true;
+        } else if (uniform.name == LOD_ERROR_UNIFORM_NAME && uniform.data.size() == sizeof(float)) {
+            memcpy(&lodError, &uniform.data.front(), sizeof(float));
+            hasError = true;
+        }
+    }
+    return hasLevel && hasError;
+}
+
+
+// The cell coordinates are packed into 21 bits each.
+const uint32_t MAX_CLUSTERING_RESOLUTION = (1u << 21) - 1u;
+
+static inline uint64_t packCell(const glm::uvec3 &cell)
+{
+    return uint64_t(cell.x) | (uint64_t(cell.y) << 21) | (uint64_t(cell.z) << 42);
+}
+
+static inline glm::uvec3 unpackCell(uint64_t key)
+{
+    return glm::uvec3(uint32_t(key & 0x1FFFFFu), uint32_t((key >> 21) & 0x1FFFFFu), uint32_t(key >> 42));
+}
+
+/// Adds the area-weighted quadric of the plane of the triangle to q (a2, ab, ac, ad, b2, bc, bd, c2, cd, d2).
+static inline void addTriangleQuadric(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, double *q)
+{
+    glm::dvec3 d0(p0), d1(p1), d2(p2);
+    glm::dvec3 n = glm::cross(d1 - d0, d2 - d0);
+    double doubleArea = glm::length(n);
+    if (!(doubleArea > 0.0)) {
+        return;
+    }
+    n /= doubleArea;
+    double d = -glm::dot(n, d0);
+    double w = doubleArea * 0.5;
+    q[0] += w*n.x*n.x; q[1] += w*n.x*n.y; q[2] += w*n.x*n.z; q[3] += w*n.x*d;
+    q[4] += w*n.y*n.y; q[5] += w*n.y*n.z; q[6] += w*n.y*d;
+    q[7] += w*n.z*n.z; q[8] += w*n.z*d;
+    q[9] += w*d*d;
+}
+
+/// Eigendecomposition of a symmetric 3x3 matrix using Jacobi rotations. The eigenvectors are the columns of v.
+static void computeSymmetricEigenvectors(double a[3][3], double eigenvalues[3], double v[3][3])
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            v[i][j] = i == j ? 1.0 : 0.0;
+        }
+    }
+
+    const int pairs[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+    for (int sweep = 0; sweep < 16; sweep++) {
+        double offDiagonal = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+        double diagonal = a[0][0]*a[0][0] + a[1][1]*a[1][1] + a[2][2]*a[2][2];
+        if (offDiagonal <= 1e-24 * diagonal) {
+            break;
+        }
+        for (int pairIdx = 0; pairIdx < 3; pairIdx++) {
+            int p = pairs[pairIdx][0], q = pairs[pairIdx][1];
+            if (a[p][q] == 0.0) {
+                continue;
+            }
+            double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+            double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta*theta + 1.0));
+            double c = 1.0 / std::sqrt(t*t + 1.0), s = t * c;
+            for (int k = 0; k < 3; k++) {
+                double akp = a[k][p], akq = a[k][q];
+                a[k][p] = c*akp - s*akq;
+                a[k][q] = s*akp + c*akq;
+            }
+            for (int k = 0; k < 3; k++) {
+                double apk = a[p][k], aqk = a[q][k];
+                a[p][k] = c*apk - s*aqk;
+                a[q][k] = s*apk + c*aqk;
+            }
+            for (int k = 0; k < 3; k++) {
+                double vkp = v[k][p], vkq = v[k][q];
+                v[k][p] = c*vkp - s*vkq;
+                v[k][q] = s*vkp + c*vkq;
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        eigenvalues[i] = a[i][i];
+    }
+}
+
+/**
+ * Computes the point minimizing the quadric error. Like in Lindstrom's paper, the solution is computed relative to the
+ * mean position of the merged vertices using a truncated pseudo-inverse, so that the point stays at the mean position
+ * in directions the quadric doesn't constrain (e.g., for planar regions).
+ */
+static glm::vec3 solveQuadric(const double *q, const glm::dvec3 &meanPosition)
+{
+    double a[3][3] = {
+            { q[0], q[1], q[2] },
+            { q[1], q[4], q[5] },
+            { q[2], q[5], q[7] }
+    };
+    glm::dvec3 b(q[3], q[6], q[8]);
+    glm::dvec3 residual = glm::dvec3(
+            a[0][0]*meanPosition.x + a[0][1]*meanPosition.y + a[0][2]*meanPosition.z,
+            a[1][0]*meanPosition.x + a[1][1]*meanPosition.y + a[1][2]*meanPosition.z,
+            a[2][0]*meanPosition.x + a[2][1]*meanPosition.y + a[2][2]*meanPosition.z) + b;
+
+    double eigenvalues[3], v[3][3];
+    computeSymmetricEigenvectors(a, eigenvalues, v);
+    double maxEigenvalue = std::max(std::abs(eigenvalues[0]), std::max(std::abs(eigenvalues[1]),
+            std::abs(eigenvalues[2])));
+
+    glm::dvec3 position = meanPosition;
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(eigenvalues[i]) > 1e-3 * maxEigenvalue && maxEigenvalue > 0.0) {
+            glm::dvec3 u(v[0][i], v[1][i], v[2][i]);
+            position -= u * (glm::dot(u, residual) / eigenvalues[i]);
+        }
+    }
+    return glm::vec3(position);
+}
+
+static inline size_t getFormatNumBytes(sgl::VertexAttributeFormat format)
+{
+    switch (format) {
+        case sgl::ATTRIB_BYTE: case sgl::ATTRIB_UNSIGNED_BYTE: return 1;
+        case sgl::ATTRIB_SHORT: case sgl::ATTRIB_UNSIGNED_SHORT: return 2;
+        case sgl::ATTRIB_INT: case sgl::ATTRIB_UNSIGNED_INT: case sgl::ATTRIB_FLOAT: return 4;
+        case sgl::ATTRIB_DOUBLE: return 8;
+        default: return 0;
+    }
+}
+
+template<class T>
+static inline double getTypedComponent(const uint8_t *data, size_t index)
+{
+    T value;
+    memcpy(&value, data + index * sizeof(T), sizeof(T));
+    return double(value);
+}
+
+template<class T>
+static inline void setTypedComponent(uint8_t *data, size_t index, double value, bool round)
+{
+    T typedValue = T(round ? std::floor(value + 0.5) : value);
+    memcpy(data + index * sizeof(T), &typedValue, sizeof(T));
+}
+
+static inline double getComponent(const BinaryMeshAttribute &attribute, size_t index)
+{
+    const uint8_t *data = &attribute.data.front();
+    switch (attribute.attributeFormat) {
+        case sgl::ATTRIB_BYTE: return getTypedComponent<int8_t>(data, index);
+        case sgl::ATTRIB_UNSIGNED_BYTE: return getTypedComponent<uint8_t>(data, index);
+        case sgl::ATTRIB_SHORT: return getTypedComponent<int16_t>(data, index);
+        case sgl::ATTRIB_UNSIGNED_SHORT: return getTypedComponent<uint16_t>(data, index);
+        case sgl::ATTRIB_INT: return getTypedComponent<int32_t>(data, index);
+        case sgl::ATTRIB_UNSIGNED_INT: return getTypedComponent<uint32_t>(data, index);
+        case sgl::ATTRIB_FLOAT: return getTypedComponent<float>(data, index);
+        case sgl::ATTRIB_DOUBLE: return getTypedComponent<double>(data, index);
+        default: return 0.0;
+    }
+}
+
+static inline void setComponent(BinaryMeshAttribute &attribute, size_t index, double value)
+{
+    uint8_t *data = &attribute.data.front();
+    switch (attribute.attributeFormat) {
+        case sgl::ATTRIB_BYTE: setTypedComponent<int8_t>(data, index, value, true); break;
+        case sgl::ATTRIB_UNSIGNED_BYTE: setTypedComponent<uint8_t>(data, index, value, true); break;
+        case sgl::ATTRIB_SHORT: setTypedComponent<int16_t>(data, index, value, true); break;
+        case sgl::ATTRIB_UNSIGNED_SHORT: setTypedComponent<uint16_t>(data, index, value, true); break;
+        case sgl::ATTRIB_INT: setTypedComponent<int32_t>(data, index, value, true); break;
+        case sgl::ATTRIB_UNSIGNED_INT: setTypedComponent<uint32_t>(data, index, value, true); break;
+        case sgl::ATTRIB_FLOAT: setTypedComponent<float>(data, index, value, false); break;
+        case sgl::ATTRIB_DOUBLE: setTypedComponent<double>(data, index, value, false); break;
+        default: break;
+    }
+}
+
+struct ClusterTriangle
+{
+    uint32_t sortedIndices[3];
+    uint32_t triangleIndex;
+};
+
+static inline bool operator<(const ClusterTriangle &a, const ClusterTriangle &b)
+{
+    for (int i = 0; i < 3; i++) {
+        if (a.sortedIndices[i] != b.sortedIndices[i]) {
+            return a.sortedIndices[i] < b.sortedIndices[i];
+        }
+    }
+    return a.triangleIndex < b.triangleIndex;
+}
+
+/**
+ * Quadric-based vertex clustering of one submesh. The vertex-to-triangle adjacency is shared by all levels of detail.
+ */
+class VertexClusteringSimplifier
+{
+public:
+    VertexClusteringSimplifier(const BinarySubMesh &submesh, const BinaryMeshAttribute &positionAttribute)
+            : submesh(submesh), indices(submesh.indices) {
+        vertices = reinterpret_cast<const glm::vec3*>(&positionAttribute.data.front());
+        numVertices = positionAttribute.data.size() / sizeof(glm::vec3);
+
+        float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+        #pragma omp parallel for reduction(min:minX,minY,minZ) reduction(max:maxX,maxY,maxZ)
+        for (size_t i = 0; i < numVertices; i++) {
+            minX = std::min(minX, vertices[i].x);
+            minY = std::min(minY, vertices[i].y);
+            minZ = std::min(minZ, vertices[i].z);
+            maxX = std::max(maxX, vertices[i].x);
+            maxY = std::max(maxY, vertices[i].y);
+            maxZ = std::max(maxZ, vertices[i].z);
+        }
+        minVec = glm::vec3(minX, minY, minZ);
+        maxExtent = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ));
+
+        buildVertexTriangleAdjacency(numVertices, indices, adjacency);
+    }
+
+    inline size_t getNumTriangles() const { return indices.size() / 3; }
+
+    /// Binary search for the lowest grid resolution leaving at least the target number of triangles.
+    uint32_t findResolution(size_t targetNumTriangles) const {
+        uint32_t lower = 1, upper = MAX_CLUSTERING_RESOLUTION;
+        if (countTriangles(upper) < targetNumTriangles) {
+            return upper;
+        }
+        while (lower < upper) {
+            uint32_t middle = lower + (upper - lower) / 2;
+            if (countTriangles(middle) >= targetNumTriangles) {
+                upper = middle;
+            } else {
+                lower = middle + 1;
+            }
+        }
+        return lower;
+    }
+
+    /// @return The diagonal of a grid cell, i.e., the maximum distance a vertex was moved.
+    float simplify(uint32_t resolution, BinarySubMesh &simplifiedSubmesh) const;
+
+private:
+    inline float getCellSize(uint32_t resolution) const { return maxExtent / float(resolution); }
+
+    void computeCellKeys(uint32_t resolution, std::vector<uint64_t> &cellKeys) const {
+        const float cellSize = getCellSize(resolution);
+        cellKeys.resize(numVertices);
+        #pragma omp parallel for
+        for (size_t i = 0; i < numVertices; i++) {
+            glm::vec3 cellPosition = glm::max((vertices[i] - minVec) / cellSize, glm::vec3(0.0f));
+            glm::uvec3 cell = glm::min(glm::uvec3(cellPosition), glm::uvec3(resolution - 1));
+            cellKeys[i] = packCell(cell);
+        }
+    }
+
+    /// Number of triangles whose vertices lie in three different cells.
+    size_t countTriangles(uint32_t resolution) const {
+        std::vector<uint64_t> cellKeys;
+        computeCellKeys(resolution, cellKeys);
+        const size_t numTriangles = getNumTriangles();
+        size_t numRemainingTriangles = 0;
+        #pragma omp parallel for reduction(+:numRemainingTriangles)
+        for (size_t t = 0; t < numTriangles; t++) {
+            uint64_t k0 = cellKeys[indices[t*3]], k1 = cellKeys[indices[t*3+1]], k2 = cellKeys[indices[t*3+2]];
+            if (k0 != k1 && k1 != k2 && k0 != k2) {
+                numRemainingTriangles++;
+            }
+        }
+        return numRemainingTriangles;
+    }
+
+    const BinarySubMesh &submesh;
+    const std::vector<uint32_t> &indices;
+    const glm::vec3 *vertices;
+    size_t numVertices;
+    glm::vec3 minVec;
+    float maxExtent;
+    VertexTriangleAdjacency adjacency;
+};
+
+float VertexClusteringSimplifier::simplify(uint32_t resolution, BinarySubMesh &simplifiedSubmesh) const
+{
+    const float cellSize = getCellSize(resolution);
+    const size_t numTriangles = getNumTriangles();
+
+    // 1. Sort the vertices by cell and number the non-empty cells (i.e., the clusters) in this order.
+    std::vector<uint64_t> cellKeys;
+    computeCellKeys(resolution, cellKeys);
+    std::vector<uint32_t> vertexOrder(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+        vertexOrder[i] = uint32_t(i);
+    }
+    std::sort(vertexOrder.begin(), vertexOrder.end(), [&cellKeys](uint32_t a, uint32_t b) {
+        return cellKeys[a] < cellKeys[b] || (cellKeys[a] == cellKeys[b] && a < b);
+    });
+
+    std::vector<uint32_t> clusterOffsets;
+    std::vector<uint32_t> vertexClusters(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+        if (i == 0 || cellKeys[vertexOrder[i]] != cellKeys[vertexOrder[i-1]]) {
+            clusterOffsets.push_back(uint32_t(i));
+        }
+        vertexClusters[vertexOrder[i]] = uint32_t(clusterOffsets.size() - 1);
+    }
+    const size_t numClusters = clusterOffsets.size();
+    clusterOffsets.push_back(uint32_t(numVertices));
+
+    // 2. Map the triangles to the clusters. Remove triangles that collapsed and duplicates (keeping the first one).
+    std::vector<ClusterTriangle> clusterTriangles;
+    for (size_t t = 0; t < numTriangles; t++) {
+        uint32_t c0 = vertexClusters[indices[t*3]], c1 = vertexClusters[indices[t*3+1]];
+        uint32_t c2 = vertexClusters[indices[t*3+2]];
+        if (c0 == c1 || c1 == c2 || c0 == c2) {
+            continue;
+        }
+        ClusterTriangle clusterTriangle;
+        clusterTriangle.sortedIndices[0] = std::min(c0, std::min(c1, c2));
+        clusterTriangle.sortedIndices[2] = std::max(c0, std::max(c1, c2));
+        clusterTriangle.sortedIndices[1] = c0 ^ c1 ^ c2 ^ clusterTriangle.sortedIndices[0]
+                ^ clusterTriangle.sortedIndices[2];
+        clusterTriangle.triangleIndex = uint32_t(t);
+        clusterTriangles.push_back(clusterTriangle);
+    }
+    std::sort(clusterTriangles.begin(), clusterTriangles.end());
+    std::vector<uint32_t> keptTriangles;
+    keptTriangles.reserve(clusterTriangles.size());
+    for (size_t i = 0; i < clusterTriangles.size(); i++) {
+        if (i == 0 || memcmp(clusterTriangles[i].sortedIndices, clusterTriangles[i-1].sortedIndices,
+                sizeof(uint32_t) * 3) != 0) {
+            keptTriangles.push_back(clusterTriangles[i].triangleIndex);
+        }
+    }
+    clusterTriangles.clear(); clusterTriangles.shrink_to_fit();
+    std::sort(keptTriangles.begin(), keptTriangles.end());
+
+    // 3. Only keep the clusters referenced by the remaining triangles.
+    std::vector<uint32_t> clusterRemap(numClusters, 0);
+    for (size_t i = 0; i < keptTriangles.size(); i++) {
+        uint32_t t = keptTriangles[i];
+        for (int j = 0; j < 3; j++) {
+            clusterRemap[vertexClusters[indices[t*3+j]]] = 1;
+        }
+    }
+    std::vector<uint32_t> usedClusters;
+    for (size_t c = 0; c < numClusters; c++) {
+        if (clusterRemap[c]) {
+            clusterRemap[c] = uint32_t(usedClusters.size());
+            usedClusters.push_back(uint32_t(c));
+        }
+    }
+    const size_t numNewVertices = usedClusters.size();
+
+    simplifiedSubmesh.material = submesh.material;
+    simplifiedSubmesh.vertexMode = submesh.vertexMode;
+    simplifiedSubmesh.uniforms = submesh.uniforms;
+    simplifiedSubmesh.indices.resize(keptTriangles.size() * 3);
+    #pragma omp parallel for
+    for (size_t i = 0; i < keptTriangles.size(); i++) {
+        uint32_t t = keptTriangles[i];
+        for (int j = 0; j < 3; j++) {
+            simplifiedSubmesh.indices[i*3+j] = clusterRemap[vertexClusters[indices[t*3+j]]];
+        }
+    }
+
+    // 4. Compute the position minimizing the quadric error of each cluster, and average the other attributes.
+    simplifiedSubmesh.attributes.clear();
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        size_t numComponents = attribute.numComponents;
+        size_t formatNumBytes = getFormatNumBytes(attribute.attributeFormat);
+        if (attribute.data.size() != numVertices * numComponents * formatNumBytes || numComponents == 0) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in VertexClusteringSimplifier::simplify: Attribute \""
+                    + attribute.name + "\" is not a per-vertex attribute and is dropped.");
+            continue;
+        }
+
+        simplifiedSubmesh.attributes.push_back(BinaryMeshAttribute());
+        BinaryMeshAttribute &newAttribute = simplifiedSubmesh.attributes.back();
+        newAttribute.name = attribute.name;
+        newAttribute.attributeFormat = attribute.attributeFormat;
+        newAttribute.numComponents = attribute.numComponents;
+        newAttribute.data.resize(numNewVertices * numComponents * formatNumBytes);
+        if (numNewVertices == 0) {
+            continue;
+        }
+
+        bool isPosition = attribute.name == "vertexPosition";
+        bool isNormal = attribute.name == "vertexNormal" && numComponents == 3;
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t newIndex = 0; newIndex < numNewVertices; newIndex++) {
+            uint32_t cluster = usedClusters[newIndex];
+            uint32_t clusterBegin = clusterOffsets[cluster], clusterEnd = clusterOffsets[cluster+1];
+            double invNumVertices = 1.0 / double(clusterEnd - clusterBegin);
+
+            if (isPosition) {
+                double quadric[10] = { 0.0 };
+                glm::dvec3 meanPosition(0.0);
+                for (uint32_t i = clusterBegin; i < clusterEnd; i++) {
+                    uint32_t vertexIndex = vertexOrder[i];
+                    meanPosition += glm::dvec3(vertices[vertexIndex]);
+                    uint32_t numAdjacentTriangles = adjacency.getNumTriangles(vertexIndex);
+                    const uint32_t *adjacentTriangles = adjacency.getTriangles(vertexIndex);
+                    for (uint32_t j = 0; j < numAdjacentTriangles; j++) {
+                        size_t t = adjacentTriangles[j];
+                        addTriangleQuadric(
+                                vertices[indices[t*3]], vertices[indices[t*3+1]], vertices[indices[t*3+2]], quadric);
+                    }
+                }
+                meanPosition *= invNumVertices;
+
+                // Keep the representative within its cell to bound the geometric error.
+                glm::vec3 cellMin = minVec + glm::vec3(unpackCell(cellKeys[vertexOrder[clusterBegin]])) * cellSize;
+                glm::vec3 position = glm::clamp(
+                        solveQuadric(quadric, meanPosition), cellMin, cellMin + glm::vec3(cellSize));
+                for (size_t k = 0; k < 3; k++) {
+                    setComponent(newAttribute, newIndex * 3 + k, position[int(k)]);
+                }
+                continue;
+            }
+
+            double sums[16] = { 0.0 };
+            size_t numSummedComponents = std::min(numComponents, size_t(16));
+            for (uint32_t i = clusterBegin; i < clusterEnd; i++) {
+                size_t vertexIndex = vertexOrder[i];
+                for (size_t k = 0; k < numSummedComponents; k++) {
+                    sums[k] += getComponent(attribute, vertexIndex * numComponents + k);
+                }
+            }
+            double normalization = invNumVertices;
+            if (isNormal) {
+                double length = std::sqrt(sums[0]*sums[0] + sums[1]*sums[1] + sums[2]*sums[2]);
+                normalization = length > 0.0 ? 1.0 / length : 0.0;
+            }
+            for (size_t k = 0; k < numComponents; k++) {
+                double value = k < numSummedComponents ? sums[k] * normalization
+                        : getComponent(attribute, vertexOrder[clusterBegin] * numComponents + k);
+                setComponent(newAttribute, newIndex * numComponents + k, value);
+            }
+        }
+    }
+
+    return std::sqrt(3.0f) * cellSize;
+}
+
+static const BinaryMeshAttribute *findPositionAttribute(const BinarySubMesh &submesh)
+{
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        if (attribute.name == "vertexPosition" && attribute.attributeFormat == sgl::ATTRIB_FLOAT
+                && attribute.numComponents == 3) {
+            return &attribute;
+        }
+    }
+    return NULL;
+}
+
+void addTriangleMeshLods(BinaryMesh &mesh, const std::vector<float> &triangleRatios)
+{
+    std::vector<float> sortedRatios = triangleRatios;
+    std::sort(sortedRatios.begin(), sortedRatios.end(), [](float a, float b) { return a > b; });
+
+    // The simplified versions of each original submesh per level. Levels that don't reduce the number of triangles
+    // of a submesh stay empty for it.
+    const size_t numOriginalSubmeshes = mesh.submeshes.size();
+    std::vector<std::vector<BinarySubMesh>> simplifiedSubmeshes(
+            numOriginalSubmeshes, std::vector<BinarySubMesh>(sortedRatios.size()));
+    std::vector<bool> isLevelUsed(sortedRatios.size(), false);
+    std::vector<bool> hasLods(numOriginalSubmeshes, false);
+    for (size_t submeshIdx = 0; submeshIdx < numOriginalSubmeshes; submeshIdx++) {
+        BinarySubMesh &submesh = mesh.submeshes.at(submeshIdx);
+        const BinaryMeshAttribute *positionAttribute = findPositionAttribute(submesh);
+        if (submesh.vertexMode != sgl::VERTEX_MODE_TRIANGLES || submesh.indices.size() < 3 || !positionAttribute) {
+            // Part of every level.
+            continue;
+        }
+        hasLods.at(submeshIdx) = true;
+        setSubmeshLod(submesh, 0, 0.0f);
+
+        VertexClusteringSimplifier simplifier(submesh, *positionAttribute);
+        size_t numTrianglesLastLevel = simplifier.getNumTriangles();
+        uint32_t lastResolution = MAX_CLUSTERING_RESOLUTION;
+        for (size_t level = 0; level < sortedRatios.size(); level++) {
+            size_t targetNumTriangles = std::max(
+                    size_t(1), size_t(sortedRatios.at(level) * simplifier.getNumTriangles()));
+            uint32_t resolution = std::min(simplifier.findResolution(targetNumTriangles), lastResolution - 1);
+            if (resolution == 0) {
+                break;
+            }
+            BinarySubMesh simplifiedSubmesh;
+            float geometricError = simplifier.simplify(resolution, simplifiedSubmesh);
+            size_t numTriangles = simplifiedSubmesh.indices.size() / 3;
+            if (numTriangles == 0 || numTriangles >= numTrianglesLastLevel) {
+                continue;
+            }
+            sgl::Logfile::get()->writeInfo(std::string() + "LOD " + sgl::toString(level + 1) + ": "
+                    + sgl::toString(numTriangles) + " triangles (grid resolution "
+                    + sgl::toString(resolution) + ", geometric error " + sgl::toString(geometricError) + ")");
+            numTrianglesLastLevel = numTriangles;
+            lastResolution = resolution;
+            setSubmeshLod(simplifiedSubmesh, 0, geometricError);
+            simplifiedSubmeshes.at(submeshIdx).at(level) = std::move(simplifiedSubmesh);
+            isLevelUsed.at(level) = true;
+        }
+    }
+
+    // Number the levels consecutively, skipping levels without any simplified submeshes. The simplified submeshes
+    // are appended after all original submeshes, ordered by level. As only the submeshes of the current level are
+    // rendered, a submesh that wasn't simplified further for a level uses its previous level (or the original) there.
+    uint32_t lodLevel = 1;
+    std::vector<const BinarySubMesh*> previousLevels(numOriginalSubmeshes, NULL);
+    for (size_t level = 0; level < sortedRatios.size(); level++) {
+        if (!isLevelUsed.at(level)) {
+            continue;
+        }
+        for (size_t submeshIdx = 0; submeshIdx < numOriginalSubmeshes; submeshIdx++) {
+            if (!hasLods.at(submeshIdx)) {
+                continue;
+            }
+            BinarySubMesh &simplifiedSubmesh = simplifiedSubmeshes.at(submeshIdx).at(level);
+            if (!simplifiedSubmesh.indices.empty()) {
+                previousLevels.at(submeshIdx) = &simplifiedSubmesh;
+            }
+            BinarySubMesh lodSubmesh = previousLevels.at(submeshIdx) ? *previousLevels.at(submeshIdx)
+                    : mesh.submeshes.at(submeshIdx);
+            uint32_t unusedLevel;
+            float geometricError;
+            getSubmeshLod(lodSubmesh, unusedLevel, geometricError);
+            setSubmeshLod(lodSubmesh, lodLevel, geometricError);
+            mesh.submeshes.push_back(std::move(lodSubmesh));
+        }
+        lodLevel++;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_MESHSIMPLIFICATION_HPP
+#define PIXELSYNCOIT_MESHSIMPLIFICATION_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "MeshSerializer.hpp"
+
+/**
+ * Levels of detail (LODs) of triangle meshes are stored as additional submeshes in the binmesh file. A submesh
+ * belonging to a LOD has the uniforms "lodLevel" (unsigned int, 0 is the original mesh) and "lodError" (float,
+ * the maximum distance a vertex of the original mesh was moved in object space). Submeshes without these uniforms
+ * are part of every level.
+ */
+const char *const LOD_LEVEL_UNIFORM_NAME = "lodLevel";
+const char *const LOD_ERROR_UNIFORM_NAME = "lodError";
+
+/// Sets the LOD uniforms of the submesh.
+void setSubmeshLod(BinarySubMesh &submesh, uint32_t lodLevel, float lodError);
+
+/// @return False if the submesh has no LOD uniforms.
+bool getSubmeshLod(const BinarySubMesh &submesh, uint32_t &lodLevel, float &lodError);
+
+/**
+ * Appends a simplified version of each triangle submesh for every entry of triangleRatios (in descending order)
+ * and sets the LOD uniforms of the original and simplified submeshes. Levels that don't reduce the number of
+ * triangles of any submesh are skipped. A submesh not reduced further at a kept level reuses its previous level.
+ * The submeshes are simplified using quadric-based vertex clustering (Lindstrom, "Out-of-Core Simplification of Large
+ * Polygonal Models", 2000). The bounding box is divided into a uniform grid, and the vertices of each cell are merged
+ * into the point minimizing the sum of the quadric error metrics of their adjacent triangles (clamped to the cell).
+ * The grid resolution is chosen such that approximately the passed ratio of the triangles remains.
+ * All steps except for sorting the vertices into the cells are parallelized, and the result is deterministic.
+ * All other per-vertex attributes are averaged over the merged vertices, and "vertexNormal" is renormalized.
+ * Only submeshes in triangle mode with indices and a float vec3 "vertexPosition" attribute are simplified.
+ */
+void addTriangleMeshLods(BinaryMesh &mesh, const std::vector<float> &triangleRatios);
+
+#endif //PIXELSYNCOIT_MESHSIMPLIFICATION_HPP
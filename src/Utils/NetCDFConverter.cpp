@@ -8,6 +8,12 @@
 #include <fstream>
 #include <iomanip>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
 
 #include <glm/glm.hpp>
 #include <netcdf.h>
@@ -211,54 +217,184 @@ void loadFloatArray3D(int ncid, const char *varname, size_t zstart, size_t ystar
 
 
 
-Trajectories convertLatLonToCartesian(float *lat, float *lon, float *pressure, size_t trajectoryDim,
-        size_t timeDim) {
-    Trajectories trajectories;
-    trajectories.reserve(timeDim);
+/// The number of float values of lon, lat and pressure per chunk (i.e., 3 * 4 MiB = 12 MiB per chunk buffer).
+const size_t NETCDF_CHUNK_NUM_VALUES = 1024 * 1024;
 
-    float minPressure = FLT_MAX;
-    float maxPressure = -FLT_MAX;
-    //float minPressure = 1200.0f;
-    //float maxPressure = 0.0001f;
-	#pragma omp parallel for reduction(min:minPressure) reduction(max:maxPressure)
-	for (size_t idx = 0; idx < trajectoryDim*timeDim; idx++) {
-	    if (pressure[idx] > 0.0f) {
-            minPressure = std::min(minPressure, pressure[idx]);
-	    }
-		maxPressure = std::max(maxPressure, pressure[idx]);
-	}
-	float logMinPressure = log(minPressure);
-	float logMaxPressure = log(maxPressure);
+/**
+ * A hyperslab of lon, lat and pressure values of a consecutive block of trajectories.
+ */
+struct TrajectoryChunk
+{
+    TrajectoryChunk() : trajectoryStart(0), numTrajectories(0) {}
+    size_t trajectoryStart;
+    size_t numTrajectories;
+    std::vector<float> lon, lat, pressure;
+};
+
+/**
+ * The part of a NetCDF trajectory file to load, i.e., one ensemble member and a window of time steps.
+ */
+struct NetCdfHyperslab
+{
+    int lonVarid, latVarid, pressureVarid;
+    size_t ensembleMember;
+    size_t timeStart;
+    size_t timeCount;
+};
+
+/**
+ * Reads the lon, lat and pressure values of the trajectories [trajectoryStart, trajectoryStart + numTrajectories).
+ * The buffers of the chunk are reused if they are already large enough.
+ */
+void readTrajectoryChunk(int ncid, const NetCdfHyperslab &hyperslab, size_t trajectoryStart,
+        size_t numTrajectories, TrajectoryChunk &chunk)
+{
+    const size_t timeDim = hyperslab.timeCount;
+    chunk.trajectoryStart = trajectoryStart;
+    chunk.numTrajectories = numTrajectories;
+    chunk.lon.resize(numTrajectories * timeDim);
+    chunk.lat.resize(numTrajectories * timeDim);
+    chunk.pressure.resize(numTrajectories * timeDim);
+
+    size_t startp[] = {hyperslab.ensembleMember, trajectoryStart, hyperslab.timeStart};
+    size_t countp[] = {1, numTrajectories, timeDim};
+    myassert(nc_get_vara_float(ncid, hyperslab.lonVarid, startp, countp, &chunk.lon.front()) == 0);
+    myassert(nc_get_vara_float(ncid, hyperslab.latVarid, startp, countp, &chunk.lat.front()) == 0);
+    myassert(nc_get_vara_float(ncid, hyperslab.pressureVarid, startp, countp, &chunk.pressure.front()) == 0);
+}
 
-    for (int trajectoryIndex = 0; trajectoryIndex < trajectoryDim; trajectoryIndex++) {
-        Trajectory trajectory;
+/**
+ * Converts the trajectories of a chunk in parallel. The y coordinate is set by @ref normalizeTrajectoryPressure once
+ * the pressure range of the whole file is known.
+ * @param chunk The chunk to convert.
+ * @param timeDim The number of time steps per trajectory.
+ * @param trajectories The trajectories of the chunk (without points) are stored at the indices
+ * [chunk.trajectoryStart, chunk.trajectoryStart + chunk.numTrajectories) of this array.
+ * @param minPressure The minimum positive pressure value of the chunk is combined with this value.
+ * @param maxPressure The maximum pressure value of the chunk is combined with this value.
+ */
+void convertTrajectoryChunk(const TrajectoryChunk &chunk, size_t timeDim, Trajectories &trajectories,
+        float &minPressure, float &maxPressure)
+{
+    const float *lat = &chunk.lat.front();
+    const float *lon = &chunk.lon.front();
+    const float *pressure = &chunk.pressure.front();
+
+    #pragma omp parallel for reduction(min:minPressure) reduction(max:maxPressure) schedule(dynamic, 64)
+    for (size_t chunkTrajectoryIndex = 0; chunkTrajectoryIndex < chunk.numTrajectories; chunkTrajectoryIndex++) {
+        size_t offset = chunkTrajectoryIndex*timeDim;
+
+        // Count the valid points first to allocate the output arrays with their exact size.
+        size_t numValidPoints = 0;
+        for (size_t i = 0; i < timeDim; i++) {
+            float pressureAtIdx = pressure[offset + i];
+            if (pressureAtIdx > 0.0f) {
+                minPressure = std::min(minPressure, pressureAtIdx);
+                numValidPoints++;
+            }
+            maxPressure = std::max(maxPressure, pressureAtIdx);
+        }
+
+        Trajectory &trajectory = trajectories.at(chunk.trajectoryStart + chunkTrajectoryIndex);
         trajectory.attributes.resize(1);
         std::vector<glm::vec3> &cartesianCoords = trajectory.positions;
         std::vector<float> &pressureAttr = trajectory.attributes.at(0);
-        cartesianCoords.reserve(trajectoryDim);
-        pressureAttr.reserve(trajectoryDim);
-        for (int i = 0; i < timeDim; i++) {
-            int index = i + trajectoryIndex*timeDim;
+        cartesianCoords.resize(numValidPoints);
+        pressureAttr.resize(numValidPoints);
+
+        size_t pointIndex = 0;
+        for (size_t i = 0; i < timeDim; i++) {
+            size_t index = offset + i;
             float pressureAtIdx = pressure[index];
             if (pressureAtIdx <= 0.0f) {
                 continue;
             }
-            //float normalizedPressure = (pressureAtIdx - minPressure) / (maxPressure - minPressure);
-            float normalizedLogPressure = (log(pressureAtIdx) - logMaxPressure) / (logMinPressure - logMaxPressure);
-            float x = lat[index]/100.0f;
-            float y = normalizedLogPressure;
-            float z = lon[index]/100.0f;
+            cartesianCoords.at(pointIndex) = glm::vec3(lat[index]/100.0f, 0.0f, lon[index]/100.0f);
+            pressureAttr.at(pointIndex) = pressureAtIdx;
+            pointIndex++;
+        }
+    }
+}
 
-            glm::vec3 cartesianCoord = glm::vec3(x, y, z);
+/**
+ * Sets the y coordinate of all points to the logarithmic pressure normalized to the range of the whole file.
+ */
+void normalizeTrajectoryPressure(Trajectories &trajectories, float minPressure, float maxPressure)
+{
+    float logMinPressure = log(minPressure);
+    float logMaxPressure = log(maxPressure);
 
-            cartesianCoords.push_back(cartesianCoord);
-            pressureAttr.push_back(pressureAtIdx);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t trajectoryIndex = 0; trajectoryIndex < trajectories.size(); trajectoryIndex++) {
+        Trajectory &trajectory = trajectories.at(trajectoryIndex);
+        std::vector<glm::vec3> &cartesianCoords = trajectory.positions;
+        const std::vector<float> &pressureAttr = trajectory.attributes.at(0);
+        for (size_t i = 0; i < cartesianCoords.size(); i++) {
+            //float normalizedPressure = (pressureAttr.at(i) - minPressure) / (maxPressure - minPressure);
+            float normalizedLogPressure = (log(pressureAttr.at(i)) - logMaxPressure)
+                    / (logMinPressure - logMaxPressure);
+            cartesianCoords.at(i).y = normalizedLogPressure;
         }
+    }
+}
 
-        if (!trajectory.positions.empty()) {
-            trajectories.push_back(trajectory);
+/**
+ * Loads the lon, lat and pressure data of all trajectories in chunks of consecutive trajectories and converts them to
+ * cartesian coordinates. While a chunk is converted in parallel, the next chunk is already read by a separate thread.
+ * Thus, at most two chunks are held in memory at the same time.
+ */
+Trajectories loadTrajectoriesChunked(int ncid, size_t trajectoryDim, size_t ensembleMember, size_t timeStart,
+        size_t timeDim)
+{
+    NetCdfHyperslab hyperslab;
+    myassert(nc_inq_varid(ncid, "lon", &hyperslab.lonVarid) == 0);
+    myassert(nc_inq_varid(ncid, "lat", &hyperslab.latVarid) == 0);
+    myassert(nc_inq_varid(ncid, "pressure", &hyperslab.pressureVarid) == 0);
+    hyperslab.ensembleMember = ensembleMember;
+    hyperslab.timeStart = timeStart;
+    hyperslab.timeCount = timeDim;
+
+    Trajectories trajectories;
+    if (trajectoryDim == 0 || timeDim == 0) {
+        return trajectories;
+    }
+    trajectories.resize(trajectoryDim);
+
+    size_t chunkSize = std::max(NETCDF_CHUNK_NUM_VALUES / timeDim, size_t(1));
+    TrajectoryChunk chunks[2];
+    readTrajectoryChunk(ncid, hyperslab, 0, std::min(chunkSize, trajectoryDim), chunks[0]);
+
+    float minPressure = FLT_MAX;
+    float maxPressure = -FLT_MAX;
+    //float minPressure = 1200.0f;
+    //float maxPressure = 0.0001f;
+    for (size_t chunkIndex = 0; chunkIndex * chunkSize < trajectoryDim; chunkIndex++) {
+        TrajectoryChunk &currentChunk = chunks[chunkIndex % 2];
+        TrajectoryChunk &nextChunk = chunks[(chunkIndex + 1) % 2];
+
+        // NetCDF calls are not thread-safe, so only this reader thread accesses the file while converting.
+        size_t nextChunkStart = (chunkIndex + 1) * chunkSize;
+        std::thread readerThread;
+        if (nextChunkStart < trajectoryDim) {
+            size_t nextChunkSize = std::min(chunkSize, trajectoryDim - nextChunkStart);
+            readerThread = std::thread(
+                    readTrajectoryChunk, ncid, std::cref(hyperslab), nextChunkStart, nextChunkSize,
+                    std::ref(nextChunk));
+        }
+
+        convertTrajectoryChunk(currentChunk, timeDim, trajectories, minPressure, maxPressure);
+
+        if (readerThread.joinable()) {
+            readerThread.join();
         }
     }
+
+    // Remove the trajectories without valid points.
+    trajectories.erase(std::remove_if(trajectories.begin(), trajectories.end(), [](const Trajectory &trajectory) {
+        return trajectory.positions.empty();
+    }), trajectories.end());
+
+    normalizeTrajectoryPressure(trajectories, minPressure, maxPressure);
     return trajectories;
 }
 
@@ -309,8 +445,28 @@ void exportObjFile(Trajectories &trajectories, const std::string &filename)
     outfile.close();
 }
 
-Trajectories loadNetCdfFile(const std::string &filename)
+/// The NetCDF library is not thread-safe, so only one file is loaded at a time.
+static std::mutex netCdfMutex;
+
+size_t getNetCdfNumEnsembleMembers(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(netCdfMutex);
+
+    int ncid;
+    int status = nc_open(filename.c_str(), NC_NOWRITE, &ncid);
+    if (status != 0) {
+        std::cerr << "ERROR in getNetCdfNumEnsembleMembers: File \"" << filename << "\" couldn't be opened!"
+                << std::endl;
+        return 0;
+    }
+    size_t ensembleDim = getDim(ncid, "ensemble");
+    myassert(nc_close(ncid) == NC_NOERR);
+    return ensembleDim;
+}
+
+Trajectories loadNetCdfFile(const std::string &filename, size_t ensembleMember, size_t timeStart, size_t timeCount)
 {
+    std::lock_guard<std::mutex> lock(netCdfMutex);
     Trajectories trajectories;
 
     // File handle
@@ -333,17 +489,20 @@ Trajectories loadNetCdfFile(const std::string &filename)
 
     // Load data arrays
     double *time = NULL;
-    float *lon = NULL, *lat = NULL, *pressure = NULL, *startLon = NULL, *startLat = NULL, *timeInterval = NULL;
+    float *startLon = NULL, *startLat = NULL, *timeInterval = NULL;
     loadDoubleArray1D(ncid, "time", timeDim, &time);
-    loadFloatArray3D(ncid, "lon", 1, trajectoryDim, timeDim, &lon);
-    loadFloatArray3D(ncid, "lat", 1, trajectoryDim, timeDim, &lat);
-    loadFloatArray3D(ncid, "pressure", 1, trajectoryDim, timeDim, &pressure);
     loadFloatArray1D(ncid, "start_lon", startLonDim, &startLon);
     loadFloatArray1D(ncid, "start_lat", startLatDim, &startLat);
     loadFloatArray1D(ncid, "time_interval", timeIntervalDim, &timeInterval);
 
-
-    trajectories = convertLatLonToCartesian(lat, lon, pressure, trajectoryDim, timeDim);
+    if (ensembleMember >= ensembleDim || timeStart >= timeDim) {
+        std::cerr << "ERROR in loadNetCdfFile: Ensemble member " << ensembleMember << " or time step " << timeStart
+                << " out of range in file \"" << filename << "\"!" << std::endl;
+    } else {
+        // The lon, lat and pressure arrays are streamed in chunks of trajectories.
+        size_t timeWindowSize = timeCount == 0 ? timeDim - timeStart : std::min(timeCount, timeDim - timeStart);
+        trajectories = loadTrajectoriesChunked(ncid, trajectoryDim, ensembleMember, timeStart, timeWindowSize);
+    }
     std::string outputFilename = filename.substr(0, filename.find_last_of(".")) + ".obj";
     //exportObjFile(trajectories, outputFilename);
 
@@ -352,9 +511,6 @@ Trajectories loadNetCdfFile(const std::string &filename)
     myassert(nc_close(ncid) == NC_NOERR);
 
     SAFE_DELETE_ARRAY(time);
-    SAFE_DELETE_ARRAY(lon);
-    SAFE_DELETE_ARRAY(lat);
-    SAFE_DELETE_ARRAY(pressure);
     SAFE_DELETE_ARRAY(startLon);
     SAFE_DELETE_ARRAY(startLat);
     SAFE_DELETE_ARRAY(timeInterval);
@@ -8,6 +8,19 @@
 #include <string>
 #include "TrajectoryFile.hpp"
 
-Trajectories loadNetCdfFile(const std::string &filename);
+/**
+ * Loads the trajectories of one ensemble member of a WCB NetCDF file.
+ * @param filename The name of the NetCDF file.
+ * @param ensembleMember The index of the ensemble member to load.
+ * @param timeStart The first time step to load.
+ * @param timeCount The number of time steps to load (0 means all time steps starting at timeStart).
+ */
+Trajectories loadNetCdfFile(const std::string &filename, size_t ensembleMember = 0, size_t timeStart = 0,
+        size_t timeCount = 0);
+
+/**
+ * @return The size of the ensemble dimension of a WCB NetCDF file (or 0 if the file couldn't be opened).
+ */
+size_t getNetCdfNumEnsembleMembers(const std::string &filename);
 
 #endif //NETCDFIMPORTER_NETCDFCONVERTER_HPP
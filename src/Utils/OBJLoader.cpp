@@ -6,12 +6,11 @@
  */
 
 #include <algorithm>
-#include <iostream>
-#include <fstream>
 #include <vector>
 #include <string>
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/split.hpp>
+#include <unordered_map>
+#include <cstring>
+#include <cstdlib>
 #include <glm/glm.hpp>
 
 #include <Utils/File/Logfile.hpp>
@@ -22,7 +21,9 @@
 #include <Graphics/Renderer.hpp>
 
 #include "MeshSerializer.hpp"
-#include "KDTree.hpp"
+#include "MeshAdjacency.hpp"
+#include "VertexWelding.hpp"
+#include "MappedFile.hpp"
 
 using namespace std;
 using namespace sgl;
@@ -79,127 +80,364 @@ struct TempSubmesh
     std::vector<uint32_t> normalIndices;
 };
 
-void globalIndicesToLocal(std::vector<uint32_t> &globalIndexBuffer, std::vector<glm::vec3> &globalVertexBuffer,
-                          std::vector<uint32_t> &localIndexBuffer, std::vector<glm::vec3> &localVertexBuffer)
+/**
+ * A token of a line in an .obj or .mtl file. Tokens point into the file buffer, i.e., no strings are copied.
+ */
+struct ObjToken
+{
+    ObjToken() : begin(NULL), end(NULL) {}
+    ObjToken(const char *begin, const char *end) : begin(begin), end(end) {}
+
+    inline size_t size() const { return end - begin; }
+    inline bool operator==(const char *str) const {
+        size_t length = strlen(str);
+        return size() == length && (length == 0 || memcmp(begin, str, length) == 0);
+    }
+    inline bool startsWith(char c) const { return begin != end && *begin == c; }
+    inline std::string toString() const { return std::string(begin, end); }
+
+    const char *begin;
+    const char *end;
+};
+
+/**
+ * Splits the lines of a text buffer into tokens separated by spaces and tabs. The result is the same as reading the
+ * lines with getline, removing trailing '\r' and ' ' characters and splitting the line with
+ * boost::algorithm::split(..., boost::is_any_of("\t "), boost::token_compress_on). This means that e.g. a line
+ * starting with a space has an empty first token.
+ */
+class ObjLineTokenizer
 {
-    // Create global indices <-> local indices mapping
-    std::vector<uint32_t> sortedIndexBuffer = globalIndexBuffer;
-    std::sort(sortedIndexBuffer.begin(), sortedIndexBuffer.end());
-    std::map<uint32_t, uint32_t> mappingGlobalToLocal;
-    std::map<uint32_t, uint32_t> mappingLocalToGlobal;
-    size_t index = 0;
-    for (size_t i = 0; i < globalIndexBuffer.size(); i++) {
-        if (i == 0 || sortedIndexBuffer.at(i) != sortedIndexBuffer.at(i-1)) {
-            mappingGlobalToLocal.insert(make_pair(sortedIndexBuffer.at(i), index));
-            mappingLocalToGlobal.insert(make_pair(index, sortedIndexBuffer.at(i)));
-            index++;
+public:
+    ObjLineTokenizer(const char *bufferBegin, const char *bufferEnd) : current(bufferBegin), bufferEnd(bufferEnd) {}
+
+    /// Tokenizes the next line. @return False if the end of the buffer was reached.
+    bool nextLine() {
+        if (current == bufferEnd) {
+            return false;
+        }
+
+        const char *lineBegin = current;
+        const char *lineEnd = static_cast<const char*>(memchr(current, '\n', bufferEnd - current));
+        if (lineEnd == NULL) {
+            lineEnd = bufferEnd;
+            current = bufferEnd;
+        } else {
+            current = lineEnd + 1;
+        }
+        // Remove '\r' of Windows line ending
+        while (lineEnd != lineBegin && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ')) {
+            lineEnd--;
+        }
+
+        tokens.clear();
+        const char *tokenBegin = lineBegin;
+        while (true) {
+            const char *tokenEnd = tokenBegin;
+            while (tokenEnd != lineEnd && *tokenEnd != ' ' && *tokenEnd != '\t') {
+                tokenEnd++;
+            }
+            tokens.push_back(ObjToken(tokenBegin, tokenEnd));
+            if (tokenEnd == lineEnd) {
+                break;
+            }
+            while (tokenEnd != lineEnd && (*tokenEnd == ' ' || *tokenEnd == '\t')) {
+                tokenEnd++;
+            }
+            tokenBegin = tokenEnd;
         }
+        return true;
+    }
+
+    inline size_t getNumTokens() const { return tokens.size(); }
+    /// Returns an empty token if the line has less than i+1 tokens.
+    inline const ObjToken &getToken(size_t i) const { return i < tokens.size() ? tokens[i] : emptyToken; }
+
+private:
+    const char *current;
+    const char *bufferEnd;
+    std::vector<ObjToken> tokens;
+    ObjToken emptyToken;
+};
+
+// Same result as fromString<float>, but without creating a string stream.
+static float parseFloat(const ObjToken &token)
+{
+    // The token is not null-terminated, so copy it for strtof.
+    char buffer[64];
+    if (token.size() >= sizeof(buffer)) {
+        return strtof(token.toString().c_str(), NULL);
     }
+    memcpy(buffer, token.begin, token.size());
+    buffer[token.size()] = '\0';
+    return strtof(buffer, NULL);
+}
 
-    localVertexBuffer.resize(index);
-    for (size_t i = 0; i < index; i++) {
-        localVertexBuffer.at(i) = globalVertexBuffer.at(mappingLocalToGlobal[i]);
+// Same result as atoi for the characters in [begin, end).
+static int parseInt(const char *begin, const char *end)
+{
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+')) {
+        negative = *begin == '-';
+        begin++;
     }
-    localIndexBuffer.resize(globalIndexBuffer.size());
-    for (size_t i = 0; i < globalIndexBuffer.size(); i++) {
-        localIndexBuffer.at(i) = mappingGlobalToLocal[globalIndexBuffer.at(i)];
+    int64_t value = 0;
+    for (; begin != end && *begin >= '0' && *begin <= '9'; begin++) {
+        value = value * 10 + (*begin - '0');
     }
+    return int(negative ? -value : value);
+}
+
+static inline glm::vec3 parseVec3(const ObjLineTokenizer &tokenizer)
+{
+    return glm::vec3(parseFloat(tokenizer.getToken(1)), parseFloat(tokenizer.getToken(2)),
+            parseFloat(tokenizer.getToken(3)));
 }
 
-void processTempSubmesh(ObjMesh &mesh, TempSubmesh &tempSubmesh, std::vector<glm::vec3> &globalVertices,
-        std::vector<glm::vec2> &globalTexcoords, std::vector<glm::vec3> &globalNormals)
+/**
+ * Hash map from global to local vertex indices using open addressing with linear probing.
+ * The capacity is fixed on construction to twice the maximum number of keys.
+ */
+class FlatIndexMap
 {
-    // Input
-    bool smooth = tempSubmesh.smooth;
-    std::vector<uint32_t> &vertexIndices = tempSubmesh.vertexIndices;
-    std::vector<uint32_t> &tecoordIndices = tempSubmesh.tecoordIndices;
-    std::vector<uint32_t> &normalIndices = tempSubmesh.normalIndices;
-
-    // Output
-    ObjSubmesh submesh;
-    std::vector<uint32_t> &indices = submesh.indices;
-    std::vector<glm::vec3> &vertices = submesh.vertices;
-    std::vector<glm::vec2> &texcoords = submesh.texcoords;
-    std::vector<glm::vec3> &normals = submesh.normals;
-    submesh.material = tempSubmesh.material;
-
-
-    if (!smooth) {
+public:
+    explicit FlatIndexMap(size_t maxNumKeys) {
+        size_t capacity = 16;
+        shift = 60;
+        while (capacity < maxNumKeys * 2) {
+            capacity *= 2;
+            shift--;
+        }
+        entries.resize(capacity, Entry(EMPTY_KEY, 0));
+        mask = capacity - 1;
+    }
+
+    /// @return True if the key was not in the map yet.
+    inline bool insert(uint32_t key) {
+        size_t slot = findSlot(key);
+        if (entries[slot].key == key) {
+            return false;
+        }
+        entries[slot].key = key;
+        return true;
+    }
+    /// The key needs to be in the map already.
+    inline void set(uint32_t key, uint32_t value) { entries[findSlot(key)].value = value; }
+    inline uint32_t get(uint32_t key) const { return entries[findSlot(key)].value; }
+
+private:
+    static const uint32_t EMPTY_KEY = 0xFFFFFFFFu;
+    struct Entry {
+        Entry(uint32_t key, uint32_t value) : key(key), value(value) {}
+        uint32_t key;
+        uint32_t value;
+    };
+
+    // Fibonacci hashing, then linear probing. Returns the slot of the key or the empty slot it belongs into.
+    inline size_t findSlot(uint32_t key) const {
+        size_t slot = size_t((uint64_t(key) * 11400714819323198485ull) >> shift);
+        while (entries[slot].key != key && entries[slot].key != EMPTY_KEY) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    std::vector<Entry> entries;
+    size_t mask;
+    int shift;
+};
+
+static inline bool indicesInRange(const std::vector<uint32_t> &indices, size_t numElements)
+{
+    return indices.empty() || *std::max_element(indices.begin(), indices.end()) < numElements;
+}
+
+/**
+ * Converts a submesh to a binary submesh with a position and a normal attribute.
+ * - Flat shaded submeshes get one vertex per index. The normals are taken from the file or computed per face.
+ * - Smooth shaded submeshes are indexed. The local vertices are sorted by their global index, and the normal of a
+ *   vertex is the average of the normalized normals of all faces referencing it.
+ * @return False if the submesh references vertices or normals that don't exist, or if its faces aren't triangles.
+ */
+static bool processTempSubmesh(const TempSubmesh &tempSubmesh, const std::vector<glm::vec3> &globalVertices,
+        const std::vector<glm::vec3> &globalNormals, BinarySubMesh &binarySubmesh)
+{
+    const std::vector<uint32_t> &vertexIndices = tempSubmesh.vertexIndices;
+    const std::vector<uint32_t> &normalIndices = tempSubmesh.normalIndices;
+    bool useFileNormals = !tempSubmesh.smooth && normalIndices.size() > 0;
+    if (!indicesInRange(vertexIndices, globalVertices.size())
+            || (useFileNormals && (normalIndices.size() < vertexIndices.size()
+                    || !indicesInRange(normalIndices, globalNormals.size())))
+            || (!useFileNormals && vertexIndices.size() % 3 != 0)) {
+        return false;
+    }
+
+    binarySubmesh.material = tempSubmesh.material;
+    binarySubmesh.vertexMode = VERTEX_MODE_TRIANGLES;
+
+    // Local vertex index -> global vertex index.
+    std::vector<uint32_t> localToGlobal;
+    if (tempSubmesh.smooth) {
+        FlatIndexMap globalToLocal(vertexIndices.size());
         for (size_t i = 0; i < vertexIndices.size(); i++) {
-            vertices.push_back(globalVertices.at(vertexIndices.at(i)));
-            //if (tecoordIndices.size() > 0)
-            //  texcoords.push_back(globalTexcoords.at(tecoordIndices.at(i)));
-            if (normalIndices.size() > 0)
-                normals.push_back(globalNormals.at(normalIndices.at(i)));
+            if (globalToLocal.insert(vertexIndices[i])) {
+                localToGlobal.push_back(vertexIndices[i]);
+            }
+        }
+        std::sort(localToGlobal.begin(), localToGlobal.end());
+        for (size_t i = 0; i < localToGlobal.size(); i++) {
+            globalToLocal.set(localToGlobal[i], uint32_t(i));
+        }
+
+        std::vector<uint32_t> &indices = binarySubmesh.indices;
+        indices.resize(vertexIndices.size());
+        #pragma omp parallel for
+        for (size_t i = 0; i < vertexIndices.size(); i++) {
+            indices[i] = globalToLocal.get(vertexIndices[i]);
+        }
+    }
+
+    size_t numVertices = tempSubmesh.smooth ? localToGlobal.size() : vertexIndices.size();
+    if (numVertices == 0) {
+        BinaryMeshAttribute positionAttribute;
+        positionAttribute.name = "vertexPosition";
+        positionAttribute.attributeFormat = ATTRIB_FLOAT;
+        positionAttribute.numComponents = 3;
+        binarySubmesh.attributes.push_back(positionAttribute);
+        return true;
+    }
+
+    binarySubmesh.attributes.resize(2);
+    BinaryMeshAttribute &positionAttribute = binarySubmesh.attributes.at(0);
+    positionAttribute.name = "vertexPosition";
+    positionAttribute.attributeFormat = ATTRIB_FLOAT;
+    positionAttribute.numComponents = 3;
+    positionAttribute.data.resize(numVertices * sizeof(glm::vec3));
+    glm::vec3 *vertices = reinterpret_cast<glm::vec3*>(&positionAttribute.data.front());
+
+    BinaryMeshAttribute &normalAttribute = binarySubmesh.attributes.at(1);
+    normalAttribute.name = "vertexNormal";
+    normalAttribute.attributeFormat = ATTRIB_FLOAT;
+    normalAttribute.numComponents = 3;
+    normalAttribute.data.resize(numVertices * sizeof(glm::vec3));
+    glm::vec3 *normals = reinterpret_cast<glm::vec3*>(&normalAttribute.data.front());
+
+    if (!tempSubmesh.smooth) {
+        #pragma omp parallel for
+        for (size_t i = 0; i < numVertices; i++) {
+            vertices[i] = globalVertices[vertexIndices[i]];
+            if (useFileNormals) {
+                normals[i] = globalNormals[normalIndices[i]];
+            }
         }
 
-        if (normalIndices.size() == 0) {
+        if (!useFileNormals) {
             // Compute manually
-            for (size_t i = 0; i < vertices.size(); i += 3) {
-                glm::vec3 normal = glm::cross(vertices.at(i) - vertices.at(i+1), vertices.at(i) - vertices.at(i+2));
+            #pragma omp parallel for
+            for (size_t i = 0; i < numVertices; i += 3) {
+                glm::vec3 normal = glm::cross(vertices[i] - vertices[i+1], vertices[i] - vertices[i+2]);
                 normal = glm::normalize(normal);
-                normals.push_back(normal);
-                normals.push_back(normal);
-                normals.push_back(normal);
+                normals[i] = normal;
+                normals[i+1] = normal;
+                normals[i+2] = normal;
             }
         }
-    } else {
-        std::vector<uint32_t> &globalIndices = vertexIndices;
-        globalIndicesToLocal(globalIndices, globalVertices, indices, vertices);
+        return true;
+    }
+
+    const std::vector<uint32_t> &indices = binarySubmesh.indices;
+    #pragma omp parallel for
+    for (size_t i = 0; i < numVertices; i++) {
+        vertices[i] = globalVertices[localToGlobal[i]];
+    }
 
+    std::vector<glm::vec3> faceNormals(indices.size() / 3);
+    #pragma omp parallel for
+    for (size_t f = 0; f < faceNormals.size(); f++) {
+        size_t i1 = indices[f*3], i2 = indices[f*3+1], i3 = indices[f*3+2];
+        glm::vec3 faceNormal = glm::cross(vertices[i1] - vertices[i2], vertices[i1] - vertices[i3]);
+        faceNormals[f] = glm::normalize(faceNormal);
+    }
 
-        // For finding all triangles with a specific index. Maps vertex index -> first triangle index.
-        std::multimap<size_t, size_t> indexMap;
-        for (size_t j = 0; j < indices.size(); j++) {
-            indexMap.insert(make_pair(indices.at(j), (j/3)*3));
+    // For finding all triangles with a specific index. The face normals are summed up in ascending triangle order.
+    VertexTriangleAdjacency adjacency;
+    buildVertexTriangleAdjacency(numVertices, indices, adjacency);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numVertices; i++) {
+        glm::vec3 normal(0.0f, 0.0f, 0.0f);
+        uint32_t numTrianglesSharedBy = adjacency.getNumTriangles(i);
+        const uint32_t *triangles = adjacency.getTriangles(i);
+        for (uint32_t j = 0; j < numTrianglesSharedBy; j++) {
+            normal += faceNormals[triangles[j]];
         }
+        normal /= (float)numTrianglesSharedBy;
+        normals[i] = normal;
+    }
 
-        for (size_t i = 0; i < vertices.size(); i++) {
-            glm::vec3 normal(0.0f, 0.0f, 0.0f);
-            int numTrianglesSharedBy = 0;
-            auto triangleRange = indexMap.equal_range(i);
-            for (auto it = triangleRange.first; it != triangleRange.second; it++) {
-                size_t j = it->second;
-                size_t i1 = indices.at(j), i2 = indices.at(j+1), i3 = indices.at(j+2);
-                glm::vec3 faceNormal = glm::cross(vertices.at(i1) - vertices.at(i2), vertices.at(i1) - vertices.at(i3));
-                faceNormal = glm::normalize(faceNormal);
-                normal += faceNormal;
-                numTrianglesSharedBy++;
-            }
-            /*for (size_t j = 0; j < indices.size(); j += 3) {
-                // Does this triangle contain vertex #i?
-                if (indices.at(j) == i || indices.at(j+1) == i || indices.at(j+2) == i) {
-                    size_t i1 = indices.at(j), i2 = indices.at(j+1), i3 = indices.at(j+2);
-                    glm::vec3 faceNormal = glm::cross(vertices.at(i1) - vertices.at(i2), vertices.at(i1) - vertices.at(i3));
-                    faceNormal = glm::normalize(faceNormal);
-                    normal += faceNormal;
-                    numTrianglesSharedBy++;
-                }
-            }*/
+    return true;
+}
+
+// Keeps the per-corner indices of the triangles in keptTriangles (see remapWeldedTriangleIndices).
+static void keepTriangleCorners(std::vector<uint32_t> &cornerIndices, const std::vector<uint32_t> &keptTriangles)
+{
+    for (size_t t = 0; t < keptTriangles.size(); t++) {
+        size_t oldTriangle = keptTriangles[t];
+        cornerIndices[t*3] = cornerIndices[oldTriangle*3];
+        cornerIndices[t*3+1] = cornerIndices[oldTriangle*3+1];
+        cornerIndices[t*3+2] = cornerIndices[oldTriangle*3+2];
+    }
+    cornerIndices.resize(keptTriangles.size() * 3);
+}
 
-            if (numTrianglesSharedBy == 0) {
-                Logfile::get()->writeError("Error in parseObjMesh: numTrianglesSharedBy == 0");
-                exit(1); // TODO: Global vertex buffer
+/**
+ * Welds the global vertices (see computeVertexWelding) and updates the vertex indices of all submeshes.
+ * Triangles that collapsed are removed together with their texture coordinate and normal indices.
+ */
+static void weldTempMeshVertices(
+        std::vector<TempSubmesh> &tempMesh, std::vector<glm::vec3> &globalVertices, float relativeEpsilon)
+{
+    std::vector<uint32_t> vertexRemap;
+    std::vector<glm::vec3> weldedVertices;
+    computeVertexWelding(globalVertices, relativeEpsilon, vertexRemap, weldedVertices);
+
+    size_t numRemovedTriangles = 0;
+    std::vector<uint32_t> keptTriangles;
+    for (TempSubmesh &tempSubmesh : tempMesh) {
+        std::vector<uint32_t> &vertexIndices = tempSubmesh.vertexIndices;
+        if (vertexIndices.size() % 3 != 0) {
+            // Not a triangle list, so only remap the indices.
+            for (size_t i = 0; i < vertexIndices.size(); i++) {
+                vertexIndices[i] = vertexRemap[vertexIndices[i]];
             }
-            normal /= (float)numTrianglesSharedBy;
-            normals.push_back(normal);
+            continue;
+        }
+
+        size_t numCorners = vertexIndices.size();
+        numRemovedTriangles += remapWeldedTriangleIndices(vertexRemap, vertexIndices, &keptTriangles);
+        if (tempSubmesh.tecoordIndices.size() == numCorners) {
+            keepTriangleCorners(tempSubmesh.tecoordIndices, keptTriangles);
+        }
+        if (tempSubmesh.normalIndices.size() == numCorners) {
+            keepTriangleCorners(tempSubmesh.normalIndices, keptTriangles);
         }
     }
 
-    mesh.submeshes.push_back(submesh);
+    Logfile::get()->writeInfo(string() + "Welded " + toString(globalVertices.size()) + " vertices to "
+            + toString(weldedVertices.size()) + " (" + toString(globalVertices.size() - weldedVertices.size())
+            + " merged), removed " + toString(numRemovedTriangles) + " degenerate triangles.");
+    globalVertices.swap(weldedVertices);
 }
 
 void addMaterialsFromFile(const std::string &filename, const std::string &objFilename,
-        std::map<std::string, ObjMaterial> &materials)
+        std::unordered_map<std::string, ObjMaterial> &materials)
 {
     std::string absFilename = filename;
     if (!FileUtils::get()->exists(absFilename)) {
         absFilename = FileUtils::get()->getPathToFile(objFilename) + FileUtils::get()->getPureFilename(absFilename);
     }
 
-    std::ifstream file(absFilename.c_str());
-
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.open(absFilename)) {
         Logfile::get()->writeError(string() + "Error in parseObjMesh: File \"" + filename + "\" does not exist.");
         return;
     }
@@ -207,69 +445,55 @@ void addMaterialsFromFile(const std::string &filename, const std::string &objFil
     std::string materialName;
     ObjMaterial currMaterial;
 
-
-    std::string lineString;
-    while (getline(file, lineString)) {
-        while (lineString.size() > 0 && (lineString[lineString.size()-1] == '\r' || lineString[lineString.size()-1] == ' ')) {
-            // Remove '\r' of Windows line ending
-            lineString = lineString.substr(0, lineString.size() - 1);
-        }
-        std::vector<std::string> line;
-        boost::algorithm::split(line, lineString, boost::is_any_of("\t "), boost::token_compress_on);
-
-        std::string command = line.at(0);
+    const char *fileData = reinterpret_cast<const char*>(file.getData());
+    ObjLineTokenizer tokenizer(fileData, fileData + file.getSize());
+    while (tokenizer.nextLine()) {
+        const ObjToken &command = tokenizer.getToken(0);
 
         if (command == "newmtl") {
             // New object
             if (materialName.length() != 0) {
                 materials.insert(make_pair(materialName, currMaterial));
             }
-            materialName = line.at(1);
+            materialName = tokenizer.getToken(1).toString();
             currMaterial = ObjMaterial();
         } else if (command == "Ka") {
             // Ambient color
-            currMaterial.ambientColor = glm::vec3(fromString<float>(line.at(1)), fromString<float>(line.at(2)),
-                                                  fromString<float>(line.at(3)));
+            currMaterial.ambientColor = parseVec3(tokenizer);
         }  else if (command == "Kd") {
             // Diffuse color
-            currMaterial.diffuseColor = glm::vec3(fromString<float>(line.at(1)), fromString<float>(line.at(2)),
-                                                  fromString<float>(line.at(3)));
+            currMaterial.diffuseColor = parseVec3(tokenizer);
         } else if (command == "Ks") {
             // Specular color
-            currMaterial.specularColor = glm::vec3(fromString<float>(line.at(1)), fromString<float>(line.at(2)),
-                                                   fromString<float>(line.at(3)));
+            currMaterial.specularColor = parseVec3(tokenizer);
         } else if (command == "Ns") {
             // Specular exponent
-            currMaterial.specularExponent = fromString<float>(line.at(1));
+            currMaterial.specularExponent = parseFloat(tokenizer.getToken(1));
         } else if (command == "d") {
             // Opacity
-            currMaterial.opacity = fromString<float>(line.at(1));
+            currMaterial.opacity = parseFloat(tokenizer.getToken(1));
         } else if (command == "tr") {
             // Transparency (= 1 - opacity)
-            currMaterial.opacity = 1.0f - fromString<float>(line.at(1));
+            currMaterial.opacity = 1.0f - parseFloat(tokenizer.getToken(1));
         } else if (command == "illum") {
             // TODO
-        } else if (boost::starts_with(command, "#") || command == "") {
+        } else if (command.startsWith('#') || command == "") {
             // Ignore comments and empty lines
-        } else {
-            //Logfile::get()->writeError(string() + "Error in addMaterialsFromFile: Unknown command \"" + command + "\".");
         }
     }
 
     if (materialName.length() != 0) {
         materials.insert(make_pair(materialName, currMaterial));
     }
-
-    file.close();
 }
 
 void convertObjMeshToBinary(
         const std::string &objFilename,
-        const std::string &binaryFilename)
+        const std::string &binaryFilename,
+        float weldingEpsilon)
 {
-    std::ifstream file(objFilename.c_str());
-
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.open(objFilename)) {
         Logfile::get()->writeError(string() + "Error in parseObjMesh: File \"" + objFilename + "\" does not exist.");
         return;
     }
@@ -277,138 +501,110 @@ void convertObjMeshToBinary(
     vector<TempSubmesh> tempMesh;
     TempSubmesh currSubmesh;
     uint32_t indexOffset = 1;
-    std::map<std::string, ObjMaterial> materials;
+    std::unordered_map<std::string, ObjMaterial> materials;
 
     std::vector<glm::vec3> globalVertices;
-    std::vector<glm::vec2> globalTexcoords;
     std::vector<glm::vec3> globalNormals;
 
-    std::string lineString;
-    while (getline(file, lineString)) {
-        while (lineString.size() > 0 && (lineString[lineString.size()-1] == '\r' || lineString[lineString.size()-1] == ' ')) {
-            // Remove '\r' of Windows line ending
-            lineString = lineString.substr(0, lineString.size() - 1);
-        }
-        std::vector<std::string> line;
-        boost::algorithm::split(line, lineString, boost::is_any_of("\t "), boost::token_compress_on);
-
-        std::string command = line.at(0);
+    const char *fileData = reinterpret_cast<const char*>(file.getData());
+    ObjLineTokenizer tokenizer(fileData, fileData + file.getSize());
+    while (tokenizer.nextLine()) {
+        const ObjToken &command = tokenizer.getToken(0);
 
-        if (command == "o") {
+        if (command == "v") {
+            // Vertex position
+            globalVertices.push_back(parseVec3(tokenizer));
+        } else if (command == "vn") {
+            // Vertex normal
+            globalNormals.push_back(parseVec3(tokenizer));
+        } else if (command == "f") {
+            // Face indices of the form "v", "v/vt", "v//vn" or "v/vt/vn"
+            for (size_t i = 1; i < tokenizer.getNumTokens(); i++) {
+                const ObjToken &vertexToken = tokenizer.getToken(i);
+                const char *componentBegin = vertexToken.begin;
+                for (int component = 0; component < 3; component++) {
+                    const char *componentEnd = static_cast<const char*>(
+                            memchr(componentBegin, '/', vertexToken.end - componentBegin));
+                    if (componentEnd == NULL) {
+                        componentEnd = vertexToken.end;
+                    }
+                    uint32_t index = uint32_t(parseInt(componentBegin, componentEnd)) - indexOffset;
+                    if (component == 0) {
+                        currSubmesh.vertexIndices.push_back(index);
+                    } else if (component == 1) {
+                        currSubmesh.tecoordIndices.push_back(index);
+                    } else {
+                        currSubmesh.normalIndices.push_back(index);
+                    }
+                    if (componentEnd == vertexToken.end) {
+                        break;
+                    }
+                    componentBegin = componentEnd + 1;
+                }
+            }
+        } else if (command == "vt") {
+            // Texture coordinates are not stored in the binary mesh
+        } else if (command == "o") {
             // New object
             if (globalVertices.size() != 0) {
-                tempMesh.push_back(currSubmesh);
+                tempMesh.push_back(std::move(currSubmesh));
                 currSubmesh = TempSubmesh();
             }
         } else if (command == "g") {
             // Groups not supported for now
         }  else if (command == "mtllib") {
             //  Load material definition file
-            addMaterialsFromFile(line.at(1), objFilename, materials);
+            addMaterialsFromFile(tokenizer.getToken(1).toString(), objFilename, materials);
         } else if (command == "usemtl") {
             // Use new material
-            auto it = materials.find(line.at(1));
+            std::string materialName = tokenizer.getToken(1).toString();
+            auto it = materials.find(materialName);
             if (it != materials.end()) {
                 currSubmesh.material = it->second;
             } else if (materials.size() > 0) {
                 Logfile::get()->writeError(string() + "Error in parseObjMesh: Material \""
-                        + line.at(1) + "\" does not exist.");
+                        + materialName + "\" does not exist.");
             }
         } else if (command == "s") {
             // Smooth shading is always assumed for now
             currSubmesh.smooth = true; // TODO
-        } else if (command == "v") {
-            // Vertex position
-            globalVertices.push_back(glm::vec3(fromString<float>(line.at(1)), fromString<float>(line.at(2)),
-                    fromString<float>(line.at(3))));
-        } else if (command == "vt") {
-            // Texture coordinate
-            globalTexcoords.push_back(glm::vec2(fromString<float>(line.at(1)),
-                    fromString<float>(line.at(2))));
-        } else if (command == "vn") {
-            // Vertex normal
-            globalNormals.push_back(glm::vec3(fromString<float>(line.at(1)), fromString<float>(line.at(2)),
-                    fromString<float>(line.at(3))));
-        } else if (command == "f") {
-            // Face indices
-            std::vector<uint32_t> tempVertexIndices;
-            std::vector<uint32_t> tempTecoordIndices;
-            std::vector<uint32_t> tempNormalIndices;
-            for (size_t i = 1; i < line.size(); i++) {
-                std::vector<std::string> indices;
-                boost::algorithm::split(indices, line.at(i), boost::is_any_of("/"));
-                currSubmesh.vertexIndices.push_back(atoi(indices.at(0).c_str()) - indexOffset);
-                if (indices.size() > 1)
-                    currSubmesh.tecoordIndices.push_back(atoi(indices.at(1).c_str()) - indexOffset);
-                if (indices.size() > 2)
-                    currSubmesh.normalIndices.push_back(atoi(indices.at(2).c_str()) - indexOffset);
-            }
-            triangleStripToTriangles(tempVertexIndices, currSubmesh.vertexIndices);
-            triangleStripToTriangles(tempTecoordIndices, currSubmesh.tecoordIndices);
-            triangleStripToTriangles(tempNormalIndices, currSubmesh.normalIndices);
-        } else if (boost::starts_with(command, "#") || command == "") {
+        } else if (command.startsWith('#') || command == "") {
             // Ignore comments and empty lines
-        } else {
-//            Logfile::get()->writeError(string() + "Error in parseObjMesh: Unknown command \"" + command + "\".");
         }
     }
 
     if (globalVertices.size() != 0) {
-        tempMesh.push_back(currSubmesh);
-    }
-
-
-
-    ObjMesh mesh;
-    mesh.submeshes.reserve(tempMesh.size());
-    for (TempSubmesh tempSubmesh : tempMesh) {
-        processTempSubmesh(mesh, tempSubmesh, globalVertices, globalTexcoords, globalNormals);
+        tempMesh.push_back(std::move(currSubmesh));
     }
-
     file.close();
 
+    for (size_t i = 0; i < tempMesh.size(); i++) {
+        if (!indicesInRange(tempMesh[i].vertexIndices, globalVertices.size())) {
+            Logfile::get()->writeError(string() + "Error in parseObjMesh: Submesh " + toString(i) + " of \""
+                    + objFilename + "\" references missing vertices.");
+            return;
+        }
+    }
+    if (weldingEpsilon > 0.0f) {
+        weldTempMeshVertices(tempMesh, globalVertices, weldingEpsilon);
+    }
 
-
+    // Process the submeshes in parallel. If there is only one submesh, the loops over its elements run in parallel.
     BinaryMesh binaryMesh;
     binaryMesh.submeshes.resize(tempMesh.size());
-    for (size_t i = 0; i < mesh.submeshes.size(); ++i) {
-        ObjSubmesh &submesh = mesh.submeshes.at(i);
-        BinarySubMesh &binarySubmesh = binaryMesh.submeshes.at(i);
-        binarySubmesh.material = submesh.material;
-        binarySubmesh.vertexMode = VERTEX_MODE_TRIANGLES;
-        binarySubmesh.indices = submesh.indices;
-
-        BinaryMeshAttribute positionAttribute;
-        positionAttribute.name = "vertexPosition";
-        positionAttribute.attributeFormat = ATTRIB_FLOAT;
-        positionAttribute.numComponents = 3;
-        positionAttribute.data.resize(submesh.vertices.size() * sizeof(glm::vec3));
-        memcpy(&positionAttribute.data.front(), &submesh.vertices.front(), submesh.vertices.size() * sizeof(glm::vec3));
-        binarySubmesh.attributes.push_back(positionAttribute);
-
-        if (submesh.normals.size() > 0) {
-            BinaryMeshAttribute normalAttribute;
-            normalAttribute.name = "vertexNormal";
-            normalAttribute.attributeFormat = ATTRIB_FLOAT;
-            normalAttribute.numComponents = 3;
-            normalAttribute.data.resize(submesh.normals.size() * sizeof(glm::vec3));
-            memcpy(&normalAttribute.data.front(), &submesh.normals.front(), submesh.normals.size() * sizeof(glm::vec3));
-            binarySubmesh.attributes.push_back(normalAttribute);
-        }
+    std::vector<uint8_t> submeshValid(tempMesh.size());
+    #pragma omp parallel for schedule(dynamic) if(tempMesh.size() > 1)
+    for (size_t i = 0; i < tempMesh.size(); i++) {
+        submeshValid[i] = processTempSubmesh(tempMesh[i], globalVertices, globalNormals, binaryMesh.submeshes[i]);
+    }
 
-        if (submesh.texcoords.size() > 0) {
-            BinaryMeshAttribute texcoordAttribute;
-            texcoordAttribute.name = "vertexTexcoords";
-            texcoordAttribute.attributeFormat = ATTRIB_FLOAT;
-            texcoordAttribute.numComponents = 2;
-            texcoordAttribute.data.resize(submesh.texcoords.size() * sizeof(glm::vec2));
-            memcpy(&texcoordAttribute.data.front(), &submesh.texcoords.front(), submesh.texcoords.size() * sizeof(glm::vec2));
-            binarySubmesh.attributes.push_back(texcoordAttribute);
+    for (size_t i = 0; i < tempMesh.size(); i++) {
+        if (!submeshValid[i]) {
+            Logfile::get()->writeError(string() + "Error in parseObjMesh: Submesh " + toString(i) + " of \""
+                    + objFilename + "\" references missing vertices or normals, or its faces aren't triangles.");
+            return;
         }
     }
 
-
     writeMesh3D(binaryFilename, binaryMesh);
 }
-
-
@@ -17,9 +17,12 @@
  *
  * @param objFilename: The input .obj file.
  * @param binaryFilename: The filename of the binary output file.
+ * @param weldingEpsilon: If greater than zero, vertices closer than weldingEpsilon times the maximum extent of the
+ * bounding box are merged before the normals are computed (see VertexWelding.hpp).
  */
 void convertObjMeshToBinary(
         const std::string &objFilename,
-        const std::string &binaryFilename);
+        const std::string &binaryFilename,
+        float weldingEpsilon = 0.0f);
 
 #endif /* OBJLOADER_HPP_ */
@@ -0,0 +1,665 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+#include <Math/Geometry/AABB3.hpp>
+#include <Utils/Convert.hpp>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Events/Stream/Stream.hpp>
+
+#include "MappedFile.hpp"
+#include "MeshSerializer.hpp"
+#include "MeshAdjacency.hpp"
+#include "ComputeNormals.hpp"
+#include "ImportanceCriteria.hpp"
+#include "OutOfCoreBinaryObjLoader.hpp"
+
+// Rough upper bounds of the memory needed per vertex and triangle by convertBinaryObjMeshToBinmesh (including the
+// copies made when assembling and serializing the binary mesh) and per triangle of a bucket by the out-of-core
+// conversion (including the halo triangles and the vertices of the bucket).
+const size_t IN_CORE_BYTES_PER_VERTEX = 80;
+const size_t IN_CORE_BYTES_PER_TRIANGLE = 40;
+const size_t OUT_OF_CORE_BYTES_PER_TRIANGLE = 96;
+
+// The maximum bucket grid resolution per axis and the number of elements processed at once when streaming arrays.
+const int MAX_BUCKET_GRID_RESOLUTION = 64;
+const size_t OUT_OF_CORE_CHUNK_SIZE = 1 << 20;
+
+const uint32_t INVALID_BUCKET = 0xFFFFFFFFu;
+
+/// A .bobj file consists of the header (number of vertices, number of triangles), the vertices and the indices.
+const size_t BOBJ_HEADER_SIZE = 2 * sizeof(uint64_t);
+
+size_t estimateBinaryObjConversionMemory(const std::string &bobjFilename)
+{
+    FILE *file = fopen(bobjFilename.c_str(), "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    uint64_t header[2] = {0};
+    size_t readSize = fread(header, 1, sizeof(header), file);
+    fclose(file);
+    if (readSize != sizeof(header)) {
+        return 0;
+    }
+    return header[0] * IN_CORE_BYTES_PER_VERTEX + header[1] * IN_CORE_BYTES_PER_TRIANGLE;
+}
+
+static bool seekFile(FILE *file, uint64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, offset, SEEK_SET) == 0;
+#endif
+}
+
+/**
+ * Creates a file of the passed size filled with zeros. The file is removed when the object is destroyed.
+ */
+class TemporaryFile
+{
+public:
+    TemporaryFile(const std::string &filename) : filename(filename), file(NULL) {}
+    ~TemporaryFile() { close(); std::remove(filename.c_str()); }
+
+    bool create(uint64_t size) {
+        file = fopen(filename.c_str(), "wb");
+        if (file == NULL) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in TemporaryFile::create: Couldn't create file \""
+                    + filename + "\".");
+            return false;
+        }
+        // Writing the last byte extends the file to its full size.
+        uint8_t zero = 0;
+        if (size > 0 && (!seekFile(file, size - 1) || fwrite(&zero, 1, 1, file) != 1)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in TemporaryFile::create: Couldn't write to file \""
+                    + filename + "\".");
+            return false;
+        }
+        return true;
+    }
+    /// Writes numBytes bytes at the passed offset.
+    bool write(uint64_t offset, const void *data, size_t numBytes) {
+        if (!seekFile(file, offset) || fwrite(data, 1, numBytes, file) != numBytes) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in TemporaryFile::write: Couldn't write to file \""
+                    + filename + "\".");
+            return false;
+        }
+        return true;
+    }
+    void close() { if (file != NULL) { fclose(file); file = NULL; } }
+    inline const std::string &getFilename() const { return filename; }
+
+private:
+    std::string filename;
+    FILE *file;
+};
+
+/**
+ * A uniform grid of buckets over the bounding box of the (not transformed) vertices of the .bobj file.
+ */
+struct BucketGrid
+{
+    glm::vec3 minimum;
+    glm::vec3 scale;
+    int resolution;
+
+    BucketGrid(const glm::vec3 &minimum, const glm::vec3 &maximum, int resolution)
+            : minimum(minimum), resolution(resolution) {
+        glm::vec3 extent = maximum - minimum;
+        for (int i = 0; i < 3; i++) {
+            scale[i] = extent[i] > 0.0f ? float(resolution) / extent[i] : 0.0f;
+        }
+    }
+    inline uint32_t getNumBuckets() const { return uint32_t(resolution * resolution * resolution); }
+    inline uint32_t getBucket(const glm::vec3 &vertex) const {
+        glm::ivec3 cell = glm::clamp(glm::ivec3((vertex - minimum) * scale), glm::ivec3(0), glm::ivec3(resolution-1));
+        return uint32_t((cell.z * resolution + cell.y) * resolution + cell.x);
+    }
+};
+
+/**
+ * The mapped data of a .bobj file and the transformation convertBinaryObjMeshToBinmesh applies to the vertices
+ * (swapping the y and z axis, normalizing the bounding box to the range (-1, 1) and flipping the y axis).
+ */
+struct BinaryObjMeshView
+{
+    size_t numVertices;
+    size_t numTriangles;
+    const glm::vec3 *vertices;
+    const uint8_t *indices; ///< 64-bit indices, not necessarily aligned to 8 bytes.
+    glm::vec3 center;
+    float maxExtent;
+
+    inline uint32_t getIndex(size_t i) const {
+        uint64_t index;
+        memcpy(&index, indices + i * sizeof(uint64_t), sizeof(uint64_t));
+        return static_cast<uint32_t>(index);
+    }
+    inline glm::vec3 transformVertex(const glm::vec3 &vertex) const {
+        glm::vec3 transformedVertex(vertex.x, vertex.z, vertex.y);
+        transformedVertex = (transformedVertex - center) / maxExtent;
+        transformedVertex.y = -transformedVertex.y;
+        return transformedVertex;
+    }
+};
+
+/**
+ * Computes the distinct buckets of the vertices of the triangles [triangleStart, triangleEnd). Duplicates are set
+ * to INVALID_BUCKET.
+ * @return False if a triangle references a vertex that doesn't exist.
+ */
+static bool computeTriangleBuckets(
+        const BinaryObjMeshView &mesh, const BucketGrid &grid, size_t triangleStart, size_t triangleEnd,
+        std::vector<uint32_t> &triangleBuckets)
+{
+    triangleBuckets.resize((triangleEnd - triangleStart) * 3);
+    int numInvalidIndices = 0;
+    #pragma omp parallel for reduction(+:numInvalidIndices)
+    for (size_t t = triangleStart; t < triangleEnd; t++) {
+        uint32_t *buckets = &triangleBuckets[(t - triangleStart) * 3];
+        for (int j = 0; j < 3; j++) {
+            uint64_t index;
+            memcpy(&index, mesh.indices + (t * 3 + j) * sizeof(uint64_t), sizeof(uint64_t));
+            if (index >= mesh.numVertices) {
+                numInvalidIndices++;
+                buckets[j] = INVALID_BUCKET;
+                continue;
+            }
+            buckets[j] = grid.getBucket(mesh.vertices[index]);
+        }
+        if (buckets[1] == buckets[0]) {
+            buckets[1] = INVALID_BUCKET;
+        }
+        if (buckets[2] == buckets[0] || buckets[2] == buckets[1]) {
+            buckets[2] = INVALID_BUCKET;
+        }
+    }
+    return numInvalidIndices == 0;
+}
+
+/**
+ * Counts the triangles stored in each bucket of the grid.
+ * @return False if a triangle references a vertex that doesn't exist.
+ */
+static bool countBucketTriangles(
+        const BinaryObjMeshView &mesh, const BucketGrid &grid, std::vector<uint64_t> &bucketSizes)
+{
+    bucketSizes.clear();
+    bucketSizes.resize(grid.getNumBuckets(), 0);
+    std::vector<uint32_t> triangleBuckets;
+    for (size_t chunkStart = 0; chunkStart < mesh.numTriangles; chunkStart += OUT_OF_CORE_CHUNK_SIZE) {
+        size_t chunkEnd = std::min(chunkStart + OUT_OF_CORE_CHUNK_SIZE, mesh.numTriangles);
+        if (!computeTriangleBuckets(mesh, grid, chunkStart, chunkEnd, triangleBuckets)) {
+            return false;
+        }
+        for (size_t i = 0; i < triangleBuckets.size(); i++) {
+            if (triangleBuckets[i] != INVALID_BUCKET) {
+                bucketSizes[triangleBuckets[i]]++;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Writes the buffered triangle lists of all buckets to the bucket file and frees the buffers.
+ */
+static bool flushBucketBuffers(
+        std::vector<std::vector<uint32_t>> &bucketBuffers, std::vector<uint64_t> &bucketWriteOffsets,
+        TemporaryFile &bucketFile)
+{
+    for (size_t bucket = 0; bucket < bucketBuffers.size(); bucket++) {
+        std::vector<uint32_t> &buffer = bucketBuffers[bucket];
+        if (buffer.empty()) {
+            continue;
+        }
+        if (!bucketFile.write(bucketWriteOffsets[bucket] * sizeof(uint32_t), buffer.data(),
+                buffer.size() * sizeof(uint32_t))) {
+            return false;
+        }
+        bucketWriteOffsets[bucket] += buffer.size();
+        std::vector<uint32_t>().swap(buffer);
+    }
+    return true;
+}
+
+/**
+ * Writes the indices of the triangles of each bucket (in ascending order) to the bucket file. The triangles of
+ * bucket b are stored at [bucketOffsets[b], bucketOffsets[b+1]). The lists are assembled in per-bucket buffers, which
+ * are all written to the file once they hold maxBufferedTriangles triangles in total. Thus, the memory used by the
+ * buffers doesn't depend on the number of buckets.
+ */
+static bool writeBucketTriangles(
+        const BinaryObjMeshView &mesh, const BucketGrid &grid, const std::vector<uint64_t> &bucketOffsets,
+        size_t maxBufferedTriangles, TemporaryFile &bucketFile)
+{
+    const uint32_t numBuckets = grid.getNumBuckets();
+    std::vector<std::vector<uint32_t>> bucketBuffers(numBuckets);
+    std::vector<uint64_t> bucketWriteOffsets(bucketOffsets.begin(), bucketOffsets.end() - 1);
+    size_t numBufferedTriangles = 0;
+
+    std::vector<uint32_t> triangleBuckets;
+    for (size_t chunkStart = 0; chunkStart < mesh.numTriangles; chunkStart += OUT_OF_CORE_CHUNK_SIZE) {
+        size_t chunkEnd = std::min(chunkStart + OUT_OF_CORE_CHUNK_SIZE, mesh.numTriangles);
+        computeTriangleBuckets(mesh, grid, chunkStart, chunkEnd, triangleBuckets);
+        for (size_t i = 0; i < triangleBuckets.size(); i++) {
+            const uint32_t bucket = triangleBuckets[i];
+            if (bucket == INVALID_BUCKET) {
+                continue;
+            }
+            bucketBuffers[bucket].push_back(uint32_t(chunkStart + i / 3));
+            numBufferedTriangles++;
+            if (numBufferedTriangles >= maxBufferedTriangles) {
+                if (!flushBucketBuffers(bucketBuffers, bucketWriteOffsets, bucketFile)) {
+                    return false;
+                }
+                numBufferedTriangles = 0;
+            }
+        }
+    }
+
+    return flushBucketBuffers(bucketBuffers, bucketWriteOffsets, bucketFile);
+}
+
+/**
+ * The triangles of a bucket with local vertex indices. The local vertices are sorted by their global index.
+ */
+struct MeshBucket
+{
+    std::vector<uint32_t> vertexIds; ///< The global index of each local vertex.
+    std::vector<uint8_t> isOwned; ///< Whether the vertex lies in the bucket (otherwise it is a halo vertex).
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    VertexTriangleAdjacency adjacency;
+};
+
+static void loadMeshBucket(
+        const BinaryObjMeshView &mesh, const BucketGrid &grid, uint32_t bucketIndex,
+        const uint32_t *triangleIds, size_t numTriangles, MeshBucket &bucket)
+{
+    bucket.indices.resize(numTriangles * 3);
+    #pragma omp parallel for
+    for (size_t t = 0; t < numTriangles; t++) {
+        for (size_t j = 0; j < 3; j++) {
+            bucket.indices[t * 3 + j] = mesh.getIndex(size_t(triangleIds[t]) * 3 + j);
+        }
+    }
+
+    bucket.vertexIds = bucket.indices;
+    std::sort(bucket.vertexIds.begin(), bucket.vertexIds.end());
+    bucket.vertexIds.erase(std::unique(bucket.vertexIds.begin(), bucket.vertexIds.end()), bucket.vertexIds.end());
+    bucket.vertexIds.shrink_to_fit();
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < bucket.indices.size(); i++) {
+        bucket.indices[i] = uint32_t(std::lower_bound(
+                bucket.vertexIds.begin(), bucket.vertexIds.end(), bucket.indices[i]) - bucket.vertexIds.begin());
+    }
+
+    const size_t numVertices = bucket.vertexIds.size();
+    bucket.vertices.resize(numVertices);
+    bucket.isOwned.resize(numVertices);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numVertices; i++) {
+        const glm::vec3 &vertex = mesh.vertices[bucket.vertexIds[i]];
+        bucket.vertices[i] = mesh.transformVertex(vertex);
+        bucket.isOwned[i] = grid.getBucket(vertex) == bucketIndex;
+    }
+
+    // The triangles are sorted by their global index, so the adjacent faces are in the same order as in
+    // computeNormals for the whole mesh.
+    buildVertexTriangleAdjacency(numVertices, bucket.indices, bucket.adjacency);
+}
+
+/**
+ * Writes the values of the vertices owned by the bucket to the file storing the values of all vertices. Runs of
+ * consecutive global vertex indices are written at once.
+ */
+template<class T>
+static bool writeOwnedVertexValues(const MeshBucket &bucket, const std::vector<T> &values, TemporaryFile &file)
+{
+    const size_t numVertices = bucket.vertexIds.size();
+    size_t i = 0;
+    while (i < numVertices) {
+        if (!bucket.isOwned[i]) {
+            i++;
+            continue;
+        }
+        size_t runEnd = i + 1;
+        while (runEnd < numVertices && bucket.isOwned[runEnd]
+                && bucket.vertexIds[runEnd] == bucket.vertexIds[runEnd - 1] + 1) {
+            runEnd++;
+        }
+        if (!file.write(uint64_t(bucket.vertexIds[i]) * sizeof(T), &values[i], (runEnd - i) * sizeof(T))) {
+            return false;
+        }
+        i = runEnd;
+    }
+    return true;
+}
+
+static bool writeStreamToFile(FILE *file, sgl::BinaryWriteStream &stream)
+{
+    return writeMesh3DData(file, stream.getBuffer(), stream.getSize());
+}
+
+/**
+ * Writes the binmesh file in the layout of writeMesh3D. The arrays are streamed in chunks from the mapped files.
+ */
+static bool writeOutOfCoreBinmesh(
+        const std::string &binaryFilename, const BinaryObjMeshView &mesh, const glm::vec3 *normals,
+        const float *curvatures, float minCurvature, float maxCurvature)
+{
+    FILE *file = fopen(binaryFilename.c_str(), "wb");
+    if (file == NULL) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertBinaryObjMeshToBinmeshOutOfCore: File \""
+                + binaryFilename + "\" couldn't be created.");
+        return false;
+    }
+
+    sgl::BinaryWriteStream headerStream;
+    headerStream.write((uint32_t)MESH_FORMAT_VERSION);
+    headerStream.write((uint32_t)1u); // One submesh
+    headerStream.write(ObjMaterial());
+    headerStream.write((uint32_t)sgl::VERTEX_MODE_TRIANGLES);
+    headerStream.write((uint32_t)(mesh.numTriangles * 3));
+    bool success = writeStreamToFile(file, headerStream);
+
+    std::vector<uint32_t> indexChunk;
+    for (size_t chunkStart = 0; success && chunkStart < mesh.numTriangles * 3; chunkStart += OUT_OF_CORE_CHUNK_SIZE) {
+        indexChunk.resize(std::min(OUT_OF_CORE_CHUNK_SIZE, mesh.numTriangles * 3 - chunkStart));
+        #pragma omp parallel for
+        for (size_t i = 0; i < indexChunk.size(); i++) {
+            indexChunk[i] = mesh.getIndex(chunkStart + i);
+        }
+        success = writeMesh3DData(file, indexChunk.data(), indexChunk.size() * sizeof(uint32_t));
+    }
+    indexChunk.clear(); indexChunk.shrink_to_fit();
+
+    sgl::BinaryWriteStream numAttributesStream;
+    numAttributesStream.write((uint32_t)3u);
+    success = success && writeStreamToFile(file, numAttributesStream);
+
+    success = success && writeMesh3DAttributeHeader(
+            file, "vertexPosition", sgl::ATTRIB_FLOAT, 3, mesh.numVertices * sizeof(glm::vec3));
+    std::vector<glm::vec3> vertexChunk;
+    for (size_t chunkStart = 0; success && chunkStart < mesh.numVertices; chunkStart += OUT_OF_CORE_CHUNK_SIZE) {
+        vertexChunk.resize(std::min(OUT_OF_CORE_CHUNK_SIZE, mesh.numVertices - chunkStart));
+        #pragma omp parallel for
+        for (size_t i = 0; i < vertexChunk.size(); i++) {
+            vertexChunk[i] = mesh.transformVertex(mesh.vertices[chunkStart + i]);
+        }
+        success = writeMesh3DData(file, vertexChunk.data(), vertexChunk.size() * sizeof(glm::vec3));
+    }
+    vertexChunk.clear(); vertexChunk.shrink_to_fit();
+
+    success = success && writeMesh3DAttributeHeader(
+            file, "vertexNormal", sgl::ATTRIB_FLOAT, 3, mesh.numVertices * sizeof(glm::vec3));
+    success = success && writeMesh3DData(file, normals, mesh.numVertices * sizeof(glm::vec3));
+
+    success = success && writeMesh3DAttributeHeader(
+            file, "vertexAttribute0", sgl::ATTRIB_UNSIGNED_SHORT, 1, mesh.numVertices * sizeof(uint16_t));
+    std::vector<uint16_t> unormChunk;
+    for (size_t chunkStart = 0; success && chunkStart < mesh.numVertices; chunkStart += OUT_OF_CORE_CHUNK_SIZE) {
+        unormChunk.resize(std::min(OUT_OF_CORE_CHUNK_SIZE, mesh.numVertices - chunkStart));
+        packUnorm16Array(curvatures + chunkStart, unormChunk.size(), minCurvature, maxCurvature, unormChunk.data());
+        success = writeMesh3DData(file, unormChunk.data(), unormChunk.size() * sizeof(uint16_t));
+    }
+
+    sgl::BinaryWriteStream numUniformsStream;
+    numUniformsStream.write((uint32_t)0u);
+    success = success && writeStreamToFile(file, numUniformsStream);
+
+    fclose(file);
+    if (!success) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertBinaryObjMeshToBinmeshOutOfCore: "
+                + "Couldn't write to file \"" + binaryFilename + "\".");
+        std::remove(binaryFilename.c_str());
+    }
+    return success;
+}
+
+void convertBinaryObjMeshToBinmeshOutOfCore(
+        const std::string &bobjFilename,
+        const std::string &binaryFilename,
+        size_t memoryBudget)
+{
+    MappedFile bobjFile;
+    if (!bobjFile.open(bobjFilename)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertBinaryObjMeshToBinmeshOutOfCore: File \""
+                + bobjFilename + "\" does not exist.");
+        return;
+    }
+    sgl::Logfile::get()->writeInfo(std::string() + "Converting binary OBJ mesh \"" + bobjFilename
+            + "\" out-of-core with a memory budget of " + sgl::toString(memoryBudget / (1024 * 1024)) + " MiB...");
+
+    uint64_t header[2] = {0};
+    if (bobjFile.getSize() >= BOBJ_HEADER_SIZE) {
+        memcpy(header, bobjFile.getData(), BOBJ_HEADER_SIZE);
+    }
+    BinaryObjMeshView mesh;
+    mesh.numVertices = header[0];
+    mesh.numTriangles = header[1];
+    if (mesh.numVertices == 0 || mesh.numTriangles == 0
+            || (bobjFile.getSize() - BOBJ_HEADER_SIZE) / sizeof(glm::vec3) < mesh.numVertices
+            || (bobjFile.getSize() - BOBJ_HEADER_SIZE - mesh.numVertices * sizeof(glm::vec3)) / (3 * sizeof(uint64_t))
+                    < mesh.numTriangles) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertBinaryObjMeshToBinmeshOutOfCore: File \""
+                + bobjFilename + "\" is empty or truncated.");
+        return;
+    }
+    // The binmesh format stores the sizes of the arrays as 32-bit values.
+    if (mesh.numVertices * sizeof(glm::vec3) > UINT32_MAX || mesh.numTriangles * 3 > UINT32_MAX) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertBinaryObjMeshToBinmeshOutOfCore: File \""
+                + bobjFilename + "\" is too large for the binmesh format.");
+        return;
+    }
+    mesh.vertices = reinterpret_cast<const glm::vec3*>(bobjFile.getData() + BOBJ_HEADER_SIZE);
+    mesh.indices = bobjFile.getData() + BOBJ_HEADER_SIZE + mesh.numVertices * sizeof(glm::vec3);
+
+    // Compute the bounding box of the vertices.
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+    #pragma omp parallel for reduction(min:minX,minY,minZ) reduction(max:maxX,maxY,maxZ)
+    for (size_t i = 0; i < mesh.numVertices; i++) {
+        const glm::vec3 &vertex = mesh.vertices[i];
+        minX = std::min(minX, vertex.x); minY = std::min(minY, vertex.y); minZ = std::min(minZ, vertex.z);
+        maxX = std::max(maxX, vertex.x); maxY = std::max(maxY, vertex.y); maxZ = std::max(maxZ, vertex.z);
+    }
+    // The y and z axis are swapped like in convertBinaryObjMeshToBinmesh.
+    sgl::AABB3 bbox(glm::vec3(minX, minZ, minY), glm::vec3(maxX, maxZ, maxY));
+    mesh.center = bbox.getCenter();
+    glm::vec3 extent = bbox.getExtent();
+    mesh.maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+
+    // Pass 1: Sort the triangles into buckets. Refine the grid until the largest bucket fits into the budget.
+    const size_t maxBucketTriangles = std::max(memoryBudget / OUT_OF_CORE_BYTES_PER_TRIANGLE, size_t(1));
+    size_t numBucketsNeeded = (mesh.numTriangles + maxBucketTriangles - 1) / maxBucketTriangles;
+    int resolution = std::min(
+            std::max(int(std::ceil(std::cbrt(double(numBucketsNeeded)))), 1), MAX_BUCKET_GRID_RESOLUTION);
+    BucketGrid grid(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ), resolution);
+    std::vector<uint64_t> bucketSizes;
+    uint64_t maxBucketSize = 0;
+    while (true) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Counting the triangles of " + sgl::toString(resolution)
+                + "^3 buckets...");
+        if (!countBucketTriangles(mesh, grid, bucketSizes)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in convertBinaryObjMeshToBinmeshOutOfCore: File \""
+                    + bobjFilename + "\" contains invalid vertex indices.");
+            return;
+        }
+        maxBucketSize = *std::max_element(bucketSizes.begin(), bucketSizes.end());
+        if (maxBucketSize <= maxBucketTriangles || resolution >= MAX_BUCKET_GRID_RESOLUTION) {
+            break;
+        }
+        resolution = std::min(resolution * 2, MAX_BUCKET_GRID_RESOLUTION);
+        grid = BucketGrid(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ), resolution);
+    }
+    if (maxBucketSize > maxBucketTriangles) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Warning in convertBinaryObjMeshToBinmeshOutOfCore: The "
+                + "largest bucket has " + sgl::toString(maxBucketSize) + " triangles and exceeds the memory budget.");
+    }
+
+    const uint32_t numBuckets = grid.getNumBuckets();
+    std::vector<uint64_t> bucketOffsets(numBuckets + 1, 0);
+    for (uint32_t bucket = 0; bucket < numBuckets; bucket++) {
+        bucketOffsets[bucket + 1] = bucketOffsets[bucket] + bucketSizes[bucket];
+    }
+    bucketSizes.clear(); bucketSizes.shrink_to_fit();
+    // A quarter of the budget is used for the write buffers of the buckets. The capacity of a growing buffer is up to
+    // twice its size.
+    const size_t maxBufferedTriangles = std::max(memoryBudget / 4 / (2 * sizeof(uint32_t)), size_t(1));
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Writing the triangle lists of " + sgl::toString(numBuckets)
+            + " buckets (" + sgl::toString(bucketOffsets.back()) + " entries)...");
+    TemporaryFile bucketFile(binaryFilename + ".buckets.tmp");
+    if (!bucketFile.create(bucketOffsets.back() * sizeof(uint32_t))
+            || !writeBucketTriangles(mesh, grid, bucketOffsets, maxBufferedTriangles, bucketFile)) {
+        return;
+    }
+    bucketFile.close();
+    MappedFile bucketTriangles;
+    if (!bucketTriangles.open(bucketFile.getFilename())) {
+        return;
+    }
+    const uint32_t *bucketTriangleIds = reinterpret_cast<const uint32_t*>(bucketTriangles.getData());
+
+    // Pass 2a: Compute the normals of the vertices of each bucket.
+    sgl::Logfile::get()->writeInfo(std::string() + "Computing normals for " + sgl::toString(mesh.numVertices)
+            + " vertices...");
+    TemporaryFile normalFile(binaryFilename + ".normals.tmp");
+    if (!normalFile.create(mesh.numVertices * sizeof(glm::vec3))) {
+        return;
+    }
+    size_t numOwnedVertices = 0;
+    MeshBucket bucket;
+    std::vector<glm::vec3> faceNormals;
+    std::vector<glm::vec3> normals;
+    for (uint32_t bucketIndex = 0; bucketIndex < numBuckets; bucketIndex++) {
+        size_t numBucketTriangles = bucketOffsets[bucketIndex + 1] - bucketOffsets[bucketIndex];
+        if (numBucketTriangles == 0) {
+            continue;
+        }
+        loadMeshBucket(mesh, grid, bucketIndex, bucketTriangleIds + bucketOffsets[bucketIndex],
+                numBucketTriangles, bucket);
+        computeFaceNormals(bucket.vertices.data(), bucket.indices, faceNormals);
+
+        // Halo vertices lack some of their adjacent faces. They are computed by the bucket owning them.
+        const size_t numVertices = bucket.vertexIds.size();
+        normals.resize(numVertices);
+        #pragma omp parallel for reduction(+:numOwnedVertices)
+        for (size_t i = 0; i < numVertices; i++) {
+            if (bucket.isOwned[i]) {
+                normals[i] = computeVertexNormal(
+                        faceNormals.data(), bucket.adjacency.getTriangles(i), bucket.adjacency.getNumTriangles(i));
+                numOwnedVertices++;
+            }
+        }
+        if (!writeOwnedVertexValues(bucket, normals, normalFile)) {
+            return;
+        }
+    }
+    faceNormals.clear(); faceNormals.shrink_to_fit();
+    normalFile.close();
+    if (numOwnedVertices != mesh.numVertices) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Warning in convertBinaryObjMeshToBinmeshOutOfCore: "
+                + sgl::toString(mesh.numVertices - numOwnedVertices) + " vertices aren't referenced by any "
+                + "triangle. Their normal and curvature is set to zero.");
+    }
+
+    MappedFile normalData;
+    if (!normalData.open(normalFile.getFilename())) {
+        return;
+    }
+    const glm::vec3 *globalNormals = reinterpret_cast<const glm::vec3*>(normalData.getData());
+
+    // Pass 2b: Compute the curvature of the vertices of each bucket using the normals of all one-ring neighbors.
+    sgl::Logfile::get()->writeInfo(std::string() + "Computing curvature for " + sgl::toString(mesh.numVertices)
+            + " vertices...");
+    TemporaryFile curvatureFile(binaryFilename + ".curvatures.tmp");
+    if (!curvatureFile.create(mesh.numVertices * sizeof(float))) {
+        return;
+    }
+    float minCurvature = FLT_MAX;
+    float maxCurvature = -FLT_MAX;
+    std::vector<float> curvatures;
+    for (uint32_t bucketIndex = 0; bucketIndex < numBuckets; bucketIndex++) {
+        size_t numBucketTriangles = bucketOffsets[bucketIndex + 1] - bucketOffsets[bucketIndex];
+        if (numBucketTriangles == 0) {
+            continue;
+        }
+        loadMeshBucket(mesh, grid, bucketIndex, bucketTriangleIds + bucketOffsets[bucketIndex],
+                numBucketTriangles, bucket);
+
+        const size_t numVertices = bucket.vertexIds.size();
+        normals.resize(numVertices);
+        #pragma omp parallel for
+        for (size_t i = 0; i < numVertices; i++) {
+            normals[i] = globalNormals[bucket.vertexIds[i]];
+        }
+
+        curvatures.resize(numVertices);
+        #pragma omp parallel for reduction(min:minCurvature) reduction(max:maxCurvature)
+        for (size_t i = 0; i < numVertices; i++) {
+            if (bucket.isOwned[i]) {
+                float curvature = computeVertexCurvature(
+                        i, bucket.vertices.data(), normals.data(), bucket.indices.data(),
+                        bucket.adjacency.getTriangles(i), bucket.adjacency.getNumTriangles(i));
+                curvatures[i] = curvature;
+                minCurvature = std::min(minCurvature, curvature);
+                maxCurvature = std::max(maxCurvature, curvature);
+            }
+        }
+        if (!writeOwnedVertexValues(bucket, curvatures, curvatureFile)) {
+            return;
+        }
+    }
+    bucket = MeshBucket();
+    normals.clear(); normals.shrink_to_fit();
+    curvatures.clear(); curvatures.shrink_to_fit();
+    curvatureFile.close();
+    bucketTriangles.close();
+
+    MappedFile curvatureData;
+    if (!curvatureData.open(curvatureFile.getFilename())) {
+        return;
+    }
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
+    if (writeOutOfCoreBinmesh(binaryFilename, mesh, globalNormals,
+            reinterpret_cast<const float*>(curvatureData.getData()), minCurvature, maxCurvature)) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Finished writing binary mesh.");
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIXELSYNCOIT_OUTOFCOREBINARYOBJLOADER_HPP
+#define PIXELSYNCOIT_OUTOFCOREBINARYOBJLOADER_HPP
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Estimates the peak amount of memory in bytes convertBinaryObjMeshToBinmesh needs for converting the passed .bobj
+ * file (without levels of detail). Only the header of the file is read.
+ * @return The estimate, or 0 if the file could not be read.
+ */
+size_t estimateBinaryObjConversionMemory(const std::string &bobjFilename);
+
+/**
+ * Converts the content of a binary OBJ file to the binmesh format like convertBinaryObjMeshToBinmesh, but for meshes
+ * too large to be processed in memory. The output is the same as the one of convertBinaryObjMeshToBinmesh without
+ * welding and levels of detail.
+ *
+ * The input file is memory-mapped, and the conversion works in two passes:
+ * 1. The triangles are sorted into the buckets of a uniform grid over the bounding box. Each vertex belongs to the
+ *    bucket containing it, and each triangle is stored (by its index) in the buckets of all of its vertices. Thus,
+ *    a bucket contains all triangles adjacent to its vertices, i.e., it includes the halo of triangles needed for
+ *    computing the normals and curvature of its vertices exactly. The grid resolution is chosen such that the data
+ *    of the largest bucket fits into the memory budget. The bucket lists are stored in a temporary file.
+ * 2. The buckets are processed one after another. First, the normals of all vertices are computed, then the
+ *    curvature, which needs the normals of the one-ring neighbors (including the ones of other buckets). The results
+ *    are scattered to temporary files indexed by the global vertex index, which stitches the buckets together.
+ * Finally, the binmesh file is written in chunks directly from the mapped input and temporary files.
+ *
+ * @param bobjFilename The filename of the .bobj file
+ * @param binaryFilename The filename of the binary output file. The temporary files are stored next to it.
+ * @param memoryBudget The approximate amount of memory in bytes the conversion may use (not counting the pages of
+ * the mapped files, which the operating system can evict).
+ */
+void convertBinaryObjMeshToBinmeshOutOfCore(
+        const std::string &bobjFilename,
+        const std::string &binaryFilename,
+        size_t memoryBudget);
+
+#endif //PIXELSYNCOIT_OUTOFCOREBINARYOBJLOADER_HPP
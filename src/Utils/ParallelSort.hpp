@@ -0,0 +1,75 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_PARALLELSORT_HPP
+#define PIXELSYNCOIT_PARALLELSORT_HPP
+
+#include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Sorts the values in ascending order using all OpenMP threads. Chunks of the array are sorted in parallel and then
+ * merged pairwise in parallel rounds. The result is the same as the one of std::sort for values without duplicates.
+ */
+template<class T>
+void parallelSort(std::vector<T> &values)
+{
+    int numChunks = 1;
+#ifdef _OPENMP
+    numChunks = omp_get_max_threads();
+#endif
+    const size_t chunkSize = (values.size() + size_t(numChunks) - 1) / size_t(numChunks);
+    if (numChunks <= 1 || chunkSize < 4096) {
+        std::sort(values.begin(), values.end());
+        return;
+    }
+
+    #pragma omp parallel for
+    for (int chunk = 0; chunk < numChunks; chunk++) {
+        size_t begin = std::min(size_t(chunk) * chunkSize, values.size());
+        size_t end = std::min(begin + chunkSize, values.size());
+        std::sort(values.begin() + begin, values.begin() + end);
+    }
+    for (size_t width = chunkSize; width < values.size(); width *= 2) {
+        const int numMerges = int((values.size() + 2 * width - 1) / (2 * width));
+        #pragma omp parallel for
+        for (int merge = 0; merge < numMerges; merge++) {
+            size_t begin = size_t(merge) * 2 * width;
+            size_t middle = std::min(begin + width, values.size());
+            size_t end = std::min(begin + 2 * width, values.size());
+            std::inplace_merge(values.begin() + begin, values.begin() + middle, values.begin() + end);
+        }
+    }
+}
+
+#endif //PIXELSYNCOIT_PARALLELSORT_HPP
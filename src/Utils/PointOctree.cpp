@@ -0,0 +1,317 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include "MeshSerializer.hpp"
+#include "ParallelSort.hpp"
+#include "PointOctree.hpp"
+
+const char *const POINT_OCTREE_UNIFORM_NAME = "pointOctreeNodes";
+
+// The Morton codes interleave 21 bits per axis.
+const int MORTON_BITS_PER_AXIS = 21;
+
+/// Spreads the lower 21 bits of the value such that two zero bits lie between each pair of consecutive bits.
+static inline uint64_t spreadBits(uint64_t value)
+{
+    value &= 0x1FFFFFu;
+    value = (value | (value << 32)) & 0x1F00000000FFFFull;
+    value = (value | (value << 16)) & 0x1F0000FF0000FFull;
+    value = (value | (value << 8)) & 0x100F00F00F00F00Full;
+    value = (value | (value << 4)) & 0x10C30C30C30C30C3ull;
+    value = (value | (value << 2)) & 0x1249249249249249ull;
+    return value;
+}
+
+typedef std::pair<uint64_t, uint32_t> MortonEntry;
+
+/// A node whose points are distributed to its own samples and its children in the next build step.
+struct PointOctreeBuildItem {
+    uint32_t nodeIndex;
+    size_t begin, end;
+    int depth;
+};
+
+void buildPointOctree(
+        const std::vector<glm::vec3> &positions, std::vector<uint32_t> &pointOrder,
+        std::vector<PointOctreeNode> &nodes, size_t nodeCapacity)
+{
+    const size_t numPoints = positions.size();
+    pointOrder.clear();
+    nodes.clear();
+    if (numPoints == 0) {
+        return;
+    }
+    nodeCapacity = std::max(nodeCapacity, size_t(1));
+
+    // The octree covers the bounding cube of the points.
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+    #pragma omp parallel for reduction(min: minX) reduction(min: minY) reduction(min: minZ) \
+            reduction(max: maxX) reduction(max: maxY) reduction(max: maxZ)
+    for (size_t i = 0; i < numPoints; i++) {
+        const glm::vec3 &p = positions[i];
+        minX = std::min(minX, p.x); minY = std::min(minY, p.y); minZ = std::min(minZ, p.z);
+        maxX = std::max(maxX, p.x); maxY = std::max(maxY, p.y); maxZ = std::max(maxZ, p.z);
+    }
+    const glm::vec3 cubeMin(minX, minY, minZ);
+    const float cubeSize = std::max(std::max(maxX - minX, maxY - minY), std::max(maxZ - minZ, FLT_MIN));
+
+    // Sort the points along the Morton curve. The cells subdivide the cube like the child bounds of the nodes, and
+    // the points on the upper faces of the cube are put into the last cell.
+    const uint64_t maxCell = (uint64_t(1) << MORTON_BITS_PER_AXIS) - 1u;
+    const float cellsPerUnit = float(uint64_t(1) << MORTON_BITS_PER_AXIS) / cubeSize;
+    std::vector<MortonEntry> entries(numPoints);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPoints; i++) {
+        glm::vec3 cell = (positions[i] - cubeMin) * cellsPerUnit;
+        uint64_t code = spreadBits(std::min(uint64_t(cell.x), maxCell))
+                | (spreadBits(std::min(uint64_t(cell.y), maxCell)) << 1)
+                | (spreadBits(std::min(uint64_t(cell.z), maxCell)) << 2);
+        entries[i] = MortonEntry(code, uint32_t(i));
+    }
+    parallelSort(entries);
+
+    // Build the octree level by level. All nodes of a level are processed in parallel.
+    PointOctreeNode root;
+    root.boundsMin = cubeMin;
+    root.boundsMax = cubeMin + glm::vec3(cubeSize);
+    root.firstPoint = 0;
+    root.numPoints = 0;
+    root.subtreeEnd = uint32_t(numPoints);
+    root.firstChild = 0;
+    root.numChildren = 0;
+    nodes.push_back(root);
+    std::vector<PointOctreeBuildItem> currentLevel = { PointOctreeBuildItem{ 0, 0, numPoints, 0 } };
+    while (!currentLevel.empty()) {
+        std::vector<std::vector<PointOctreeBuildItem>> childItems(currentLevel.size());
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t itemIdx = 0; itemIdx < currentLevel.size(); itemIdx++) {
+            const PointOctreeBuildItem &item = currentLevel[itemIdx];
+            PointOctreeNode &node = nodes[item.nodeIndex];
+            const size_t count = item.end - item.begin;
+            if (count <= nodeCapacity || item.depth >= MORTON_BITS_PER_AXIS) {
+                node.numPoints = uint32_t(count);
+                continue;
+            }
+
+            // Keep samples evenly spaced along the Morton curve and move them to the front of the range.
+            // The remaining points stay sorted.
+            std::vector<MortonEntry> samples, remaining;
+            samples.reserve(nodeCapacity);
+            remaining.reserve(count - nodeCapacity);
+            size_t nextSample = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (samples.size() < nodeCapacity && i == nextSample) {
+                    samples.push_back(entries[item.begin + i]);
+                    nextSample = (samples.size() * count) / nodeCapacity;
+                } else {
+                    remaining.push_back(entries[item.begin + i]);
+                }
+            }
+            std::copy(samples.begin(), samples.end(), entries.begin() + item.begin);
+            std::copy(remaining.begin(), remaining.end(), entries.begin() + item.begin + samples.size());
+            node.numPoints = uint32_t(samples.size());
+
+            // Split the remaining points by the next three bits of their Morton code.
+            const int shift = 3 * (MORTON_BITS_PER_AXIS - 1 - item.depth);
+            size_t childBegin = item.begin + samples.size();
+            while (childBegin < item.end) {
+                uint64_t octant = (entries[childBegin].first >> shift) & 7u;
+                size_t childEnd = childBegin + 1;
+                while (childEnd < item.end && ((entries[childEnd].first >> shift) & 7u) == octant) {
+                    childEnd++;
+                }
+                childItems[itemIdx].push_back(PointOctreeBuildItem{
+                        uint32_t(octant), childBegin, childEnd, item.depth + 1 });
+                childBegin = childEnd;
+            }
+        }
+
+        // Append the children in breadth-first order.
+        std::vector<PointOctreeBuildItem> nextLevel;
+        for (size_t itemIdx = 0; itemIdx < currentLevel.size(); itemIdx++) {
+            const uint32_t parentIndex = currentLevel[itemIdx].nodeIndex;
+            nodes[parentIndex].firstChild = uint32_t(nodes.size());
+            nodes[parentIndex].numChildren = uint32_t(childItems[itemIdx].size());
+            const glm::vec3 parentMin = nodes[parentIndex].boundsMin;
+            const glm::vec3 childSize = (nodes[parentIndex].boundsMax - parentMin) * 0.5f;
+            for (PointOctreeBuildItem childItem : childItems[itemIdx]) {
+                const uint32_t octant = childItem.nodeIndex;
+                PointOctreeNode child;
+                child.boundsMin = parentMin + glm::vec3(
+                        float(octant & 1u), float((octant >> 1) & 1u), float((octant >> 2) & 1u)) * childSize;
+                child.boundsMax = child.boundsMin + childSize;
+                child.firstPoint = uint32_t(childItem.begin);
+                child.numPoints = 0;
+                child.subtreeEnd = uint32_t(childItem.end);
+                child.firstChild = 0;
+                child.numChildren = 0;
+                childItem.nodeIndex = uint32_t(nodes.size());
+                nodes.push_back(child);
+                nextLevel.push_back(childItem);
+            }
+        }
+        currentLevel.swap(nextLevel);
+    }
+
+    pointOrder.resize(numPoints);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPoints; i++) {
+        pointOrder[i] = entries[i].second;
+    }
+}
+
+size_t selectPointOctreeNodes(
+        const std::vector<PointOctreeNode> &nodes, const glm::mat4 &modelViewMatrix,
+        const glm::mat4 &projectionMatrix, size_t pointBudget, std::vector<uint32_t> &selectedNodes)
+{
+    selectedNodes.clear();
+    if (nodes.empty()) {
+        return 0;
+    }
+
+    // The frustum planes in object space (Gribb/Hartmann). A point p is inside if dot(plane, (p, 1)) >= 0.
+    glm::mat4 mvpMatrix = projectionMatrix * modelViewMatrix;
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(mvpMatrix[0][i], mvpMatrix[1][i], mvpMatrix[2][i], mvpMatrix[3][i]);
+    }
+    glm::vec4 planes[6] = {
+            rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+            rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]
+    };
+    auto isVisible = [&planes](const PointOctreeNode &node) {
+        for (int i = 0; i < 6; i++) {
+            // The corner of the box farthest along the plane normal.
+            glm::vec3 corner(
+                    planes[i].x >= 0.0f ? node.boundsMax.x : node.boundsMin.x,
+                    planes[i].y >= 0.0f ? node.boundsMax.y : node.boundsMin.y,
+                    planes[i].z >= 0.0f ? node.boundsMax.z : node.boundsMin.z);
+            if (planes[i].x * corner.x + planes[i].y * corner.y + planes[i].z * corner.z + planes[i].w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // The priority of a node is its projected size, i.e., its radius divided by its distance to the camera.
+    float scale = glm::length(glm::vec3(modelViewMatrix[0]));
+    auto getPriority = [&modelViewMatrix, scale](const PointOctreeNode &node) {
+        glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+        glm::vec3 centerView = glm::vec3(modelViewMatrix * glm::vec4(center, 1.0f));
+        float radius = glm::length(node.boundsMax - center) * scale;
+        float distance = glm::length(centerView);
+        return distance <= radius ? FLT_MAX : radius / (distance - radius);
+    };
+
+    typedef std::pair<float, uint32_t> QueueEntry;
+    std::priority_queue<QueueEntry> queue;
+    if (isVisible(nodes.front())) {
+        queue.push(QueueEntry(getPriority(nodes.front()), 0u));
+    }
+    size_t numSelectedPoints = 0;
+    while (!queue.empty()) {
+        const PointOctreeNode &node = nodes.at(queue.top().second);
+        if (numSelectedPoints + node.numPoints > pointBudget) {
+            break;
+        }
+        selectedNodes.push_back(queue.top().second);
+        numSelectedPoints += node.numPoints;
+        queue.pop();
+        for (uint32_t childIdx = node.firstChild; childIdx < node.firstChild + node.numChildren; childIdx++) {
+            const PointOctreeNode &child = nodes.at(childIdx);
+            if (isVisible(child)) {
+                queue.push(QueueEntry(getPriority(child), childIdx));
+            }
+        }
+    }
+
+    std::sort(selectedNodes.begin(), selectedNodes.end());
+    return numSelectedPoints;
+}
+
+void getPointOctreeNodeIndices(
+        const std::vector<PointOctreeNode> &nodes, const std::vector<uint32_t> &selectedNodes,
+        std::vector<uint32_t> &indices)
+{
+    std::vector<size_t> indexOffsets(selectedNodes.size() + 1, 0);
+    for (size_t i = 0; i < selectedNodes.size(); i++) {
+        indexOffsets[i + 1] = indexOffsets[i] + nodes.at(selectedNodes[i]).numPoints;
+    }
+    indices.resize(indexOffsets.back());
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t i = 0; i < selectedNodes.size(); i++) {
+        const PointOctreeNode &node = nodes[selectedNodes[i]];
+        for (uint32_t j = 0; j < node.numPoints; j++) {
+            indices[indexOffsets[i] + j] = node.firstPoint + j;
+        }
+    }
+}
+
+void setSubmeshPointOctree(BinarySubMesh &submesh, const std::vector<PointOctreeNode> &nodes)
+{
+    for (auto it = submesh.uniforms.begin(); it != submesh.uniforms.end();) {
+        if (it->name == POINT_OCTREE_UNIFORM_NAME) {
+            it = submesh.uniforms.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (nodes.empty()) {
+        return;
+    }
+
+    BinaryMeshUniform nodesUniform;
+    nodesUniform.name = POINT_OCTREE_UNIFORM_NAME;
+    nodesUniform.attributeFormat = sgl::ATTRIB_UNSIGNED_BYTE;
+    nodesUniform.numComponents = sizeof(PointOctreeNode);
+    nodesUniform.data.resize(nodes.size() * sizeof(PointOctreeNode));
+    memcpy(&nodesUniform.data.front(), &nodes.front(), nodes.size() * sizeof(PointOctreeNode));
+    submesh.uniforms.push_back(nodesUniform);
+}
+
+bool getSubmeshPointOctree(const BinarySubMesh &submesh, std::vector<PointOctreeNode> &nodes)
+{
+    for (const BinaryMeshUniform &uniform : submesh.uniforms) {
+        if (uniform.name == POINT_OCTREE_UNIFORM_NAME && uniform.numComponents == sizeof(PointOctreeNode)
+                && !uniform.data.empty() && uniform.data.size() % sizeof(PointOctreeNode) == 0) {
+            nodes.resize(uniform.data.size() / sizeof(PointOctreeNode));
+            memcpy(&nodes.front(), &uniform.data.front(), uniform.data.size());
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,93 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_POINTOCTREE_HPP
+#define PIXELSYNCOIT_POINTOCTREE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+struct BinarySubMesh;
+
+/**
+ * An octree over a point data set for rendering it with a per-frame point budget.
+ * The points are sorted along a Morton curve, and the octree is built over the sorted points. Each inner node keeps
+ * a representative subsample of the points of its subtree (evenly spaced along the Morton curve), and the remaining
+ * points are passed on to its children. The points are stored such that the subtree of a node spans the contiguous
+ * range [firstPoint, subtreeEnd), where its own points [firstPoint, firstPoint + numPoints) come first.
+ * The nodes are stored in breadth-first order, with the children of a node stored contiguously.
+ */
+struct PointOctreeNode {
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    uint32_t firstPoint;
+    uint32_t numPoints;
+    uint32_t subtreeEnd;
+    uint32_t firstChild;
+    uint32_t numChildren;
+};
+
+/// The maximum number of (representative) points per node.
+const size_t POINT_OCTREE_NODE_CAPACITY = 8192;
+
+/**
+ * Builds the octree over the passed points.
+ * @param positions The point positions.
+ * @param pointOrder The order in which the points need to be stored for the octree (new index -> old index).
+ * @param nodes The nodes of the octree. The point ranges refer to the reordered points.
+ */
+void buildPointOctree(
+        const std::vector<glm::vec3> &positions, std::vector<uint32_t> &pointOrder,
+        std::vector<PointOctreeNode> &nodes, size_t nodeCapacity = POINT_OCTREE_NODE_CAPACITY);
+
+/**
+ * Selects the nodes to render: Starting at the root, the visible nodes with the largest projected size are selected
+ * until the next node would exceed the point budget. Nodes outside of the view frustum are culled.
+ * @param selectedNodes The indices of the selected nodes in ascending order.
+ * @return The number of selected points.
+ */
+size_t selectPointOctreeNodes(
+        const std::vector<PointOctreeNode> &nodes, const glm::mat4 &modelViewMatrix,
+        const glm::mat4 &projectionMatrix, size_t pointBudget, std::vector<uint32_t> &selectedNodes);
+
+/**
+ * Creates the index buffer data for rendering the points of the selected nodes.
+ */
+void getPointOctreeNodeIndices(
+        const std::vector<PointOctreeNode> &nodes, const std::vector<uint32_t> &selectedNodes,
+        std::vector<uint32_t> &indices);
+
+/// Stores the octree in the uniforms of the submesh containing the (reordered) points.
+void setSubmeshPointOctree(BinarySubMesh &submesh, const std::vector<PointOctreeNode> &nodes);
+/// @return False if the submesh stores no octree.
+bool getSubmeshPointOctree(const BinarySubMesh &submesh, std::vector<PointOctreeNode> &nodes);
+
+#endif //PIXELSYNCOIT_POINTOCTREE_HPP
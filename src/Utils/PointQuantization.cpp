@@ -0,0 +1,143 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+#include "MeshSerializer.hpp"
+#include "PointQuantization.hpp"
+
+const float QUANTIZATION_MAX = 65535.0f;
+
+/// The size of the quantization steps of the node in each axis.
+static inline glm::vec3 getNodeStepSize(const PointOctreeNode &node)
+{
+    return glm::max(node.boundsMax - node.boundsMin, glm::vec3(FLT_MIN)) / QUANTIZATION_MAX;
+}
+
+void quantizePointSubmesh(BinarySubMesh &submesh, const std::vector<PointOctreeNode> &nodes, int attributeBits)
+{
+    for (BinaryMeshAttribute &attribute : submesh.attributes) {
+        if (attribute.name == "vertexPosition" && attribute.attributeFormat == sgl::ATTRIB_FLOAT
+                && attribute.numComponents == 3) {
+            const glm::vec3 *positions = (const glm::vec3*)&attribute.data.front();
+            std::vector<uint8_t> quantizedData(attribute.data.size() / sizeof(glm::vec3) * 3 * sizeof(uint16_t));
+            uint16_t *quantizedPositions = (uint16_t*)&quantizedData.front();
+
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (size_t nodeIdx = 0; nodeIdx < nodes.size(); nodeIdx++) {
+                const PointOctreeNode &node = nodes[nodeIdx];
+                const glm::vec3 invStepSize = glm::vec3(1.0f) / getNodeStepSize(node);
+                for (uint32_t i = node.firstPoint; i < node.firstPoint + node.numPoints; i++) {
+                    glm::vec3 localPosition = (positions[i] - node.boundsMin) * invStepSize;
+                    for (int c = 0; c < 3; c++) {
+                        float value = std::min(std::max(std::round(localPosition[c]), 0.0f), QUANTIZATION_MAX);
+                        quantizedPositions[i * 3 + c] = uint16_t(value);
+                    }
+                }
+            }
+
+            attribute.name = QUANTIZED_POSITION_ATTRIBUTE_NAME;
+            attribute.attributeFormat = sgl::ATTRIB_UNSIGNED_SHORT;
+            attribute.data.swap(quantizedData);
+        } else if (attributeBits == 8 && attribute.numComponents == 1
+                && attribute.attributeFormat == sgl::ATTRIB_UNSIGNED_SHORT) {
+            const uint16_t *values16 = (const uint16_t*)&attribute.data.front();
+            size_t numValues = attribute.data.size() / sizeof(uint16_t);
+            std::vector<uint8_t> values8(numValues);
+            #pragma omp parallel for
+            for (size_t i = 0; i < numValues; i++) {
+                values8[i] = uint8_t((uint32_t(values16[i]) * 255u + 32767u) / 65535u);
+            }
+            attribute.attributeFormat = sgl::ATTRIB_UNSIGNED_BYTE;
+            attribute.data.swap(values8);
+        }
+    }
+}
+
+bool isQuantizedPointSubmesh(const BinarySubMesh &submesh)
+{
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        if (attribute.name == QUANTIZED_POSITION_ATTRIBUTE_NAME) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void getPointQuantizationNodes(
+        const std::vector<PointOctreeNode> &nodes, std::vector<PointQuantizationNode> &quantizationNodes)
+{
+    quantizationNodes.clear();
+    quantizationNodes.reserve(nodes.size());
+    for (const PointOctreeNode &node : nodes) {
+        if (node.numPoints == 0) {
+            continue;
+        }
+        PointQuantizationNode quantizationNode;
+        quantizationNode.boundsMin = node.boundsMin;
+        quantizationNode.firstPoint = node.firstPoint;
+        quantizationNode.boundsExtent = getNodeStepSize(node) * QUANTIZATION_MAX;
+        quantizationNode.padding = 0;
+        quantizationNodes.push_back(quantizationNode);
+    }
+    std::sort(quantizationNodes.begin(), quantizationNodes.end(),
+            [](const PointQuantizationNode &node0, const PointQuantizationNode &node1) {
+        return node0.firstPoint < node1.firstPoint;
+    });
+}
+
+sgl::AABB3 computeQuantizedPointsAABB(const BinarySubMesh &submesh, const std::vector<PointOctreeNode> &nodes)
+{
+    sgl::AABB3 aabb(glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        if (attribute.name != QUANTIZED_POSITION_ATTRIBUTE_NAME) {
+            continue;
+        }
+        const uint16_t *quantizedPositions = (const uint16_t*)&attribute.data.front();
+        // Only the extreme quantized values of each node need to be decoded.
+        for (const PointOctreeNode &node : nodes) {
+            if (node.numPoints == 0) {
+                continue;
+            }
+            glm::uvec3 minValue(65535u), maxValue(0u);
+            for (uint32_t i = node.firstPoint; i < node.firstPoint + node.numPoints; i++) {
+                for (int c = 0; c < 3; c++) {
+                    minValue[c] = std::min(minValue[c], uint32_t(quantizedPositions[i * 3 + c]));
+                    maxValue[c] = std::max(maxValue[c], uint32_t(quantizedPositions[i * 3 + c]));
+                }
+            }
+            glm::vec3 stepSize = getNodeStepSize(node);
+            aabb.combine(node.boundsMin + glm::vec3(minValue) * stepSize);
+            aabb.combine(node.boundsMin + glm::vec3(maxValue) * stepSize);
+        }
+    }
+    return aabb;
+}
@@ -0,0 +1,86 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_POINTQUANTIZATION_HPP
+#define PIXELSYNCOIT_POINTQUANTIZATION_HPP
+
+#include <vector>
+
+#include <Math/Geometry/AABB3.hpp>
+
+#include "PointOctree.hpp"
+
+struct BinarySubMesh;
+
+/**
+ * Compact storage of point data sets sorted into an octree (see PointOctree.hpp).
+ * The point positions are stored as 16-bit fixed-point coordinates local to the bounds of the octree node the point
+ * belongs to ("vertexPositionQuantized", three unsigned shorts per point). As the octree nodes are stored in the
+ * submesh anyway, no additional data is needed for decoding. The scalar point attributes (unorm16) are optionally
+ * reduced to 8 bits. This needs 7 or 8 instead of 14 bytes per point.
+ * The data stays quantized on the GPU: The positions are fetched as normalized unsigned shorts and decoded in the
+ * vertex shader with the bounds of their node (see QUANTIZED_POINT_POSITIONS in PseudoPhongPoints.glsl).
+ */
+const char *const QUANTIZED_POSITION_ATTRIBUTE_NAME = "vertexPositionQuantized";
+
+/// The shader storage buffer binding point of the node bounds used for decoding the positions in the vertex shader.
+const int POINT_QUANTIZATION_NODE_BUFFER_BINDING = 7;
+
+/**
+ * The decoding data of one octree node in the std430 layout of PseudoPhongPoints.glsl. A point with the normalized
+ * quantized position q in [0,1]^3 lies at boundsMin + q * boundsExtent.
+ */
+struct PointQuantizationNode {
+    glm::vec3 boundsMin;
+    uint32_t firstPoint;
+    glm::vec3 boundsExtent;
+    uint32_t padding;
+};
+
+/**
+ * Replaces the float positions of the point submesh by their quantized version.
+ * @param nodes The octree of the points stored in the submesh.
+ * @param attributeBits The precision of the scalar attributes (8 or 16 bits).
+ */
+void quantizePointSubmesh(BinarySubMesh &submesh, const std::vector<PointOctreeNode> &nodes, int attributeBits = 16);
+
+/// @return True if the positions of the submesh are stored quantized.
+bool isQuantizedPointSubmesh(const BinarySubMesh &submesh);
+
+/**
+ * Returns the decoding data of all non-empty octree nodes sorted by their first point, such that the vertex shader
+ * can find the node of a point with a binary search.
+ */
+void getPointQuantizationNodes(
+        const std::vector<PointOctreeNode> &nodes, std::vector<PointQuantizationNode> &quantizationNodes);
+
+/// Computes the bounding box of the quantized points without decoding all of them.
+sgl::AABB3 computeQuantizedPointsAABB(const BinarySubMesh &submesh, const std::vector<PointOctreeNode> &nodes);
+
+#endif //PIXELSYNCOIT_POINTQUANTIZATION_HPP
@@ -26,20 +26,26 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
 #include "import_uintah.h"
 #include "import_cosmic_web.h"
 #include "../MeshSerializer.hpp"
 #include "../ImportanceCriteria.hpp"
+#include "../PointOctree.hpp"
+#include "../PointQuantization.hpp"
 #include "PointFileLoader.hpp"
 
 // timestep.xml -> uintah
 // .dat -> cosmic_web
+// directory -> all cosmic_web bricks (.dat) in it
 
 void convertPointDataSetToBinmesh(
         const std::string &inputFilename,
-        const std::string &binaryFilename) {
+        const std::string &binaryFilename,
+        int attributeBits) {
     sgl::Logfile::get()->writeInfo(std::string() + "Loading point data from \"" + inputFilename + "\"...");
 
     pl::ParticleModel particleModel;
@@ -47,6 +53,21 @@ void convertPointDataSetToBinmesh(
         pl::import_uintah(pl::FileName(inputFilename), particleModel);
     } else if (boost::ends_with(inputFilename, ".dat")) {
         pl::import_cosmic_web(pl::FileName(inputFilename), particleModel);
+    } else if (sgl::FileUtils::get()->isDirectory(inputFilename)) {
+        std::vector<std::string> filenames = sgl::FileUtils::get()->getFilesInDirectoryVector(inputFilename);
+        std::sort(filenames.begin(), filenames.end());
+        std::vector<pl::FileName> brickFilenames;
+        for (const std::string &filename : filenames) {
+            if (boost::ends_with(filename, ".dat")) {
+                brickFilenames.push_back(pl::FileName(filename));
+            }
+        }
+        if (brickFilenames.empty()) {
+            sgl::Logfile::get()->writeError(
+                    std::string() + "Error: No cosmic web bricks found in \"" + inputFilename + "\"!");
+            return;
+        }
+        pl::import_cosmic_web_bricks(brickFilenames, particleModel);
     } else {
         sgl::Logfile::get()->writeError(
                 std::string() + "Error: Unknown point data set file association for \""
@@ -82,6 +103,19 @@ void convertPointDataSetToBinmesh(
         positionValues[i] = (oldPoint - aabb.getCenter()) / largestAxis;
     }
 
+    // Sort the points into an octree whose nodes store subsamples of the points below them (see PointOctree.hpp).
+    // The points are stored in the order of the octree, so every node references a contiguous range of points.
+    sgl::Logfile::get()->writeInfo(std::string() + "Building point octree...");
+    std::vector<glm::vec3> unsortedPositions(positionValues, positionValues + numPoints);
+    std::vector<uint32_t> pointOrder;
+    std::vector<PointOctreeNode> octreeNodes;
+    buildPointOctree(unsortedPositions, pointOrder, octreeNodes);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPoints; i++) {
+        positionValues[i] = unsortedPositions[pointOrder[i]];
+    }
+    std::vector<glm::vec3>().swap(unsortedPositions);
+
     // Create a binary mesh from the data.
     BinaryMesh binaryMesh;
     binaryMesh.submeshes.resize(1);
@@ -135,8 +169,14 @@ void convertPointDataSetToBinmesh(
         packUnorm16Array(velocityMagnitudes, vertexAttributeData);
     }
     vertexAttribute.data.resize(vertexAttributeData.size() * sizeof(uint16_t));
-    memcpy(&vertexAttribute.data.front(), &vertexAttributeData.front(), vertexAttributeData.size() * sizeof(uint16_t));
+    uint16_t *sortedAttributeData = (uint16_t*)&vertexAttribute.data.front();
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPoints; i++) {
+        sortedAttributeData[i] = vertexAttributeData[pointOrder[i]];
+    }
     binarySubmesh.attributes.push_back(vertexAttribute);
+    setSubmeshPointOctree(binarySubmesh, octreeNodes);
+    quantizePointSubmesh(binarySubmesh, octreeNodes, attributeBits);
 
     // TODO: Test
     /*BinaryMeshAttribute positionAttribute;
@@ -33,11 +33,15 @@
  * File associations:
  * - timestep.xml -> uintah data set
  * - .dat -> cosmic_web data set
+ * - directory -> all bricks (.dat files) of the cosmic_web data set in it, loaded in parallel
  * @param inputFilename The file name of the input data set.
  * @param binaryFilename: The file name of the binary output file.
+ * @param attributeBits: The precision of the stored point attribute (8 or 16 bits). The positions are always stored
+ * quantized to 16 bits per axis local to their octree node (see PointQuantization.hpp).
  */
 void convertPointDataSetToBinmesh(
         const std::string &inputFilename,
-        const std::string &binaryFilename);
+        const std::string &binaryFilename,
+        int attributeBits = 16);
 
 #endif //PIXELSYNCOIT_POINTFILELOADER_HPP
@@ -2,6 +2,9 @@
 #include <algorithm>
 #include <limits>
 #include <fstream>
+#include <memory>
+#include <cstring>
+#include "../MappedFile.hpp"
 #include "import_cosmic_web.h"
 
 using namespace pl;
@@ -32,22 +35,12 @@ std::ostream& operator<<(std::ostream &os, const CosmicWebHeader &h) {
 	return os;
 }
 
-void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
-	std::ifstream fin(file_name.c_str(), std::ios::binary);
-
-	if (!fin.good()) {
-		throw std::runtime_error("could not open particle data file " + file_name.file_name);
-	}
-
-	CosmicWebHeader header;
-	if (!fin.read(reinterpret_cast<char*>(&header), sizeof(CosmicWebHeader))) {
-		throw std::runtime_error("Failed to read header");
-	}
-
-	std::cout << "Cosmic Web Header: " << header << "\n";
-
-	// Compute the brick offset for this file, given in the last 3 numbers of the name
+// Compute the brick offset for this file, given in the last 3 numbers of the name
+static vec3f brick_offset(const FileName &file_name) {
 	std::string brick_name = file_name.name();
+	if (brick_name.size() < 3) {
+		throw std::runtime_error("invalid cosmic web brick file name " + file_name.file_name);
+	}
 	brick_name = brick_name.substr(brick_name.size() - 3, 3);
 	const int brick_number = std::stoi(brick_name);
 
@@ -55,39 +48,90 @@ void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
 	const int brick_z = brick_number / 64;
 	const int brick_y = (brick_number / 8) % 8;
 	const int brick_x = brick_number % 8;
-	std::cout << "Brick position = { " << brick_x << ", " << brick_y
-		<< ", " << brick_z << " }\n";
 
 	// Each cell is 768x768x768 units
 	const float step = 768.f;
-	const vec3f offset(step * brick_x, step * brick_y, step * brick_z);
+	return vec3f(step * brick_x, step * brick_y, step * brick_z);
+}
 
-	auto positions = std::make_shared<DataT<float>>();
-	auto velocities = std::make_shared<DataT<float>>();
-	positions->data.reserve(header.np_local * 3);
-	velocities->data.reserve(header.np_local * 3);
+void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
+	import_cosmic_web_bricks(std::vector<FileName>{file_name}, model);
+}
 
-	std::vector<char> file_data(header.np_local * 2 * sizeof(vec3f), 0);
-	if (!fin.read(file_data.data(), file_data.size())) {
-		throw std::runtime_error("Failed to read cosmic web file");
+void pl::import_cosmic_web_bricks(const std::vector<FileName> &brick_files, ParticleModel &model) {
+	// Map all bricks and compute where their particles go in the output arrays
+	const size_t num_bricks = brick_files.size();
+	std::vector<std::unique_ptr<MappedFile>> files(num_bricks);
+	std::vector<vec3f> offsets(num_bricks);
+	std::vector<size_t> particle_offsets(num_bricks + 1, 0);
+	for (size_t i = 0; i < num_bricks; ++i) {
+		files[i] = std::unique_ptr<MappedFile>(new MappedFile);
+		if (!files[i]->open(brick_files[i].file_name)) {
+			throw std::runtime_error("could not open particle data file " + brick_files[i].file_name);
+		}
+		if (files[i]->getSize() < sizeof(CosmicWebHeader)) {
+			throw std::runtime_error("Failed to read header of " + brick_files[i].file_name);
+		}
+
+		CosmicWebHeader header;
+		std::memcpy(&header, files[i]->getData(), sizeof(CosmicWebHeader));
+		if (num_bricks == 1) {
+			std::cout << "Cosmic Web Header: " << header << "\n";
+		}
+		if (header.np_local < 0 || files[i]->getSize()
+				< sizeof(CosmicWebHeader) + size_t(header.np_local) * 2 * sizeof(vec3f)) {
+			throw std::runtime_error("Failed to read cosmic web file " + brick_files[i].file_name);
+		}
+
+		offsets[i] = brick_offset(brick_files[i]);
+		if (num_bricks == 1) {
+			std::cout << "Brick position = { " << offsets[i].x / 768.f << ", " << offsets[i].y / 768.f
+				<< ", " << offsets[i].z / 768.f << " }\n";
+		}
+		particle_offsets[i + 1] = particle_offsets[i] + size_t(header.np_local);
 	}
+	const size_t num_particles = particle_offsets[num_bricks];
+	std::cout << "Loading " << num_particles << " particles from " << num_bricks << " bricks\n";
 
-	vec3f *vecs = reinterpret_cast<vec3f*>(file_data.data());
-
-	for (int i = 0; i < header.np_local; ++i) { 
-		const vec3f position = vecs[i * 2] + offset;
-		const vec3f velocity = vecs[i * 2 + 1];
-
-		positions->data.push_back(position.x);
-		positions->data.push_back(position.y);
-		positions->data.push_back(position.z);
+	auto positions = std::make_shared<DataT<float>>();
+	auto velocities = std::make_shared<DataT<float>>();
+	positions->data.resize(num_particles * 3);
+	velocities->data.resize(num_particles * 3);
+
+	// Split the bricks into chunks, so that also a few large bricks are decoded by all threads
+	const size_t chunk_size = 1 << 20;
+	std::vector<std::pair<size_t, size_t>> chunks;
+	for (size_t i = 0; i < num_bricks; ++i) {
+		const size_t brick_particles = particle_offsets[i + 1] - particle_offsets[i];
+		for (size_t begin = 0; begin < brick_particles; begin += chunk_size) {
+			chunks.push_back(std::make_pair(i, begin));
+		}
+	}
 
-		velocities->data.push_back(velocity.x);
-		velocities->data.push_back(velocity.y);
-		velocities->data.push_back(velocity.z);
+	// The particles are stored as interleaved (position, velocity) pairs. The files are only
+	// touched here, so the page faults of the mappings are spread over all threads.
+	float *position_data = positions->data.data();
+	float *velocity_data = velocities->data.data();
+	#pragma omp parallel for schedule(dynamic)
+	for (size_t c = 0; c < chunks.size(); ++c) {
+		const size_t brick = chunks[c].first;
+		const size_t begin = chunks[c].second;
+		const size_t end = std::min(begin + chunk_size, particle_offsets[brick + 1] - particle_offsets[brick]);
+		const uint8_t *particles = files[brick]->getData() + sizeof(CosmicWebHeader);
+		const vec3f &offset = offsets[brick];
+		for (size_t i = begin; i < end; ++i) {
+			vec3f vecs[2];
+			std::memcpy(vecs, particles + i * 2 * sizeof(vec3f), 2 * sizeof(vec3f));
+			const size_t out = (particle_offsets[brick] + i) * 3;
+			position_data[out] = vecs[0].x + offset.x;
+			position_data[out + 1] = vecs[0].y + offset.y;
+			position_data[out + 2] = vecs[0].z + offset.z;
+			velocity_data[out] = vecs[1].x;
+			velocity_data[out + 1] = vecs[1].y;
+			velocity_data[out + 2] = vecs[1].z;
+		}
 	}
 
 	model["positions"] = std::move(positions);
 	model["velocities"] = std::move(velocities);
 }
-
@@ -7,5 +7,10 @@ namespace pl {
 // Import a single brick of the cosmic web dataset into the model
 void import_cosmic_web(const FileName &file_name, ParticleModel &model);
 
+// Import multiple bricks of the cosmic web dataset into the model. The brick files are
+// memory-mapped, and the bricks are decoded and offset concurrently directly into the
+// preallocated positions and velocities arrays (in the order of brick_files).
+void import_cosmic_web_bricks(const std::vector<FileName> &brick_files, ParticleModel &model);
+
 }
 
@@ -5,9 +5,23 @@
 #include <cstdlib>
 #include <cstdio>
 #include <limits>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
 #include "tinyxml2.h"
 #include "import_uintah.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define UINTAH_USE_PREAD
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UINTAH_USE_SSE2
+#endif
+
 using namespace pl;
 using namespace tinyxml2;
 
@@ -15,6 +29,23 @@ struct UintahPatch {
 	vec3f lower;
 };
 
+enum UintahVariableType {
+	UINTAH_POSITIONS, UINTAH_DOUBLE, UINTAH_FLOAT, UINTAH_LONG64
+};
+
+// A read of (a part of) the data of one variable of a patch. The XML metadata is parsed
+// first, and the reads are then executed in parallel directly into the output arrays.
+struct UintahReadJob {
+	FileName file_name;
+	std::string variable;
+	UintahVariableType type;
+	// Byte offset of the data in the file
+	size_t start;
+	size_t num_particles;
+	// Offset of the first particle in the output array
+	size_t offset;
+};
+
 bool uintah_is_big_endian = false;
 
 std::string tinyxml_error_string(const XMLError e){
@@ -58,94 +89,189 @@ std::string tinyxml_error_string(const XMLError e){
 			return "XML_SUCCESS";
 	}
 }
-double ntohd(double d){
-	double ret = 0;
-	char *in = reinterpret_cast<char*>(&d);
-	char *out = reinterpret_cast<char*>(&ret);
-	for (int i = 0; i < 8; ++i){
-		out[i] = in[7 - i];
+// Swap the byte order of n 32 bit values in place
+void byte_swap_32(void *values, size_t n){
+	uint8_t *bytes = static_cast<uint8_t*>(values);
+	size_t i = 0;
+#ifdef UINTAH_USE_SSE2
+	// Reverse the 16 bit words of each value, then swap the bytes of each word
+	for (; i + 4 <= n; i += 4){
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i * 4));
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 4), v);
+	}
+#endif
+	for (; i < n; ++i){
+		uint32_t v;
+		std::memcpy(&v, bytes + i * 4, 4);
+		v = (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+		std::memcpy(bytes + i * 4, &v, 4);
 	}
-	return ret;
 }
-float ntohf(float f){
-	float ret = 0;
-	char *in = reinterpret_cast<char*>(&f);
-	char *out = reinterpret_cast<char*>(&ret);
-	for (int i = 0; i < 4; ++i){
-		out[i] = in[3 - i];
+// Swap the byte order of n 64 bit values in place
+void byte_swap_64(void *values, size_t n){
+	uint8_t *bytes = static_cast<uint8_t*>(values);
+	size_t i = 0;
+#ifdef UINTAH_USE_SSE2
+	for (; i + 2 <= n; i += 2){
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i * 8));
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 8), v);
+	}
+#endif
+	for (; i < n; ++i){
+		uint8_t *b = bytes + i * 8;
+		std::reverse(b, b + 8);
 	}
-	return ret;
 }
-bool read_particles(const FileName &file_name, Data *pos_data, const size_t num_particles,
-		const size_t start, const size_t end) {
-	auto *positions = static_cast<DataT<float>*>(pos_data);
-	assert(positions);
-	// TODO: Would mmap'ing the file at the start and keeping each new file we encounter
-	// mapped be faster than fopen/fread/fclose?
-	FILE *fp = fopen(file_name.file_name.c_str(), "rb");
+// Read len bytes at the byte offset start of the file. Safe to call concurrently.
+bool read_at(const FileName &file_name, const size_t start, const size_t len, void *dst){
+#ifdef UINTAH_USE_PREAD
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0){
+		std::cout << "Failed to open Uintah data file '" << file_name << "'\n";
+		return false;
+	}
+	size_t done = 0;
+	while (done < len){
+		ssize_t n = pread(fd, static_cast<char*>(dst) + done, len - done, off_t(start + done));
+		if (n <= 0){
+			break;
+		}
+		done += size_t(n);
+	}
+	close(fd);
+#else
+	FILE *fp = fopen(file_name.c_str(), "rb");
 	if (!fp){
 		std::cout << "Failed to open Uintah data file '" << file_name << "'\n";
 		return false;
 	}
+#if defined(_WIN32)
+	_fseeki64(fp, start, SEEK_SET);
+#else
 	fseek(fp, start, SEEK_SET);
-	size_t len = end - start;
-	if (len != num_particles * sizeof(double) * 3){
-		std::cout << "Length of data != expected length of particle data\n";
+#endif
+	size_t done = fread(dst, 1, len, fp);
+	fclose(fp);
+#endif
+	if (done != len){
+		std::cout << "Error reading particle data from file '" << file_name << "'\n";
 		return false;
-		fclose(fp);
 	}
-
-	double position[3];
-	for (size_t i = 0; i < num_particles; ++i){
-		if (fread(position, sizeof(position), 1, fp) != 1){
-			std::cout << "Error reading particle from file\n";
-			fclose(fp);
-			return false;
+	return true;
+}
+// Read the particles [first, first + count) of a job into the output array
+bool execute_read_job(const UintahReadJob &job, const size_t first, const size_t count,
+		ParticleModel &model, std::vector<double> &buffer)
+{
+	Data *data = model.at(job.variable).get();
+	const size_t out = job.offset + first;
+	switch (job.type){
+		case UINTAH_POSITIONS: {
+			// Positions are stored as doubles and converted to float
+			buffer.resize(count * 3);
+			if (!read_at(job.file_name, job.start + first * 3 * sizeof(double),
+					count * 3 * sizeof(double), buffer.data())){
+				return false;
+			}
+			if (uintah_is_big_endian){
+				byte_swap_64(buffer.data(), count * 3);
+			}
+			float *positions = static_cast<DataT<float>*>(data)->data.data() + out * 3;
+			for (size_t i = 0; i < count * 3; ++i){
+				positions[i] = static_cast<float>(buffer[i]);
+			}
+			return true;
+		}
+		case UINTAH_DOUBLE: {
+			double *dst = static_cast<DataT<double>*>(data)->data.data() + out;
+			if (!read_at(job.file_name, job.start + first * sizeof(double), count * sizeof(double), dst)){
+				return false;
+			}
+			if (uintah_is_big_endian){
+				byte_swap_64(dst, count);
+			}
+			return true;
 		}
-		if (uintah_is_big_endian){
-			position[0] = ntohd(position[0]);
-			position[1] = ntohd(position[1]);
-			position[2] = ntohd(position[2]);
+		case UINTAH_FLOAT: {
+			float *dst = static_cast<DataT<float>*>(data)->data.data() + out;
+			if (!read_at(job.file_name, job.start + first * sizeof(float), count * sizeof(float), dst)){
+				return false;
+			}
+			if (uintah_is_big_endian){
+				byte_swap_32(dst, count);
+			}
+			return true;
+		}
+		case UINTAH_LONG64: {
+			int64_t *dst = static_cast<DataT<int64_t>*>(data)->data.data() + out;
+			if (!read_at(job.file_name, job.start + first * sizeof(int64_t), count * sizeof(int64_t), dst)){
+				return false;
+			}
+			if (uintah_is_big_endian){
+				byte_swap_64(dst, count);
+			}
+			return true;
 		}
-		positions->data.push_back(static_cast<float>(position[0]));
-		positions->data.push_back(static_cast<float>(position[1]));
-		positions->data.push_back(static_cast<float>(position[2]));
 	}
-	fclose(fp);
-	return true;
+	return false;
 }
-template<typename In, typename Out = In>
-bool read_particle_attribute(const FileName &file_name, Data *attrib_data, const size_t num_particles,
-		const size_t start, const size_t end){
-	auto attribs = static_cast<DataT<Out>*>(attrib_data);
-	// TODO: Would mmap'ing the file at the start and keeping each new file we encounter
-	// mapped be faster than fopen/fread/fclose?
-	FILE *fp = fopen(file_name.file_name.c_str(), "rb");
-	if (!fp){
-		std::cout << "Failed to open Uintah data file '" << file_name << "'\n";
-		return false;
+// Compute the output ranges of the jobs from the XML metadata, allocate the output arrays
+// and execute the reads in parallel
+bool execute_read_jobs(std::vector<UintahReadJob> &jobs, ParticleModel &model){
+	// The particles of each variable are stored in the order of the jobs, after any
+	// particles already in the model
+	std::unordered_map<std::string, size_t> num_particles;
+	for (auto &job : jobs){
+		if (num_particles.find(job.variable) == num_particles.end()){
+			const size_t components = job.type == UINTAH_POSITIONS ? 3 : 1;
+			num_particles[job.variable] = model[job.variable]->size() / components;
+		}
+		job.offset = num_particles[job.variable];
+		num_particles[job.variable] += job.num_particles;
 	}
-	fseek(fp, start, SEEK_SET);
-	size_t len = end - start;
-	if (len != num_particles * sizeof(In)){
-		std::cout << "Length of data != expected length of particle data\n";
-		return false;
-		fclose(fp);
+	for (const auto &var : num_particles){
+		Data *data = model[var.first].get();
+		if (data->type() == typeid(float)){
+			const size_t components = var.first == "positions" ? 3 : 1;
+			static_cast<DataT<float>*>(data)->data.resize(var.second * components);
+		} else if (data->type() == typeid(double)){
+			static_cast<DataT<double>*>(data)->data.resize(var.second);
+		} else if (data->type() == typeid(int64_t)){
+			static_cast<DataT<int64_t>*>(data)->data.resize(var.second);
+		}
 	}
 
-	std::vector<In> data(num_particles, In());
-	if (fread(data.data(), sizeof(In), num_particles, fp) != num_particles){
-		std::cout << "Error reading particle attribute from file\n";
-		fclose(fp);
-		return false;
+	// Split large patches, so that the work is balanced over the threads
+	const size_t chunk_size = 1 << 18;
+	std::vector<std::pair<size_t, size_t>> chunks;
+	for (size_t j = 0; j < jobs.size(); ++j){
+		for (size_t first = 0; first < jobs[j].num_particles; first += chunk_size){
+			chunks.push_back(std::make_pair(j, first));
+		}
 	}
-	fclose(fp);
-	std::transform(data.begin(), data.end(), std::back_inserter(attribs->data),
-			[](const In &t){ return static_cast<Out>(t); });
-	return true;
+
+	int num_failed = 0;
+	#pragma omp parallel
+	{
+		std::vector<double> buffer;
+		#pragma omp for schedule(dynamic) reduction(+:num_failed)
+		for (size_t c = 0; c < chunks.size(); ++c){
+			const UintahReadJob &job = jobs[chunks[c].first];
+			const size_t first = chunks[c].second;
+			const size_t count = std::min(chunk_size, job.num_particles - first);
+			if (!execute_read_job(job, first, count, model, buffer)){
+				num_failed++;
+			}
+		}
+	}
+	return num_failed == 0;
 }
 bool read_uintah_particle_variable(const FileName &base_path, XMLElement *elem,
-		ParticleModel &model)
+		ParticleModel &model, std::vector<UintahReadJob> &jobs)
 {
 	std::string type;
 	{
@@ -223,6 +349,13 @@ bool read_uintah_particle_variable(const FileName &base_path, XMLElement *elem,
 			variable = "positions";
 		}
 		const bool need_new_array = model.find(variable) == model.end();
+		UintahReadJob job;
+		job.file_name = base_path.join(FileName(file_name));
+		job.variable = variable;
+		job.start = start;
+		job.num_particles = num_particles;
+		job.offset = 0;
+		size_t value_size = 0;
 		// Particle positions are p.x, rename them to position when we load them
 		// TODO: This should handle arbitrary ParticleVariable<Point> types
 		if (variable == "positions"){
@@ -230,31 +363,39 @@ bool read_uintah_particle_variable(const FileName &base_path, XMLElement *elem,
 				std::cout << "new positions array\n";
 				model["positions"] = std::make_shared<DataT<float>>();
 			}
-			return read_particles(base_path.join(FileName(file_name)),
-					model["positions"].get(), num_particles, start, end);
+			job.type = UINTAH_POSITIONS;
+			value_size = sizeof(double) * 3;
 		} else if (type == "ParticleVariable<double>"){
 			if (need_new_array) {
 				model[variable] = std::make_shared<DataT<double>>();
 			}
-			return read_particle_attribute<double>(base_path.join(FileName(file_name)),
-					model[variable].get(), num_particles, start, end);
+			job.type = UINTAH_DOUBLE;
+			value_size = sizeof(double);
 		} else if (type == "ParticleVariable<float>"){
 			if (need_new_array) {
 				model[variable] = std::make_shared<DataT<float>>();
 			}
-			return read_particle_attribute<float>(base_path.join(FileName(file_name)),
-					model[variable].get(), num_particles, start, end);
+			job.type = UINTAH_FLOAT;
+			value_size = sizeof(float);
 		} else if (type == "ParticleVariable<long64>"){
 			if (need_new_array) {
 				model[variable] = std::make_shared<DataT<int64_t>>();
 			}
-			return read_particle_attribute<int64_t>(base_path.join(FileName(file_name)),
-					model[variable].get(), num_particles, start, end);
+			job.type = UINTAH_LONG64;
+			value_size = sizeof(int64_t);
+		} else {
+			return true;
 		}
+		if (end < start || end - start != num_particles * value_size){
+			std::cout << "Length of data != expected length of particle data\n";
+			return false;
+		}
+		jobs.push_back(job);
 	}
 	return true;
 }
-bool read_uintah_datafile(const FileName &file_name, XMLDocument &doc, ParticleModel &model){
+bool read_uintah_datafile(const FileName &file_name, XMLDocument &doc, ParticleModel &model,
+		std::vector<UintahReadJob> &jobs){
 	XMLElement *node = doc.FirstChildElement("Uintah_Output");
 	const static std::string VAR_TYPE = "ParticleVariable";
 	for (XMLNode *c = node->FirstChild(); c; c = c->NextSibling()){
@@ -269,7 +410,7 @@ bool read_uintah_datafile(const FileName &file_name, XMLDocument &doc, ParticleM
 		}
 		std::string var_type = e->Attribute("type");
 		if (var_type.substr(0, VAR_TYPE.size()) == VAR_TYPE){
-			if (!read_uintah_particle_variable(file_name.path(), e, model)){
+			if (!read_uintah_particle_variable(file_name.path(), e, model, jobs)){
 				return false;
 			}
 		}
@@ -310,7 +451,7 @@ bool read_uintah_patches(XMLNode *node, std::vector<UintahPatch> &patches) {
 	return true;
 }
 bool read_uintah_timestep_data(const FileName &base_path, XMLNode *node,
-		ParticleModel &model)
+		ParticleModel &model, std::vector<UintahReadJob> &jobs)
 {
 	for (XMLNode *c = node->FirstChild(); c; c = c->NextSibling()){
 		if (std::string(c->Value()) == "Datafile"){
@@ -333,7 +474,7 @@ bool read_uintah_timestep_data(const FileName &base_path, XMLNode *node,
 					<< tinyxml_error_string(err) << "\n";
 				return false;
 			}
-			if (!read_uintah_datafile(data_file, doc, model)){
+			if (!read_uintah_datafile(data_file, doc, model, jobs)){
 				std::cout << "Error reading Uintah data file " << data_file << "\n";
 				return false;
 			}
@@ -341,7 +482,8 @@ bool read_uintah_timestep_data(const FileName &base_path, XMLNode *node,
 	}
 	return true;
 }
-bool read_uintah_timestep(const FileName &file_name, XMLElement *node, ParticleModel &model){
+bool read_uintah_timestep(const FileName &file_name, XMLElement *node, ParticleModel &model,
+		std::vector<UintahReadJob> &jobs){
 	std::vector<UintahPatch> patches;
 	for (XMLNode *c = node->FirstChild(); c; c = c->NextSibling()){
 		std::cout << c->Value() << "\n" << std::flush;
@@ -353,7 +495,7 @@ bool read_uintah_timestep(const FileName &file_name, XMLElement *node, ParticleM
 		}
 	}
 	XMLNode *c = node->FirstChildElement("Data");
-	if (!c || !read_uintah_timestep_data(file_name.path(), c, model)){
+	if (!c || !read_uintah_timestep_data(file_name.path(), c, model, jobs)){
 		return false;
 	}
 	return true;
@@ -368,13 +510,14 @@ void pl::import_uintah(const FileName &file_name, ParticleModel &model){
 			<< tinyxml_error_string(err) << "\n";
 		throw std::runtime_error("Failed to open XML file");
 	}
+	std::vector<UintahReadJob> jobs;
 	if (doc.FirstChildElement("Uintah_timestep")) {
-		if (!read_uintah_timestep(file_name, doc.FirstChildElement("Uintah_timestep"), model)) {
+		if (!read_uintah_timestep(file_name, doc.FirstChildElement("Uintah_timestep"), model, jobs)) {
 			std::cout << "Error reading Uintah timestep\n";
 			throw std::runtime_error("Failed to read Uintah timestep");
 		}
 	} else if (doc.FirstChildElement("Uintah_Output")) {
-		if (!read_uintah_datafile(file_name, doc, model)) {
+		if (!read_uintah_datafile(file_name, doc, model, jobs)) {
 			std::cout << "Error reading Uintah Output\n";
 			throw std::runtime_error("Failed to read Uintah output");
 		}
@@ -382,6 +525,11 @@ void pl::import_uintah(const FileName &file_name, ParticleModel &model){
 		std::cout << "Unrecognized UDA XML file!\n";
 		throw std::runtime_error("Failed to read Uintah data");
 	}
+	std::cout << "Reading " << jobs.size() << " Uintah patch variables\n";
+	if (!execute_read_jobs(jobs, model)) {
+		std::cout << "Error reading Uintah patch data\n";
+		throw std::runtime_error("Failed to read Uintah patch data");
+	}
 	if (model.find("positions") != model.end()) {
 		auto positions = static_cast<DataT<float>*>(model["positions"].get());
 		std::cout << "Read Uintah data with " << positions->data.size() / 3 << " particles\n";
@@ -0,0 +1,213 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "SegmentSorter.hpp"
+
+/// Up to one descent per this many segments, the previous order is considered nearly sorted.
+const size_t NEARLY_SORTED_DESCENT_RATIO = 64;
+/// Maximum number of element moves per segment before the insertion sort gives up.
+const size_t INSERTION_SORT_MAX_MOVES_PER_SEGMENT = 8;
+const int RADIX_BITS = 8;
+const int RADIX_NUM_BUCKETS = 1 << RADIX_BITS;
+
+/**
+ * Maps a float to an unsigned integer with the same ordering (negative values are bit-inverted, positive values get
+ * their sign bit set).
+ */
+static inline uint32_t floatToSortableKey(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(uint32_t));
+    uint32_t mask = (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+    return bits ^ mask;
+}
+
+void SegmentSorter::setVertexPositions(const std::vector<glm::vec3> &vertexPositions)
+{
+    this->vertexPositions = vertexPositions;
+}
+
+void SegmentSorter::setLineIndices(const std::vector<uint32_t> &lineIndices)
+{
+    this->lineIndices = lineIndices;
+    const size_t numSegments = vertexPositions.empty() ? 0 : lineIndices.size() / 2;
+    segmentCenters.resize(numSegments);
+    segmentOrder.resize(numSegments);
+    depthKeys.resize(numSegments);
+    segmentOrderTmp.resize(numSegments);
+    depthKeysTmp.resize(numSegments);
+    sortedIndices.resize(numSegments * 2);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < numSegments; i++) {
+        segmentCenters[i] = (vertexPositions[lineIndices[i*2]] + vertexPositions[lineIndices[i*2 + 1]]) * 0.5f;
+        segmentOrder[i] = uint32_t(i);
+    }
+}
+
+const std::vector<uint32_t> &SegmentSorter::sortBackToFront(const glm::mat4 &modelViewMatrix)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    const size_t numSegments = segmentCenters.size();
+
+    // The camera looks along the negative z axis in view space, so the farthest segments have the smallest z value.
+    const glm::vec4 depthRow(modelViewMatrix[0][2], modelViewMatrix[1][2], modelViewMatrix[2][2], modelViewMatrix[3][2]);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numSegments; i++) {
+        depthKeys[i] = floatToSortableKey(glm::dot(depthRow, glm::vec4(segmentCenters[segmentOrder[i]], 1.0f)));
+    }
+
+    size_t numDescents = 0;
+    #pragma omp parallel for reduction(+:numDescents)
+    for (size_t i = 1; i < numSegments; i++) {
+        if (depthKeys[i-1] > depthKeys[i]) {
+            numDescents++;
+        }
+    }
+
+    if (numDescents > 0) {
+        if (numDescents > numSegments / NEARLY_SORTED_DESCENT_RATIO
+                || !insertionSort(numSegments * INSERTION_SORT_MAX_MOVES_PER_SEGMENT)) {
+            radixSort();
+        }
+    }
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < numSegments; i++) {
+        uint32_t segmentIndex = segmentOrder[i];
+        sortedIndices[i*2] = lineIndices[segmentIndex*2];
+        sortedIndices[i*2 + 1] = lineIndices[segmentIndex*2 + 1];
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    lastSortTimeMS = std::chrono::duration<double, std::milli>(end - start).count();
+    return sortedIndices;
+}
+
+bool SegmentSorter::insertionSort(size_t maxNumMoves)
+{
+    const size_t numSegments = depthKeys.size();
+    size_t numMoves = 0;
+    for (size_t i = 1; i < numSegments; i++) {
+        uint32_t key = depthKeys[i];
+        uint32_t segmentIndex = segmentOrder[i];
+        size_t j = i;
+        while (j > 0 && depthKeys[j-1] > key) {
+            depthKeys[j] = depthKeys[j-1];
+            segmentOrder[j] = segmentOrder[j-1];
+            j--;
+        }
+        depthKeys[j] = key;
+        segmentOrder[j] = segmentIndex;
+
+        numMoves += i - j;
+        if (numMoves > maxNumMoves) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SegmentSorter::radixSort()
+{
+    const size_t numSegments = depthKeys.size();
+#ifdef _OPENMP
+    const int maxNumThreads = omp_get_max_threads();
+#else
+    const int maxNumThreads = 1;
+#endif
+    std::vector<size_t> histograms(size_t(maxNumThreads) * RADIX_NUM_BUCKETS);
+
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        bool skipPass = false;
+
+        #pragma omp parallel
+        {
+#ifdef _OPENMP
+            const int threadIndex = omp_get_thread_num();
+            const int numThreads = omp_get_num_threads();
+#else
+            const int threadIndex = 0;
+            const int numThreads = 1;
+#endif
+            // Each thread handles one contiguous block, which keeps the sort stable.
+            const size_t blockBegin = numSegments * threadIndex / numThreads;
+            const size_t blockEnd = numSegments * (threadIndex + 1) / numThreads;
+            size_t *histogram = &histograms[size_t(threadIndex) * RADIX_NUM_BUCKETS];
+            std::fill(histogram, histogram + RADIX_NUM_BUCKETS, 0);
+            for (size_t i = blockBegin; i < blockEnd; i++) {
+                histogram[(depthKeys[i] >> shift) & (RADIX_NUM_BUCKETS - 1)]++;
+            }
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                // Exclusive prefix sum in (bucket, thread) order.
+                size_t offset = 0;
+                for (int bucket = 0; bucket < RADIX_NUM_BUCKETS; bucket++) {
+                    for (int thread = 0; thread < numThreads; thread++) {
+                        size_t &count = histograms[size_t(thread) * RADIX_NUM_BUCKETS + bucket];
+                        size_t bucketCount = count;
+                        count = offset;
+                        offset += bucketCount;
+                    }
+                }
+                // The entries of the first thread now hold the start of each bucket. If all keys share the same
+                // digit, the pass wouldn't change anything.
+                for (int bucket = 0; bucket < RADIX_NUM_BUCKETS; bucket++) {
+                    size_t bucketEnd = bucket + 1 < RADIX_NUM_BUCKETS ? histograms[bucket + 1] : numSegments;
+                    if (bucketEnd - histograms[bucket] == numSegments) {
+                        skipPass = true;
+                    }
+                }
+            }
+
+            if (!skipPass) {
+                for (size_t i = blockBegin; i < blockEnd; i++) {
+                    size_t writeIndex = histogram[(depthKeys[i] >> shift) & (RADIX_NUM_BUCKETS - 1)]++;
+                    depthKeysTmp[writeIndex] = depthKeys[i];
+                    segmentOrderTmp[writeIndex] = segmentOrder[i];
+                }
+            }
+        }
+
+        if (!skipPass) {
+            depthKeys.swap(depthKeysTmp);
+            segmentOrder.swap(segmentOrderTmp);
+        }
+    }
+}
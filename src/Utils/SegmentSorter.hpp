@@ -0,0 +1,84 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_SEGMENTSORTER_HPP
+#define PIXELSYNCOIT_SEGMENTSORTER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * Sorts the segments of a line mesh (VERTEX_MODE_LINES) back-to-front by the view depth of their centers on the CPU.
+ * Rendering the sorted index buffer with ordinary alpha blending gives an exact per-segment order without any
+ * per-pixel fragment storage (see OIT_SortedSegments).
+ *
+ * The order of the last frame is kept. As the camera moves only slightly between frames, the segments are usually
+ * (nearly) sorted already in this order, which is detected and handled by an adaptive insertion sort. Otherwise, a
+ * parallel LSD radix sort over the 32-bit depth keys is used.
+ */
+class SegmentSorter
+{
+public:
+    /// The vertex positions the line indices refer to (in object space).
+    void setVertexPositions(const std::vector<glm::vec3> &vertexPositions);
+    inline const std::vector<glm::vec3> &getVertexPositions() const { return vertexPositions; }
+    /// Sets the line list index buffer to sort (e.g., the currently visible lines). Resets the previous order.
+    void setLineIndices(const std::vector<uint32_t> &lineIndices);
+    inline bool isEmpty() const { return segmentCenters.empty(); }
+
+    /**
+     * Sorts the segments back-to-front for the passed model-view matrix.
+     * @return The sorted line list index buffer.
+     */
+    const std::vector<uint32_t> &sortBackToFront(const glm::mat4 &modelViewMatrix);
+
+    /// CPU time of the last call to sortBackToFront (including the assembly of the index buffer).
+    inline double getLastSortTimeMS() const { return lastSortTimeMS; }
+
+private:
+    /// Returns false if the input was too far from being sorted (the keys and order stay a valid permutation).
+    bool insertionSort(size_t maxNumMoves);
+    void radixSort();
+
+    std::vector<glm::vec3> vertexPositions;
+    std::vector<uint32_t> lineIndices;
+    std::vector<glm::vec3> segmentCenters;
+
+    // Segment order of the last frame and the depth keys in this order
+    std::vector<uint32_t> segmentOrder;
+    std::vector<uint32_t> depthKeys;
+    std::vector<uint32_t> segmentOrderTmp;
+    std::vector<uint32_t> depthKeysTmp;
+
+    std::vector<uint32_t> sortedIndices;
+    double lastSortTimeMS = 0.0;
+};
+
+#endif //PIXELSYNCOIT_SEGMENTSORTER_HPP
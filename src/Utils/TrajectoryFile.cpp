@@ -5,16 +5,51 @@
 #define _FILE_OFFSET_BITS 64
 
 #include <cstdio>
+#include <cfloat>
+#include <limits>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
 #include <Utils/File/Logfile.hpp>
 #include <Math/Geometry/AABB3.hpp>
 #include <Utils/Events/Stream/Stream.hpp>
 #include "NetCDFConverter.hpp"
+#include "BinLinesFile.hpp"
 #include "TrajectoryFile.hpp"
 #include <iostream>
 
 Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryType trajectoryType)
+{
+    TrajectoryNormalization normalization;
+    return loadTrajectoriesFromFile(filename, trajectoryType, normalization);
+}
+
+Trajectories loadTrajectoriesFromFile(
+        const std::string &filename, TrajectoryType trajectoryType, TrajectoryNormalization &normalization)
+{
+    Trajectories trajectories;
+
+    BinLinesFile binLinesFile;
+    if (openBinLinesDataForTrajectoryFile(filename, trajectoryType, binLinesFile)) {
+        trajectories = binLinesFile.toTrajectories();
+        normalization = binLinesFile.getNormalization();
+        applyTrajectoryNormalization(trajectories, normalization);
+        return trajectories;
+    }
+
+    std::string cacheFilename = getBinLinesCacheFilename(filename);
+    trajectories = loadTrajectoriesFromFileUnnormalized(filename, trajectoryType);
+    normalization = computeTrajectoryNormalization(trajectories, trajectoryType);
+    if (!trajectories.empty() && cacheFilename != filename) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Writing binlines cache \"" + cacheFilename + "\"...");
+        writeBinLinesFile(cacheFilename, trajectories, trajectoryType, normalization);
+    }
+    applyTrajectoryNormalization(trajectories, normalization);
+
+    return trajectories;
+}
+
+Trajectories loadTrajectoriesFromFileUnnormalized(const std::string &filename, TrajectoryType trajectoryType)
 {
     Trajectories trajectories;
 
@@ -27,75 +62,102 @@ Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryTyp
         trajectories = loadTrajectoriesFromBinLines(filename, trajectoryType);
     }
 
-    sgl::AABB3 boundingBox;
-    for (Trajectory &trajectory : trajectories) {
-        for (glm::vec3 &position : trajectory.positions) {
-            boundingBox.combine(position);
-        }
-    }
+    return trajectories;
+}
 
+TrajectoryNormalization computeTrajectoryNormalization(const Trajectories &trajectories, TrajectoryType trajectoryType)
+{
     bool isConvectionRolls = trajectoryType == TRAJECTORY_TYPE_CONVECTION_ROLLS_NEW;
     bool isUCLA = trajectoryType == TRAJECTORY_TYPE_UCLA;
     bool isRings = trajectoryType == TRAJECTORY_TYPE_RINGS;
     bool isCfdData = trajectoryType == TRAJECTORY_TYPE_CFD;
 
-    glm::vec3 minVec(boundingBox.getMinimum());
-    glm::vec3 maxVec(boundingBox.getMaximum());
-
+    // Fused reduction: Bounding box and attribute range are computed in one pass over the data.
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
     float minAttr = std::numeric_limits<float>::max();
     float maxAttr = std::numeric_limits<float>::lowest();
-
-    if (isConvectionRolls) {
-        minVec = glm::vec3(0);
-        maxVec = glm::vec3(0.5);
-    } else if (isUCLA)
-    {
-        minVec = glm::vec3(glm::min(boundingBox.getMinimum().x, std::min(boundingBox.getMinimum().y, boundingBox.getMinimum().z)));
-        maxVec = glm::vec3(glm::max(boundingBox.getMaximum().x, std::max(boundingBox.getMaximum().y, boundingBox.getMaximum().z)));
-
-        for(const Trajectory& traj : trajectories)
-        {
-            for (const float& attr : traj.attributes[0])
-            {
+    const size_t numTrajectories = trajectories.size();
+
+    #pragma omp parallel for schedule(dynamic, 64) reduction(min:minX,minY,minZ,minAttr) \
+            reduction(max:maxX,maxY,maxZ,maxAttr)
+    for (size_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+        const Trajectory &trajectory = trajectories[trajectoryIdx];
+        for (const glm::vec3 &position : trajectory.positions) {
+            minX = std::min(minX, position.x);
+            minY = std::min(minY, position.y);
+            minZ = std::min(minZ, position.z);
+            maxX = std::max(maxX, position.x);
+            maxY = std::max(maxY, position.y);
+            maxZ = std::max(maxZ, position.z);
+        }
+        if (isUCLA && !trajectory.attributes.empty()) {
+            for (const float &attr : trajectory.attributes[0]) {
                 minAttr = std::min(minAttr, attr);
                 maxAttr = std::max(maxAttr, attr);
             }
         }
+    }
 
+    TrajectoryNormalization normalization;
+    sgl::AABB3 &boundingBox = normalization.boundingBox;
+    if (minX <= maxX) {
+        boundingBox = sgl::AABB3(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ));
+    }
+
+    if (isConvectionRolls) {
+        normalization.minVec = glm::vec3(0);
+        normalization.maxVec = glm::vec3(0.5);
     } else {
-        // Normalize data for rings
+        // Normalize data for rings and UCLA uniformly along all axes
         float minValue = glm::min(boundingBox.getMinimum().x, std::min(boundingBox.getMinimum().y, boundingBox.getMinimum().z));
         float maxValue = glm::max(boundingBox.getMaximum().x, std::max(boundingBox.getMaximum().y, boundingBox.getMaximum().z));
-        minVec = glm::vec3(minValue);
-        maxVec = glm::vec3(maxValue);
+        normalization.minVec = glm::vec3(minValue);
+        normalization.maxVec = glm::vec3(maxValue);
     }
 
-    if (isRings || isConvectionRolls || isCfdData || isUCLA) {
-        for (Trajectory &trajectory : trajectories) {
-            for (glm::vec3 &position : trajectory.positions) {
-                position = (position - minVec) / (maxVec - minVec);
-                if (isConvectionRolls || isCfdData) {
-                    glm::vec3 dims = glm::vec3(1);
-                    dims.y = boundingBox.getDimensions().y;
-                    position -= dims;
-                }
-            }
-        }
+    normalization.normalizePositions = isRings || isConvectionRolls || isCfdData || isUCLA;
+    if (isConvectionRolls || isCfdData) {
+        glm::vec3 dims = glm::vec3(1);
+        dims.y = boundingBox.getDimensions().y;
+        normalization.positionOffset = dims;
     }
 
     // if UCLA --> normalize attributes
-    if (isUCLA)
-    {
-        for(Trajectory& traj : trajectories)
-        {
-            for (float& attr : traj.attributes[0])
-            {
-                attr = (attr - minAttr) / (maxAttr - minAttr);
+    normalization.normalizeAttribute = isUCLA;
+    normalization.minAttribute = minAttr;
+    normalization.maxAttribute = maxAttr;
+
+    return normalization;
+}
+
+void applyTrajectoryNormalization(Trajectories &trajectories, const TrajectoryNormalization &normalization)
+{
+    if (!normalization.normalizePositions && !normalization.normalizeAttribute) {
+        return;
+    }
+
+    const glm::vec3 minVec = normalization.minVec;
+    const glm::vec3 range = normalization.maxVec - normalization.minVec;
+    const glm::vec3 positionOffset = normalization.positionOffset;
+    const float minAttr = normalization.minAttribute;
+    const float attrRange = normalization.maxAttribute - normalization.minAttribute;
+    const size_t numTrajectories = trajectories.size();
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+        Trajectory &trajectory = trajectories[trajectoryIdx];
+        if (normalization.normalizePositions) {
+            for (glm::vec3 &position : trajectory.positions) {
+                position = (position - minVec) / range - positionOffset;
+            }
+        }
+        if (normalization.normalizeAttribute && !trajectory.attributes.empty()) {
+            for (float &attr : trajectory.attributes[0]) {
+                attr = (attr - minAttr) / attrRange;
             }
         }
     }
-
-    return trajectories;
 }
 
 Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType trajectoryType)
@@ -249,8 +311,9 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
     return trajectories;
 }
 
-Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryType trajectoryType) {
-    Trajectories trajectories = loadNetCdfFile(filename);
+Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryType trajectoryType,
+        size_t ensembleMember, size_t timeStart, size_t timeCount) {
+    Trajectories trajectories = loadNetCdfFile(filename, ensembleMember, timeStart, timeCount);
 
     for (Trajectory &trajectory : trajectories) {
         // Compute importance criteria
@@ -266,6 +329,12 @@ Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryT
 Trajectories loadTrajectoriesFromBinLines(const std::string &filename, TrajectoryType trajectoryType) {
     Trajectories trajectories;
 
+    // Format version 2 can be used in place.
+    BinLinesFile binLinesFile;
+    if (binLinesFile.open(filename)) {
+        return binLinesFile.toTrajectories();
+    }
+
     std::ifstream file(filename.c_str(), std::ifstream::binary);
     if (!file.is_open()) {
         sgl::Logfile::get()->writeError(std::string() + "Error in loadTrajectoriesFromBinLines: File \""
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
+#include <Math/Geometry/AABB3.hpp>
 #include "Utils/ImportanceCriteria.hpp"
 
 struct Trajectory {
@@ -17,18 +18,74 @@ struct Trajectory {
 
 typedef std::vector<Trajectory> Trajectories;
 
+/**
+ * The transformation loadTrajectoriesFromFile applies to the raw data of a data set, i.e.:
+ * - position' = (position - minVec) / (maxVec - minVec) - positionOffset (if normalizePositions is set).
+ * - attribute0' = (attribute0 - minAttribute) / (maxAttribute - minAttribute) (if normalizeAttribute is set).
+ * It can be stored together with caches derived from the data so that they don't need to recompute it on each load.
+ */
+struct TrajectoryNormalization {
+    TrajectoryNormalization() : normalizePositions(false), minVec(0.0f), maxVec(1.0f), positionOffset(0.0f),
+                                normalizeAttribute(false), minAttribute(0.0f), maxAttribute(1.0f) {}
+
+    /// Bounding box of the positions before the normalization.
+    sgl::AABB3 boundingBox;
+
+    bool normalizePositions;
+    glm::vec3 minVec;
+    glm::vec3 maxVec;
+    glm::vec3 positionOffset;
+
+    bool normalizeAttribute;
+    float minAttribute;
+    float maxAttribute;
+};
+
+/**
+ * Computes the bounding box and (if necessary for the data set type) the attribute range of the trajectories in one
+ * fused parallel reduction and derives the normalization transformation used by loadTrajectoriesFromFile from them.
+ */
+TrajectoryNormalization computeTrajectoryNormalization(const Trajectories &trajectories, TrajectoryType trajectoryType);
+
+/**
+ * Applies the passed normalization to the positions and attributes of all trajectories in one parallel pass.
+ */
+void applyTrajectoryNormalization(Trajectories &trajectories, const TrajectoryNormalization &normalization);
+
 /**
  * Selects loadTrajectoriesFromObj, loadTrajectoriesFromNetCdf or loadTrajectoriesFromBinLines depending on the file
  * endings and performs some normalization for special datasets (e.g. the rings dataset).
+ * The loaded data and its normalization are cached in a binlines v2 file next to the trajectory file
+ * (see getBinLinesCacheFilename), which is used instead of the trajectory file as long as it is up to date.
  * @param filename The name of the trajectory file to open.
  * @return The trajectories loaded from the file (empty if the file could not be opened).
  */
 Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryType trajectoryType);
 
+/**
+ * Same as above, but additionally returns the normalization transformation that was applied to the data.
+ */
+Trajectories loadTrajectoriesFromFile(
+        const std::string &filename, TrajectoryType trajectoryType, TrajectoryNormalization &normalization);
+
+/**
+ * Selects the loader depending on the file ending like loadTrajectoriesFromFile, but neither uses the binlines cache
+ * nor normalizes the data.
+ */
+Trajectories loadTrajectoriesFromFileUnnormalized(const std::string &filename, TrajectoryType trajectoryType);
+
 Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType trajectoryType);
 
-Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryType trajectoryType);
+/**
+ * Loads one ensemble member (and optionally only a window of time steps) of a WCB NetCDF file.
+ * By default, the full time range of the first ensemble member is loaded (see loadNetCdfFile).
+ */
+Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryType trajectoryType,
+        size_t ensembleMember = 0, size_t timeStart = 0, size_t timeCount = 0);
 
+/**
+ * Loads a .binlines file in the format version 1 or 2 (see BinLinesFile.hpp).
+ */
 Trajectories loadTrajectoriesFromBinLines(const std::string &filename, TrajectoryType trajectoryType);
 
 #endif //PIXELSYNCOIT_TRAJECTORYFILE_HPP
@@ -4,11 +4,14 @@
 
 #include <Utils/File/Logfile.hpp>
 #include <Utils/Convert.hpp>
+#include <Utils/Events/Stream/Stream.hpp>
 #include <Math/Math.hpp>
 #include <Graphics/Shader/ShaderManager.hpp>
 #include <Graphics/Renderer.hpp>
 
 #include <chrono>
+#include <thread>
+#include <cfloat>
 #include <iostream>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -16,6 +19,8 @@
 
 #include "MeshSerializer.hpp"
 #include "TrajectoryFile.hpp"
+#include "BinLinesFile.hpp"
+#include "ConversionPipeline.hpp"
 #include "TrajectoryLoader.hpp"
 
 using namespace sgl;
@@ -363,6 +368,60 @@ void createTubeRenderData<uint32_t>(const std::vector<glm::vec3> &pathLineCenter
 
 
 
+/// Number of lines per batch passed between the stages of the conversion pipeline.
+const size_t CONVERSION_BATCH_NUM_LINES = 256;
+/// Maximum number of batches waiting between two stages.
+const size_t CONVERSION_QUEUE_CAPACITY = 16;
+/// Number of attribute values packed to unorm and written at once.
+const size_t CONVERSION_PACK_CHUNK_SIZE = 1u << 20;
+
+struct TrajectoryBatch
+{
+    size_t batchIndex;
+    Trajectories trajectories;
+};
+
+struct TubeGeometryBatch
+{
+    size_t batchIndex;
+    size_t numLines;
+    size_t numLineSegments;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<std::vector<float>> importanceCriteria;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * Appends local tube geometry to the geometry of a batch or the whole mesh (local indices -> global indices).
+ */
+static void appendTubeGeometry(
+        std::vector<glm::vec3> &globalVertexPositions, std::vector<glm::vec3> &globalNormals,
+        std::vector<std::vector<float>> &globalImportanceCriteria, std::vector<uint32_t> &globalIndices,
+        const std::vector<glm::vec3> &localVertices, const std::vector<glm::vec3> &localNormals,
+        const std::vector<std::vector<float>> &importanceCriteriaVertex, const std::vector<uint32_t> &localIndices)
+{
+    if (localVertices.size() == 0) {
+        return;
+    }
+
+    const uint32_t indexOffset = uint32_t(globalVertexPositions.size());
+    for (size_t i = 0; i < localIndices.size(); i++) {
+        globalIndices.push_back(localIndices.at(i) + indexOffset);
+    }
+    globalVertexPositions.insert(globalVertexPositions.end(), localVertices.begin(), localVertices.end());
+    globalNormals.insert(globalNormals.end(), localNormals.begin(), localNormals.end());
+    if (globalImportanceCriteria.empty()) {
+        globalImportanceCriteria.insert(globalImportanceCriteria.end(), importanceCriteriaVertex.begin(),
+                                        importanceCriteriaVertex.end());
+    } else {
+        for (size_t i = 0; i < globalImportanceCriteria.size(); i++) {
+            globalImportanceCriteria.at(i).insert(globalImportanceCriteria.at(i).end(),
+                                                  importanceCriteriaVertex.at(i).begin(), importanceCriteriaVertex.at(i).end());
+        }
+    }
+}
+
 void convertTrajectoryDataToBinaryTriangleMesh(
         TrajectoryType trajectoryType,
         const std::string &trajectoriesFilename,
@@ -379,117 +438,257 @@ void convertTrajectoryDataToBinaryTriangleMesh(
         initializeCircleData(3, lineRadius);
     }
 
-    BinaryMesh binaryMesh;
-    binaryMesh.submeshes.push_back(BinarySubMesh());
-    BinarySubMesh &submesh = binaryMesh.submeshes.front();
-    submesh.vertexMode = VERTEX_MODE_TRIANGLES;
-
     std::vector<glm::vec3> globalVertexPositions;
     std::vector<glm::vec3> globalNormals;
     std::vector<std::vector<float>> globalImportanceCriteria;
-    std::vector<uint32_t> globalIndices;
-
-    uint32_t numLines = 0;
-    uint32_t numLineSegments = 0;
-
-
-    Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
-
-    for (size_t i = 0; i < trajectories.size(); i++) {
-        Trajectory &trajectory = trajectories.at(i);
-
-        numLines++;
-        numLineSegments += trajectory.positions.size() - 1;
-
-        // Create tube render data
-        std::vector<glm::vec3> localVertices;
-        std::vector<std::vector<float>> importanceCriteriaVertex;
-        std::vector<glm::vec3> localNormals;
-        std::vector<uint32_t> localIndices;
-        createTubeRenderData(trajectory.positions, trajectory.attributes, localVertices, localNormals,
-                             importanceCriteriaVertex, localIndices);
-
-        // Local -> global
-        if (localVertices.size() > 0) {
-            for (size_t i = 0; i < localIndices.size(); i++) {
-                globalIndices.push_back(localIndices.at(i) + globalVertexPositions.size());
+    size_t numIndices = 0;
+
+    size_t numLines = 0;
+    size_t numLineSegments = 0;
+
+    // The conversion runs as a pipeline of line batches: Reading (and, if no binlines data exists yet, parsing and
+    // attribute computation) -> tube generation on several threads -> merging in the original line order -> writing.
+    // The binmesh format stores the indices before the vertex attributes, so the write stage streams the indices to
+    // the file as they arrive and writes the vertex attributes once all batches are merged. The unorm packing of the
+    // attributes needs their global ranges and thus also waits for the last batch.
+    const int numTubeThreads = std::max(int(std::thread::hardware_concurrency()) - 3, 1);
+    BoundedQueue<TrajectoryBatch> trajectoryQueue(CONVERSION_QUEUE_CAPACITY);
+    BoundedQueue<TubeGeometryBatch> geometryQueue(CONVERSION_QUEUE_CAPACITY, numTubeThreads);
+    BoundedQueue<TubeGeometryBatch> mergedGeometryQueue(CONVERSION_QUEUE_CAPACITY);
+    ConversionPipeline pipeline;
+
+    pipeline.addStage("read", 1, [&](PipelineStageTimer &timer) {
+        size_t batchIndex = 0;
+        BinLinesFile binLinesFile;
+        if (openBinLinesDataForTrajectoryFile(trajectoriesFilename, trajectoryType, binLinesFile)) {
+            // Stream the lines directly from the memory-mapped binlines data.
+            const TrajectoryNormalization normalization = binLinesFile.getNormalization();
+            const uint64_t *lineOffsets = binLinesFile.getLineOffsets();
+            const glm::vec3 *positions = binLinesFile.getPositions();
+            const uint32_t numAttributes = binLinesFile.getNumAttributes();
+            const size_t numFileLines = binLinesFile.getNumLines();
+            for (size_t lineStart = 0; lineStart < numFileLines; lineStart += CONVERSION_BATCH_NUM_LINES) {
+                timer.beginBatch();
+                size_t lineEnd = std::min(lineStart + CONVERSION_BATCH_NUM_LINES, numFileLines);
+                TrajectoryBatch batch;
+                batch.batchIndex = batchIndex++;
+                batch.trajectories.resize(lineEnd - lineStart);
+                for (size_t lineIdx = lineStart; lineIdx < lineEnd; lineIdx++) {
+                    Trajectory &trajectory = batch.trajectories.at(lineIdx - lineStart);
+                    const uint64_t pointsBegin = lineOffsets[lineIdx];
+                    const uint64_t pointsEnd = lineOffsets[lineIdx + 1];
+                    trajectory.positions.assign(positions + pointsBegin, positions + pointsEnd);
+                    trajectory.attributes.resize(numAttributes);
+                    for (uint32_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+                        const float *attribute = binLinesFile.getAttribute(attrIdx);
+                        trajectory.attributes.at(attrIdx).assign(attribute + pointsBegin, attribute + pointsEnd);
+                    }
+                }
+                applyTrajectoryNormalization(batch.trajectories, normalization);
+                timer.endBatch();
+                trajectoryQueue.push(std::move(batch));
             }
-            globalVertexPositions.insert(globalVertexPositions.end(), localVertices.begin(), localVertices.end());
-            globalNormals.insert(globalNormals.end(), localNormals.begin(), localNormals.end());
-            if (globalImportanceCriteria.empty()) {
-                globalImportanceCriteria.insert(globalImportanceCriteria.end(), importanceCriteriaVertex.begin(),
-                                                importanceCriteriaVertex.end());
-            } else {
-                for (size_t i = 0; i < globalImportanceCriteria.size(); i++) {
-                    globalImportanceCriteria.at(i).insert(globalImportanceCriteria.at(i).end(),
-                                                          importanceCriteriaVertex.at(i).begin(), importanceCriteriaVertex.at(i).end());
+        } else {
+            // Parses the file, computes the importance criteria and writes the binlines cache for the next run.
+            // The normalization needs the bounding box of all lines, so no batch can be passed on before.
+            timer.beginBatch();
+            Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
+            timer.endBatch();
+            for (size_t lineStart = 0; lineStart < trajectories.size(); lineStart += CONVERSION_BATCH_NUM_LINES) {
+                size_t lineEnd = std::min(lineStart + CONVERSION_BATCH_NUM_LINES, trajectories.size());
+                TrajectoryBatch batch;
+                batch.batchIndex = batchIndex++;
+                batch.trajectories.reserve(lineEnd - lineStart);
+                for (size_t lineIdx = lineStart; lineIdx < lineEnd; lineIdx++) {
+                    batch.trajectories.push_back(std::move(trajectories.at(lineIdx)));
                 }
+                trajectoryQueue.push(std::move(batch));
             }
         }
-    }
-
-
-    submesh.material.diffuseColor = glm::vec3(165, 220, 84) / 255.0f;
-    submesh.material.opacity = 120 / 255.0f;
-    submesh.indices = globalIndices;
-
-    const size_t numIndices = globalIndices.size();
-    const size_t numVertices = globalVertexPositions.size();
-    const size_t numNormals = globalNormals.size();
-    // free memory
-    globalIndices.clear(); globalIndices.shrink_to_fit();
-
-    BinaryMeshAttribute positionAttribute;
-    positionAttribute.name = "vertexPosition";
-    positionAttribute.attributeFormat = ATTRIB_FLOAT;
-    positionAttribute.numComponents = 3;
-    positionAttribute.data.resize(numVertices * sizeof(glm::vec3));
-    memcpy(&positionAttribute.data.front(), &globalVertexPositions.front(), numVertices * sizeof(glm::vec3));
-    submesh.attributes.push_back(positionAttribute);
+        trajectoryQueue.close();
+    });
+
+    pipeline.addStage("tubes", numTubeThreads, [&](PipelineStageTimer &timer) {
+        TrajectoryBatch batch;
+        while (trajectoryQueue.pop(batch)) {
+            timer.beginBatch();
+            TubeGeometryBatch geometry;
+            geometry.batchIndex = batch.batchIndex;
+            geometry.numLines = batch.trajectories.size();
+            geometry.numLineSegments = 0;
+            for (Trajectory &trajectory : batch.trajectories) {
+                geometry.numLineSegments += trajectory.positions.size() - 1;
+
+                // Create tube render data
+                std::vector<glm::vec3> localVertices;
+                std::vector<std::vector<float>> importanceCriteriaVertex;
+                std::vector<glm::vec3> localNormals;
+                std::vector<uint32_t> localIndices;
+                createTubeRenderData(trajectory.positions, trajectory.attributes, localVertices, localNormals,
+                                     importanceCriteriaVertex, localIndices);
+                appendTubeGeometry(geometry.vertices, geometry.normals, geometry.importanceCriteria,
+                                   geometry.indices, localVertices, localNormals, importanceCriteriaVertex,
+                                   localIndices);
+            }
+            timer.endBatch();
+            geometryQueue.push(std::move(geometry));
+        }
+        geometryQueue.close();
+    });
+
+    pipeline.addStage("merge", 1, [&](PipelineStageTimer &timer) {
+        // The tube threads finish their batches out of order. Keep the original line order in the output.
+        std::map<size_t, TubeGeometryBatch> pendingBatches;
+        size_t nextBatchIndex = 0;
+        size_t numMergedVertices = 0;
+        TubeGeometryBatch geometry;
+        while (geometryQueue.pop(geometry)) {
+            timer.beginBatch();
+            size_t batchIndex = geometry.batchIndex;
+            pendingBatches.insert(std::make_pair(batchIndex, std::move(geometry)));
+            std::vector<TubeGeometryBatch> mergedBatches;
+            auto it = pendingBatches.find(nextBatchIndex);
+            while (it != pendingBatches.end()) {
+                // Local indices -> global indices
+                TubeGeometryBatch &nextGeometry = it->second;
+                const uint32_t indexOffset = uint32_t(numMergedVertices);
+                for (uint32_t &index : nextGeometry.indices) {
+                    index += indexOffset;
+                }
+                numMergedVertices += nextGeometry.vertices.size();
+                mergedBatches.push_back(std::move(nextGeometry));
+                pendingBatches.erase(it);
+                nextBatchIndex++;
+                it = pendingBatches.find(nextBatchIndex);
+            }
+            timer.endBatch();
+            for (TubeGeometryBatch &mergedGeometry : mergedBatches) {
+                mergedGeometryQueue.push(std::move(mergedGeometry));
+            }
+        }
+        mergedGeometryQueue.close();
+    });
+
+    bool writeSuccessful = true;
+    pipeline.addStage("write", 1, [&](PipelineStageTimer &timer) {
+        FILE *file = fopen(binaryFilename.c_str(), "wb");
+        if (file == NULL) {
+            Logfile::get()->writeError(std::string() + "Error in convertTrajectoryDataToBinaryTriangleMesh: File \""
+                    + binaryFilename + "\" couldn't be created.");
+            writeSuccessful = false;
+        }
 
-    // free memory
-    globalVertexPositions.clear(); globalVertexPositions.shrink_to_fit();
+        // Header in the layout of writeMesh3D. The number of indices is patched after the last batch.
+        ObjMaterial material;
+        material.diffuseColor = glm::vec3(165, 220, 84) / 255.0f;
+        material.opacity = 120 / 255.0f;
+        sgl::BinaryWriteStream headerStream;
+        headerStream.write((uint32_t)MESH_FORMAT_VERSION);
+        headerStream.write((uint32_t)1u); // One submesh
+        headerStream.write(material);
+        headerStream.write((uint32_t)VERTEX_MODE_TRIANGLES);
+        const long numIndicesOffset = long(headerStream.getSize());
+        headerStream.write((uint32_t)0u);
+        writeSuccessful = writeSuccessful && writeMesh3DData(file, headerStream.getBuffer(), headerStream.getSize());
+
+        TubeGeometryBatch geometry;
+        while (mergedGeometryQueue.pop(geometry)) {
+            timer.beginBatch();
+            numLines += geometry.numLines;
+            numLineSegments += geometry.numLineSegments;
+            numIndices += geometry.indices.size();
+            writeSuccessful = writeSuccessful && writeMesh3DData(
+                    file, geometry.indices.data(), geometry.indices.size() * sizeof(uint32_t));
+            if (!geometry.vertices.empty()) {
+                globalVertexPositions.insert(
+                        globalVertexPositions.end(), geometry.vertices.begin(), geometry.vertices.end());
+                globalNormals.insert(globalNormals.end(), geometry.normals.begin(), geometry.normals.end());
+                if (globalImportanceCriteria.empty()) {
+                    globalImportanceCriteria = std::move(geometry.importanceCriteria);
+                } else {
+                    for (size_t i = 0; i < globalImportanceCriteria.size(); i++) {
+                        globalImportanceCriteria.at(i).insert(globalImportanceCriteria.at(i).end(),
+                                geometry.importanceCriteria.at(i).begin(), geometry.importanceCriteria.at(i).end());
+                    }
+                }
+            }
+            timer.endBatch();
+        }
 
-    BinaryMeshAttribute lineNormalsAttribute;
-    lineNormalsAttribute.name = "vertexNormal";
-    lineNormalsAttribute.attributeFormat = ATTRIB_FLOAT;
-    lineNormalsAttribute.numComponents = 3;
-    lineNormalsAttribute.data.resize(numNormals * sizeof(glm::vec3));
-    memcpy(&lineNormalsAttribute.data.front(), &globalNormals.front(), numNormals * sizeof(glm::vec3));
-    submesh.attributes.push_back(lineNormalsAttribute);
+        timer.beginBatch();
+        if (writeSuccessful) {
+            const uint32_t numIndicesUint32 = uint32_t(numIndices);
+            writeSuccessful = fseek(file, numIndicesOffset, SEEK_SET) == 0
+                    && writeMesh3DData(file, &numIndicesUint32, sizeof(uint32_t)) && fseek(file, 0, SEEK_END) == 0;
+        }
 
-    // free memory
-    globalNormals.clear(); globalNormals.shrink_to_fit();
+        sgl::BinaryWriteStream numAttributesStream;
+        numAttributesStream.write(uint32_t(2 + globalImportanceCriteria.size()));
+        writeSuccessful = writeSuccessful
+                && writeMesh3DData(file, numAttributesStream.getBuffer(), numAttributesStream.getSize());
+        writeSuccessful = writeSuccessful && writeMesh3DAttributeHeader(
+                file, "vertexPosition", ATTRIB_FLOAT, 3, globalVertexPositions.size() * sizeof(glm::vec3))
+                && writeMesh3DData(
+                        file, globalVertexPositions.data(), globalVertexPositions.size() * sizeof(glm::vec3));
+        writeSuccessful = writeSuccessful && writeMesh3DAttributeHeader(
+                file, "vertexNormal", ATTRIB_FLOAT, 3, globalNormals.size() * sizeof(glm::vec3))
+                && writeMesh3DData(file, globalNormals.data(), globalNormals.size() * sizeof(glm::vec3));
+
+        // Pack the importance criteria to unorm chunk by chunk instead of keeping a second copy of all of them.
+        std::vector<uint16_t> unormChunk;
+        for (size_t attrIdx = 0; writeSuccessful && attrIdx < globalImportanceCriteria.size(); attrIdx++) {
+            const std::vector<float> &currentAttr = globalImportanceCriteria.at(attrIdx);
+            float minValue = FLT_MAX;
+            float maxValue = -FLT_MAX;
+            #pragma omp parallel for reduction(min:minValue) reduction(max:maxValue)
+            for (size_t i = 0; i < currentAttr.size(); i++) {
+                minValue = std::min(minValue, currentAttr[i]);
+                maxValue = std::max(maxValue, currentAttr[i]);
+            }
 
-    std::vector<std::vector<uint16_t>> globalImportanceCriteriaUnorm;
-    packUnorm16ArrayOfArrays(globalImportanceCriteria, globalImportanceCriteriaUnorm);
+            writeSuccessful = writeMesh3DAttributeHeader(
+                    file, "vertexAttribute" + sgl::toString(attrIdx), ATTRIB_UNSIGNED_SHORT, 1,
+                    currentAttr.size() * sizeof(uint16_t));
+            for (size_t chunkStart = 0; writeSuccessful && chunkStart < currentAttr.size();
+                    chunkStart += CONVERSION_PACK_CHUNK_SIZE) {
+                unormChunk.resize(std::min(CONVERSION_PACK_CHUNK_SIZE, currentAttr.size() - chunkStart));
+                packUnorm16Array(currentAttr.data() + chunkStart, unormChunk.size(), minValue, maxValue,
+                                 unormChunk.data());
+                writeSuccessful = writeMesh3DData(file, unormChunk.data(), unormChunk.size() * sizeof(uint16_t));
+            }
+        }
 
-    for (size_t i = 0; i < globalImportanceCriteriaUnorm.size(); i++) {
-        std::vector<uint16_t> &currentAttr = globalImportanceCriteriaUnorm.at(i);
-        BinaryMeshAttribute vertexAttribute;
-        vertexAttribute.name = "vertexAttribute" + sgl::toString(i);
-        vertexAttribute.attributeFormat = ATTRIB_UNSIGNED_SHORT;
-        vertexAttribute.numComponents = 1;
-        vertexAttribute.data.resize(currentAttr.size() * sizeof(uint16_t));
-        memcpy(&vertexAttribute.data.front(), &currentAttr.front(), currentAttr.size() * sizeof(uint16_t));
-        submesh.attributes.push_back(vertexAttribute);
-    }
+        sgl::BinaryWriteStream numUniformsStream;
+        numUniformsStream.write((uint32_t)0u);
+        writeSuccessful = writeSuccessful
+                && writeMesh3DData(file, numUniformsStream.getBuffer(), numUniformsStream.getSize());
+
+        if (file != NULL) {
+            fclose(file);
+            if (!writeSuccessful) {
+                Logfile::get()->writeError(std::string() + "Error in convertTrajectoryDataToBinaryTriangleMesh: "
+                        + "Couldn't write to file \"" + binaryFilename + "\".");
+                std::remove(binaryFilename.c_str());
+            }
+        }
+        timer.endBatch();
+    });
 
-    // free memory
-    globalImportanceCriteriaUnorm.clear(); globalImportanceCriteriaUnorm.shrink_to_fit();
+    pipeline.run();
+    pipeline.logStatistics();
 
     auto end = std::chrono::system_clock::now();
 
+    const size_t numVertices = globalVertexPositions.size();
     Logfile::get()->writeInfo(std::string() + "Summary: "
                               + sgl::toString(numVertices) + " vertices, "
                               + sgl::toString(numIndices / 3) + " faces, "
                               + sgl::toString(numIndices) + " indices.");
-    Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
-    writeMesh3D(binaryFilename, binaryMesh);
 
     // compute size of renderable geometry;
-    float byteSize = positionAttribute.data.size() * sizeof(uint8_t) + lineNormalsAttribute.data.size() * sizeof(uint8_t)
-                     + submesh.attributes[0].data.size() * sizeof(uint8_t) + submesh.indices.size() * sizeof(uint32_t);
+    float byteSize = numVertices * sizeof(glm::vec3) + globalNormals.size() * sizeof(glm::vec3)
+                     + numVertices * globalImportanceCriteria.size() * sizeof(uint16_t)
+                     + numIndices * sizeof(uint32_t);
 
     float MBSize = byteSize / 1024. / 1024.;
 
@@ -944,7 +1143,55 @@ void convertTrajectoryDataToBinaryLineMesh(
 {
     auto start = std::chrono::system_clock::now();
 
+    Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
+    // The line summaries stored in the binlines data (or its cache written by loadTrajectoriesFromFile) are reused.
+    BinLinesFile binLinesFile;
+    openBinLinesDataForTrajectoryFile(trajectoriesFilename, trajectoryType, binLinesFile);
     BinaryMesh binaryMesh;
+    convertTrajectoriesToBinaryLineMesh(trajectories, binaryMesh, binLinesFile.isOpen() ? &binLinesFile : NULL);
+
+    auto end = std::chrono::system_clock::now();
+
+    Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
+    writeMesh3D(binaryFilename, binaryMesh);
+
+
+    auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    Logfile::get()->writeInfo(std::string() + "Computational time to create binmesh: "
+                        + std::to_string(elapsed.count()));
+}
+
+/**
+ * Maps line summaries to the values of an attribute after packUnorm16Array with the passed range and
+ * unpackUnorm16Array, i.e., to the values parseMesh3D passes to the line filter. The minimum and maximum are packed
+ * like the vertex values to match them exactly.
+ */
+static void packLineSummariesUnorm16(
+        std::vector<LineAttributeSummary> &summaries, float minValue, float maxValue)
+{
+    const size_t numLines = summaries.size();
+    std::vector<float> minMaxValues(numLines * 2);
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        minMaxValues[lineIdx * 2] = summaries[lineIdx].minValue;
+        minMaxValues[lineIdx * 2 + 1] = summaries[lineIdx].maxValue;
+    }
+    std::vector<uint16_t> minMaxValuesUnorm(numLines * 2);
+    packUnorm16Array(minMaxValues.data(), minMaxValues.size(), minValue, maxValue, minMaxValuesUnorm.data());
+    unpackUnorm16Array(minMaxValuesUnorm.data(), minMaxValuesUnorm.size(), minMaxValues);
+
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        LineAttributeSummary &summary = summaries[lineIdx];
+        summary.minValue = minMaxValues[lineIdx * 2];
+        summary.maxValue = minMaxValues[lineIdx * 2 + 1];
+        summary.meanValue = glm::clamp((summary.meanValue - minValue) / (maxValue - minValue), 0.0f, 1.0f);
+    }
+}
+
+void convertTrajectoriesToBinaryLineMesh(
+        Trajectories &trajectories, BinaryMesh &binaryMesh, const BinLinesFile *binLinesFile)
+{
+    binaryMesh.submeshes.clear();
     binaryMesh.submeshes.push_back(BinarySubMesh());
     BinarySubMesh &submesh = binaryMesh.submeshes.front();
     submesh.vertexMode = VERTEX_MODE_LINES;
@@ -955,8 +1202,16 @@ void convertTrajectoryDataToBinaryLineMesh(
     std::vector<std::vector<float>> globalImportanceCriteria;
     std::vector<uint32_t> globalIndices;
 
-
-    Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
+    // Summaries of the attributes of all lines in the mesh (see LineFilter).
+    std::vector<std::vector<LineAttributeSummary>> lineSummaries;
+    if (binLinesFile != NULL && (!binLinesFile->hasLineSummaries()
+            || binLinesFile->getNumLines() != trajectories.size())) {
+        binLinesFile = NULL;
+    }
+    TrajectoryNormalization normalization;
+    if (binLinesFile != NULL) {
+        normalization = binLinesFile->getNormalization();
+    }
 
     for (size_t i = 0; i < trajectories.size(); i++) {
         Trajectory &trajectory = trajectories.at(i);
@@ -970,6 +1225,34 @@ void convertTrajectoryDataToBinaryLineMesh(
         createTangentAndNormalData(trajectory.positions, trajectory.attributes, localVertices,
                                    importanceCriteriaOut, localTangents, localNormals, localIndices);
 
+        // Line summaries of the line in the index buffer (if it has at least one segment)
+        const size_t numAttributes = importanceCriteriaOut.size();
+        if (!localIndices.empty()) {
+            lineSummaries.resize(numAttributes);
+            // Points removed by createTangentAndNormalData change the summaries of the line.
+            bool useStoredSummaries = binLinesFile != NULL && localVertices.size() == trajectory.positions.size()
+                    && binLinesFile->getNumAttributes() == numAttributes;
+            for (size_t attributeIdx = 0; attributeIdx < numAttributes; attributeIdx++) {
+                LineAttributeSummary summary;
+                if (useStoredSummaries) {
+                    summary = binLinesFile->getLineSummaries(uint32_t(attributeIdx))[i];
+                    // Same transformation as in applyTrajectoryNormalization.
+                    if (attributeIdx == 0 && normalization.normalizeAttribute) {
+                        const float minAttr = normalization.minAttribute;
+                        const float attrRange = normalization.maxAttribute - normalization.minAttribute;
+                        summary.minValue = (summary.minValue - minAttr) / attrRange;
+                        summary.maxValue = (summary.maxValue - minAttr) / attrRange;
+                        summary.meanValue = (summary.meanValue - minAttr) / attrRange;
+                    }
+                } else {
+                    const uint64_t lineOffsets[2] = { 0, localVertices.size() };
+                    computeLineAttributeSummaries(lineOffsets, 1, &importanceCriteriaOut.at(attributeIdx).front(),
+                            &summary);
+                }
+                lineSummaries.at(attributeIdx).push_back(summary);
+            }
+        }
+
         // Local -> global
         if (localVertices.size() > 0) {
             for (size_t i = 0; i < localIndices.size(); i++) {
@@ -1036,6 +1319,19 @@ void convertTrajectoryDataToBinaryLineMesh(
     // free memory
     globalTangents.clear(); globalTangents.shrink_to_fit();
 
+    // The line summaries need to refer to the values packed below.
+    for (size_t i = 0; i < lineSummaries.size() && i < globalImportanceCriteria.size(); i++) {
+        const std::vector<float> &currentAttr = globalImportanceCriteria.at(i);
+        float minValue = FLT_MAX, maxValue = -FLT_MAX;
+        #pragma omp parallel for reduction(min:minValue) reduction(max:maxValue)
+        for (size_t j = 0; j < currentAttr.size(); j++) {
+            minValue = std::min(minValue, currentAttr[j]);
+            maxValue = std::max(maxValue, currentAttr[j]);
+        }
+        packLineSummariesUnorm16(lineSummaries.at(i), minValue, maxValue);
+    }
+    setSubmeshLineSummaries(submesh, lineSummaries);
+
     std::vector<std::vector<uint16_t>> globalImportanceCriteriaUnorm;
     packUnorm16ArrayOfArrays(globalImportanceCriteria, globalImportanceCriteriaUnorm);
 
@@ -1053,19 +1349,9 @@ void convertTrajectoryDataToBinaryLineMesh(
     // free memory
     globalImportanceCriteriaUnorm.clear(); globalImportanceCriteriaUnorm.shrink_to_fit();
 
-    auto end = std::chrono::system_clock::now();
-
     Logfile::get()->writeInfo(std::string() + "Summary: "
                               + sgl::toString(numVertices) + " vertices, "
                               + sgl::toString(numIndices / 3) + " faces, "
                               + sgl::toString(numIndices) + " indices.");
-    Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
-    writeMesh3D(binaryFilename, binaryMesh);
-
-
-    auto elapsed =
-            std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    Logfile::get()->writeInfo(std::string() + "Computational time to create binmesh: "
-                        + std::to_string(elapsed.count()));
 }
 
@@ -12,6 +12,10 @@
 #include <glm/glm.hpp>
 
 #include "ImportanceCriteria.hpp"
+#include "TrajectoryFile.hpp"
+
+struct BinaryMesh;
+class BinLinesFile;
 
 /**
  * @param pathLineCenters: The (input) path line points to create a tube from.
@@ -59,4 +63,13 @@ void convertTrajectoryDataToBinaryLineMesh(
         const std::string &trajectoriesFilename,
         const std::string &binaryFilename);
 
+/**
+ * Creates the line mesh written by convertTrajectoryDataToBinaryLineMesh from trajectories already in memory.
+ * The per-line attribute summaries used by LineFilter are stored in the mesh (see setSubmeshLineSummaries).
+ * @param binLinesFile The binlines data the trajectories were loaded from (optional). If it stores line summaries,
+ * they are used for the lines the mesh contains unchanged instead of computing the summaries from the points.
+ */
+void convertTrajectoriesToBinaryLineMesh(
+        Trajectories &trajectories, BinaryMesh &binaryMesh, const BinLinesFile *binLinesFile = NULL);
+
 #endif //PIXELSYNCOIT_TRAJECTORYLOADER_HPP
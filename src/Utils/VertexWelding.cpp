@@ -0,0 +1,211 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+#include "VertexWelding.hpp"
+
+struct WeldingGridEntry
+{
+    uint64_t cellHash;
+    uint32_t vertexIndex;
+};
+
+static inline bool operator<(const WeldingGridEntry &a, const WeldingGridEntry &b)
+{
+    return a.cellHash < b.cellHash || (a.cellHash == b.cellHash && a.vertexIndex < b.vertexIndex);
+}
+
+// Cells with the same hash share their entries in the grid. This only adds candidates to the distance test.
+static inline uint64_t hashWeldingCell(int64_t x, int64_t y, int64_t z)
+{
+    uint64_t hash = uint64_t(x) * 0x9E3779B97F4A7C15ull;
+    hash ^= uint64_t(y) * 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
+    hash ^= uint64_t(z) * 0x165667B19E3779F9ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+void computeVertexWelding(
+        const std::vector<glm::vec3> &vertices, float relativeEpsilon,
+        std::vector<uint32_t> &vertexRemap, std::vector<glm::vec3> &weldedVertices)
+{
+    const size_t numVertices = vertices.size();
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+    #pragma omp parallel for reduction(min:minX,minY,minZ) reduction(max:maxX,maxY,maxZ)
+    for (size_t i = 0; i < numVertices; i++) {
+        const glm::vec3 &vertex = vertices[i];
+        minX = std::min(minX, vertex.x);
+        minY = std::min(minY, vertex.y);
+        minZ = std::min(minZ, vertex.z);
+        maxX = std::max(maxX, vertex.x);
+        maxY = std::max(maxY, vertex.y);
+        maxZ = std::max(maxZ, vertex.z);
+    }
+    const glm::vec3 minVec(minX, minY, minZ);
+    const float maxExtent = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ));
+    const float cellSize = relativeEpsilon * maxExtent;
+
+    vertexRemap.resize(numVertices);
+    if (numVertices == 0 || !(cellSize > 0.0f)) {
+        // Nothing to weld.
+        for (size_t i = 0; i < numVertices; i++) {
+            vertexRemap[i] = uint32_t(i);
+        }
+        weldedVertices = vertices;
+        return;
+    }
+    const float cellSizeSquared = cellSize * cellSize;
+
+    // Build the spatial hash grid: The entries are sorted by cell hash and, within a cell, by vertex index.
+    std::vector<glm::ivec3> cells(numVertices);
+    std::vector<WeldingGridEntry> grid(numVertices);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numVertices; i++) {
+        glm::vec3 cellPosition = (vertices[i] - minVec) / cellSize;
+        glm::ivec3 cell(
+                int(std::floor(cellPosition.x)), int(std::floor(cellPosition.y)),
+                int(std::floor(cellPosition.z)));
+        cells[i] = cell;
+        grid[i].cellHash = hashWeldingCell(cell.x, cell.y, cell.z);
+        grid[i].vertexIndex = uint32_t(i);
+    }
+    std::sort(grid.begin(), grid.end());
+
+    // Merge every vertex into the lowest-indexed vertex within the welding distance.
+    std::vector<uint32_t> representatives(numVertices);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t i = 0; i < numVertices; i++) {
+        const glm::vec3 &vertex = vertices[i];
+        const glm::ivec3 &cell = cells[i];
+        uint32_t representative = uint32_t(i);
+        for (int64_t dz = -1; dz <= 1; dz++) {
+            for (int64_t dy = -1; dy <= 1; dy++) {
+                for (int64_t dx = -1; dx <= 1; dx++) {
+                    WeldingGridEntry key;
+                    key.cellHash = hashWeldingCell(cell.x + dx, cell.y + dy, cell.z + dz);
+                    key.vertexIndex = 0;
+                    auto it = std::lower_bound(grid.begin(), grid.end(), key);
+                    for (; it != grid.end() && it->cellHash == key.cellHash; it++) {
+                        if (it->vertexIndex >= representative) {
+                            break;
+                        }
+                        glm::vec3 diff = vertices[it->vertexIndex] - vertex;
+                        if (glm::dot(diff, diff) <= cellSizeSquared) {
+                            // The entries are sorted by vertex index, so this is the lowest one in the cell.
+                            representative = it->vertexIndex;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        representatives[i] = representative;
+    }
+    cells.clear(); cells.shrink_to_fit();
+    grid.clear(); grid.shrink_to_fit();
+
+    // Collapse chains of merged vertices. Representatives always have a lower index, so this terminates.
+    std::vector<uint32_t> roots(numVertices);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numVertices; i++) {
+        uint32_t root = representatives[i];
+        while (representatives[root] != root) {
+            root = representatives[root];
+        }
+        roots[i] = root;
+    }
+
+    // Number the remaining vertices in their original order.
+    size_t numWeldedVertices = 0;
+    for (size_t i = 0; i < numVertices; i++) {
+        if (roots[i] == i) {
+            vertexRemap[i] = uint32_t(numWeldedVertices++);
+        }
+    }
+    weldedVertices.resize(numWeldedVertices);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numVertices; i++) {
+        if (roots[i] == i) {
+            weldedVertices[vertexRemap[i]] = vertices[i];
+        } else {
+            vertexRemap[i] = vertexRemap[roots[i]];
+        }
+    }
+}
+
+size_t remapWeldedTriangleIndices(
+        const std::vector<uint32_t> &vertexRemap, std::vector<uint32_t> &indices,
+        std::vector<uint32_t> *keptTriangles)
+{
+    #pragma omp parallel for
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = vertexRemap[indices[i]];
+    }
+
+    // Remove the triangles with merged corners while keeping the order of the remaining ones.
+    const size_t numTriangles = indices.size() / 3;
+    size_t numKeptTriangles = 0;
+    if (keptTriangles) {
+        keptTriangles->clear();
+    }
+    for (size_t t = 0; t < numTriangles; t++) {
+        uint32_t i0 = indices[t*3], i1 = indices[t*3+1], i2 = indices[t*3+2];
+        if (i0 == i1 || i1 == i2 || i0 == i2) {
+            continue;
+        }
+        indices[numKeptTriangles*3] = i0;
+        indices[numKeptTriangles*3+1] = i1;
+        indices[numKeptTriangles*3+2] = i2;
+        numKeptTriangles++;
+        if (keptTriangles) {
+            keptTriangles->push_back(uint32_t(t));
+        }
+    }
+    indices.resize(numKeptTriangles * 3);
+    return numTriangles - numKeptTriangles;
+}
+
+void weldVertices(std::vector<glm::vec3> &vertices, std::vector<uint32_t> &indices, float relativeEpsilon)
+{
+    sgl::Logfile::get()->writeInfo(std::string() + "Welding " + sgl::toString(vertices.size()) + " vertices...");
+    std::vector<uint32_t> vertexRemap;
+    std::vector<glm::vec3> weldedVertices;
+    computeVertexWelding(vertices, relativeEpsilon, vertexRemap, weldedVertices);
+    size_t numRemovedTriangles = remapWeldedTriangleIndices(vertexRemap, indices);
+
+    size_t numVerticesOld = vertices.size();
+    vertices.swap(weldedVertices);
+    sgl::Logfile::get()->writeInfo(std::string() + "Welded " + sgl::toString(numVerticesOld) + " vertices to "
+            + sgl::toString(vertices.size()) + " (" + sgl::toString(numVerticesOld - vertices.size())
+            + " merged), removed " + sgl::toString(numRemovedTriangles) + " degenerate triangles.");
+}
@@ -0,0 +1,67 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2019, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PIXELSYNCOIT_VERTEXWELDING_HPP
+#define PIXELSYNCOIT_VERTEXWELDING_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * Computes which vertices of a mesh to merge because their distance is at most "epsilon * maximum bounding box
+ * extent", e.g. duplicates that only differ by floating point noise.
+ * The vertices are sorted into a spatial hash grid with a cell size of the welding distance. Each vertex is merged
+ * into the lowest-indexed vertex within the welding distance, and chains of merged vertices are collapsed. Thus,
+ * the result doesn't depend on the number of threads. The merged vertex keeps the position of its lowest-indexed
+ * vertex, and the order of the remaining vertices is preserved.
+ * @param vertices The vertex positions.
+ * @param relativeEpsilon The welding distance relative to the maximum extent of the bounding box of the vertices.
+ * @param vertexRemap Is set to the new index of every old vertex.
+ * @param weldedVertices Is set to the remaining vertex positions.
+ */
+void computeVertexWelding(
+        const std::vector<glm::vec3> &vertices, float relativeEpsilon,
+        std::vector<uint32_t> &vertexRemap, std::vector<glm::vec3> &weldedVertices);
+
+/**
+ * Remaps the indices of a triangle list with the result of computeVertexWelding and removes triangles that collapsed.
+ * @param keptTriangles If not NULL, is set to the old index of every remaining triangle.
+ * @return The number of removed triangles.
+ */
+size_t remapWeldedTriangleIndices(
+        const std::vector<uint32_t> &vertexRemap, std::vector<uint32_t> &indices,
+        std::vector<uint32_t> *keptTriangles = NULL);
+
+/**
+ * Welds the vertices of an indexed triangle mesh in place (see computeVertexWelding) and logs the reduction.
+ */
+void weldVertices(std::vector<glm::vec3> &vertices, std::vector<uint32_t> &indices, float relativeEpsilon);
+
+#endif //PIXELSYNCOIT_VERTEXWELDING_HPP
@@ -15,6 +15,7 @@
 #include <ImGui/ImGuiWrapper.hpp>
 
 #include "../Performance/InternalState.hpp"
+#include "../Utils/GuideHairFile.hpp"
 #include "VoxelCurveDiscretizer.hpp"
 #include "OIT_VoxelRaytracing.hpp"
 #include "../OIT/BufferSizeWatch.hpp"
@@ -169,7 +170,7 @@ void OIT_VoxelRaytracing::fromFile(const std::string &filename, TrajectoryType t
                 glm::ivec3(quantizationRes, quantizationRes, quantizationRes));
 
         if (isHairDataset) {
-            std::string modelFilenameHair = modelFilenamePure + ".hair";
+            std::string modelFilenameHair = isGuideHairFilename(filename) ? filename : modelFilenamePure + ".hair";
             compressedData = discretizer.createFromHairDataset(modelFilenameHair, lineRadius, hairStrandColor,
                     maxNumLinesPerVoxel);
         } else {
@@ -5,6 +5,11 @@
 #include <fstream>
 #include <iostream>
 #include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <map>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -21,140 +26,13 @@
 #include <Graphics/OpenGL/Texture.hpp>
 
 #include "Utils/HairLoader.hpp"
+#include "Utils/ParallelSort.hpp"
 #include "Utils/TrajectoryFile.hpp"
 #include "VoxelCurveDiscretizer.hpp"
 
-#define BIAS 0.001
-
-/**
- * Helper function for rayBoxIntersection (see below).
- */
-bool rayBoxPlaneIntersection(float rayOriginX, float rayDirectionX, float lowerX, float upperX,
-                             float &tNear, float &tFar)
-{
-    if (std::abs(rayDirectionX) < BIAS) {
-        // Ray is parallel to the x planes
-        if (rayOriginX < lowerX || rayOriginX > upperX) {
-            return false;
-        }
-    } else {
-        // Not parallel to the x planes. Compute the intersection distance to the planes.
-        float t0 = (lowerX - rayOriginX) / rayDirectionX;
-        float t1 = (upperX - rayOriginX) / rayDirectionX;
-        if (t0 > t1) {
-            // Since t0 intersection with near plane
-            float tmp = t0;
-            t0 = t1;
-            t1 = tmp;
-        }
-
-        if (t0 > tNear) {
-            // We want the largest tNear
-            tNear = t0;
-        }
-        if (t1 < tFar) {
-            // We want the smallest tFar
-            tFar = t1;
-        }
-        if (tNear > tFar) {
-            // Box is missed
-            return false;
-        }
-        if (tFar < 0) {
-            // Box is behind ray
-            return false;
-        }
-    }
-    return true;
-}
-
-/**
- * Implementation of ray-box intersection (idea from A. Glassner et al., "An Introduction to Ray Tracing").
- * For more details see: https://www.siggraph.org//education/materials/HyperGraph/raytrace/rtinter3.htm
- */
-bool rayBoxIntersection(glm::vec3 rayOrigin, glm::vec3 rayDirection, glm::vec3 lower, glm::vec3 upper,
-                        float &tNear, float &tFar)
-{
-    tNear = -1e7;
-    tFar = 1e7;
-    for (int i = 0; i < 3; i++) {
-        if (!rayBoxPlaneIntersection(rayOrigin[i], rayDirection[i], lower[i], upper[i], tNear, tFar)) {
-            return false;
-        }
-    }
-
-    //entrancePoint = rayOrigin + tNear * rayDirection;
-    //exitPoint = rayOrigin + tFar * rayDirection;
-    return true;
-}
-
-
-
-
-bool VoxelDiscretizer::addPossibleIntersections(const glm::vec3 &v1, const glm::vec3 &v2, float a1, float a2)
-{
-    float tNear, tFar;
-    glm::vec3 voxelLower = glm::vec3(index);
-    glm::vec3 voxelUpper = glm::vec3(index + glm::ivec3(1,1,1));
-    if (rayBoxIntersection(v1, (v2 - v1), voxelLower, voxelUpper, tNear, tFar)) {
-        bool intersectionNear = 0.0f <= tNear && tNear <= 1.0f;
-        bool intersectionFar = 0.0f <= tFar && tFar <= 1.0f;
-        if (intersectionNear) {
-            glm::vec3 entrancePoint = v1 + tNear * (v2 - v1);
-            float interpolatedAttribute = a1 + tNear * (a2 - a1);
-            currentCurveIntersections.push_back(AttributePoint(entrancePoint, interpolatedAttribute));
-        }
-        if (intersectionFar) {
-            glm::vec3 exitPoint = v1 + tFar * (v2 - v1);
-            float interpolatedAttribute = a1 + tFar * (a2 - a1);
-            currentCurveIntersections.push_back(AttributePoint(exitPoint, interpolatedAttribute));
-        }
-        if (intersectionNear || intersectionFar) {
-            return true; // Intersection found
-        }
-    }
-
-    return false;
-}
-
-void VoxelDiscretizer::setIndex(glm::ivec3 index)
-{
-    this->index = index;
-}
-
-float VoxelDiscretizer::computeDensity(float maxVorticity)
-{
-    float density = 0.0f;
-    for (LineSegment &line : lines) {
-        density += line.length() * line.avgOpacity(maxVorticity);
-    }
-    return density;
-}
-
-float VoxelDiscretizer::computeDensityHair(float opacity)
-{
-    float density = 0.0f;
-    for (LineSegment &line : lines) {
-        density += line.length() * opacity;
-    }
-    return density;
-}
-
-
-
-
-
-
-
 VoxelCurveDiscretizer::VoxelCurveDiscretizer(const glm::ivec3 &gridResolution, const glm::ivec3 &quantizationResolution)
         : gridResolution(gridResolution), quantizationResolution(quantizationResolution)
 {
-    voxels = nullptr;
-}
-
-VoxelCurveDiscretizer::~VoxelCurveDiscretizer()
-{
-    delete[] voxels;
 }
 
 void VoxelCurveDiscretizer::setVoxelGrid(const sgl::AABB3 &aabb)
@@ -170,19 +48,8 @@ void VoxelCurveDiscretizer::setVoxelGrid(const sgl::AABB3 &aabb)
         float sideLengthFactor = gridDimensions[i] / maxDimensionLength;
         gridResolution[i] = (int)std::ceil(gridResolution[i] * sideLengthFactor);
     }
-
-    voxels = new VoxelDiscretizer[gridResolution.x * gridResolution.y * gridResolution.z];
-    for (int z = 0; z < gridResolution.z; z++) {
-        for (int y = 0; y < gridResolution.y; y++) {
-            for (int x = 0; x < gridResolution.x; x++) {
-                int index = x + y*gridResolution.x + z*gridResolution.x*gridResolution.y;
-                voxels[index].setIndex(glm::ivec3(x, y, z));
-            }
-        }
-    }
 }
 
-
 VoxelGridDataCompressed VoxelCurveDiscretizer::createFromTrajectoryDataset(const std::string &filename,
         TrajectoryType trajectoryType, std::vector<float> &attributes, float &_maxVorticity,
         unsigned int maxNumLinesPerVoxel, bool useGPU)
@@ -263,16 +130,7 @@ VoxelGridDataCompressed VoxelCurveDiscretizer::createFromTrajectoryDataset(const
     }
 
     if (!useGPU) {
-        // Insert lines into voxel representation
-        //int lineNum = 0;
-        for (const Curve &curve : curves) {
-            /*if (lineNum == 1000) {
-                break;
-            }*/
-            nextStreamline(curve);
-            //lineNum++;
-        }
-        return compressData();
+        return createVoxelGridCPU(curves);
     } else {
         return createVoxelGridGPU(curves, maxNumLinesPerVoxel);
     }
@@ -282,7 +140,7 @@ VoxelGridDataCompressed VoxelCurveDiscretizer::createFromTrajectoryDataset(const
 VoxelGridDataCompressed VoxelCurveDiscretizer::createFromHairDataset(const std::string &filename, float &lineRadius,
         glm::vec4 &hairStrandColor, unsigned int maxNumLinesPerVoxel, bool useGPU)
 {
-    HairData hairData;
+    FlatHairData hairData;
     loadHairFile(filename, hairData);
     downscaleHairData(hairData, HAIR_MODEL_SCALING_FACTOR);
 
@@ -293,32 +151,37 @@ VoxelGridDataCompressed VoxelCurveDiscretizer::createFromHairDataset(const std::
     this->hairStrandColor = hairStrandColor;
     this->hairOpacity = hairData.defaultOpacity;
 
-
-    linesBoundingBox = sgl::AABB3();
-    std::vector<Curve> curves;
-    Curve currentCurve;
     maxVorticity = 0.0f;
-    int lineCounter = 0;
     isHairDataset = true;
 
     // Process all strands and convert them to curves
-    for (HairStrand &strand : hairData.strands) {
-        lineCounter++;
-        if (lineCounter % 1000 == 999) {
-            sgl::Logfile::get()->writeInfo(std::string() + "Parsing hair strand " + sgl::toString(lineCounter) + "...");
-        }
-
-        for (glm::vec3 point : strand.points) {
-            glm::vec3 scaledPoint = point;
-            currentCurve.points.push_back(scaledPoint);
-            currentCurve.attributes.push_back(this->hairOpacity);
-            linesBoundingBox.combine(scaledPoint);
-        }
-
-        curves.push_back(currentCurve);
-        currentCurve = Curve();
-        currentCurve.lineID = lineCounter;
+    const size_t numStrands = hairData.getNumStrands();
+    sgl::Logfile::get()->writeInfo(std::string() + "Converting " + sgl::toString(numStrands)
+            + " hair strands to curves...");
+    std::vector<Curve> curves(numStrands);
+    const float opacity = this->hairOpacity;
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
+        Curve &curve = curves.at(strandIdx);
+        const uint32_t begin = hairData.strandOffsets[strandIdx], end = hairData.strandOffsets[strandIdx+1];
+        curve.points.assign(hairData.points.begin() + begin, hairData.points.begin() + end);
+        curve.attributes.assign(end - begin, opacity);
+        curve.lineID = (unsigned int)strandIdx;
+    }
+
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+    #pragma omp parallel for reduction(min:minX,minY,minZ) reduction(max:maxX,maxY,maxZ)
+    for (size_t i = 0; i < hairData.points.size(); i++) {
+        const glm::vec3 &point = hairData.points[i];
+        minX = std::min(minX, point.x); minY = std::min(minY, point.y); minZ = std::min(minZ, point.z);
+        maxX = std::max(maxX, point.x); maxY = std::max(maxY, point.y); maxZ = std::max(maxZ, point.z);
     }
+    linesBoundingBox = sgl::AABB3();
+    if (!hairData.points.empty()) {
+        linesBoundingBox = sgl::AABB3(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ));
+    }
+    hairData = FlatHairData();
 
     // Move to origin and scale to range from (0, 0, 0) to (rx, ry, rz).
     setVoxelGrid(linesBoundingBox);
@@ -327,126 +190,114 @@ VoxelGridDataCompressed VoxelCurveDiscretizer::createFromHairDataset(const std::
     voxelToLines = glm::inverse(linesToVoxel);
 
     // Transform curves to voxel grid space
-    for (Curve &curve : curves) {
-        for (glm::vec3 &v : curve.points) {
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t curveIdx = 0; curveIdx < curves.size(); curveIdx++) {
+        for (glm::vec3 &v : curves[curveIdx].points) {
             v = sgl::transformPoint(linesToVoxel, v);
         }
     }
 
     if (!useGPU) {
-        // Insert lines into voxel representation
-        for (const Curve &curve : curves) {
-            nextStreamline(curve);
-        }
-        return compressData();
+        return createVoxelGridCPU(curves);
     } else {
         return createVoxelGridGPU(curves, maxNumLinesPerVoxel);
     }
 }
 
 
-VoxelGridDataCompressed VoxelCurveDiscretizer::compressData()
+/**
+ * Traverses the voxels crossed by the line segment (v1, v2) in the order of the segment using a 3D-DDA (see J.
+ * Amanatides and A. Woo, "A Fast Voxel Traversal Algorithm for Ray Tracing", 1987). For every crossed voxel,
+ * addIntersection(voxel, point) is called with the points where the segment enters and leaves the voxel
+ * (if they lie on the segment). Only the voxels crossed by the segment are visited instead of testing all voxels in
+ * its bounding box for an intersection (see testVoxelCurveDiscretization for a comparison).
+ * @param isCurveStart Whether v1 is the first point of a curve. Otherwise, voxel needs to be the voxel the previous
+ * segment ended in. Segments ending on a voxel boundary stay in their voxel, and the next segment leaves it (if
+ * necessary). This way, every boundary crossing of a curve is added exactly once.
+ * @param voxel The voxel the segment ends in (output).
+ */
+template<typename AddIntersectionFunction>
+static void traverseSegmentVoxels(const glm::ivec3 &gridResolution, const glm::vec3 &v1, const glm::vec3 &v2,
+        float a1, float a2, bool isCurveStart, glm::ivec3 &voxel, AddIntersectionFunction addIntersection)
 {
-    VoxelGridDataCompressed dataCompressed;
-    dataCompressed.gridResolution = gridResolution;
-    dataCompressed.quantizationResolution = quantizationResolution;
-    dataCompressed.worldToVoxelGridMatrix = this->getWorldToVoxelGridMatrix();
-    dataCompressed.dataType = isHairDataset ? 1u : 0u;
-
-    if (isHairDataset) {
-        dataCompressed.hairStrandColor = hairStrandColor;
-        dataCompressed.hairThickness = hairThickness;
-    } else {
-        dataCompressed.attributes = attributes;
-        dataCompressed.maxVorticity = maxVorticity;
-    }
-
-    int n = gridResolution.x * gridResolution.y * gridResolution.z;
-    std::vector<float> voxelDensities;
-    std::vector<uint32_t> usedVoxels;
-    voxelDensities.reserve(n);
-    usedVoxels.reserve(n);
-
-    size_t lineOffset = 0;
-    dataCompressed.voxelLineListOffsets.reserve(n);
-    dataCompressed.numLinesInVoxel.reserve(n);
-    dataCompressed.lineSegments.clear();
-
-    for (int i = 0; i < n; i++) {
-        dataCompressed.voxelLineListOffsets.push_back(lineOffset);
-        size_t numLines = voxels[i].lines.size();
-        dataCompressed.numLinesInVoxel.push_back(numLines);
-        if (isHairDataset) {
-            voxelDensities.push_back(voxels[i].computeDensityHair(hairOpacity));
+    const glm::vec3 direction = v2 - v1;
+    glm::ivec3 step;
+    glm::vec3 tNextPlane;
+    float tEnter = -FLT_MAX;
+    for (int i = 0; i < 3; i++) {
+        if (isCurveStart) {
+            voxel[i] = int(std::floor(v1[i]));
+            // Curves starting on the upper boundary of the grid start in its last voxel.
+            if (v1[i] == float(gridResolution[i])) {
+                voxel[i] = gridResolution[i] - 1;
+            }
+        }
+        if (direction[i] == 0.0f) {
+            // Parallel to the planes of this axis. No bias is used, as the voxel needs to be tracked exactly for the
+            // next segment.
+            step[i] = 0;
+            tNextPlane[i] = FLT_MAX;
         } else {
-            voxelDensities.push_back(voxels[i].computeDensity(maxVorticity));
+            step[i] = direction[i] > 0.0f ? 1 : -1;
+            if (isCurveStart) {
+                // The curve can start on the plane it enters the first voxel through.
+                float lowerPlane = float(voxel[i] + (step[i] > 0 ? 0 : 1));
+                tEnter = std::max(tEnter, (lowerPlane - v1[i]) / direction[i]);
+            }
+            tNextPlane[i] = (float(voxel[i] + (step[i] > 0 ? 1 : 0)) - v1[i]) / direction[i];
         }
-        usedVoxels.push_back(numLines > 0 ? 1 : 0);
+    }
 
-#ifdef PACK_LINES
-        std::vector<LineSegmentCompressed> lineSegments;
-        lineSegments.resize(voxels[i].lines.size());
-        for (size_t j = 0; j < voxels[i].lines.size(); j++) {
-            compressLine(voxels[i].getIndex(), voxels[i].lines[j], lineSegments[j]);
-
-            // Test
-            /*LineSegment originalLine = voxels[i].lines[j];
-            LineSegment decompressedLine;
-            decompressLine(glm::vec3(voxels[i].getIndex()), lineSegments[j], decompressedLine);
-            if (!checkLinesEqual(originalLine, decompressedLine)) {
-                compressLine(voxels[i].getIndex(), voxels[i].lines[j], lineSegments[j]);
-                decompressLine(glm::vec3(voxels[i].getIndex()), lineSegments[j], decompressedLine);
-            }*/
+    auto addPoint = [&](float t) {
+        addIntersection(voxel, AttributePoint(v1 + t * direction, a1 + t * (a2 - a1)));
+    };
+    while (true) {
+        int axis = 0;
+        if (tNextPlane[1] < tNextPlane[axis]) axis = 1;
+        if (tNextPlane[2] < tNextPlane[axis]) axis = 2;
+        // Planes slightly behind the start point (due to rounding at the end of the previous segment) are crossed
+        // at the start point.
+        float tExit = std::max(tNextPlane[axis], 0.0f);
+
+        bool isInGrid = voxel.x >= 0 && voxel.y >= 0 && voxel.z >= 0 && voxel.x < gridResolution.x
+                && voxel.y < gridResolution.y && voxel.z < gridResolution.z;
+        if (isInGrid && tEnter >= 0.0f) {
+            addPoint(tEnter);
+        }
+        if (tExit >= 1.0f) {
+            break;
+        }
+        if (isInGrid) {
+            addPoint(tExit);
         }
-        dataCompressed.lineSegments.insert(dataCompressed.lineSegments.end(),
-                lineSegments.begin(), lineSegments.end());
-#else
-        dataCompressed.lineSegments.insert(dataCompressed.lineSegments.end(),
-                voxels[i].lines.begin(), voxels[i].lines.end());
-#endif
 
-        lineOffset += numLines;
+        // Step to the neighboring voxel. The plane distances are computed from the start point instead of
+        // incrementally to avoid accumulating rounding errors.
+        voxel[axis] += step[axis];
+        tNextPlane[axis] = (float(voxel[axis] + (step[axis] > 0 ? 1 : 0)) - v1[axis]) / direction[axis];
+        tEnter = tExit;
     }
-
-    std::vector<float> voxelAOFactors;
-    voxelAOFactors.resize(n);
-    generateVoxelAOFactorsFromDensity(voxelDensities, voxelAOFactors, gridResolution, isHairDataset);
-
-    dataCompressed.voxelDensities = voxelDensities;
-    dataCompressed.voxelAOFactors = voxelAOFactors;
-    return dataCompressed;
 }
 
-
-
-std::vector<VoxelDiscretizer*> VoxelCurveDiscretizer::getVoxelsInAABB(const sgl::AABB3 &aabb)
+/**
+ * Huge values are used in many scientific datasets to indicate invalid line points. Non-finite points are invalid,
+ * too, as traverseSegmentVoxels would never reach the end of a segment with such a point.
+ */
+static inline bool isValidLinePoint(const glm::vec3 &v)
 {
-    std::vector<VoxelDiscretizer*> voxelsInAABB;
-    glm::vec3 minimum = aabb.getMinimum();
-    glm::vec3 maximum = aabb.getMaximum();
-
-    glm::ivec3 lower = glm::ivec3(minimum); // Round down
-    glm::ivec3 upper = glm::ivec3(ceil(maximum.x), ceil(maximum.y), ceil(maximum.z)); // Round up
-    lower = glm::max(lower, glm::ivec3(0));
-    upper = glm::min(upper, gridResolution - glm::ivec3(1));
-
-    for (int z = lower.z; z <= upper.z; z++) {
-        for (int y = lower.y; y <= upper.y; y++) {
-            for (int x = lower.x; x <= upper.x; x++) {
-                int index = x + y*gridResolution.x + z*gridResolution.x*gridResolution.y;
-                voxelsInAABB.push_back(voxels + index);
-            }
-        }
-    }
-    return voxelsInAABB;
+    const float MAX_VAL = 1e10;
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z)
+            && std::fabs(v.x) <= MAX_VAL && std::fabs(v.y) <= MAX_VAL && std::fabs(v.z) <= MAX_VAL;
 }
 
-void VoxelCurveDiscretizer::nextStreamline(const Curve &line)
+void VoxelCurveDiscretizer::discretizeCurve(const Curve &line, std::vector<VoxelLineSegment> &voxelLineSegments)
 {
     int N = line.points.size();
 
-    // Add intersections to voxels
-    std::set<VoxelDiscretizer*> usedVoxels;
+    // Add intersections to the voxels. The voxels are ordered by their index.
+    std::map<uint32_t, std::vector<AttributePoint>> curveIntersections;
+    glm::ivec3 currentVoxel;
+    bool isCurveStart = true;
     for (int i = 0; i < N-1; i++) {
         // Get line segment
         glm::vec3 v1 = line.points.at(i);
@@ -454,47 +305,160 @@ void VoxelCurveDiscretizer::nextStreamline(const Curve &line)
         float a1 = line.attributes.at(i);
         float a2 = line.attributes.at(i+1);
 
-        // Remove invalid line points (used in many scientific datasets to indicate invalid lines).
-        const float MAX_VAL = 1e10;
-        if (std::fabs(v1.x) > MAX_VAL || std::fabs(v1.y) > MAX_VAL || std::fabs(v1.z) > MAX_VAL
-                || std::fabs(v2.x) > MAX_VAL || std::fabs(v2.y) > MAX_VAL || std::fabs(v2.z) > MAX_VAL) {
+        // Remove invalid line points (see isValidLinePoint).
+        if (!isValidLinePoint(v1) || !isValidLinePoint(v2)) {
+            isCurveStart = true;
             continue;
         }
 
-        // Compute AABB of current segment
-        sgl::AABB3 segmentAABB = sgl::AABB3();
-        segmentAABB.combine(v1);
-        segmentAABB.combine(v2);
+        // Add the points where the segment enters and leaves the voxels it crosses
+        traverseSegmentVoxels(gridResolution, v1, v2, a1, a2, isCurveStart, currentVoxel,
+                [this, &curveIntersections](const glm::ivec3 &voxel, const AttributePoint &point) {
+            uint32_t voxelIndex = voxel.x + voxel.y*gridResolution.x + voxel.z*gridResolution.x*gridResolution.y;
+            curveIntersections[voxelIndex].push_back(point);
+        });
+        isCurveStart = false;
+    }
 
-        // Iterate over all voxels with possible intersections
-        std::vector<VoxelDiscretizer*> voxelsInAABB = getVoxelsInAABB(segmentAABB);
+    // Convert intersections to clipped line segments
+    for (auto &voxelIntersections : curveIntersections) {
+        std::vector<AttributePoint> &intersections = voxelIntersections.second;
+        for (size_t i = 0; i + 1 < intersections.size(); i += 2) {
+            voxelLineSegments.push_back(VoxelLineSegment(voxelIntersections.first, LineSegment(
+                    intersections[i].v, intersections[i].a, intersections[i+1].v, intersections[i+1].a,
+                    line.lineID)));
+        }
+    }
+}
 
-        for (VoxelDiscretizer *voxel : voxelsInAABB) {
-            // Line-voxel intersection
-            if (voxel->addPossibleIntersections(v1, v2, a1, a2)) {
-                // Intersection(s) added to "currentLineIntersections", voxel used
-                usedVoxels.insert(voxel);
-            }
+VoxelGridDataCompressed VoxelCurveDiscretizer::createVoxelGridCPU(const std::vector<Curve> &curves)
+{
+    // PART 1: Voxelize batches of curves in parallel. The batches don't depend on the number of threads.
+    auto startVoxelize = std::chrono::system_clock::now();
+    const size_t CURVES_PER_BATCH = 256;
+    const size_t numBatches = (curves.size() + CURVES_PER_BATCH - 1) / CURVES_PER_BATCH;
+    std::vector<std::vector<VoxelLineSegment>> batchLineSegments(numBatches);
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+        size_t curvesEnd = std::min((batchIdx + 1) * CURVES_PER_BATCH, curves.size());
+        for (size_t curveIdx = batchIdx * CURVES_PER_BATCH; curveIdx < curvesEnd; curveIdx++) {
+            discretizeCurve(curves[curveIdx], batchLineSegments[batchIdx]);
         }
     }
 
-    // Convert intersections to clipped line segments
-    for (VoxelDiscretizer *voxel : usedVoxels) {
-        if (voxel->currentCurveIntersections.size() < 2) {
-            voxel->currentCurveIntersections.clear();
-            continue;
+    auto endVoxelize = std::chrono::system_clock::now();
+    auto elapsedVoxelize = std::chrono::duration_cast<std::chrono::milliseconds>(endVoxelize - startVoxelize);
+    sgl::Logfile::get()->writeInfo(std::string() + "Computational time to voxelize the lines: "
+                                   + std::to_string(elapsedVoxelize.count()));
+
+
+    // PART 2: Merge the lists. Sorting by (voxel index, index in the concatenated lists) keeps the curve order in
+    // each voxel, i.e., the result doesn't depend on the number of threads.
+    auto startMerge = std::chrono::system_clock::now();
+    std::vector<size_t> batchOffsets(numBatches + 1, 0);
+    for (size_t batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+        batchOffsets[batchIdx + 1] = batchOffsets[batchIdx] + batchLineSegments[batchIdx].size();
+    }
+    // The sort keys store the segment index in their lower 32 bits (and the voxel line list offsets are 32-bit, too).
+    size_t numMergedBatches = numBatches;
+    while (batchOffsets[numMergedBatches] > size_t(UINT32_MAX)) {
+        numMergedBatches--;
+    }
+    if (numMergedBatches < numBatches) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in VoxelCurveDiscretizer::createVoxelGridCPU: "
+                + "More than 2^32 line segments. Skipping the curves from curve "
+                + std::to_string(numMergedBatches * CURVES_PER_BATCH) + " on.");
+        batchLineSegments.resize(numMergedBatches);
+        batchOffsets.resize(numMergedBatches + 1);
+    }
+    const size_t numLineSegments = batchOffsets.back();
+    std::vector<uint64_t> sortKeys(numLineSegments);
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t batchIdx = 0; batchIdx < numMergedBatches; batchIdx++) {
+        const std::vector<VoxelLineSegment> &lineSegments = batchLineSegments[batchIdx];
+        for (size_t i = 0; i < lineSegments.size(); i++) {
+            sortKeys[batchOffsets[batchIdx] + i] =
+                    (uint64_t(lineSegments[i].voxelIndex) << 32) | uint64_t(batchOffsets[batchIdx] + i);
         }
-        auto it1 = voxel->currentCurveIntersections.begin();
-        auto it2 = voxel->currentCurveIntersections.begin();
-        it2++;
-        while (it2 != voxel->currentCurveIntersections.end()) {
-            voxel->lines.push_back(LineSegment(it1->v, it1->a, it2->v, it2->a, line.lineID));
-            it1++; it1++;
-            if (it1 == voxel->currentCurveIntersections.end()) break;
-            it2++; it2++;
+    }
+    parallelSort(sortKeys);
+
+    std::vector<LineSegment> lineSegments(numLineSegments);
+    std::vector<uint32_t> lineSegmentVoxels(numLineSegments);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numLineSegments; i++) {
+        size_t segmentIdx = size_t(sortKeys[i] & 0xFFFFFFFFu);
+        size_t batchIdx = std::upper_bound(batchOffsets.begin(), batchOffsets.end(), segmentIdx)
+                - batchOffsets.begin() - 1;
+        lineSegments[i] = batchLineSegments[batchIdx][segmentIdx - batchOffsets[batchIdx]].line;
+        lineSegmentVoxels[i] = uint32_t(sortKeys[i] >> 32);
+    }
+    std::vector<uint64_t>().swap(sortKeys);
+    std::vector<std::vector<VoxelLineSegment>>().swap(batchLineSegments);
+
+    auto endMerge = std::chrono::system_clock::now();
+    auto elapsedMerge = std::chrono::duration_cast<std::chrono::milliseconds>(endMerge - startMerge);
+    sgl::Logfile::get()->writeInfo(std::string() + "Computational time to merge the line lists: "
+                                   + std::to_string(elapsedMerge.count()));
+
+
+    // PART 3: Compute the voxel line lists, densities and compressed lines.
+    VoxelGridDataCompressed dataCompressed;
+    dataCompressed.gridResolution = gridResolution;
+    dataCompressed.quantizationResolution = quantizationResolution;
+    dataCompressed.worldToVoxelGridMatrix = this->getWorldToVoxelGridMatrix();
+    dataCompressed.dataType = isHairDataset ? 1u : 0u;
+
+    if (isHairDataset) {
+        dataCompressed.hairStrandColor = hairStrandColor;
+        dataCompressed.hairThickness = hairThickness;
+    } else {
+        dataCompressed.attributes = attributes;
+        dataCompressed.maxVorticity = maxVorticity;
+    }
+
+    const size_t n = size_t(gridResolution.x) * size_t(gridResolution.y) * size_t(gridResolution.z);
+    std::vector<float> voxelDensities(n);
+    dataCompressed.voxelLineListOffsets.resize(n);
+    dataCompressed.numLinesInVoxel.resize(n);
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (size_t i = 0; i < n; i++) {
+        size_t begin = std::lower_bound(lineSegmentVoxels.begin(), lineSegmentVoxels.end(), uint32_t(i))
+                - lineSegmentVoxels.begin();
+        size_t end = begin;
+        float density = 0.0f;
+        while (end < numLineSegments && lineSegmentVoxels[end] == i) {
+            LineSegment &line = lineSegments[end];
+            density += isHairDataset ? line.length() * hairOpacity : line.length() * line.avgOpacity(maxVorticity);
+            end++;
         }
-        voxel->currentCurveIntersections.clear();
+        dataCompressed.voxelLineListOffsets[i] = uint32_t(begin);
+        dataCompressed.numLinesInVoxel[i] = uint32_t(end - begin);
+        voxelDensities[i] = density;
+    }
+
+#ifdef PACK_LINES
+    dataCompressed.lineSegments.resize(numLineSegments);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numLineSegments; i++) {
+        uint32_t voxelIndex = lineSegmentVoxels[i];
+        glm::ivec3 voxelIndex3D(
+                voxelIndex % uint32_t(gridResolution.x),
+                (voxelIndex / uint32_t(gridResolution.x)) % uint32_t(gridResolution.y),
+                voxelIndex / uint32_t(gridResolution.x * gridResolution.y));
+        compressLine(voxelIndex3D, lineSegments[i], dataCompressed.lineSegments[i]);
     }
+#else
+    dataCompressed.lineSegments = lineSegments;
+#endif
+
+    std::vector<float> voxelAOFactors;
+    voxelAOFactors.resize(n);
+    generateVoxelAOFactorsFromDensity(voxelDensities, voxelAOFactors, gridResolution, isHairDataset);
+
+    dataCompressed.voxelDensities = voxelDensities;
+    dataCompressed.voxelAOFactors = voxelAOFactors;
+    return dataCompressed;
 }
 
 template<typename T>
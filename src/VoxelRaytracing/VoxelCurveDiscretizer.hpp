@@ -27,32 +27,20 @@ struct AttributePoint
     float a;
 };
 
-class VoxelDiscretizer
+/// A line segment clipped to the voxel with the linear index voxelIndex.
+struct VoxelLineSegment
 {
-public:
-    // Returns true if the passed line intersects the voxel boundaries
-    bool addPossibleIntersections(const glm::vec3 &v1, const glm::vec3 &v2, float a1, float a2);
-    void setIndex(glm::ivec3 index);
-    const glm::ivec3 &getIndex() const { return index; }
-    float computeDensity(float maxVorticity);
-    float computeDensityHair(float opacity);
-
-    glm::ivec3 index;
-    std::vector<LineSegment> lines;
-
-    // For clipping lines to voxel
-    std::vector<AttributePoint> currentCurveIntersections;
+    VoxelLineSegment(uint32_t voxelIndex, const LineSegment &line) : voxelIndex(voxelIndex), line(line) {}
+    uint32_t voxelIndex;
+    LineSegment line;
 };
 
-
-
 class VoxelCurveDiscretizer
 {
 public:
     VoxelCurveDiscretizer(
             const glm::ivec3 &gridResolution = glm::ivec3(256, 256, 256),
             const glm::ivec3 &quantizationResolution = glm::ivec3(8, 8, 8));
-    ~VoxelCurveDiscretizer();
     VoxelGridDataCompressed createFromTrajectoryDataset(const std::string &filename, TrajectoryType trajectoryType,
             std::vector<float> &attributes, float &maxVorticity, unsigned int maxNumLinesPerVoxel, bool useGPU = true);
     VoxelGridDataCompressed createFromHairDataset(const std::string &filename, float &lineRadius,
@@ -63,10 +51,15 @@ public:
     void recreateDensityAndAOFactors(VoxelGridDataCompressed &dataCompressed, VoxelGridDataGPU &dataGPU,
             unsigned int maxNumLinesPerVoxel);
 
+    /**
+     * Clips the curve (in voxel grid space) to the voxels it crosses and appends the clipped segments to
+     * voxelLineSegments, ordered by the voxel index.
+     */
+    void discretizeCurve(const Curve &line, std::vector<VoxelLineSegment> &voxelLineSegments);
+
 private:
     bool isHairDataset = false;
     glm::ivec3 gridResolution, quantizationResolution;
-    VoxelDiscretizer *voxels;
 
     // Trajectory dataset
     float maxVorticity;
@@ -80,9 +73,9 @@ private:
     // Grid generation
     void setVoxelGrid(const sgl::AABB3 &aabb);
 
-    // On CPU
-    VoxelGridDataCompressed compressData();
-    void nextStreamline(const Curve &line);
+    // On CPU using all cores. Batches of curves are voxelized in parallel into lists of clipped segments, which are
+    // merged by their voxel index keeping the curve order in each voxel.
+    VoxelGridDataCompressed createVoxelGridCPU(const std::vector<Curve> &curves);
     // On GPU
     VoxelGridDataCompressed createVoxelGridGPU(std::vector<Curve> &curves, unsigned int maxNumLinesPerVoxel);
 
@@ -99,7 +92,6 @@ private:
             LineSegment &decompressedLine);
     bool checkLinesEqual(const LineSegment &originalLine, const LineSegment &decompressedLine);
 
-    std::vector<VoxelDiscretizer*> getVoxelsInAABB(const sgl::AABB3 &aabb);
     sgl::AABB3 linesBoundingBox;
     glm::mat4 linesToVoxel, voxelToLines;
 };